@@ -1,127 +1,559 @@
-// NativeVision.cpp — AVX2+FMA accelerated scoring for FeatureMatchTool Phase 2
+// NativeVision.cpp — SIMD accelerated scoring for FeatureMatchTool Phase 2
 // + OpenMP Hough Voting for Phase 1
 // + Fused Sobel+Magnitude preprocessing
-// Build: cl /O2 /arch:AVX2 /fp:fast /LD /EHsc /MD /openmp NativeVision.cpp /Fe:NativeVision.dll
+// + Multi-instance search (peak NMS + parallel pose refinement)
+// + Persistent matcher context (NvCreateMatcher) — zero steady-state allocation
+// + Runtime CPU dispatch (AVX-512 / AVX2 / SSE4.1 / scalar, chosen once via CPUID)
+// + Compact fixed-point gradients (packed int16 dx/dy) with matching scorers
+// + Fused pyramid + Canny + phase-bin search-edge extraction (NvExtractSearchEdges)
+// + Cross-frame pose-bank cache for Phase 2 (NvAcquirePoseBank)
+// + Gather-free Phase 2 window scoring over normalised gradient tiles
+// + L2-banded uint16 Hough accumulators with SIMD peak search
+// + Batched multi-model search with a shared pruning score (NvMatchModels)
+// + Gauss-Newton sub-pixel / sub-step pose refinement (NvRefinePose)
+// + Batched caliper projection + edge detection for the measurement tools (NvMeasureCalipers)
+// + Fused threshold + run-length blob labeling with streaming statistics (NvLabelBlobs)
+// + Zero-copy SharedFrame ingestion with torn-frame checks and double-buffered slots
+// + Asynchronous two-stage match pipeline (NvCreatePipeline / NvPipelineSubmit)
+// + Frame-to-frame tracking inside a predicted window (NvTrackPose)
+// + Lazy full-resolution gradient computed per 64×64 tile on first touch (NvBeginLazyGradient)
+// + Runtime-switchable per-thread stage timers and kernel counters (NvGetStats)
+// + Shared core ledger: fair-share OpenMP teams for concurrent callers (NvConfigureWorkers)
+// + Versioned, memory-mapped precompiled models with full-range pose banks (NvOpenModelFile)
+// + LINE-2D response-map Phase 1 engine, chosen per model (NvModelDesc::voteMode)
+// + van Herk/Gil-Werman rectangle morphology, fused two-stage operations (NvMorphology)
+// + One-pass depth-map and organized point-cloud slicing (NvSliceDepth, NvSlicePointCloud)
+// + Scale as a coarse Phase 1 voting dimension, narrow Phase 2 scale bands (NvHoughVotingScaled)
+// + Edge-density integral-image pruning of vote edges and Phase 2 windows (NvSetEdgePruning)
+// Build: cl /O2 /fp:fast /LD /EHsc /MD /openmp NativeVision.cpp /Fe:NativeVision.dll
+//   or CMakeLists.txt (MSVC, GCC, Clang), which also builds the nv_bench suite.
+//   No /arch switch: every SIMD kernel is compiled for its own ISA and only
+//   reached through the dispatch table, so the DLL loads on any x64 CPU.
 
 #include <immintrin.h>
 #include <cmath>
+#include <cstdio>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <omp.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+#include <new>
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define NV_TARGET(isa)
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#define NV_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#if defined(_WIN32)
 #define EXPORT extern "C" __declspec(dllexport)
+#else
+// Shared-object build (CMakeLists.txt): default visibility, no calling-convention
+// keyword, and the CRT's aligned allocator mapped onto posix_memalign
+#define EXPORT extern "C" __attribute__((visibility("default")))
+#define __cdecl
 
-// ─── Fused Sobel X, Y + Magnitude in one pass (AVX2) ────────────────────────
-// Replaces 3 separate OpenCV calls with a single memory traversal.
-// Input: 8-bit grayscale; Output: float Sobel X, Sobel Y, Magnitude
-// Uses Sobel 3×3 kernel with AVX2 for horizontal rows.
+static inline void* _aligned_malloc(size_t bytes, size_t alignment)
+{
+    void* p = nullptr;
+    return posix_memalign(&p, alignment, bytes) == 0 ? p : nullptr;
+}
 
-EXPORT void __cdecl ComputeGradientNative(
-    const uint8_t* __restrict gray,
-    int width, int height, int stride,
-    float* __restrict outDx,
-    float* __restrict outDy,
-    float* __restrict outMag)
+static inline void _aligned_free(void* p)
 {
-    // Sobel 3×3 kernels:
-    // Kx = [-1 0 1; -2 0 2; -1 0 1]
-    // Ky = [-1 -2 -1;  0  0  0;  1  2  1]
-    // Border pixels: zero gradient
+    free(p);
+}
+#endif
 
-    // Zero border rows
-    memset(outDx, 0, width * sizeof(float));
-    memset(outDy, 0, width * sizeof(float));
-    memset(outMag, 0, width * sizeof(float));
-    memset(outDx + (height - 1) * width, 0, width * sizeof(float));
-    memset(outDy + (height - 1) * width, 0, width * sizeof(float));
-    memset(outMag + (height - 1) * width, 0, width * sizeof(float));
+// Per-function ISA tags. MSVC accepts any intrinsic without /arch, GCC/Clang
+// need the target attribute on every function that uses wider instructions.
+#define NV_TARGET_SSE41  NV_TARGET("sse4.1")
+#define NV_TARGET_AVX2   NV_TARGET("avx2,fma")
+#define NV_TARGET_AVX512 NV_TARGET("avx512f,avx512bw,avx2,fma")
 
-    #pragma omp parallel for schedule(static)
-    for (int y = 1; y < height - 1; y++)
+enum NvIsa { NV_ISA_SCALAR = 0, NV_ISA_SSE41 = 1, NV_ISA_AVX2 = 2, NV_ISA_AVX512 = 3 };
+
+static inline int Ctz32(unsigned v)
+{
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, v);
+    return (int)i;
+#else
+    return __builtin_ctz(v);
+#endif
+}
+
+static inline int Ctz64(uint64_t v)
+{
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward64(&i, v);
+    return (int)i;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+static inline int PopCount32(unsigned v)
+{
+#if defined(_MSC_VER)
+    return (int)__popcnt(v);
+#else
+    return __builtin_popcount(v);
+#endif
+}
+
+// ─── Fused Sobel X, Y + Magnitude row kernels ───────────────────────────────
+// Sobel 3×3 kernels:
+//   Kx = [-1 0 1; -2 0 2; -1 0 1]
+//   Ky = [-1 -2 -1;  0  0  0;  1  2  1]
+// Each kernel fills columns 1 .. width-2 of one output row. Gradients are
+// exact integers in float, so every ISA produces bit-identical output.
+
+static void GradientRowScalar(
+    const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+    float* dx, float* dy, float* mg, int x, int width)
+{
+    for (; x < width - 1; x++)
     {
-        const uint8_t* r0 = gray + (y - 1) * stride;
-        const uint8_t* r1 = gray + y * stride;
-        const uint8_t* r2 = gray + (y + 1) * stride;
-        float* dx = outDx + y * width;
-        float* dy = outDy + y * width;
-        float* mg = outMag + y * width;
+        float gx = -(float)r0[x-1] + (float)r0[x+1]
+                  - 2.0f*(float)r1[x-1] + 2.0f*(float)r1[x+1]
+                  - (float)r2[x-1] + (float)r2[x+1];
+        float gy = -(float)r0[x-1] - 2.0f*(float)r0[x] - (float)r0[x+1]
+                  + (float)r2[x-1] + 2.0f*(float)r2[x] + (float)r2[x+1];
+        dx[x] = gx;
+        dy[x] = gy;
+        mg[x] = sqrtf(gx*gx + gy*gy);
+    }
+}
 
-        // Zero border columns
-        dx[0] = dy[0] = mg[0] = 0.0f;
-        dx[width - 1] = dy[width - 1] = mg[width - 1] = 0.0f;
+static void GradientRowPortable(
+    const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+    float* dx, float* dy, float* mg, int width)
+{
+    GradientRowScalar(r0, r1, r2, dx, dy, mg, 1, width);
+}
+
+NV_TARGET_SSE41
+static inline __m128 LoadU8x4(const uint8_t* p)
+{
+    int32_t v;
+    memcpy(&v, p, sizeof(v));
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v)));
+}
+
+NV_TARGET_SSE41
+static void GradientRowSse41(
+    const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+    float* dx, float* dy, float* mg, int width)
+{
+    __m128 two = _mm_set1_ps(2.0f);
+    int x = 1;
+    for (; x + 4 < width - 1; x += 4)
+    {
+        __m128 r0_m1 = LoadU8x4(r0 + x - 1), r0_0 = LoadU8x4(r0 + x), r0_p1 = LoadU8x4(r0 + x + 1);
+        __m128 r1_m1 = LoadU8x4(r1 + x - 1), r1_p1 = LoadU8x4(r1 + x + 1);
+        __m128 r2_m1 = LoadU8x4(r2 + x - 1), r2_0 = LoadU8x4(r2 + x), r2_p1 = LoadU8x4(r2 + x + 1);
+
+        __m128 gx = _mm_sub_ps(r0_p1, r0_m1);
+        gx = _mm_add_ps(gx, _mm_mul_ps(two, _mm_sub_ps(r1_p1, r1_m1)));
+        gx = _mm_add_ps(gx, _mm_sub_ps(r2_p1, r2_m1));
+
+        __m128 gy = _mm_sub_ps(r2_m1, r0_m1);
+        gy = _mm_add_ps(gy, _mm_mul_ps(two, _mm_sub_ps(r2_0, r0_0)));
+        gy = _mm_add_ps(gy, _mm_sub_ps(r2_p1, r0_p1));
+
+        _mm_storeu_ps(dx + x, gx);
+        _mm_storeu_ps(dy + x, gy);
+        _mm_storeu_ps(mg + x, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(gx, gx), _mm_mul_ps(gy, gy))));
+    }
+    GradientRowScalar(r0, r1, r2, dx, dy, mg, x, width);
+}
+
+NV_TARGET_AVX2
+static void GradientRowAvx2(
+    const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+    float* dx, float* dy, float* mg, int width)
+{
+    int x = 1;
+    // AVX2 path: process 8 pixels at a time
+    for (; x + 8 < width - 1; x += 8)
+    {
+        __m256 r0_m1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((__m128i*)(r0 + x - 1))));
+        __m256 r0_0  = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((__m128i*)(r0 + x))));
+        __m256 r0_p1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((__m128i*)(r0 + x + 1))));
+        __m256 r1_m1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((__m128i*)(r1 + x - 1))));
+        __m256 r1_p1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((__m128i*)(r1 + x + 1))));
+        __m256 r2_m1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((__m128i*)(r2 + x - 1))));
+        __m256 r2_0  = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((__m128i*)(r2 + x))));
+        __m256 r2_p1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((__m128i*)(r2 + x + 1))));
+
+        __m256 two = _mm256_set1_ps(2.0f);
+
+        // Gx = -r0_m1 + r0_p1 - 2*r1_m1 + 2*r1_p1 - r2_m1 + r2_p1
+        __m256 gx = _mm256_sub_ps(r0_p1, r0_m1);
+        gx = _mm256_fmadd_ps(two, _mm256_sub_ps(r1_p1, r1_m1), gx);
+        gx = _mm256_add_ps(gx, _mm256_sub_ps(r2_p1, r2_m1));
+
+        // Gy = -r0_m1 - 2*r0_0 - r0_p1 + r2_m1 + 2*r2_0 + r2_p1
+        __m256 gy = _mm256_sub_ps(r2_m1, r0_m1);
+        gy = _mm256_fmadd_ps(two, _mm256_sub_ps(r2_0, r0_0), gy);
+        gy = _mm256_add_ps(gy, _mm256_sub_ps(r2_p1, r0_p1));
+
+        // Magnitude = sqrt(gx² + gy²)
+        __m256 mag = _mm256_sqrt_ps(
+            _mm256_fmadd_ps(gx, gx, _mm256_mul_ps(gy, gy)));
+
+        _mm256_storeu_ps(dx + x, gx);
+        _mm256_storeu_ps(dy + x, gy);
+        _mm256_storeu_ps(mg + x, mag);
+    }
+    GradientRowScalar(r0, r1, r2, dx, dy, mg, x, width);
+}
+
+NV_TARGET_AVX512
+static void GradientRowAvx512(
+    const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+    float* dx, float* dy, float* mg, int width)
+{
+    __m512 two = _mm512_set1_ps(2.0f);
+    int x = 1;
+    // 16 pixels per iteration: one 128-bit load widened straight to 16 × int32
+    for (; x + 16 < width - 1; x += 16)
+    {
+        __m512 r0_m1 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(r0 + x - 1))));
+        __m512 r0_0  = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(r0 + x))));
+        __m512 r0_p1 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(r0 + x + 1))));
+        __m512 r1_m1 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(r1 + x - 1))));
+        __m512 r1_p1 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(r1 + x + 1))));
+        __m512 r2_m1 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(r2 + x - 1))));
+        __m512 r2_0  = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(r2 + x))));
+        __m512 r2_p1 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(r2 + x + 1))));
+
+        __m512 gx = _mm512_sub_ps(r0_p1, r0_m1);
+        gx = _mm512_fmadd_ps(two, _mm512_sub_ps(r1_p1, r1_m1), gx);
+        gx = _mm512_add_ps(gx, _mm512_sub_ps(r2_p1, r2_m1));
+
+        __m512 gy = _mm512_sub_ps(r2_m1, r0_m1);
+        gy = _mm512_fmadd_ps(two, _mm512_sub_ps(r2_0, r0_0), gy);
+        gy = _mm512_add_ps(gy, _mm512_sub_ps(r2_p1, r0_p1));
+
+        _mm512_storeu_ps(dx + x, gx);
+        _mm512_storeu_ps(dy + x, gy);
+        _mm512_storeu_ps(mg + x, _mm512_sqrt_ps(_mm512_fmadd_ps(gx, gx, _mm512_mul_ps(gy, gy))));
+    }
+    GradientRowScalar(r0, r1, r2, dx, dy, mg, x, width);
+}
+
+// ─── Compact fixed-point gradient row kernels ───────────────────────────────
+// Same Sobel, computed in int16 lanes. Output per pixel is one packed word
+// (dx in the low 16 bits, dy in the high 16 bits, both signed) plus an
+// optional uint16 magnitude rounded to the nearest integer: 4–6 bytes per
+// pixel instead of 12. |dx|,|dy| ≤ 1020 and dx²+dy² ≤ 2 080 800, so int16
+// lanes and the madd-based magnitude never overflow.
+
+static void GradientCompactRowScalar(
+    const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+    uint32_t* packed, uint16_t* mg, int x, int width)
+{
+    for (; x < width - 1; x++)
+    {
+        int gx = -r0[x-1] + r0[x+1] - 2*r1[x-1] + 2*r1[x+1] - r2[x-1] + r2[x+1];
+        int gy = -r0[x-1] - 2*r0[x] - r0[x+1] + r2[x-1] + 2*r2[x] + r2[x+1];
+        packed[x] = (uint16_t)gx | ((uint32_t)(uint16_t)gy << 16);
+        if (mg) mg[x] = (uint16_t)(sqrtf((float)(gx*gx + gy*gy)) + 0.5f);
+    }
+}
+
+static void GradientCompactRowPortable(
+    const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+    uint32_t* packed, uint16_t* mg, int width)
+{
+    GradientCompactRowScalar(r0, r1, r2, packed, mg, 1, width);
+}
+
+NV_TARGET_SSE41
+static void GradientCompactRowSse41(
+    const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+    uint32_t* packed, uint16_t* mg, int width)
+{
+    __m128 half = _mm_set1_ps(0.5f);
+    int x = 1;
+    // 8 pixels per iteration: 8-byte loads widened to 8 × int16
+    for (; x + 8 < width - 1; x += 8)
+    {
+        __m128i r0_m1 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r0 + x - 1)));
+        __m128i r0_0  = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r0 + x)));
+        __m128i r0_p1 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r0 + x + 1)));
+        __m128i r1_m1 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r1 + x - 1)));
+        __m128i r1_p1 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r1 + x + 1)));
+        __m128i r2_m1 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r2 + x - 1)));
+        __m128i r2_0  = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r2 + x)));
+        __m128i r2_p1 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r2 + x + 1)));
+
+        __m128i gx = _mm_add_epi16(_mm_sub_epi16(r0_p1, r0_m1), _mm_sub_epi16(r2_p1, r2_m1));
+        gx = _mm_add_epi16(gx, _mm_slli_epi16(_mm_sub_epi16(r1_p1, r1_m1), 1));
+        __m128i gy = _mm_add_epi16(_mm_sub_epi16(r2_m1, r0_m1), _mm_sub_epi16(r2_p1, r0_p1));
+        gy = _mm_add_epi16(gy, _mm_slli_epi16(_mm_sub_epi16(r2_0, r0_0), 1));
+
+        // Interleave to (dx, dy) pairs: pixels 0-3 and 4-7
+        __m128i p0 = _mm_unpacklo_epi16(gx, gy);
+        __m128i p1 = _mm_unpackhi_epi16(gx, gy);
+        _mm_storeu_si128((__m128i*)(packed + x), p0);
+        _mm_storeu_si128((__m128i*)(packed + x + 4), p1);
+
+        if (mg)
+        {
+            // madd on the pairs yields dx²+dy² per pixel directly
+            __m128i m0 = _mm_cvttps_epi32(_mm_add_ps(_mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(p0, p0))), half));
+            __m128i m1 = _mm_cvttps_epi32(_mm_add_ps(_mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(p1, p1))), half));
+            _mm_storeu_si128((__m128i*)(mg + x), _mm_packus_epi32(m0, m1));
+        }
+    }
+    GradientCompactRowScalar(r0, r1, r2, packed, mg, x, width);
+}
+
+NV_TARGET_AVX2
+static void GradientCompactRowAvx2(
+    const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+    uint32_t* packed, uint16_t* mg, int width)
+{
+    __m256 half = _mm256_set1_ps(0.5f);
+    int x = 1;
+    // 16 pixels per iteration: 16-byte loads widened to 16 × int16
+    for (; x + 16 < width - 1; x += 16)
+    {
+        __m256i r0_m1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r0 + x - 1)));
+        __m256i r0_0  = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r0 + x)));
+        __m256i r0_p1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r0 + x + 1)));
+        __m256i r1_m1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r1 + x - 1)));
+        __m256i r1_p1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r1 + x + 1)));
+        __m256i r2_m1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r2 + x - 1)));
+        __m256i r2_0  = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r2 + x)));
+        __m256i r2_p1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r2 + x + 1)));
+
+        __m256i gx = _mm256_add_epi16(_mm256_sub_epi16(r0_p1, r0_m1), _mm256_sub_epi16(r2_p1, r2_m1));
+        gx = _mm256_add_epi16(gx, _mm256_slli_epi16(_mm256_sub_epi16(r1_p1, r1_m1), 1));
+        __m256i gy = _mm256_add_epi16(_mm256_sub_epi16(r2_m1, r0_m1), _mm256_sub_epi16(r2_p1, r0_p1));
+        gy = _mm256_add_epi16(gy, _mm256_slli_epi16(_mm256_sub_epi16(r2_0, r0_0), 1));
 
-        int x = 1;
-        // AVX2 path: process 8 pixels at a time
-        for (; x + 8 < width - 1; x += 8)
-        {
-            // Load 10 bytes per row (need x-1 .. x+8) and convert to int32
-            // Simpler: load 3 columns per row as int16, compute
-            // Use scalar-promoted approach: load individual pixels
-            __m256 r0_m1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
-                _mm_loadl_epi64((__m128i*)(r0 + x - 1))));
-            __m256 r0_0  = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
-                _mm_loadl_epi64((__m128i*)(r0 + x))));
-            __m256 r0_p1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
-                _mm_loadl_epi64((__m128i*)(r0 + x + 1))));
-            __m256 r1_m1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
-                _mm_loadl_epi64((__m128i*)(r1 + x - 1))));
-            __m256 r1_p1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
-                _mm_loadl_epi64((__m128i*)(r1 + x + 1))));
-            __m256 r2_m1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
-                _mm_loadl_epi64((__m128i*)(r2 + x - 1))));
-            __m256 r2_0  = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
-                _mm_loadl_epi64((__m128i*)(r2 + x))));
-            __m256 r2_p1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
-                _mm_loadl_epi64((__m128i*)(r2 + x + 1))));
-
-            __m256 two = _mm256_set1_ps(2.0f);
-
-            // Gx = -r0_m1 + r0_p1 - 2*r1_m1 + 2*r1_p1 - r2_m1 + r2_p1
-            __m256 gx = _mm256_sub_ps(r0_p1, r0_m1);
-            gx = _mm256_fmadd_ps(two, _mm256_sub_ps(r1_p1, r1_m1), gx);
-            gx = _mm256_add_ps(gx, _mm256_sub_ps(r2_p1, r2_m1));
-
-            // Gy = -r0_m1 - 2*r0_0 - r0_p1 + r2_m1 + 2*r2_0 + r2_p1
-            __m256 gy = _mm256_sub_ps(r2_m1, r0_m1);
-            gy = _mm256_fmadd_ps(two, _mm256_sub_ps(r2_0, r0_0), gy);
-            gy = _mm256_add_ps(gy, _mm256_sub_ps(r2_p1, r0_p1));
-
-            // Magnitude = sqrt(gx² + gy²)
-            __m256 mag = _mm256_sqrt_ps(
-                _mm256_fmadd_ps(gx, gx, _mm256_mul_ps(gy, gy)));
-
-            _mm256_storeu_ps(dx + x, gx);
-            _mm256_storeu_ps(dy + x, gy);
-            _mm256_storeu_ps(mg + x, mag);
-        }
-
-        // Scalar remainder
-        for (; x < width - 1; x++)
-        {
-            float gx = -(float)r0[x-1] + (float)r0[x+1]
-                      - 2.0f*(float)r1[x-1] + 2.0f*(float)r1[x+1]
-                      - (float)r2[x-1] + (float)r2[x+1];
-            float gy = -(float)r0[x-1] - 2.0f*(float)r0[x] - (float)r0[x+1]
-                      + (float)r2[x-1] + 2.0f*(float)r2[x] + (float)r2[x+1];
-            dx[x] = gx;
-            dy[x] = gy;
-            mg[x] = sqrtf(gx*gx + gy*gy);
-        }
-    }
-}
-
-// ─── Per-pixel scoring (SIMD gather version) ─────────────────────────────────
+        // unpack works per 128-bit lane: lo = px 0-3 | 8-11, hi = px 4-7 | 12-15
+        __m256i lo = _mm256_unpacklo_epi16(gx, gy);
+        __m256i hi = _mm256_unpackhi_epi16(gx, gy);
+        __m256i p0 = _mm256_permute2x128_si256(lo, hi, 0x20);
+        __m256i p1 = _mm256_permute2x128_si256(lo, hi, 0x31);
+        _mm256_storeu_si256((__m256i*)(packed + x), p0);
+        _mm256_storeu_si256((__m256i*)(packed + x + 8), p1);
+
+        if (mg)
+        {
+            __m256i m0 = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_sqrt_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(p0, p0))), half));
+            __m256i m1 = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_sqrt_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(p1, p1))), half));
+            // packus is per lane too; restore pixel order with a qword permute
+            __m256i m = _mm256_permute4x64_epi64(_mm256_packus_epi32(m0, m1), 0xD8);
+            _mm256_storeu_si256((__m256i*)(mg + x), m);
+        }
+    }
+    GradientCompactRowScalar(r0, r1, r2, packed, mg, x, width);
+}
+
+NV_TARGET_AVX512
+static void GradientCompactRowAvx512(
+    const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+    uint32_t* packed, uint16_t* mg, int width)
+{
+    __m512 half = _mm512_set1_ps(0.5f);
+    __m512i pickLo = _mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11);
+    __m512i pickHi = _mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15);
+    int x = 1;
+    // 32 pixels per iteration: 32-byte loads widened to 32 × int16
+    for (; x + 32 < width - 1; x += 32)
+    {
+        __m512i r0_m1 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(r0 + x - 1)));
+        __m512i r0_0  = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(r0 + x)));
+        __m512i r0_p1 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(r0 + x + 1)));
+        __m512i r1_m1 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(r1 + x - 1)));
+        __m512i r1_p1 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(r1 + x + 1)));
+        __m512i r2_m1 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(r2 + x - 1)));
+        __m512i r2_0  = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(r2 + x)));
+        __m512i r2_p1 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(r2 + x + 1)));
+
+        __m512i gx = _mm512_add_epi16(_mm512_sub_epi16(r0_p1, r0_m1), _mm512_sub_epi16(r2_p1, r2_m1));
+        gx = _mm512_add_epi16(gx, _mm512_slli_epi16(_mm512_sub_epi16(r1_p1, r1_m1), 1));
+        __m512i gy = _mm512_add_epi16(_mm512_sub_epi16(r2_m1, r0_m1), _mm512_sub_epi16(r2_p1, r0_p1));
+        gy = _mm512_add_epi16(gy, _mm512_slli_epi16(_mm512_sub_epi16(r2_0, r0_0), 1));
+
+        // Per-lane unpack, then a two-source qword permute back to pixel order
+        __m512i lo = _mm512_unpacklo_epi16(gx, gy);
+        __m512i hi = _mm512_unpackhi_epi16(gx, gy);
+        __m512i p0 = _mm512_permutex2var_epi64(lo, pickLo, hi);
+        __m512i p1 = _mm512_permutex2var_epi64(lo, pickHi, hi);
+        _mm512_storeu_si512(packed + x, p0);
+        _mm512_storeu_si512(packed + x + 16, p1);
+
+        if (mg)
+        {
+            __m512i m0 = _mm512_cvttps_epi32(_mm512_add_ps(_mm512_sqrt_ps(_mm512_cvtepi32_ps(_mm512_madd_epi16(p0, p0))), half));
+            __m512i m1 = _mm512_cvttps_epi32(_mm512_add_ps(_mm512_sqrt_ps(_mm512_cvtepi32_ps(_mm512_madd_epi16(p1, p1))), half));
+            _mm256_storeu_si256((__m256i*)(mg + x), _mm512_cvtusepi32_epi16(m0));
+            _mm256_storeu_si256((__m256i*)(mg + x + 16), _mm512_cvtusepi32_epi16(m1));
+        }
+    }
+    GradientCompactRowScalar(r0, r1, r2, packed, mg, x, width);
+}
+
+// ─── Per-pixel scoring kernels ───────────────────────────────────────────────
 // offsets[i] = ry[i] * imgW + rx[i]  (pre-computed by caller)
+// All variants share the greedy early exit: once N/5 points are in, a running
+// mean below thresh*(1-greedy) rejects the pose. The mean is only tested every
+// EARLY_EXIT_STRIDE points and only inside the full strides, never on the
+// tail, so every ISA accepts or rejects a borderline pose alike.
 
-static double EvaluateNativeInternal(
+static const int EARLY_EXIT_STRIDE = 16;
+
+static inline bool EarlyExitCheckpoint(int done, int earlyN, int N)
+{
+    return (done & (EARLY_EXIT_STRIDE - 1)) == 0 && done >= earlyN &&
+           done < (N & ~(EARLY_EXIT_STRIDE - 1));
+}
+
+typedef double (*EvaluateKernel)(
     int px, int py,
     const int* __restrict offsets,
     const float* __restrict rdx, const float* __restrict rdy,
     const float* __restrict dxImg, const float* __restrict dyImg, const float* __restrict magImg,
-    int imgW, int N,
-    float thresh, float greedy,
-    int contrastInvariant)
+    int imgW, int N, float thresh, float greedy, int contrastInvariant);
+
+static double EvaluateScalar(
+    int px, int py,
+    const int* __restrict offsets,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const float* __restrict dxImg, const float* __restrict dyImg, const float* __restrict magImg,
+    int imgW, int N, float thresh, float greedy, int contrastInvariant)
+{
+    float sum = 0.0f;
+    int earlyN = N / 5;
+    float earlyThresh = thresh * (1.0f - greedy);
+    int base = py * imgW + px;
+
+    for (int i = 0; i < N; i++)
+    {
+        int idx = base + offsets[i];
+        float m = magImg[idx];
+        if (m > 0.001f)
+        {
+            float contrib = (rdx[i] * dxImg[idx] + rdy[i] * dyImg[idx]) / m;
+            sum += contrastInvariant ? fabsf(contrib) : contrib;
+        }
+        int done = i + 1;
+        if (EarlyExitCheckpoint(done, earlyN, N) && sum / done < earlyThresh)
+            return 0.0;
+    }
+    return (double)sum / N;
+}
+
+NV_TARGET_SSE41
+static double EvaluateSse41(
+    int px, int py,
+    const int* __restrict offsets,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const float* __restrict dxImg, const float* __restrict dyImg, const float* __restrict magImg,
+    int imgW, int N, float thresh, float greedy, int contrastInvariant)
+{
+    int earlyN = N / 5;
+    float earlyThresh = thresh * (1.0f - greedy);
+    int base = py * imgW + px;
+
+    __m128 vsum = _mm_setzero_ps();
+    __m128 veps = _mm_set1_ps(0.001f);
+    __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    // No gather before AVX2: four scalar loads per image, SIMD arithmetic
+    int vecN = N & ~3;
+    for (int i = 0; i < vecN; i += 4)
+    {
+        int i0 = base + offsets[i], i1 = base + offsets[i + 1];
+        int i2 = base + offsets[i + 2], i3 = base + offsets[i + 3];
+        __m128 vdx  = _mm_setr_ps(dxImg[i0], dxImg[i1], dxImg[i2], dxImg[i3]);
+        __m128 vdy  = _mm_setr_ps(dyImg[i0], dyImg[i1], dyImg[i2], dyImg[i3]);
+        __m128 vmag = _mm_setr_ps(magImg[i0], magImg[i1], magImg[i2], magImg[i3]);
+
+        __m128 dot = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(rdx + i), vdx),
+                                _mm_mul_ps(_mm_loadu_ps(rdy + i), vdy));
+        __m128 mask = _mm_cmpgt_ps(vmag, veps);
+        __m128 val = _mm_mul_ps(dot, _mm_and_ps(_mm_rcp_ps(vmag), mask));
+        if (contrastInvariant)
+            val = _mm_and_ps(val, absMask);
+        vsum = _mm_add_ps(vsum, val);
+
+        int done = i + 4;
+        if (EarlyExitCheckpoint(done, earlyN, N))
+        {
+            __m128 s = _mm_add_ps(vsum, _mm_movehl_ps(vsum, vsum));
+            s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+            if (_mm_cvtss_f32(s) / done < earlyThresh) return 0.0;
+        }
+    }
+
+    __m128 s = _mm_add_ps(vsum, _mm_movehl_ps(vsum, vsum));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    float sum = _mm_cvtss_f32(s);
+
+    for (int i = vecN; i < N; i++)
+    {
+        int idx = base + offsets[i];
+        float m = magImg[idx];
+        if (m > 0.001f)
+        {
+            float contrib = (rdx[i] * dxImg[idx] + rdy[i] * dyImg[idx]) / m;
+            sum += contrastInvariant ? fabsf(contrib) : contrib;
+        }
+    }
+
+    return (double)sum / N;
+}
+
+NV_TARGET_AVX2
+static double EvaluateAvx2(
+    int px, int py,
+    const int* __restrict offsets,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const float* __restrict dxImg, const float* __restrict dyImg, const float* __restrict magImg,
+    int imgW, int N, float thresh, float greedy, int contrastInvariant)
 {
     float sum = 0.0f;
     int earlyN = N / 5;
@@ -163,8 +595,8 @@ static double EvaluateNativeInternal(
 
         vsum = _mm256_add_ps(vsum, val);
 
-        // Early exit after earlyN points
-        if (i + 8 >= earlyN && i + 8 < vecN)
+        int done = i + 8;
+        if (EarlyExitCheckpoint(done, earlyN, N))
         {
             __m128 lo = _mm256_castps256_ps128(vsum);
             __m128 hi = _mm256_extractf128_ps(vsum, 1);
@@ -172,7 +604,7 @@ static double EvaluateNativeInternal(
             s = _mm_add_ps(s, _mm_movehl_ps(s, s));
             s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
             float partial = _mm_cvtss_f32(s);
-            if (partial / (i + 8) < earlyThresh) return 0.0;
+            if (partial / done < earlyThresh) return 0.0;
         }
     }
 
@@ -201,448 +633,7604 @@ static double EvaluateNativeInternal(
     return (double)sum / N;
 }
 
-// ─── Legacy per-pixel scoring (external API, signature unchanged) ────────────
-
-EXPORT double __cdecl EvaluateNative(
+NV_TARGET_AVX512
+static double EvaluateAvx512(
     int px, int py,
-    const int* __restrict rx, const int* __restrict ry,
+    const int* __restrict offsets,
     const float* __restrict rdx, const float* __restrict rdy,
     const float* __restrict dxImg, const float* __restrict dyImg, const float* __restrict magImg,
-    int imgW, int N,
-    float thresh, float greedy,
-    int contrastInvariant)
+    int imgW, int N, float thresh, float greedy, int contrastInvariant)
 {
-    // Build offsets on the fly for legacy callers
-    int alignedN = (N + 7) & ~7;
-    int* offsets = (int*)_aligned_malloc(alignedN * sizeof(int), 32);
-    if (!offsets) return 0.0;
-    for (int i = 0; i < N; i++)
-        offsets[i] = ry[i] * imgW + rx[i];
-    // Zero-pad remainder for safe SIMD load
-    for (int i = N; i < alignedN; i++)
-        offsets[i] = 0;
-
-    double result = EvaluateNativeInternal(
-        px, py, offsets, rdx, rdy, dxImg, dyImg, magImg,
-        imgW, N, thresh, greedy, contrastInvariant);
+    int earlyN = N / 5;
+    float earlyThresh = thresh * (1.0f - greedy);
 
-    _aligned_free(offsets);
-    return result;
-}
+    __m512 vsum = _mm512_setzero_ps();
+    __m512 veps = _mm512_set1_ps(0.001f);
+    __m512i vbase = _mm512_set1_epi32(py * imgW + px);
 
-// ─── Batch: score entire refinement grid for one pose ────────────────────────
+    // 16-wide gathers; the tail runs through the same loop under a lane mask
+    for (int i = 0; i < N; i += 16)
+    {
+        int rem = N - i;
+        __mmask16 lanes = rem >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << rem) - 1);
 
-EXPORT double __cdecl EvaluateBatchNative(
-    int baseCx, int baseCy, int refRadius,
-    const int* __restrict rx, const int* __restrict ry,
-    const float* __restrict rdx, const float* __restrict rdy,
-    const float* __restrict dxImg, const float* __restrict dyImg, const float* __restrict magImg,
-    int imgW, int imgH, int N, int margin,
-    float thresh, float greedy,
-    int* outDx, int* outDy,
-    int contrastInvariant)
-{
-    // Pre-compute offsets once for all grid positions
-    int alignedN = (N + 7) & ~7;
-    int* offsets = (int*)_aligned_malloc(alignedN * sizeof(int), 32);
-    if (!offsets) { *outDx = 0; *outDy = 0; return 0.0; }
-    for (int i = 0; i < N; i++)
-        offsets[i] = ry[i] * imgW + rx[i];
-    for (int i = N; i < alignedN; i++)
-        offsets[i] = 0;
+        __m512i vidx = _mm512_add_epi32(_mm512_maskz_loadu_epi32(lanes, offsets + i), vbase);
+        __m512 vdx  = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), lanes, vidx, dxImg,  4);
+        __m512 vdy  = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), lanes, vidx, dyImg,  4);
+        __m512 vmag = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), lanes, vidx, magImg, 4);
 
-    double bestScore = 0.0;
-    int bestDx = 0, bestDy = 0;
+        __m512 dot = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(lanes, rdx + i), vdx,
+                                     _mm512_mul_ps(_mm512_maskz_loadu_ps(lanes, rdy + i), vdy));
 
-    for (int dy = -refRadius; dy <= refRadius; dy++)
-    {
-        int py = baseCy + dy;
-        if (py < margin || py >= imgH - margin) continue;
+        // mag > eps lands in a mask register; masked-off lanes contribute zero
+        __mmask16 valid = _mm512_mask_cmp_ps_mask(lanes, vmag, veps, _CMP_GT_OS);
+        __m512 val = _mm512_maskz_mul_ps(valid, dot, _mm512_rcp14_ps(vmag));
 
-        for (int dx = -refRadius; dx <= refRadius; dx++)
-        {
-            int px = baseCx + dx;
-            if (px < margin || px >= imgW - margin) continue;
+        if (contrastInvariant)
+            val = _mm512_abs_ps(val);
 
-            double score = EvaluateNativeInternal(
-                px, py, offsets, rdx, rdy,
-                dxImg, dyImg, magImg,
-                imgW, N, thresh, greedy,
-                contrastInvariant);
+        vsum = _mm512_add_ps(vsum, val);
 
-            if (score > bestScore)
-            {
-                bestScore = score;
-                bestDx = dx;
-                bestDy = dy;
-            }
-        }
+        int done = i + 16;
+        if (EarlyExitCheckpoint(done, earlyN, N) &&
+            _mm512_reduce_add_ps(vsum) / done < earlyThresh)
+            return 0.0;
     }
 
-    _aligned_free(offsets);
-    *outDx = bestDx;
-    *outDy = bestDy;
-    return bestScore;
+    return (double)_mm512_reduce_add_ps(vsum) / N;
 }
 
-// ─── Native Hough Voting with OpenMP (Phase 1) ──────────────────────────────
+// ─── Per-pixel scoring kernels, compact gradient input ──────────────────────
+// One 32-bit load per model point fetches both dx and dy; the magnitude is
+// rebuilt as rsqrt(dx²+dy²), so neither a float plane nor a third gather is
+// needed. Gradients are integers, so "mag > eps" becomes dx²+dy² > 0.
 
-EXPORT void __cdecl HoughVotingNative(
-    const float* modelX, const float* modelY, int modelCount,
-    const int* binOffsets, const int* binIndices,
-    int numGradBins,
-    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
-    int voteWidth, int voteHeight,
-    double angleStart, double angleExtent,
-    double coarseAngleStep, double fineAngleStep,
-    int topK,
-    double invScale,
-    int binShiftBits,
-    double* outBestCx, double* outBestCy, double* outBestAngle, int* outBestVotes)
-{
-    const double PI = 3.14159265358979323846;
-    const double DEG2RAD = PI / 180.0;
+typedef double (*EvaluateCompactKernel)(
+    int px, int py,
+    const int* __restrict offsets,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const uint32_t* __restrict packed,
+    int imgW, int N, float thresh, float greedy, int contrastInvariant);
+
+static inline float CompactContribution(uint32_t g, float rdx, float rdy, int contrastInvariant)
+{
+    float gx = (float)(int16_t)(g & 0xFFFF);
+    float gy = (float)(int16_t)(g >> 16);
+    float m2 = gx * gx + gy * gy;
+    if (m2 <= 0.0f) return 0.0f;
+    float contrib = (rdx * gx + rdy * gy) / sqrtf(m2);
+    return contrastInvariant ? fabsf(contrib) : contrib;
+}
+
+static double EvaluateCompactScalar(
+    int px, int py,
+    const int* __restrict offsets,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const uint32_t* __restrict packed,
+    int imgW, int N, float thresh, float greedy, int contrastInvariant)
+{
+    float sum = 0.0f;
+    int earlyN = N / 5;
+    float earlyThresh = thresh * (1.0f - greedy);
+    const uint32_t* at = packed + py * imgW + px;
+
+    for (int i = 0; i < N; i++)
+    {
+        sum += CompactContribution(at[offsets[i]], rdx[i], rdy[i], contrastInvariant);
+        int done = i + 1;
+        if (EarlyExitCheckpoint(done, earlyN, N) && sum / done < earlyThresh)
+            return 0.0;
+    }
+    return (double)sum / N;
+}
+
+NV_TARGET_SSE41
+static double EvaluateCompactSse41(
+    int px, int py,
+    const int* __restrict offsets,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const uint32_t* __restrict packed,
+    int imgW, int N, float thresh, float greedy, int contrastInvariant)
+{
+    int earlyN = N / 5;
+    float earlyThresh = thresh * (1.0f - greedy);
+    const uint32_t* at = packed + py * imgW + px;
+
+    __m128 vsum = _mm_setzero_ps();
+    __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    int vecN = N & ~3;
+    for (int i = 0; i < vecN; i += 4)
+    {
+        __m128i g = _mm_setr_epi32((int)at[offsets[i]], (int)at[offsets[i + 1]],
+                                   (int)at[offsets[i + 2]], (int)at[offsets[i + 3]]);
+        __m128 gx = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(g, 16), 16));
+        __m128 gy = _mm_cvtepi32_ps(_mm_srai_epi32(g, 16));
+
+        __m128 dot = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(rdx + i), gx),
+                                _mm_mul_ps(_mm_loadu_ps(rdy + i), gy));
+        __m128 m2 = _mm_add_ps(_mm_mul_ps(gx, gx), _mm_mul_ps(gy, gy));
+        __m128 mask = _mm_cmpgt_ps(m2, _mm_setzero_ps());
+        __m128 val = _mm_mul_ps(dot, _mm_and_ps(_mm_rsqrt_ps(m2), mask));
+        if (contrastInvariant)
+            val = _mm_and_ps(val, absMask);
+        vsum = _mm_add_ps(vsum, val);
+
+        int done = i + 4;
+        if (EarlyExitCheckpoint(done, earlyN, N))
+        {
+            __m128 s = _mm_add_ps(vsum, _mm_movehl_ps(vsum, vsum));
+            s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+            if (_mm_cvtss_f32(s) / done < earlyThresh) return 0.0;
+        }
+    }
+
+    __m128 s = _mm_add_ps(vsum, _mm_movehl_ps(vsum, vsum));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    float sum = _mm_cvtss_f32(s);
+
+    for (int i = vecN; i < N; i++)
+        sum += CompactContribution(at[offsets[i]], rdx[i], rdy[i], contrastInvariant);
+
+    return (double)sum / N;
+}
+
+NV_TARGET_AVX2
+static double EvaluateCompactAvx2(
+    int px, int py,
+    const int* __restrict offsets,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const uint32_t* __restrict packed,
+    int imgW, int N, float thresh, float greedy, int contrastInvariant)
+{
+    int earlyN = N / 5;
+    float earlyThresh = thresh * (1.0f - greedy);
+
+    __m256 vsum = _mm256_setzero_ps();
+    __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    int base = py * imgW + px;
+    __m256i vbase = _mm256_set1_epi32(base);
+
+    int vecN = N & ~7;
+    for (int i = 0; i < vecN; i += 8)
+    {
+        __m256i vidx = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(offsets + i)), vbase);
+        __m256i g = _mm256_i32gather_epi32((const int*)packed, vidx, 4);
+        __m256 gx = _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(g, 16), 16));
+        __m256 gy = _mm256_cvtepi32_ps(_mm256_srai_epi32(g, 16));
+
+        __m256 dot = _mm256_fmadd_ps(_mm256_loadu_ps(rdx + i), gx,
+                                     _mm256_mul_ps(_mm256_loadu_ps(rdy + i), gy));
+        __m256 m2 = _mm256_fmadd_ps(gx, gx, _mm256_mul_ps(gy, gy));
+        __m256 mask = _mm256_cmp_ps(m2, _mm256_setzero_ps(), _CMP_GT_OS);
+        __m256 val = _mm256_mul_ps(dot, _mm256_and_ps(_mm256_rsqrt_ps(m2), mask));
+        if (contrastInvariant)
+            val = _mm256_and_ps(val, absMask);
+        vsum = _mm256_add_ps(vsum, val);
+
+        int done = i + 8;
+        if (EarlyExitCheckpoint(done, earlyN, N))
+        {
+            __m128 s = _mm_add_ps(_mm256_castps256_ps128(vsum), _mm256_extractf128_ps(vsum, 1));
+            s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+            s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+            if (_mm_cvtss_f32(s) / done < earlyThresh) return 0.0;
+        }
+    }
+
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(vsum), _mm256_extractf128_ps(vsum, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    float sum = _mm_cvtss_f32(s);
+
+    for (int i = vecN; i < N; i++)
+        sum += CompactContribution(packed[base + offsets[i]], rdx[i], rdy[i], contrastInvariant);
+
+    return (double)sum / N;
+}
+
+NV_TARGET_AVX512
+static double EvaluateCompactAvx512(
+    int px, int py,
+    const int* __restrict offsets,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const uint32_t* __restrict packed,
+    int imgW, int N, float thresh, float greedy, int contrastInvariant)
+{
+    int earlyN = N / 5;
+    float earlyThresh = thresh * (1.0f - greedy);
+
+    __m512 vsum = _mm512_setzero_ps();
+    __m512i vbase = _mm512_set1_epi32(py * imgW + px);
+
+    for (int i = 0; i < N; i += 16)
+    {
+        int rem = N - i;
+        __mmask16 lanes = rem >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << rem) - 1);
+
+        __m512i vidx = _mm512_add_epi32(_mm512_maskz_loadu_epi32(lanes, offsets + i), vbase);
+        __m512i g = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), lanes, vidx, packed, 4);
+        __m512 gx = _mm512_cvtepi32_ps(_mm512_srai_epi32(_mm512_slli_epi32(g, 16), 16));
+        __m512 gy = _mm512_cvtepi32_ps(_mm512_srai_epi32(g, 16));
+
+        __m512 dot = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(lanes, rdx + i), gx,
+                                     _mm512_mul_ps(_mm512_maskz_loadu_ps(lanes, rdy + i), gy));
+        __m512 m2 = _mm512_fmadd_ps(gx, gx, _mm512_mul_ps(gy, gy));
+        __mmask16 valid = _mm512_mask_cmp_ps_mask(lanes, m2, _mm512_setzero_ps(), _CMP_GT_OS);
+        __m512 val = _mm512_maskz_mul_ps(valid, dot, _mm512_rsqrt14_ps(m2));
+        if (contrastInvariant)
+            val = _mm512_abs_ps(val);
+        vsum = _mm512_add_ps(vsum, val);
+
+        int done = i + 16;
+        if (EarlyExitCheckpoint(done, earlyN, N) &&
+            _mm512_reduce_add_ps(vsum) / done < earlyThresh)
+            return 0.0;
+    }
+
+    return (double)_mm512_reduce_add_ps(vsum) / N;
+}
+
+// ─── Window scoring kernels (gather-free Phase 2) ───────────────────────────
+// Score one pose at every position of a refinement window at once. The
+// gradient comes from a GradientTile: per row, the unit x components followed
+// by the unit y components, so a model point contributes to a whole row of
+// window positions through two contiguous loads. acc is rows × accStride
+// (accStride a multiple of 16, 64-byte aligned); lanes past `cols` are
+// scratch. rowOff[i] is point i's offset from the window origin in the tile.
+
+typedef void (*WindowKernel)(
+    float* __restrict acc, int accStride, int rows, int cols,
+    const float* __restrict tile, int tileStride, int nyOffset,
+    const int* __restrict rowOff,
+    const float* __restrict rdx, const float* __restrict rdy,
+    int begin, int end, int contrastInvariant);
+
+static void WindowScalar(
+    float* __restrict acc, int accStride, int rows, int cols,
+    const float* __restrict tile, int tileStride, int nyOffset,
+    const int* __restrict rowOff,
+    const float* __restrict rdx, const float* __restrict rdy,
+    int begin, int end, int contrastInvariant)
+{
+    for (int r = 0; r < rows; r++)
+    {
+        float* accRow = acc + r * accStride;
+        const float* tileRow = tile + r * tileStride;
+        for (int c = 0; c < cols; c++)
+        {
+            float sum = accRow[c];
+            for (int i = begin; i < end; i++)
+            {
+                const float* g = tileRow + rowOff[i] + c;
+                float v = rdx[i] * g[0] + rdy[i] * g[nyOffset];
+                sum += contrastInvariant ? fabsf(v) : v;
+            }
+            accRow[c] = sum;
+        }
+    }
+}
+
+NV_TARGET_SSE41
+static void WindowSse41(
+    float* __restrict acc, int accStride, int rows, int cols,
+    const float* __restrict tile, int tileStride, int nyOffset,
+    const int* __restrict rowOff,
+    const float* __restrict rdx, const float* __restrict rdy,
+    int begin, int end, int contrastInvariant)
+{
+    __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    for (int r = 0; r < rows; r++)
+    {
+        float* accRow = acc + r * accStride;
+        const float* tileRow = tile + r * tileStride;
+        for (int c = 0; c < cols; c += 4)
+        {
+            __m128 sum = _mm_load_ps(accRow + c);
+            for (int i = begin; i < end; i++)
+            {
+                const float* g = tileRow + rowOff[i] + c;
+                __m128 v = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(rdx[i]), _mm_loadu_ps(g)),
+                                      _mm_mul_ps(_mm_set1_ps(rdy[i]), _mm_loadu_ps(g + nyOffset)));
+                if (contrastInvariant)
+                    v = _mm_and_ps(v, absMask);
+                sum = _mm_add_ps(sum, v);
+            }
+            _mm_store_ps(accRow + c, sum);
+        }
+    }
+}
+
+NV_TARGET_AVX2
+static void WindowAvx2(
+    float* __restrict acc, int accStride, int rows, int cols,
+    const float* __restrict tile, int tileStride, int nyOffset,
+    const int* __restrict rowOff,
+    const float* __restrict rdx, const float* __restrict rdy,
+    int begin, int end, int contrastInvariant)
+{
+    __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    for (int r = 0; r < rows; r++)
+    {
+        float* accRow = acc + r * accStride;
+        const float* tileRow = tile + r * tileStride;
+        for (int c = 0; c < cols; c += 8)
+        {
+            __m256 sum = _mm256_load_ps(accRow + c);
+            for (int i = begin; i < end; i++)
+            {
+                const float* g = tileRow + rowOff[i] + c;
+                __m256 v = _mm256_fmadd_ps(_mm256_broadcast_ss(rdx + i), _mm256_loadu_ps(g),
+                                           _mm256_mul_ps(_mm256_broadcast_ss(rdy + i),
+                                                         _mm256_loadu_ps(g + nyOffset)));
+                if (contrastInvariant)
+                    v = _mm256_and_ps(v, absMask);
+                sum = _mm256_add_ps(sum, v);
+            }
+            _mm256_store_ps(accRow + c, sum);
+        }
+    }
+}
+
+NV_TARGET_AVX512
+static void WindowAvx512(
+    float* __restrict acc, int accStride, int rows, int cols,
+    const float* __restrict tile, int tileStride, int nyOffset,
+    const int* __restrict rowOff,
+    const float* __restrict rdx, const float* __restrict rdy,
+    int begin, int end, int contrastInvariant)
+{
+    for (int r = 0; r < rows; r++)
+    {
+        float* accRow = acc + r * accStride;
+        const float* tileRow = tile + r * tileStride;
+        for (int c = 0; c < cols; c += 16)
+        {
+            __m512 sum = _mm512_load_ps(accRow + c);
+            for (int i = begin; i < end; i++)
+            {
+                const float* g = tileRow + rowOff[i] + c;
+                __m512 v = _mm512_fmadd_ps(_mm512_set1_ps(rdx[i]), _mm512_loadu_ps(g),
+                                           _mm512_mul_ps(_mm512_set1_ps(rdy[i]),
+                                                         _mm512_loadu_ps(g + nyOffset)));
+                if (contrastInvariant)
+                    v = _mm512_abs_ps(v);
+                sum = _mm512_add_ps(sum, v);
+            }
+            _mm512_store_ps(accRow + c, sum);
+        }
+    }
+}
+
+// ─── Hough vote kernels ─────────────────────────────────────────────────────
+// rotX/rotY hold the rotated model points in bin order (see RotateModelPoints),
+// so the three bins an edge votes with form at most two contiguous spans.
+// acc is a band of bH accumulator rows starting at row rowOrigin (0 and the
+// full height when the accumulator is not tiled). Cells are uint16: one cell
+// can collect at most modelCount << (2 * binShiftBits) votes per angle, and
+// the increment saturates rather than wraps should that ever exceed 65535.
+
+typedef void (*VoteKernel)(
+    uint16_t* acc, int bW, int bH, int rowOrigin,
+    const int* rotX, const int* rotY,
+    const int* binOffsets, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int binShift, int binShiftBits);
+
+// Spans of the bin-ordered point table for bins (b-1, b, b+1), split at wrap.
+static inline int NeighbourSpans(
+    const int* binOffsets, int numGradBins, int sb, int binShift,
+    int* spanBegin, int* spanEnd)
+{
+    if (numGradBins < 3)
+    {
+        for (int db = -1; db <= 1; db++)
+        {
+            int b = ((sb - binShift + db) % numGradBins + numGradBins) % numGradBins;
+            spanBegin[db + 1] = binOffsets[b];
+            spanEnd[db + 1] = binOffsets[b + 1];
+        }
+        return 3;
+    }
+
+    int lo = ((sb - binShift - 1) % numGradBins + numGradBins) % numGradBins;
+    int hi = lo + 3;
+    spanBegin[0] = binOffsets[lo];
+    if (hi <= numGradBins)
+    {
+        spanEnd[0] = binOffsets[hi];
+        return 1;
+    }
+    spanEnd[0] = binOffsets[numGradBins];
+    spanBegin[1] = binOffsets[0];
+    spanEnd[1] = binOffsets[hi - numGradBins];
+    return 2;
+}
+
+static inline void BumpVote(uint16_t* acc, int cell)
+{
+    uint16_t v = acc[cell];
+    acc[cell] = (uint16_t)(v + (v != 0xFFFF));
+}
+
+static inline void VoteSpanScalar(
+    uint16_t* acc, int bW, int bH, const int* rotX, const int* rotY,
+    int bi, int end, int ex, int ey, int binShiftBits)
+{
+    for (; bi < end; bi++)
+    {
+        int cx = (ex - rotX[bi]) >> binShiftBits;
+        int cy = (ey - rotY[bi]) >> binShiftBits;
+        if ((unsigned)cx < (unsigned)bW && (unsigned)cy < (unsigned)bH)
+            BumpVote(acc, cy * bW + cx);
+    }
+}
+
+static void VoteScalar(
+    uint16_t* acc, int bW, int bH, int rowOrigin,
+    const int* rotX, const int* rotY,
+    const int* binOffsets, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int binShift, int binShiftBits)
+{
+    int spanBegin[3], spanEnd[3];
+    int yOrigin = rowOrigin << binShiftBits;
+    for (int si = 0; si < searchEdgeCount; si++)
+    {
+        int ex = searchX[si], ey = searchY[si] - yOrigin;
+        int spans = NeighbourSpans(binOffsets, numGradBins, searchBin[si], binShift, spanBegin, spanEnd);
+        for (int s = 0; s < spans; s++)
+            VoteSpanScalar(acc, bW, bH, rotX, rotY, spanBegin[s], spanEnd[s], ex, ey, binShiftBits);
+    }
+}
+
+// SIMD variants compute cell indices and the in-bounds test for a whole
+// vector, then increment the surviving lanes one by one: several lanes may
+// hit the same cell, so a plain scatter would lose votes.
+
+NV_TARGET_SSE41
+static void VoteSse41(
+    uint16_t* acc, int bW, int bH, int rowOrigin,
+    const int* rotX, const int* rotY,
+    const int* binOffsets, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int binShift, int binShiftBits)
+{
+    __m128i vbW = _mm_set1_epi32(bW);
+    __m128i vmaxX = _mm_set1_epi32(bW - 1), vmaxY = _mm_set1_epi32(bH - 1);
+    __m128i vshift = _mm_cvtsi32_si128(binShiftBits);
+    alignas(16) int cell[4];
+    int spanBegin[3], spanEnd[3];
+    int yOrigin = rowOrigin << binShiftBits;
+
+    for (int si = 0; si < searchEdgeCount; si++)
+    {
+        int ex = searchX[si], ey = searchY[si] - yOrigin;
+        __m128i vex = _mm_set1_epi32(ex), vey = _mm_set1_epi32(ey);
+        int spans = NeighbourSpans(binOffsets, numGradBins, searchBin[si], binShift, spanBegin, spanEnd);
+        for (int s = 0; s < spans; s++)
+        {
+            int bi = spanBegin[s], end = spanEnd[s];
+            for (; bi + 4 <= end; bi += 4)
+            {
+                __m128i cx = _mm_sra_epi32(_mm_sub_epi32(vex, _mm_loadu_si128((const __m128i*)(rotX + bi))), vshift);
+                __m128i cy = _mm_sra_epi32(_mm_sub_epi32(vey, _mm_loadu_si128((const __m128i*)(rotY + bi))), vshift);
+                // Unsigned compare: negative values wrap above the limit
+                __m128i ok = _mm_and_si128(
+                    _mm_cmpeq_epi32(_mm_min_epu32(cx, vmaxX), cx),
+                    _mm_cmpeq_epi32(_mm_min_epu32(cy, vmaxY), cy));
+                unsigned mask = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(ok));
+                if (!mask) continue;
+                _mm_store_si128((__m128i*)cell, _mm_add_epi32(_mm_mullo_epi32(cy, vbW), cx));
+                for (; mask; mask &= mask - 1)
+                    BumpVote(acc, cell[Ctz32(mask)]);
+            }
+            VoteSpanScalar(acc, bW, bH, rotX, rotY, bi, end, ex, ey, binShiftBits);
+        }
+    }
+}
+
+NV_TARGET_AVX2
+static void VoteAvx2(
+    uint16_t* acc, int bW, int bH, int rowOrigin,
+    const int* rotX, const int* rotY,
+    const int* binOffsets, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int binShift, int binShiftBits)
+{
+    __m256i vbW = _mm256_set1_epi32(bW);
+    __m256i vmaxX = _mm256_set1_epi32(bW - 1), vmaxY = _mm256_set1_epi32(bH - 1);
+    __m128i vshift = _mm_cvtsi32_si128(binShiftBits);
+    alignas(32) int cell[8];
+    int spanBegin[3], spanEnd[3];
+    int yOrigin = rowOrigin << binShiftBits;
+
+    for (int si = 0; si < searchEdgeCount; si++)
+    {
+        int ex = searchX[si], ey = searchY[si] - yOrigin;
+        __m256i vex = _mm256_set1_epi32(ex), vey = _mm256_set1_epi32(ey);
+        int spans = NeighbourSpans(binOffsets, numGradBins, searchBin[si], binShift, spanBegin, spanEnd);
+        for (int s = 0; s < spans; s++)
+        {
+            int bi = spanBegin[s], end = spanEnd[s];
+            for (; bi + 8 <= end; bi += 8)
+            {
+                __m256i cx = _mm256_sra_epi32(_mm256_sub_epi32(vex, _mm256_loadu_si256((const __m256i*)(rotX + bi))), vshift);
+                __m256i cy = _mm256_sra_epi32(_mm256_sub_epi32(vey, _mm256_loadu_si256((const __m256i*)(rotY + bi))), vshift);
+                __m256i ok = _mm256_and_si256(
+                    _mm256_cmpeq_epi32(_mm256_min_epu32(cx, vmaxX), cx),
+                    _mm256_cmpeq_epi32(_mm256_min_epu32(cy, vmaxY), cy));
+                unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(ok));
+                if (!mask) continue;
+                _mm256_store_si256((__m256i*)cell, _mm256_add_epi32(_mm256_mullo_epi32(cy, vbW), cx));
+                for (; mask; mask &= mask - 1)
+                    BumpVote(acc, cell[Ctz32(mask)]);
+            }
+            VoteSpanScalar(acc, bW, bH, rotX, rotY, bi, end, ex, ey, binShiftBits);
+        }
+    }
+}
+
+NV_TARGET_AVX512
+static void VoteAvx512(
+    uint16_t* acc, int bW, int bH, int rowOrigin,
+    const int* rotX, const int* rotY,
+    const int* binOffsets, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int binShift, int binShiftBits)
+{
+    __m512i vbW = _mm512_set1_epi32(bW), vbH = _mm512_set1_epi32(bH);
+    __m128i vshift = _mm_cvtsi32_si128(binShiftBits);
+    alignas(64) int cell[16];
+    int spanBegin[3], spanEnd[3];
+    int yOrigin = rowOrigin << binShiftBits;
+
+    for (int si = 0; si < searchEdgeCount; si++)
+    {
+        __m512i vex = _mm512_set1_epi32(searchX[si]), vey = _mm512_set1_epi32(searchY[si] - yOrigin);
+        int spans = NeighbourSpans(binOffsets, numGradBins, searchBin[si], binShift, spanBegin, spanEnd);
+        for (int s = 0; s < spans; s++)
+        {
+            int end = spanEnd[s];
+            for (int bi = spanBegin[s]; bi < end; bi += 16)
+            {
+                int rem = end - bi;
+                __mmask16 lanes = rem >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << rem) - 1);
+                __m512i cx = _mm512_sra_epi32(_mm512_sub_epi32(vex, _mm512_maskz_loadu_epi32(lanes, rotX + bi)), vshift);
+                __m512i cy = _mm512_sra_epi32(_mm512_sub_epi32(vey, _mm512_maskz_loadu_epi32(lanes, rotY + bi)), vshift);
+                __mmask16 ok = _mm512_mask_cmplt_epu32_mask(
+                    _mm512_mask_cmplt_epu32_mask(lanes, cx, vbW), cy, vbH);
+                if (!ok) continue;
+                // Pack surviving cell indices to the front, then bump them
+                _mm512_mask_compressstoreu_epi32(cell, ok, _mm512_add_epi32(_mm512_mullo_epi32(cy, vbW), cx));
+                int hits = PopCount32(ok);
+                for (int h = 0; h < hits; h++)
+                    BumpVote(acc, cell[h]);
+            }
+        }
+    }
+}
+
+// ─── Accumulator peak kernels ───────────────────────────────────────────────
+// Largest cell of a vote accumulator and the first index holding it (index 0
+// when every cell is zero), exactly what a scalar "v > best" scan reports.
+// One pass for the maximum, then a compare pass that stops at its first hit.
+
+typedef int (*PeakKernel)(const uint16_t* acc, int len, int* outIdx);
+
+static int PeakScalar(const uint16_t* acc, int len, int* outIdx)
+{
+    int best = 0, idx = 0;
+    for (int i = 0; i < len; i++)
+        if (acc[i] > best) { best = acc[i]; idx = i; }
+    *outIdx = idx;
+    return best;
+}
+
+NV_TARGET_SSE41
+static inline int HorizontalMaxU16(__m128i v)
+{
+    // minpos finds the smallest lane, so search the complement
+    __m128i inv = _mm_xor_si128(v, _mm_set1_epi16(-1));
+    return 0xFFFF - (_mm_cvtsi128_si32(_mm_minpos_epu16(inv)) & 0xFFFF);
+}
+
+NV_TARGET_SSE41
+static int PeakSse41(const uint16_t* acc, int len, int* outIdx)
+{
+    __m128i vmax = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 8 <= len; i += 8)
+        vmax = _mm_max_epu16(vmax, _mm_loadu_si128((const __m128i*)(acc + i)));
+    int best = HorizontalMaxU16(vmax);
+    for (; i < len; i++)
+        if (acc[i] > best) best = acc[i];
+
+    *outIdx = 0;
+    if (best == 0) return 0;
+    __m128i target = _mm_set1_epi16((short)best);
+    for (i = 0; i + 8 <= len; i += 8)
+    {
+        unsigned hit = (unsigned)_mm_movemask_epi8(
+            _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(acc + i)), target));
+        if (hit) { *outIdx = i + Ctz32(hit) / 2; return best; }
+    }
+    for (; acc[i] != best; i++) {}
+    *outIdx = i;
+    return best;
+}
+
+NV_TARGET_AVX2
+static int PeakAvx2(const uint16_t* acc, int len, int* outIdx)
+{
+    __m256i vmax = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 16 <= len; i += 16)
+        vmax = _mm256_max_epu16(vmax, _mm256_loadu_si256((const __m256i*)(acc + i)));
+    int best = HorizontalMaxU16(_mm_max_epu16(_mm256_castsi256_si128(vmax),
+                                              _mm256_extracti128_si256(vmax, 1)));
+    for (; i < len; i++)
+        if (acc[i] > best) best = acc[i];
+
+    *outIdx = 0;
+    if (best == 0) return 0;
+    __m256i target = _mm256_set1_epi16((short)best);
+    for (i = 0; i + 16 <= len; i += 16)
+    {
+        unsigned hit = (unsigned)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i*)(acc + i)), target));
+        if (hit) { *outIdx = i + Ctz32(hit) / 2; return best; }
+    }
+    for (; acc[i] != best; i++) {}
+    *outIdx = i;
+    return best;
+}
+
+NV_TARGET_AVX512
+static int PeakAvx512(const uint16_t* acc, int len, int* outIdx)
+{
+    __m512i vmax = _mm512_setzero_si512();
+    for (int i = 0; i < len; i += 32)
+    {
+        int rem = len - i;
+        __mmask32 lanes = rem >= 32 ? (__mmask32)0xFFFFFFFFu : (__mmask32)((1u << rem) - 1);
+        vmax = _mm512_max_epu16(vmax, _mm512_maskz_loadu_epi16(lanes, acc + i));
+    }
+    alignas(64) uint16_t lane[32];
+    _mm512_store_si512(lane, vmax);
+    int best = 0;
+    for (int l = 0; l < 32; l++)
+        if (lane[l] > best) best = lane[l];
+
+    *outIdx = 0;
+    if (best == 0) return 0;
+    __m512i target = _mm512_set1_epi16((short)best);
+    for (int i = 0; i < len; i += 32)
+    {
+        int rem = len - i;
+        __mmask32 lanes = rem >= 32 ? (__mmask32)0xFFFFFFFFu : (__mmask32)((1u << rem) - 1);
+        __mmask32 hit = _mm512_mask_cmpeq_epi16_mask(lanes, _mm512_maskz_loadu_epi16(lanes, acc + i), target);
+        if (hit) { *outIdx = i + Ctz32((unsigned)hit); return best; }
+    }
+    return best;
+}
+
+// ─── Caliper projection row kernels ─────────────────────────────────────────
+// Bilinearly sample `count` points of a uint8 image along one row of a caliper
+// — (x0, y0) + c·(sx, sy) — and add weight × sample to acc[c]. The caller
+// guarantees every sample satisfies 0 <= x <= width-4, 0 <= y <= height-2, so
+// the 4-byte loads at x (two taps plus two spare bytes) stay in the image.
+// Weights and interpolation run in float; lanes differ from the scalar
+// kernel only by FMA rounding.
+
+typedef void (*ProjectKernel)(
+    const uint8_t* __restrict img, int stride,
+    float x0, float y0, float sx, float sy, int count, float weight,
+    float* __restrict acc);
+
+static inline float BilinearU8(const uint8_t* img, int stride, float x, float y)
+{
+    int xi = (int)x, yi = (int)y;
+    float fx = x - (float)xi, fy = y - (float)yi;
+    const uint8_t* p = img + (size_t)yi * stride + xi;
+    float top = p[0] + fx * ((float)p[1] - (float)p[0]);
+    float bot = p[stride] + fx * ((float)p[stride + 1] - (float)p[stride]);
+    return top + fy * (bot - top);
+}
+
+static void ProjectScalar(
+    const uint8_t* __restrict img, int stride,
+    float x0, float y0, float sx, float sy, int count, float weight,
+    float* __restrict acc)
+{
+    for (int c = 0; c < count; c++)
+        acc[c] += weight * BilinearU8(img, stride, x0 + c * sx, y0 + c * sy);
+}
+
+static inline int Load32(const uint8_t* p)
+{
+    int v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+NV_TARGET_SSE41
+static void ProjectSse41(
+    const uint8_t* __restrict img, int stride,
+    float x0, float y0, float sx, float sy, int count, float weight,
+    float* __restrict acc)
+{
+    // No gather before AVX2: offsets and weights stay vectorised, the four
+    // lanes are loaded one by one
+    const __m128 lane = _mm_setr_ps(0, 1, 2, 3);
+    const __m128i lowByte = _mm_set1_epi32(0xFF);
+    const __m128i strideV = _mm_set1_epi32(stride);
+    const __m128 w = _mm_set1_ps(weight);
+    alignas(16) int off[4];
+    int c = 0;
+    for (; c + 4 <= count; c += 4)
+    {
+        __m128 cf = _mm_add_ps(_mm_set1_ps((float)c), lane);
+        __m128 x = _mm_add_ps(_mm_set1_ps(x0), _mm_mul_ps(cf, _mm_set1_ps(sx)));
+        __m128 y = _mm_add_ps(_mm_set1_ps(y0), _mm_mul_ps(cf, _mm_set1_ps(sy)));
+        __m128i xi = _mm_cvttps_epi32(x), yi = _mm_cvttps_epi32(y);
+        __m128 fx = _mm_sub_ps(x, _mm_cvtepi32_ps(xi));
+        __m128 fy = _mm_sub_ps(y, _mm_cvtepi32_ps(yi));
+        _mm_store_si128((__m128i*)off, _mm_add_epi32(_mm_mullo_epi32(yi, strideV), xi));
+
+        __m128i t = _mm_setr_epi32(Load32(img + off[0]), Load32(img + off[1]),
+                                   Load32(img + off[2]), Load32(img + off[3]));
+        __m128i b = _mm_setr_epi32(Load32(img + off[0] + stride), Load32(img + off[1] + stride),
+                                   Load32(img + off[2] + stride), Load32(img + off[3] + stride));
+        __m128 p00 = _mm_cvtepi32_ps(_mm_and_si128(t, lowByte));
+        __m128 p10 = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(t, 8), lowByte));
+        __m128 p01 = _mm_cvtepi32_ps(_mm_and_si128(b, lowByte));
+        __m128 p11 = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(b, 8), lowByte));
+        __m128 top = _mm_add_ps(p00, _mm_mul_ps(fx, _mm_sub_ps(p10, p00)));
+        __m128 bot = _mm_add_ps(p01, _mm_mul_ps(fx, _mm_sub_ps(p11, p01)));
+        __m128 v = _mm_add_ps(top, _mm_mul_ps(fy, _mm_sub_ps(bot, top)));
+        _mm_storeu_ps(acc + c, _mm_add_ps(_mm_loadu_ps(acc + c), _mm_mul_ps(w, v)));
+    }
+    for (; c < count; c++)
+        acc[c] += weight * BilinearU8(img, stride, x0 + c * sx, y0 + c * sy);
+}
+
+NV_TARGET_AVX2
+static void ProjectAvx2(
+    const uint8_t* __restrict img, int stride,
+    float x0, float y0, float sx, float sy, int count, float weight,
+    float* __restrict acc)
+{
+    const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i lowByte = _mm256_set1_epi32(0xFF);
+    const __m256i strideV = _mm256_set1_epi32(stride);
+    const __m256 w = _mm256_set1_ps(weight);
+    const int* top32 = (const int*)img;
+    const int* bot32 = (const int*)(img + stride);
+    int c = 0;
+    for (; c + 8 <= count; c += 8)
+    {
+        __m256 cf = _mm256_add_ps(_mm256_set1_ps((float)c), lane);
+        __m256 x = _mm256_fmadd_ps(cf, _mm256_set1_ps(sx), _mm256_set1_ps(x0));
+        __m256 y = _mm256_fmadd_ps(cf, _mm256_set1_ps(sy), _mm256_set1_ps(y0));
+        __m256i xi = _mm256_cvttps_epi32(x), yi = _mm256_cvttps_epi32(y);
+        __m256 fx = _mm256_sub_ps(x, _mm256_cvtepi32_ps(xi));
+        __m256 fy = _mm256_sub_ps(y, _mm256_cvtepi32_ps(yi));
+        __m256i off = _mm256_add_epi32(_mm256_mullo_epi32(yi, strideV), xi);
+
+        // One 32-bit gather per row brings both horizontal taps
+        __m256i t = _mm256_i32gather_epi32(top32, off, 1);
+        __m256i b = _mm256_i32gather_epi32(bot32, off, 1);
+        __m256 p00 = _mm256_cvtepi32_ps(_mm256_and_si256(t, lowByte));
+        __m256 p10 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(t, 8), lowByte));
+        __m256 p01 = _mm256_cvtepi32_ps(_mm256_and_si256(b, lowByte));
+        __m256 p11 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(b, 8), lowByte));
+        __m256 top = _mm256_fmadd_ps(fx, _mm256_sub_ps(p10, p00), p00);
+        __m256 bot = _mm256_fmadd_ps(fx, _mm256_sub_ps(p11, p01), p01);
+        __m256 v = _mm256_fmadd_ps(fy, _mm256_sub_ps(bot, top), top);
+        _mm256_storeu_ps(acc + c, _mm256_fmadd_ps(w, v, _mm256_loadu_ps(acc + c)));
+    }
+    for (; c < count; c++)
+        acc[c] += weight * BilinearU8(img, stride, x0 + c * sx, y0 + c * sy);
+}
+
+NV_TARGET_AVX512
+static void ProjectAvx512(
+    const uint8_t* __restrict img, int stride,
+    float x0, float y0, float sx, float sy, int count, float weight,
+    float* __restrict acc)
+{
+    const __m512 lane = _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i lowByte = _mm512_set1_epi32(0xFF);
+    const __m512i strideV = _mm512_set1_epi32(stride);
+    const __m512 w = _mm512_set1_ps(weight);
+    int c = 0;
+    for (; c + 16 <= count; c += 16)
+    {
+        __m512 cf = _mm512_add_ps(_mm512_set1_ps((float)c), lane);
+        __m512 x = _mm512_fmadd_ps(cf, _mm512_set1_ps(sx), _mm512_set1_ps(x0));
+        __m512 y = _mm512_fmadd_ps(cf, _mm512_set1_ps(sy), _mm512_set1_ps(y0));
+        __m512i xi = _mm512_cvttps_epi32(x), yi = _mm512_cvttps_epi32(y);
+        __m512 fx = _mm512_sub_ps(x, _mm512_cvtepi32_ps(xi));
+        __m512 fy = _mm512_sub_ps(y, _mm512_cvtepi32_ps(yi));
+        __m512i off = _mm512_add_epi32(_mm512_mullo_epi32(yi, strideV), xi);
+
+        __m512i t = _mm512_i32gather_epi32(off, img, 1);
+        __m512i b = _mm512_i32gather_epi32(off, img + stride, 1);
+        __m512 p00 = _mm512_cvtepi32_ps(_mm512_and_si512(t, lowByte));
+        __m512 p10 = _mm512_cvtepi32_ps(_mm512_and_si512(_mm512_srli_epi32(t, 8), lowByte));
+        __m512 p01 = _mm512_cvtepi32_ps(_mm512_and_si512(b, lowByte));
+        __m512 p11 = _mm512_cvtepi32_ps(_mm512_and_si512(_mm512_srli_epi32(b, 8), lowByte));
+        __m512 top = _mm512_fmadd_ps(fx, _mm512_sub_ps(p10, p00), p00);
+        __m512 bot = _mm512_fmadd_ps(fx, _mm512_sub_ps(p11, p01), p01);
+        __m512 v = _mm512_fmadd_ps(fy, _mm512_sub_ps(bot, top), top);
+        _mm512_storeu_ps(acc + c, _mm512_fmadd_ps(w, v, _mm512_loadu_ps(acc + c)));
+    }
+    for (; c < count; c++)
+        acc[c] += weight * BilinearU8(img, stride, x0 + c * sx, y0 + c * sy);
+}
+
+// ─── Threshold row kernels (blob labeling) ──────────────────────────────────
+// Binarise one row: bit x of `bits` is set when row[x] > thresh (or, with
+// invert, when row[x] <= thresh), matching THRESH_BINARY / BINARY_INV on
+// 8-bit input. bits holds (width+63)/64 words; bits past width are cleared.
+// `out` (optional) receives the 0/255 mask of the same row.
+
+typedef void (*BinarizeKernel)(
+    const uint8_t* __restrict row, int width, int thresh, int invert,
+    uint64_t* __restrict bits, uint8_t* __restrict out);
+
+static inline void BinarizeTail(
+    const uint8_t* row, int x, int width, int thresh, int invert, uint64_t* bits, uint8_t* out)
+{
+    for (; x < width; x++)
+    {
+        bool on = (row[x] > thresh) != (invert != 0);
+        if (on) bits[x >> 6] |= 1ull << (x & 63);
+        if (out) out[x] = on ? 255 : 0;
+    }
+}
+
+static void BinarizeScalar(
+    const uint8_t* __restrict row, int width, int thresh, int invert,
+    uint64_t* __restrict bits, uint8_t* __restrict out)
+{
+    memset(bits, 0, ((width + 63) / 64) * sizeof(uint64_t));
+    BinarizeTail(row, 0, width, thresh, invert, bits, out);
+}
+
+NV_TARGET_SSE41
+static void BinarizeSse41(
+    const uint8_t* __restrict row, int width, int thresh, int invert,
+    uint64_t* __restrict bits, uint8_t* __restrict out)
+{
+    memset(bits, 0, ((width + 63) / 64) * sizeof(uint64_t));
+    if (thresh >= 255) { BinarizeTail(row, 0, width, thresh, invert, bits, out); return; }
+    // Unsigned v > t as a signed compare after flipping the sign bits
+    const __m128i bias = _mm_set1_epi8((char)0x80);
+    const __m128i t = _mm_set1_epi8((char)(thresh ^ 0x80));
+    const __m128i flip = invert ? _mm_set1_epi8(-1) : _mm_setzero_si128();
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(row + x)), bias);
+        __m128i on = _mm_xor_si128(_mm_cmpgt_epi8(v, t), flip);
+        bits[x >> 6] |= (uint64_t)(unsigned)_mm_movemask_epi8(on) << (x & 63);
+        if (out) _mm_storeu_si128((__m128i*)(out + x), on);
+    }
+    BinarizeTail(row, x, width, thresh, invert, bits, out);
+}
+
+NV_TARGET_AVX2
+static void BinarizeAvx2(
+    const uint8_t* __restrict row, int width, int thresh, int invert,
+    uint64_t* __restrict bits, uint8_t* __restrict out)
+{
+    memset(bits, 0, ((width + 63) / 64) * sizeof(uint64_t));
+    if (thresh >= 255) { BinarizeTail(row, 0, width, thresh, invert, bits, out); return; }
+    const __m256i bias = _mm256_set1_epi8((char)0x80);
+    const __m256i t = _mm256_set1_epi8((char)(thresh ^ 0x80));
+    const __m256i flip = invert ? _mm256_set1_epi8(-1) : _mm256_setzero_si256();
+    int x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(row + x)), bias);
+        __m256i on = _mm256_xor_si256(_mm256_cmpgt_epi8(v, t), flip);
+        bits[x >> 6] |= (uint64_t)(unsigned)_mm256_movemask_epi8(on) << (x & 63);
+        if (out) _mm256_storeu_si256((__m256i*)(out + x), on);
+    }
+    BinarizeTail(row, x, width, thresh, invert, bits, out);
+}
+
+NV_TARGET_AVX512
+static void BinarizeAvx512(
+    const uint8_t* __restrict row, int width, int thresh, int invert,
+    uint64_t* __restrict bits, uint8_t* __restrict out)
+{
+    const __m512i t = _mm512_set1_epi8((char)thresh);
+    const uint64_t flip = invert ? ~0ull : 0ull;
+    int words = (width + 63) / 64;
+    for (int i = 0; i < words; i++)
+    {
+        int x = i * 64, rem = width - x;
+        __mmask64 lanes = rem >= 64 ? ~(__mmask64)0 : (((__mmask64)1 << rem) - 1);
+        __m512i v = _mm512_maskz_loadu_epi8(lanes, row + x);
+        uint64_t on = ((uint64_t)_mm512_cmpgt_epu8_mask(v, t) ^ flip) & (uint64_t)lanes;
+        bits[i] = on;
+        if (out) _mm512_mask_storeu_epi8(out + x, lanes, _mm512_movm_epi8((__mmask64)on));
+    }
+}
+
+// ─── Response-map kernels (LINE-2D Phase 1) ─────────────────────────────────
+// A template is scored by adding, per feature, one shifted row of a
+// linearised response map to a byte accumulator with unsigned saturation.
+// Responses are at most RESPONSE_MAX, so the bytes are folded into the
+// 16-bit score (and cleared) every RESPONSE_CHUNK features, before any sum
+// could saturate; the fold itself saturates at 65535.
+
+typedef void (*ResponseAddKernel)(uint8_t* acc, const uint8_t* src, int len);
+typedef void (*ResponseFoldKernel)(uint16_t* score, uint8_t* acc, int len);
+
+static void ResponseAddScalar(uint8_t* acc, const uint8_t* src, int len)
+{
+    for (int i = 0; i < len; i++)
+    {
+        int v = acc[i] + src[i];
+        acc[i] = (uint8_t)(v > 255 ? 255 : v);
+    }
+}
+
+static void ResponseFoldScalar(uint16_t* score, uint8_t* acc, int len)
+{
+    for (int i = 0; i < len; i++)
+    {
+        int v = score[i] + acc[i];
+        score[i] = (uint16_t)(v > 0xFFFF ? 0xFFFF : v);
+        acc[i] = 0;
+    }
+}
+
+NV_TARGET_SSE41
+static void ResponseAddSse41(uint8_t* acc, const uint8_t* src, int len)
+{
+    int i = 0;
+    for (; i + 16 <= len; i += 16)
+        _mm_storeu_si128((__m128i*)(acc + i), _mm_adds_epu8(
+            _mm_loadu_si128((const __m128i*)(acc + i)), _mm_loadu_si128((const __m128i*)(src + i))));
+    ResponseAddScalar(acc + i, src + i, len - i);
+}
+
+NV_TARGET_SSE41
+static void ResponseFoldSse41(uint16_t* score, uint8_t* acc, int len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(acc + i));
+        __m128i* s = (__m128i*)(score + i);
+        _mm_storeu_si128(s, _mm_adds_epu16(_mm_loadu_si128(s), _mm_unpacklo_epi8(a, zero)));
+        _mm_storeu_si128(s + 1, _mm_adds_epu16(_mm_loadu_si128(s + 1), _mm_unpackhi_epi8(a, zero)));
+        _mm_storeu_si128((__m128i*)(acc + i), zero);
+    }
+    ResponseFoldScalar(score + i, acc + i, len - i);
+}
+
+NV_TARGET_AVX2
+static void ResponseAddAvx2(uint8_t* acc, const uint8_t* src, int len)
+{
+    int i = 0;
+    for (; i + 32 <= len; i += 32)
+        _mm256_storeu_si256((__m256i*)(acc + i), _mm256_adds_epu8(
+            _mm256_loadu_si256((const __m256i*)(acc + i)), _mm256_loadu_si256((const __m256i*)(src + i))));
+    ResponseAddSse41(acc + i, src + i, len - i);
+}
+
+NV_TARGET_AVX2
+static void ResponseFoldAvx2(uint16_t* score, uint8_t* acc, int len)
+{
+    int i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(acc + i)));
+        __m256i* s = (__m256i*)(score + i);
+        _mm256_storeu_si256(s, _mm256_adds_epu16(_mm256_loadu_si256(s), a));
+        _mm_storeu_si128((__m128i*)(acc + i), _mm_setzero_si128());
+    }
+    ResponseFoldScalar(score + i, acc + i, len - i);
+}
+
+NV_TARGET_AVX512
+static void ResponseAddAvx512(uint8_t* acc, const uint8_t* src, int len)
+{
+    for (int i = 0; i < len; i += 64)
+    {
+        int rem = len - i;
+        __mmask64 lanes = rem >= 64 ? ~(__mmask64)0 : (((__mmask64)1 << rem) - 1);
+        _mm512_mask_storeu_epi8(acc + i, lanes, _mm512_adds_epu8(
+            _mm512_maskz_loadu_epi8(lanes, acc + i), _mm512_maskz_loadu_epi8(lanes, src + i)));
+    }
+}
+
+NV_TARGET_AVX512
+static void ResponseFoldAvx512(uint16_t* score, uint8_t* acc, int len)
+{
+    for (int i = 0; i < len; i += 64)
+    {
+        int rem = len - i;
+        __mmask64 lanes = rem >= 64 ? ~(__mmask64)0 : (((__mmask64)1 << rem) - 1);
+        __m512i a = _mm512_maskz_loadu_epi8(lanes, acc + i);
+        __mmask32 lo = (__mmask32)lanes, hi = (__mmask32)(lanes >> 32);
+        __m512i aLo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(a));
+        __m512i aHi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(a, 1));
+        _mm512_mask_storeu_epi16(score + i, lo,
+            _mm512_adds_epu16(_mm512_maskz_loadu_epi16(lo, score + i), aLo));
+        _mm512_mask_storeu_epi16(score + i + 32, hi,
+            _mm512_adds_epu16(_mm512_maskz_loadu_epi16(hi, score + i + 32), aHi));
+        _mm512_mask_storeu_epi8(acc + i, lanes, _mm512_setzero_si512());
+    }
+}
+
+// ─── Morphology row kernels ─────────────────────────────────────────────────
+// Element-wise dst = min(a, b), max(a, b) or a − b (saturating) over one
+// row: the building block of NvMorphology's row and column passes and of
+// its top-hat / black-hat / gradient differences. dst may alias a or b, or
+// be a with b = a + m (each vector is loaded before the store behind it).
+
+enum { MORPH_ROW_MIN = 0, MORPH_ROW_MAX = 1, MORPH_ROW_SUB = 2 };
+
+typedef void (*MorphRowKernel)(uint8_t* dst, const uint8_t* a, const uint8_t* b, int width, int op);
+
+static void MorphRowScalar(uint8_t* dst, const uint8_t* a, const uint8_t* b, int width, int op)
+{
+    for (int x = 0; x < width; x++)
+    {
+        int u = a[x], v = b[x];
+        dst[x] = (uint8_t)(op == MORPH_ROW_MIN ? std::min(u, v)
+                         : op == MORPH_ROW_MAX ? std::max(u, v)
+                         : std::max(u - v, 0));
+    }
+}
+
+NV_TARGET_SSE41
+static void MorphRowSse41(uint8_t* dst, const uint8_t* a, const uint8_t* b, int width, int op)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i u = _mm_loadu_si128((const __m128i*)(a + x));
+        __m128i v = _mm_loadu_si128((const __m128i*)(b + x));
+        __m128i r = op == MORPH_ROW_MIN ? _mm_min_epu8(u, v)
+                  : op == MORPH_ROW_MAX ? _mm_max_epu8(u, v)
+                  : _mm_subs_epu8(u, v);
+        _mm_storeu_si128((__m128i*)(dst + x), r);
+    }
+    MorphRowScalar(dst + x, a + x, b + x, width - x, op);
+}
+
+NV_TARGET_AVX2
+static void MorphRowAvx2(uint8_t* dst, const uint8_t* a, const uint8_t* b, int width, int op)
+{
+    int x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i u = _mm256_loadu_si256((const __m256i*)(a + x));
+        __m256i v = _mm256_loadu_si256((const __m256i*)(b + x));
+        __m256i r = op == MORPH_ROW_MIN ? _mm256_min_epu8(u, v)
+                  : op == MORPH_ROW_MAX ? _mm256_max_epu8(u, v)
+                  : _mm256_subs_epu8(u, v);
+        _mm256_storeu_si256((__m256i*)(dst + x), r);
+    }
+    MorphRowSse41(dst + x, a + x, b + x, width - x, op);
+}
+
+NV_TARGET_AVX512
+static void MorphRowAvx512(uint8_t* dst, const uint8_t* a, const uint8_t* b, int width, int op)
+{
+    for (int x = 0; x < width; x += 64)
+    {
+        int rem = width - x;
+        __mmask64 lanes = rem >= 64 ? ~(__mmask64)0 : (((__mmask64)1 << rem) - 1);
+        __m512i u = _mm512_maskz_loadu_epi8(lanes, a + x);
+        __m512i v = _mm512_maskz_loadu_epi8(lanes, b + x);
+        __m512i r = op == MORPH_ROW_MIN ? _mm512_min_epu8(u, v)
+                  : op == MORPH_ROW_MAX ? _mm512_max_epu8(u, v)
+                  : _mm512_subs_epu8(u, v);
+        _mm512_mask_storeu_epi8(dst + x, lanes, r);
+    }
+}
+
+// ─── Depth slicing kernels ──────────────────────────────────────────────────
+// One row of a float height/depth map to 8-bit: dst = round((z − lo)·scale)
+// clamped to [0, 255]. Pixels outside [lo, hi] are written as 0, or with
+// clampOutside saturate to 0 / 255 instead; NaN (no measurement) is always
+// 0. Returns the number of pixels inside [lo, hi] (NaN never is).
+
+typedef int (*DepthSliceKernel)(const float* src, uint8_t* dst, int width,
+                                float lo, float hi, float scale, int clampOutside);
+
+static int DepthSliceScalar(const float* src, uint8_t* dst, int width,
+                            float lo, float hi, float scale, int clampOutside)
+{
+    int count = 0;
+    for (int x = 0; x < width; x++)
+    {
+        float z = src[x];
+        float v = (z - lo) * scale;
+        v = v > 0.0f ? (v < 255.0f ? v : 255.0f) : 0.0f;
+        bool in = z >= lo && z <= hi;
+        count += in;
+        dst[x] = (clampOutside ? z == z : in) ? (uint8_t)lrintf(v) : 0;
+    }
+    return count;
+}
+
+NV_TARGET_SSE41
+static int DepthSliceSse41(const float* src, uint8_t* dst, int width,
+                           float lo, float hi, float scale, int clampOutside)
+{
+    __m128 vlo = _mm_set1_ps(lo), vhi = _mm_set1_ps(hi), vs = _mm_set1_ps(scale);
+    __m128 zero = _mm_setzero_ps(), top = _mm_set1_ps(255.0f);
+    int count = 0, x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i q[4];
+        for (int k = 0; k < 4; k++)
+        {
+            __m128 z = _mm_loadu_ps(src + x + 4 * k);
+            // max(v, 0) returns 0 for NaN
+            __m128 v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(z, vlo), vs), zero), top);
+            __m128 in = _mm_and_ps(_mm_cmpge_ps(z, vlo), _mm_cmple_ps(z, vhi));
+            count += PopCount32((unsigned)_mm_movemask_ps(in));
+            __m128 keep = clampOutside ? _mm_cmpord_ps(z, z) : in;
+            q[k] = _mm_and_si128(_mm_cvtps_epi32(v), _mm_castps_si128(keep));
+        }
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+        _mm_storeu_si128((__m128i*)(dst + x), packed);
+    }
+    return count + DepthSliceScalar(src + x, dst + x, width - x, lo, hi, scale, clampOutside);
+}
+
+NV_TARGET_AVX2
+static int DepthSliceAvx2(const float* src, uint8_t* dst, int width,
+                          float lo, float hi, float scale, int clampOutside)
+{
+    __m256 vlo = _mm256_set1_ps(lo), vhi = _mm256_set1_ps(hi), vs = _mm256_set1_ps(scale);
+    __m256 zero = _mm256_setzero_ps(), top = _mm256_set1_ps(255.0f);
+    // packs/packus work per 128-bit lane; this restores pixel order
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int count = 0, x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i q[4];
+        for (int k = 0; k < 4; k++)
+        {
+            __m256 z = _mm256_loadu_ps(src + x + 8 * k);
+            __m256 v = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(z, vlo), vs), zero), top);
+            __m256 in = _mm256_and_ps(_mm256_cmp_ps(z, vlo, _CMP_GE_OQ), _mm256_cmp_ps(z, vhi, _CMP_LE_OQ));
+            count += PopCount32((unsigned)_mm256_movemask_ps(in));
+            __m256 keep = clampOutside ? _mm256_cmp_ps(z, z, _CMP_ORD_Q) : in;
+            q[k] = _mm256_and_si256(_mm256_cvtps_epi32(v), _mm256_castps_si256(keep));
+        }
+        __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(q[0], q[1]), _mm256_packs_epi32(q[2], q[3]));
+        _mm256_storeu_si256((__m256i*)(dst + x), _mm256_permutevar8x32_epi32(packed, order));
+    }
+    return count + DepthSliceSse41(src + x, dst + x, width - x, lo, hi, scale, clampOutside);
+}
+
+NV_TARGET_AVX512
+static int DepthSliceAvx512(const float* src, uint8_t* dst, int width,
+                            float lo, float hi, float scale, int clampOutside)
+{
+    __m512 vlo = _mm512_set1_ps(lo), vhi = _mm512_set1_ps(hi), vs = _mm512_set1_ps(scale);
+    __m512 zero = _mm512_setzero_ps(), top = _mm512_set1_ps(255.0f);
+    int count = 0;
+    for (int x = 0; x < width; x += 16)
+    {
+        int rem = width - x;
+        __mmask16 lanes = rem >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << rem) - 1);
+        __m512 z = _mm512_maskz_loadu_ps(lanes, src + x);
+        __m512 v = _mm512_min_ps(_mm512_max_ps(_mm512_mul_ps(_mm512_sub_ps(z, vlo), vs), zero), top);
+        __mmask16 in = _mm512_cmp_ps_mask(z, vlo, _CMP_GE_OQ) & _mm512_cmp_ps_mask(z, vhi, _CMP_LE_OQ) & lanes;
+        count += PopCount32(in);
+        __mmask16 keep = clampOutside ? _mm512_cmp_ps_mask(z, z, _CMP_ORD_Q) : in;
+        __m512i q = _mm512_maskz_mov_epi32(keep, _mm512_cvtps_epi32(v));
+        _mm512_mask_cvtusepi32_storeu_epi8(dst + x, lanes, q);
+    }
+    return count;
+}
+
+// ─── Runtime CPU dispatch ───────────────────────────────────────────────────
+// CPUID + XGETBV are read once when the DLL loads and the widest supported
+// kernel set is bound. NATIVEVISION_ISA=scalar|sse41|avx2|avx512 caps the
+// choice (never raises it), which is useful for A/B checks on one machine.
+
+typedef void (*GradientRowKernel)(
+    const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+    float* dx, float* dy, float* mg, int width);
+
+typedef void (*GradientCompactRowKernel)(
+    const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+    uint32_t* packed, uint16_t* mg, int width);
+
+struct NvKernels
+{
+    int isa;
+    const char* name;
+    GradientRowKernel gradientRow;
+    GradientCompactRowKernel gradientCompactRow;
+    EvaluateKernel evaluate;
+    EvaluateCompactKernel evaluateCompact;
+    WindowKernel window;
+    VoteKernel vote;
+    PeakKernel peak;
+    ResponseAddKernel responseAdd;
+    ResponseFoldKernel responseFold;
+    ProjectKernel project;
+    BinarizeKernel binarize;
+    MorphRowKernel morphRow;
+    DepthSliceKernel depthSlice;
+};
+
+static void CpuId(int leaf, int subLeaf, unsigned regs[4])
+{
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, leaf, subLeaf);
+    for (int i = 0; i < 4; i++) regs[i] = (unsigned)r[i];
+#else
+    __cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t ReadXcr0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+static int DetectIsa()
+{
+    unsigned regs[4];
+    CpuId(0, 0, regs);
+    unsigned maxLeaf = regs[0];
+    if (maxLeaf < 1) return NV_ISA_SCALAR;
+
+    CpuId(1, 0, regs);
+    bool sse41   = (regs[2] >> 19) & 1;
+    bool fma     = (regs[2] >> 12) & 1;
+    bool osxsave = (regs[2] >> 27) & 1;
+    bool avx     = (regs[2] >> 28) & 1;
+    int isa = sse41 ? NV_ISA_SSE41 : NV_ISA_SCALAR;
+    if (!sse41 || !osxsave || !avx || !fma || maxLeaf < 7) return isa;
+
+    // The OS must save YMM state (XCR0 bits 1-2), plus opmask/ZMM for AVX-512
+    uint64_t xcr0 = ReadXcr0();
+    if ((xcr0 & 0x6) != 0x6) return isa;
+
+    CpuId(7, 0, regs);
+    if (!((regs[1] >> 5) & 1)) return isa;
+    isa = NV_ISA_AVX2;
+    // AVX-512 level needs F + BW (int16 lanes in the compact Sobel)
+    if (((regs[1] >> 16) & 1) && ((regs[1] >> 30) & 1) && (xcr0 & 0xE6) == 0xE6)
+        isa = NV_ISA_AVX512;
+    return isa;
+}
+
+static NvKernels SelectKernels()
+{
+    int isa = DetectIsa();
+
+    const char* cap = getenv("NATIVEVISION_ISA");
+    if (cap)
+    {
+        int limit = isa;
+        if      (!strcmp(cap, "scalar")) limit = NV_ISA_SCALAR;
+        else if (!strcmp(cap, "sse41"))  limit = NV_ISA_SSE41;
+        else if (!strcmp(cap, "avx2"))   limit = NV_ISA_AVX2;
+        else if (!strcmp(cap, "avx512")) limit = NV_ISA_AVX512;
+        if (limit < isa) isa = limit;
+    }
+
+    switch (isa)
+    {
+    case NV_ISA_AVX512:
+        return { isa, "AVX-512", GradientRowAvx512, GradientCompactRowAvx512,
+                 EvaluateAvx512, EvaluateCompactAvx512, WindowAvx512, VoteAvx512, PeakAvx512,
+                 ResponseAddAvx512, ResponseFoldAvx512,
+                 ProjectAvx512, BinarizeAvx512, MorphRowAvx512,
+                 DepthSliceAvx512 };
+    case NV_ISA_AVX2:
+        return { isa, "AVX2", GradientRowAvx2, GradientCompactRowAvx2,
+                 EvaluateAvx2, EvaluateCompactAvx2, WindowAvx2, VoteAvx2, PeakAvx2,
+                 ResponseAddAvx2, ResponseFoldAvx2,
+                 ProjectAvx2, BinarizeAvx2, MorphRowAvx2,
+                 DepthSliceAvx2 };
+    case NV_ISA_SSE41:
+        return { isa, "SSE4.1", GradientRowSse41, GradientCompactRowSse41,
+                 EvaluateSse41, EvaluateCompactSse41, WindowSse41, VoteSse41, PeakSse41,
+                 ResponseAddSse41, ResponseFoldSse41,
+                 ProjectSse41, BinarizeSse41, MorphRowSse41,
+                 DepthSliceSse41 };
+    default:
+        return { isa, "Scalar", GradientRowPortable, GradientCompactRowPortable,
+                 EvaluateScalar, EvaluateCompactScalar, WindowScalar, VoteScalar, PeakScalar,
+                 ResponseAddScalar, ResponseFoldScalar,
+                 ProjectScalar, BinarizeScalar, MorphRowScalar,
+                 DepthSliceScalar };
+    }
+}
+
+static const NvKernels g_kernels = SelectKernels();
+
+// Active kernel set: 0 = scalar, 1 = SSE4.1, 2 = AVX2, 3 = AVX-512
+EXPORT int __cdecl NvGetIsaLevel()
+{
+    return g_kernels.isa;
+}
+
+EXPORT const char* __cdecl NvGetIsaName()
+{
+    return g_kernels.name;
+}
+
+// ─── Instrumentation ────────────────────────────────────────────────────────
+// Off by default; NvSetStatsEnabled switches it at runtime. When on, stages
+// add their TSC cycles and call counts, and the kernels their work counters,
+// to the calling thread's own slot. A slot has a single writer, so updates
+// are plain relaxed load/store pairs: no locks, no contended cache lines.
+// NvGetStats sums every slot into one NvStats snapshot. When off, each hook
+// costs one relaxed load and a predicted branch.
+//
+// Stage times are exclusive: a stage nested in another (a pose bank built
+// during a batched search, buffer growth during voting) is charged to itself
+// only. Work inside parallel regions is charged to the calling thread's wall
+// time; thread utilisation comes from the busy / span counters.
+
+enum NvStage
+{
+    NV_STAGE_GRADIENT,          // ComputeGradient(Compact)Native, lazy gradient tiles
+    NV_STAGE_SEARCH_EDGES,      // NvExtractSearchEdges: pyramid + Canny + bins
+    NV_STAGE_VOTE_COARSE,       // Phase 1 coarse angle sweep
+    NV_STAGE_VOTE_FINE,         // Phase 1 fine angles around the top K
+    NV_STAGE_POSE_BANK,         // pose bank (re)builds
+    NV_STAGE_SCORE,             // Phase 2 window scoring
+    NV_STAGE_INSTANCES,         // multi-instance seeding, refinement, NMS
+    NV_STAGE_REFINE,            // Gauss-Newton refinement
+    NV_STAGE_TRACK,             // NvTrackPose outside the stages above
+    NV_STAGE_ALLOC,             // matcher scratch growth
+    NV_STAGE_PRUNE,             // edge-density bounds and pruned edge lists
+    NV_STAGE_COUNT
+};
+
+enum NvCounter
+{
+    NV_COUNT_EDGES_VOTED,       // search edges fed to an accumulator (per angle, per band)
+    NV_COUNT_ACC_CELLS,         // accumulator cells cleared and scanned
+    NV_COUNT_ANGLES_VOTED,      // (model × angle) accumulators voted
+    NV_COUNT_POSES,             // poses scored over a window
+    NV_COUNT_POSITIONS,         // pose × position scores, including pruned chunks
+    NV_COUNT_POSES_PRUNED,      // tiled poses abandoned against the best score
+    NV_COUNT_EVALUATIONS,       // per-pixel scorer calls (greedy rule applies)
+    NV_COUNT_EARLY_EXITS,       // of those, rejected by the greedy rule
+    NV_COUNT_GRADIENT_TILES,    // lazy gradient tiles computed
+    NV_COUNT_POSE_BANK_HITS,    // pose-bank lookups served from the cache
+    NV_COUNT_POSE_BANK_MISSES,
+    NV_COUNT_BUSY_TICKS,        // cycles threads spent working in parallel loops
+    NV_COUNT_SPAN_TICKS,        // those loops' wall cycles × team size
+    NV_COUNT_WINDOWS_BOUNDED,   // accumulator cells / Phase 2 windows given an edge-support bound
+    NV_COUNT_WINDOWS_REJECTED,  // of those, below the minimum score
+    NV_COUNT_EDGES_PRUNED,      // search edges dropped from a model's vote list
+    NV_COUNT_COUNT
+};
+
+// Snapshot layout shared with the callers; slots beyond the enums read 0
+static const int NV_STATS_SLOTS = 16;
+
+struct NvStats
+{
+    int64_t stageCalls[NV_STATS_SLOTS];
+    int64_t stageTicks[NV_STATS_SLOTS];
+    int64_t counters[NV_STATS_SLOTS];
+    double ticksPerSecond;      // TSC rate, measured over the enabled interval
+    int threads;                // threads that have recorded anything
+    int enabled;
+};
+
+struct alignas(64) StatsSlot
+{
+    std::atomic<int64_t> stageCalls[NV_STATS_SLOTS];
+    std::atomic<int64_t> stageTicks[NV_STATS_SLOTS];
+    std::atomic<int64_t> counters[NV_STATS_SLOTS];
+};
+
+// Threads beyond this many record nothing
+static const int STATS_MAX_THREADS = 256;
+
+static StatsSlot g_statsSlots[STATS_MAX_THREADS];
+static std::atomic<int> g_statsThreads(0);
+static std::atomic<int> g_statsEnabled(0);
+static std::atomic<uint64_t> g_statsTscStart(0);
+static std::atomic<int64_t> g_statsClockStart(0);
+
+static thread_local StatsSlot* t_statsSlot = nullptr;
+static thread_local bool t_statsFull = false;
+static thread_local uint64_t t_statsNested = 0;   // child stage cycles of the running stage
+
+static inline bool StatsOn()
+{
+    return g_statsEnabled.load(std::memory_order_relaxed) != 0;
+}
+
+static StatsSlot* ThreadStatsSlot()
+{
+    if (t_statsSlot || t_statsFull) return t_statsSlot;
+    int i = g_statsThreads.fetch_add(1);
+    if (i < STATS_MAX_THREADS) t_statsSlot = &g_statsSlots[i];
+    else t_statsFull = true;
+    return t_statsSlot;
+}
+
+static inline void StatsBump(std::atomic<int64_t>& v, int64_t delta)
+{
+    v.store(v.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+static inline void StatAdd(int counter, int64_t delta)
+{
+    if (!StatsOn() || delta == 0) return;
+    if (StatsSlot* s = ThreadStatsSlot()) StatsBump(s->counters[counter], delta);
+}
+
+// TSC now when stats are on, else 0 (and the matching Stat* calls do nothing)
+static inline uint64_t StatsClock()
+{
+    return StatsOn() ? __rdtsc() : 0;
+}
+
+// Close a parallel-loop work item started at `start` on this thread
+static inline void StatsBusy(uint64_t start)
+{
+    if (start) StatAdd(NV_COUNT_BUSY_TICKS, (int64_t)(__rdtsc() - start));
+}
+
+// Close a parallel region started at `start` with `threads` team members
+static inline void StatsSpan(uint64_t start, int threads)
+{
+    if (start) StatAdd(NV_COUNT_SPAN_TICKS, (int64_t)(__rdtsc() - start) * threads);
+}
+
+// Scoped stage timer with exclusive accounting; Switch() closes the running
+// stage at a given TSC stamp and continues with another
+class StageTimer
+{
+public:
+    explicit StageTimer(int stage)
+        : stage_(StatsOn() ? stage : -1)
+    {
+        if (stage_ < 0) return;
+        begin_ = start_ = __rdtsc();
+        savedNested_ = t_statsNested;
+        t_statsNested = 0;
+    }
+
+    ~StageTimer()
+    {
+        if (stage_ < 0) return;
+        uint64_t now = __rdtsc();
+        Record(now);
+        t_statsNested = savedNested_ + (now - begin_);
+    }
+
+    void Switch(int stage, uint64_t at)
+    {
+        if (stage_ < 0 || at == 0) return;
+        Record(at);
+        stage_ = stage;
+        start_ = at;
+    }
+
+private:
+    void Record(uint64_t end)
+    {
+        uint64_t span = end > start_ ? end - start_ : 0;
+        uint64_t self = span > t_statsNested ? span - t_statsNested : 0;
+        t_statsNested = 0;
+        if (StatsSlot* s = ThreadStatsSlot())
+        {
+            StatsBump(s->stageCalls[stage_], 1);
+            StatsBump(s->stageTicks[stage_], (int64_t)self);
+        }
+    }
+
+    int stage_;
+    uint64_t begin_ = 0, start_ = 0, savedNested_ = 0;
+};
+
+static int64_t StatsSteadyNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 1 turns recording on, 0 off. Counters keep their values across switches.
+EXPORT void __cdecl NvSetStatsEnabled(int enabled)
+{
+    if (enabled && !StatsOn())
+    {
+        g_statsTscStart.store(__rdtsc(), std::memory_order_relaxed);
+        g_statsClockStart.store(StatsSteadyNs(), std::memory_order_relaxed);
+    }
+    g_statsEnabled.store(enabled ? 1 : 0, std::memory_order_relaxed);
+}
+
+// Sum of every thread's slot. Values recorded concurrently may or may not
+// be included; each field is read atomically.
+EXPORT void __cdecl NvGetStats(NvStats* out)
+{
+    memset(out, 0, sizeof(NvStats));
+    int threads = std::min(g_statsThreads.load(), STATS_MAX_THREADS);
+    for (int t = 0; t < threads; t++)
+    {
+        const StatsSlot& s = g_statsSlots[t];
+        for (int i = 0; i < NV_STATS_SLOTS; i++)
+        {
+            out->stageCalls[i] += s.stageCalls[i].load(std::memory_order_relaxed);
+            out->stageTicks[i] += s.stageTicks[i].load(std::memory_order_relaxed);
+            out->counters[i] += s.counters[i].load(std::memory_order_relaxed);
+        }
+    }
+    out->threads = threads;
+    out->enabled = StatsOn() ? 1 : 0;
+
+    int64_t ns = StatsSteadyNs() - g_statsClockStart.load(std::memory_order_relaxed);
+    uint64_t ticks = __rdtsc() - g_statsTscStart.load(std::memory_order_relaxed);
+    if (g_statsClockStart.load(std::memory_order_relaxed) != 0 && ns > 1000000)
+        out->ticksPerSecond = (double)ticks * 1e9 / (double)ns;
+}
+
+// Zero every counter. Recording threads may race a few updates past it.
+EXPORT void __cdecl NvResetStats()
+{
+    int threads = std::min(g_statsThreads.load(), STATS_MAX_THREADS);
+    for (int t = 0; t < threads; t++)
+    {
+        StatsSlot& s = g_statsSlots[t];
+        for (int i = 0; i < NV_STATS_SLOTS; i++)
+        {
+            s.stageCalls[i].store(0, std::memory_order_relaxed);
+            s.stageTicks[i].store(0, std::memory_order_relaxed);
+            s.counters[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    g_statsTscStart.store(__rdtsc(), std::memory_order_relaxed);
+    g_statsClockStart.store(StatsSteadyNs(), std::memory_order_relaxed);
+}
+
+// ─── Worker leases ───────────────────────────────────────────────────────────
+// Every call used to open a team of omp_get_max_threads(); with several
+// cameras searching at once that is N full teams on one set of cores. Now a
+// call leases its team from a process-wide core ledger first: it gets at most
+// its own budget (a matcher's thread count), at most an even share of the
+// cores among the leases currently held, and only cores nobody else holds.
+// A caller arriving while all cores are taken runs on its own thread, and
+// shares even out from the next call on, so concurrent cameras converge to
+// an equal split instead of oversubscribing. Leases nest: a call made under
+// a lease on the same thread reuses it.
+//
+// With pinning on (NvConfigureWorkers), team thread t ≥ 1 is bound to
+// leased core cores_[t]. The calling thread (team thread 0) is never pinned,
+// since it belongs to the host application: cores_[0] is only its share of
+// the ledger, so the other leases keep off it, but the caller itself stays
+// unbound and the OS may run it on any core.
+
+static const int WORKER_MAX_CORES = 256;
+
+static std::mutex g_workerLock;
+static int g_workerCores = 0;           // 0 until first use: all processors
+static bool g_workerPin = false;
+static int g_workerLeases = 0;          // leases currently held
+static uint8_t g_coreHeld[WORKER_MAX_CORES];
+
+static thread_local const class WorkerLease* t_workerLease = nullptr;
+static thread_local int t_pinnedCore = -1;
+
+static int WorkerCoresLocked()
+{
+    if (g_workerCores == 0) g_workerCores = std::min(std::max(omp_get_num_procs(), 1), WORKER_MAX_CORES);
+    return g_workerCores;
+}
+
+static void PinCurrentThread(int core)
+{
+#if defined(_WIN32)
+    if (core < 64) SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core);
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+class WorkerLease
+{
+public:
+    // budget: most threads this call may use (≤ 0: one)
+    explicit WorkerLease(int budget)
+    {
+        if (t_workerLease)
+        {
+            outer_ = t_workerLease;
+            threads_ = std::min(std::max(budget, 1), outer_->threads_);
+            return;
+        }
+
+        std::lock_guard<std::mutex> guard(g_workerLock);
+        int cores = WorkerCoresLocked();
+        int share = std::max(1, cores / (g_workerLeases + 1));
+        int want = std::min(std::max(budget, 1), share);
+        for (int c = 0; c < cores && count_ < want; c++)
+        {
+            if (g_coreHeld[c]) continue;
+            g_coreHeld[c] = 1;
+            cores_[count_++] = (int16_t)c;
+        }
+        threads_ = std::max(count_, 1);
+        pin_ = g_workerPin;
+        g_workerLeases++;
+        t_workerLease = this;
+    }
+
+    ~WorkerLease()
+    {
+        if (outer_) return;
+        t_workerLease = nullptr;
+        std::lock_guard<std::mutex> guard(g_workerLock);
+        for (int i = 0; i < count_; i++) g_coreHeld[cores_[i]] = 0;
+        g_workerLeases--;
+    }
+
+    WorkerLease(const WorkerLease&) = delete;
+    WorkerLease& operator=(const WorkerLease&) = delete;
+
+    int Threads() const { return threads_; }
+
+    // Call at the top of a parallel region (or loop body): binds worker
+    // thread t ≥ 1 to cores_[t] when pinning is on. Thread 0 is the caller
+    // and is left unbound (see above).
+    void Pin() const
+    {
+        const WorkerLease& root = outer_ ? *outer_ : *this;
+        if (!root.pin_) return;
+        int tid = omp_get_thread_num();
+        if (tid == 0 || tid >= root.count_) return;
+        int core = root.cores_[tid];
+        if (core == t_pinnedCore) return;
+        PinCurrentThread(core);
+        t_pinnedCore = core;
+    }
+
+private:
+    const WorkerLease* outer_ = nullptr;
+    int threads_ = 1;
+    int count_ = 0;
+    bool pin_ = false;
+    int16_t cores_[WORKER_MAX_CORES];   // [0]: caller's share, [1..]: workers
+};
+
+// cores: processors the ledger hands out (0 = all); pinThreads: bind worker
+// threads to their leased cores (the calling thread stays unbound). Affects
+// leases taken after the call.
+EXPORT void __cdecl NvConfigureWorkers(int cores, int pinThreads)
+{
+    std::lock_guard<std::mutex> guard(g_workerLock);
+    int all = std::min(std::max(omp_get_num_procs(), 1), WORKER_MAX_CORES);
+    g_workerCores = cores > 0 ? std::min(cores, all) : all;
+    g_workerPin = pinThreads != 0;
+}
+
+// Cores the ledger hands out, and how many of them are leased right now
+EXPORT int __cdecl NvGetWorkerCores(int* outLeased)
+{
+    std::lock_guard<std::mutex> guard(g_workerLock);
+    int cores = WorkerCoresLocked();
+    if (outLeased)
+    {
+        int held = 0;
+        for (int c = 0; c < WORKER_MAX_CORES; c++) held += g_coreHeld[c];
+        *outLeased = held;
+    }
+    return cores;
+}
+
+// ─── Fused Sobel X, Y + Magnitude in one pass ───────────────────────────────
+// Replaces 3 separate OpenCV calls with a single memory traversal.
+// Input: 8-bit grayscale; Output: float Sobel X, Sobel Y, Magnitude
+
+EXPORT void __cdecl ComputeGradientNative(
+    const uint8_t* __restrict gray,
+    int width, int height, int stride,
+    float* __restrict outDx,
+    float* __restrict outDy,
+    float* __restrict outMag)
+{
+    StageTimer timer(NV_STAGE_GRADIENT);
+
+    // Border pixels: zero gradient
+
+    // Zero border rows
+    memset(outDx, 0, width * sizeof(float));
+    memset(outDy, 0, width * sizeof(float));
+    memset(outMag, 0, width * sizeof(float));
+    memset(outDx + (height - 1) * width, 0, width * sizeof(float));
+    memset(outDy + (height - 1) * width, 0, width * sizeof(float));
+    memset(outMag + (height - 1) * width, 0, width * sizeof(float));
+
+    GradientRowKernel row = g_kernels.gradientRow;
+    WorkerLease lease(omp_get_max_threads());
+
+    #pragma omp parallel for schedule(static) num_threads(lease.Threads())
+    for (int y = 1; y < height - 1; y++)
+    {
+        lease.Pin();
+        float* dx = outDx + y * width;
+        float* dy = outDy + y * width;
+        float* mg = outMag + y * width;
+
+        // Zero border columns
+        dx[0] = dy[0] = mg[0] = 0.0f;
+        dx[width - 1] = dy[width - 1] = mg[width - 1] = 0.0f;
+
+        row(gray + (y - 1) * stride, gray + y * stride, gray + (y + 1) * stride,
+            dx, dy, mg, width);
+    }
+}
+
+// Compact variant: packed int16 dx/dy (4 B/px) and an optional uint16
+// magnitude plane (outMag may be null). Border pixels are zero.
+EXPORT void __cdecl ComputeGradientCompactNative(
+    const uint8_t* __restrict gray,
+    int width, int height, int stride,
+    uint32_t* __restrict outPacked,
+    uint16_t* __restrict outMag)
+{
+    StageTimer timer(NV_STAGE_GRADIENT);
+    memset(outPacked, 0, width * sizeof(uint32_t));
+    memset(outPacked + (height - 1) * width, 0, width * sizeof(uint32_t));
+    if (outMag)
+    {
+        memset(outMag, 0, width * sizeof(uint16_t));
+        memset(outMag + (height - 1) * width, 0, width * sizeof(uint16_t));
+    }
+
+    GradientCompactRowKernel row = g_kernels.gradientCompactRow;
+    WorkerLease lease(omp_get_max_threads());
+
+    #pragma omp parallel for schedule(static) num_threads(lease.Threads())
+    for (int y = 1; y < height - 1; y++)
+    {
+        lease.Pin();
+        uint32_t* pk = outPacked + y * width;
+        uint16_t* mg = outMag ? outMag + y * width : nullptr;
+
+        pk[0] = pk[width - 1] = 0;
+        if (mg) mg[0] = mg[width - 1] = 0;
+
+        row(gray + (y - 1) * stride, gray + y * stride, gray + (y + 1) * stride,
+            pk, mg, width);
+    }
+}
+
+// ─── Per-pixel scoring (dispatched) ─────────────────────────────────────────
+
+struct LazyGradient;
+
+// Search-image gradients as seen by the scorers: either the three float
+// planes or the packed int16 plane. A non-null packed selects the compact kernels.
+// With lazy set, packed is a LazyGradient plane: only touched tiles are valid.
+struct GradientView
+{
+    const float* dx;
+    const float* dy;
+    const float* mag;
+    const uint32_t* packed;
+    LazyGradient* lazy;
+};
+
+static inline GradientView FloatGradients(const float* dx, const float* dy, const float* mag)
+{
+    return { dx, dy, mag, nullptr, nullptr };
+}
+
+static inline GradientView CompactGradients(const uint32_t* packed)
+{
+    return { nullptr, nullptr, nullptr, packed, nullptr };
+}
+
+// ─── Lazy tiled gradient ────────────────────────────────────────────────────
+// Phase 2 and refinement read the full-resolution gradient only within a
+// model's reach of the few voted candidates; voting runs on its own pyramid
+// level. A LazyGradient is a full-size packed plane whose 64×64 tiles are
+// computed on first touch, so gradient work follows the candidate area, not
+// the image size. The plane is never cleared, so untouched pages are never
+// faulted in either. Values equal ComputeGradientCompactNative's.
+//
+// Tiles are touched before the scorers read them, always from a serial
+// section: callers touch every window first, then score in parallel.
+
+static const int LAZY_TILE = 64;
+
+// Extra reach of every scoring touch, so the winner can be refined
+// (±REFINE_SPAN along the normal, up to REFINE_MAX_SHIFT away, plus the
+// bilinear neighbour) without another touch
+static const int LAZY_REFINE_PAD = 6;
+
+struct LazyGradient
+{
+    const uint8_t* gray;
+    int width, height, stride;
+    int tilesX, tilesY;
+    int numThreads;
+    uint32_t* plane;            // width × height, uninitialised until touched
+    size_t planeCap;            // pixels
+    std::vector<uint8_t> valid; // per tile
+    std::vector<int> pending;   // tiles to compute in the current touch
+};
+
+static void ComputeGradientTile(const LazyGradient& g, int tile)
+{
+    int x0 = (tile % g.tilesX) * LAZY_TILE, y0 = (tile / g.tilesX) * LAZY_TILE;
+    int x1 = std::min(x0 + LAZY_TILE, g.width), y1 = std::min(y0 + LAZY_TILE, g.height);
+    // The row kernel writes pixels 1 .. n-2 of the span it is given, so the
+    // span starts one pixel early and ends one late; image-border pixels are zero
+    int sx0 = std::max(x0, 1), sx1 = std::min(x1, g.width - 1);
+    GradientCompactRowKernel row = g_kernels.gradientCompactRow;
+
+    for (int y = y0; y < y1; y++)
+    {
+        uint32_t* pk = g.plane + (size_t)y * g.width;
+        if (y == 0 || y == g.height - 1)
+        {
+            memset(pk + x0, 0, (x1 - x0) * sizeof(uint32_t));
+            continue;
+        }
+        if (x0 == 0) pk[0] = 0;
+        if (x1 == g.width) pk[g.width - 1] = 0;
+        if (sx1 > sx0)
+        {
+            const uint8_t* r1 = g.gray + (size_t)y * g.stride + sx0 - 1;
+            row(r1 - g.stride, r1, r1 + g.stride, pk + sx0 - 1, nullptr, sx1 - sx0 + 2);
+        }
+    }
+}
+
+// Make [x0, x1] × [y0, y1] (inclusive, clipped to the image) readable.
+// No-op for an eager gradient.
+static void TouchGradient(const GradientView& grad, int x0, int y0, int x1, int y1)
+{
+    LazyGradient* g = grad.lazy;
+    if (!g) return;
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, g->width - 1);
+    y1 = std::min(y1, g->height - 1);
+    if (x0 > x1 || y0 > y1) return;
+
+    g->pending.clear();
+    for (int ty = y0 / LAZY_TILE; ty <= y1 / LAZY_TILE; ty++)
+    {
+        for (int tx = x0 / LAZY_TILE; tx <= x1 / LAZY_TILE; tx++)
+        {
+            int t = ty * g->tilesX + tx;
+            if (!g->valid[t])
+            {
+                g->valid[t] = 1;
+                g->pending.push_back(t);
+            }
+        }
+    }
+
+    int count = (int)g->pending.size();
+    if (count == 0) return;
+    StageTimer timer(NV_STAGE_GRADIENT);
+    StatAdd(NV_COUNT_GRADIENT_TILES, count);
+    const LazyGradient& cg = *g;
+    WorkerLease lease(std::min(g->numThreads, count));
+    #pragma omp parallel for schedule(dynamic) num_threads(lease.Threads()) if (count > 1)
+    for (int i = 0; i < count; i++)
+    {
+        lease.Pin();
+        ComputeGradientTile(cg, cg.pending[i]);
+    }
+}
+
+static inline double EvaluateNativeInternal(
+    int px, int py,
+    const int* __restrict offsets,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const GradientView& grad,
+    int imgW, int N,
+    float thresh, float greedy,
+    int contrastInvariant)
+{
+    if (grad.packed)
+        return g_kernels.evaluateCompact(px, py, offsets, rdx, rdy, grad.packed,
+            imgW, N, thresh, greedy, contrastInvariant);
+    return g_kernels.evaluate(px, py, offsets, rdx, rdy, grad.dx, grad.dy, grad.mag,
+        imgW, N, thresh, greedy, contrastInvariant);
+}
+
+// ─── Gather-free window scoring ─────────────────────────────────────────────
+// Phase 2 evaluates every pose at every position of a (2r+1)² window. Instead
+// of one gather per model point per position, the gradients around the window
+// are normalised once into a GradientTile and each pose's points are sorted by
+// rotated row, so the window kernel streams whole tile rows and consecutive
+// points touch the same lines. Scores equal the per-pixel kernels' full sums
+// up to float rounding; in place of the greedy rule, a pose stops once its
+// best window position can no longer beat the best score found so far.
+
+struct GradientTile
+{
+    int x0, y0, w, h;           // image rectangle covered
+    int stride, nyOffset;       // floats per tile row; unit-y offset within a row
+    std::vector<float> data;
+};
+
+// Normalise the gradient over [x0, x1] × [y0, y1] (clipped to the image).
+// Pixels below the scorers' magnitude cut-off become (0, 0).
+static void BuildGradientTile(
+    GradientTile& tile, const GradientView& grad, int imgW, int imgH,
+    int x0, int y0, int x1, int y1)
+{
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, imgW - 1);
+    y1 = std::min(y1, imgH - 1);
+    tile.x0 = x0;
+    tile.y0 = y0;
+    tile.w = std::max(x1 - x0 + 1, 0);
+    tile.h = std::max(y1 - y0 + 1, 0);
+    // 16 floats of slack per half-row: vector lanes past the window edge read
+    // into it rather than into the next half
+    tile.nyOffset = (tile.w + 31) & ~15;
+    tile.stride = 2 * tile.nyOffset;
+    tile.data.resize((size_t)tile.h * tile.stride);
+
+    for (int y = 0; y < tile.h; y++)
+    {
+        float* nx = tile.data.data() + (size_t)y * tile.stride;
+        float* ny = nx + tile.nyOffset;
+        int src = (y0 + y) * imgW + x0;
+        if (grad.packed)
+        {
+            for (int x = 0; x < tile.w; x++)
+            {
+                uint32_t g = grad.packed[src + x];
+                float gx = (float)(int16_t)(g & 0xFFFF);
+                float gy = (float)(int16_t)(g >> 16);
+                float m2 = gx * gx + gy * gy;
+                float inv = m2 > 0.0f ? 1.0f / sqrtf(m2) : 0.0f;
+                nx[x] = gx * inv;
+                ny[x] = gy * inv;
+            }
+        }
+        else
+        {
+            for (int x = 0; x < tile.w; x++)
+            {
+                float m = grad.mag[src + x];
+                float inv = m > 0.001f ? 1.0f / m : 0.0f;
+                nx[x] = grad.dx[src + x] * inv;
+                ny[x] = grad.dy[src + x] * inv;
+            }
+        }
+        memset(nx + tile.w, 0, (tile.nyOffset - tile.w) * sizeof(float));
+        memset(ny + tile.w, 0, (tile.nyOffset - tile.w) * sizeof(float));
+    }
+}
+
+// Reorder one pose's points by rotated row: a stable counting sort, so points
+// within a row keep model order and the summation order is reproducible.
+// margin is BuildPoseOffsets' result (every |ry| < margin).
+static void SortPoseByRow(
+    const int* rotX, const int* rotY, const float* rdx, const float* rdy, int N, int margin,
+    std::vector<int>& rowStart, int* outX, int* outY, float* outDx, float* outDy)
+{
+    rowStart.assign(2 * margin + 1, 0);
+    for (int i = 0; i < N; i++)
+        rowStart[rotY[i] + margin]++;
+    int sum = 0;
+    for (size_t r = 0; r < rowStart.size(); r++)
+    {
+        int c = rowStart[r];
+        rowStart[r] = sum;
+        sum += c;
+    }
+    for (int i = 0; i < N; i++)
+    {
+        int k = rowStart[rotY[i] + margin]++;
+        outX[k] = rotX[i];
+        outY[k] = rotY[i];
+        outDx[k] = rdx[i];
+        outDy[k] = rdy[i];
+    }
+}
+
+// Window scratch for ScorePoseWindowTiled, in floats.
+static inline size_t WindowFloats(int refRadius)
+{
+    int side = 2 * refRadius + 1;
+    return (size_t)side * ((side + 15) & ~15);
+}
+
+// Tiled counterpart of ScorePoseWindow for row-sorted points. The tile must
+// cover the window grown by margin - 1 on every side. acc holds
+// WindowFloats(refRadius) floats (64-byte aligned); rowOff holds N ints.
+// A pose is abandoned once it cannot reach max(*best, floor); floor lets a
+// batched search prune against a score found outside this thread.
+static bool ScorePoseWindowTiled(
+    const GradientTile& tile,
+    int baseCx, int baseCy, int refRadius, int margin,
+    const int* rx, const int* ry, const float* rdx, const float* rdy, int N,
+    int imgW, int imgH, int contrastInvariant,
+    float* acc, int* rowOff, double floor,
+    double* best, int* bestDx, int* bestDy)
+{
+    int x0 = std::max(baseCx - refRadius, margin);
+    int x1 = std::min(baseCx + refRadius, imgW - margin - 1);
+    int y0 = std::max(baseCy - refRadius, margin);
+    int y1 = std::min(baseCy + refRadius, imgH - margin - 1);
+    if (x0 > x1 || y0 > y1 || N <= 0) return false;
+
+    int cols = x1 - x0 + 1, rows = y1 - y0 + 1;
+    int accStride = (cols + 15) & ~15;
+    memset(acc, 0, (size_t)rows * accStride * sizeof(float));
+
+    const float* origin = tile.data.data() + (size_t)(y0 - tile.y0) * tile.stride + (x0 - tile.x0);
+    for (int i = 0; i < N; i++)
+        rowOff[i] = ry[i] * tile.stride + rx[i];
+
+    // Each contribution is at most 1 in magnitude (unit vectors); the slack
+    // absorbs rounding so a pose that could tie the best is never dropped
+    const int CHUNK = 64;
+    double bar = std::max(*best, floor) * N;
+    StatAdd(NV_COUNT_POSES, 1);
+    StatAdd(NV_COUNT_POSITIONS, (int64_t)rows * cols);
+    for (int begin = 0; begin < N; begin += CHUNK)
+    {
+        int end = std::min(begin + CHUNK, N);
+        g_kernels.window(acc, accStride, rows, cols, origin, tile.stride, tile.nyOffset,
+            rowOff, rdx, rdy, begin, end, contrastInvariant);
+        if (end == N) break;
+
+        float peak = acc[0];
+        for (int r = 0; r < rows; r++)
+            for (int c = 0; c < cols; c++)
+                peak = std::max(peak, acc[r * accStride + c]);
+        if ((double)peak + (N - end) * 1.001 < bar)
+        {
+            StatAdd(NV_COUNT_POSES_PRUNED, 1);
+            return false;
+        }
+    }
+
+    bool improved = false;
+    for (int r = 0; r < rows; r++)
+    {
+        for (int c = 0; c < cols; c++)
+        {
+            double score = (double)acc[r * accStride + c] / N;
+            if (score > *best)
+            {
+                *best = score;
+                *bestDx = x0 + c - baseCx;
+                *bestDy = y0 + r - baseCy;
+                improved = true;
+            }
+        }
+    }
+    return improved;
+}
+
+// ─── Persistent matcher context ─────────────────────────────────────────────
+// Owns every scratch buffer the matching kernels need: one arena per OpenMP
+// thread (accumulator, rotated points, pose offsets) plus the shared
+// candidate tables. Buffers are allocated and pre-faulted once and only grow
+// when a call needs more, so steady-state matching performs no heap
+// allocation. A matcher is not thread-safe — use one per caller (camera).
+
+struct Candidate
+{
+    double angle, cx, cy;
+    int votes;
+    double scale;               // vote scale (VoteScaleGrid), 0 until voted
+};
+
+struct MatchInstance
+{
+    double x, y, angle, scale, score;
+};
+
+// Phase 1 engine of one model (NvModelDesc::voteMode)
+enum
+{
+    NV_VOTE_HOUGH = 0,          // generalised Hough voting over the search edges
+    NV_VOTE_RESPONSE = 1        // LINE-2D spread-orientation response maps
+};
+
+// One model of a batched search (NvMatchModels). Layout mirrors the C#
+// NativeVision.ModelDesc; modelDx/modelDy may be null for voting only.
+struct NvModelDesc
+{
+    const float* modelX;
+    const float* modelY;
+    const float* modelDx;
+    const float* modelDy;
+    const int* binOffsets;
+    const int* binIndices;
+    int modelCount, modelKey;
+    int voteMode, reserved;
+};
+
+// Per-model outcome of a batched search (C# NativeVision.ModelResult)
+struct NvModelResult
+{
+    double x, y, angle, scale, score;
+    int votes, reserved;
+};
+
+// Accumulator cells as [x0, x1) runs per row
+struct CellRuns
+{
+    std::vector<int> rowStart;  // row y holds runs [rowStart[y], rowStart[y + 1])
+    std::vector<int> x0, x1;
+};
+
+// Working state of one model inside a batched search
+struct ModelSearch
+{
+    size_t voteBase;            // first point in NvMatcher::voteX/voteY
+    int reach, bandRows;        // vote footprint and accumulator band height
+    int validK;                 // coarse candidates worth a fine pass
+    Candidate vote;             // Phase 1 result (vote level)
+    double bandCenter, bandRange;   // Phase 2 scale band around vote.scale
+    int baseCx, baseCy;         // Phase 2 window centre (full resolution)
+    int bank, poseCount;
+    double score;               // Phase 2 result
+    int bestDx, bestDy, bestPose;
+
+    // Edge-density pruning (PruneSearchEdges): distinct vote-level outline
+    // pixels, the edges this model votes with, the accumulator cells they
+    // reach when that is a small part of it, and the Phase 2 window bound
+    int outline;
+    const int *edgeX, *edgeY, *edgeBin;
+    int edgeCount;
+    bool pruned, sparse;
+    CellRuns reached;
+    double bound;
+};
+
+// Scales Phase 1 votes at (VoteModels): offsets on the Phase 2 fine scale
+// grid, centre ± range in steps of step, `stride` fine steps apart
+struct VoteScaleGrid
+{
+    double center, range, step;
+    int halfSteps;              // fine steps either side of the centre
+    int stride;                 // fine steps one vote scale covers (0: one scale)
+    std::vector<int> offsets;   // vote scales as fine-step offsets, ascending
+};
+
+// One thread's best pose for one model
+struct PoseBest
+{
+    double score;
+    int dx, dy, pose;
+};
+
+struct ThreadArena
+{
+    uint16_t* acc;              // vote accumulator (one band when tiled)
+    uint8_t* acc8;              // response-map byte sums (LINE-2D Phase 1)
+    int* rotX;                  // rotated model points (vote level)
+    int* rotY;
+    int* offsets;               // image offsets for one scoring pose
+    float* rdx;                 // rotated gradient directions for that pose
+    float* rdy;
+    int* rowX;                  // the same pose sorted by rotated row
+    int* rowY;
+    float* rowDx;
+    float* rowDy;
+    int* rowOff;                // tile offsets of the sorted points
+    float* window;              // ScorePoseWindowTiled accumulator
+    std::vector<int> rowStart;  // SortPoseByRow buckets
+    std::vector<MatchInstance> peaks;       // multi-instance: this thread's peaks
+    std::vector<MatchInstance> anglePeaks;  // multi-instance: peaks of one angle
+};
+
+// Linearised response maps of one search image (BuildResponseMaps)
+struct ResponseMaps
+{
+    int width, height;          // vote-level image
+    int gridW, gridH;           // template positions, RESPONSE_T apart
+    std::vector<uint8_t> mask;  // orientation bits per pixel, then their spread
+    std::vector<uint8_t> rows;  // the bits ORed along each row
+    std::vector<uint8_t> maps;  // orientation × T² planes × grid cells
+    std::vector<uint8_t> binOrientation;    // phase bin → orientation
+};
+
+struct ModelMapping;
+
+// Fine-pose set for one model around one coarse angle: per pose, the rotated
+// points sorted by row (modelCount each), their directions and the margin,
+// ready for ScorePoseWindowTiled. Independent of the image size.
+struct PoseBank
+{
+    int modelKey, modelCount;
+    int64_t angleKey;           // centre angle in 1/1000 degree
+    double angleRange, angleStep, scaleCenter, scaleRange, scaleStep;
+    int poseCount, maxMargin;
+    uint64_t lastUse;
+    std::vector<int> rx, ry, margins;
+    std::vector<float> rdx, rdy;
+    std::vector<double> angles, scales;
+
+    // What the scorers read: the vectors above, or a slice of a mapped model
+    // file (NvOpenModelFile), which the bank then keeps alive
+    const int* poseX;
+    const int* poseY;
+    const int* poseMargins;
+    const float* poseDx;
+    const float* poseDy;
+    const double* poseAngles;
+    const double* poseScales;
+    std::shared_ptr<const ModelMapping> mapping;
+};
+
+// Pose banks a matcher keeps by default; a batched search raises the limit so
+// its own models never evict each other
+static const int POSE_BANK_CAPACITY = 32;
+
+struct NvMatcher
+{
+    int numThreads;             // arenas; the creating thread's OpenMP thread count
+    int threadBudget;           // most threads one call leases (≤ numThreads)
+    size_t accCap;              // cells per accumulator
+    size_t acc8Cap;             // bytes per response-map accumulator
+    int pointCap;               // model points per buffer (multiple of 8)
+    int candCap;                // coarse top-K capacity
+    int fineCap;                // fine-pass result capacity
+    size_t windowCap;           // floats per window accumulator
+    ThreadArena* arenas;
+    Candidate* candidates;
+    Candidate* threadBest;      // numThreads × candCap
+    Candidate* fineResults;
+
+    // Multi-instance working sets; capacity persists across calls
+    std::vector<MatchInstance> peaks, cands, seeds, refined, results;
+    std::vector<int> clusterOf;
+    std::vector<double> bestSeed, poseScales;
+
+    // Search-edge extraction (NvExtractSearchEdges): pyramid levels, vote-level
+    // gradient, Canny map and the resulting edge list
+    std::vector<uint8_t> pyrA, pyrB, edgeMap;
+    std::vector<int> pyrRows;   // numThreads × (width + 4) vertical-pass rows
+    std::vector<uint32_t> edgeGrad;
+    std::vector<int> edgeStack, edgeX, edgeY, edgeBin;
+
+    // Hough voting: model points in bin order (PrepareVotePoints), one run
+    // per model of a batch
+    std::vector<float> voteX, voteY;
+
+    // LINE-2D Phase 1 input (BuildResponseMaps)
+    ResponseMaps responseMaps;
+
+    // Scales of the last VoteModels call
+    VoteScaleGrid voteScales;
+
+    // Edge-density pruning (NvSetEdgePruning): minimum score (0 = off),
+    // integral image of the edge counts per accumulator cell, one model's
+    // cell integral and flags, and the pruned edge lists of a batch, model
+    // after model
+    double pruneMinScore;
+    std::vector<int> edgeIntegral, cellIntegral;
+    std::vector<uint8_t> cellFlags;
+    std::vector<int> pruneX, pruneY, pruneBin;
+    std::vector<int64_t> outlineKeys;
+
+    // Batched search (VoteModels / NvMatchModels): per-model state, models
+    // in scoring order, first work item of each, and numThreads × models
+    // thread-local bests
+    std::vector<ModelSearch> searches;
+    std::vector<int> searchOrder, itemBase;
+    std::vector<PoseBest> poseBest;
+
+    // Pose banks (NvAcquirePoseBank), least recently used evicted first
+    std::vector<PoseBank> poseBanks;
+    uint64_t poseBankClock;
+    int poseBankCap;
+
+    // Normalised gradient around the Phase 2 window(s): one for a pose bank,
+    // one per multi-instance candidate
+    GradientTile tile;
+    std::vector<GradientTile> candTiles;
+
+    // Tracking (NvTrackPose): packed gradient of the predicted window only
+    std::vector<uint32_t> trackGrad;
+
+    // Full-resolution gradient computed on demand (NvBeginLazyGradient)
+    LazyGradient lazyGrad;
+};
+
+// Replace *buf with a zeroed (and therefore pre-faulted) block of `bytes`.
+static bool ReallocZeroed(void** buf, size_t bytes)
+{
+    StageTimer timer(NV_STAGE_ALLOC);
+    void* p = _aligned_malloc(bytes > 0 ? bytes : 64, 64);
+    if (!p) return false;
+    memset(p, 0, bytes);
+    _aligned_free(*buf);
+    *buf = p;
+    return true;
+}
+
+static bool EnsureAccumulator(NvMatcher* m, size_t accLen)
+{
+    if (accLen <= m->accCap) return true;
+    for (int t = 0; t < m->numThreads; t++)
+        if (!ReallocZeroed((void**)&m->arenas[t].acc, accLen * sizeof(uint16_t))) return false;
+    m->accCap = accLen;
+    return true;
+}
+
+static bool EnsureResponseAccumulator(NvMatcher* m, size_t len)
+{
+    if (len <= m->acc8Cap) return true;
+    for (int t = 0; t < m->numThreads; t++)
+        if (!ReallocZeroed((void**)&m->arenas[t].acc8, len)) return false;
+    m->acc8Cap = len;
+    return true;
+}
+
+static bool EnsurePoints(NvMatcher* m, int modelCount)
+{
+    if (modelCount <= m->pointCap) return true;
+    int cap = (modelCount + 7) & ~7;
+    for (int t = 0; t < m->numThreads; t++)
+    {
+        ThreadArena& a = m->arenas[t];
+        if (!ReallocZeroed((void**)&a.rotX, cap * sizeof(int))) return false;
+        if (!ReallocZeroed((void**)&a.rotY, cap * sizeof(int))) return false;
+        if (!ReallocZeroed((void**)&a.offsets, cap * sizeof(int))) return false;
+        if (!ReallocZeroed((void**)&a.rdx, cap * sizeof(float))) return false;
+        if (!ReallocZeroed((void**)&a.rdy, cap * sizeof(float))) return false;
+        if (!ReallocZeroed((void**)&a.rowX, cap * sizeof(int))) return false;
+        if (!ReallocZeroed((void**)&a.rowY, cap * sizeof(int))) return false;
+        if (!ReallocZeroed((void**)&a.rowDx, cap * sizeof(float))) return false;
+        if (!ReallocZeroed((void**)&a.rowDy, cap * sizeof(float))) return false;
+        if (!ReallocZeroed((void**)&a.rowOff, cap * sizeof(int))) return false;
+    }
+    m->pointCap = cap;
+    return true;
+}
+
+static bool EnsureWindow(NvMatcher* m, int refRadius)
+{
+    size_t len = WindowFloats(refRadius);
+    if (len <= m->windowCap) return true;
+    for (int t = 0; t < m->numThreads; t++)
+        if (!ReallocZeroed((void**)&m->arenas[t].window, len * sizeof(float))) return false;
+    m->windowCap = len;
+    return true;
+}
+
+static bool EnsureCandidates(NvMatcher* m, int topK, int fineCount)
+{
+    if (topK > m->candCap)
+    {
+        if (!ReallocZeroed((void**)&m->candidates, topK * sizeof(Candidate))) return false;
+        if (!ReallocZeroed((void**)&m->threadBest, (size_t)m->numThreads * topK * sizeof(Candidate))) return false;
+        m->candCap = topK;
+    }
+    if (fineCount > m->fineCap)
+    {
+        if (!ReallocZeroed((void**)&m->fineResults, fineCount * sizeof(Candidate))) return false;
+        m->fineCap = fineCount;
+    }
+    return true;
+}
+
+EXPORT void __cdecl NvDestroyMatcher(NvMatcher* m);
+
+// maxW/maxH: largest vote image (accumulator sized for binShiftBits = 0).
+// maxModelPoints: largest model. maxPoses: largest fine pose set per call.
+EXPORT NvMatcher* __cdecl NvCreateMatcher(int maxW, int maxH, int maxModelPoints, int maxPoses)
+{
+    NvMatcher* m = new (std::nothrow) NvMatcher();
+    if (!m) return nullptr;
+
+    m->numThreads = omp_get_max_threads();
+    m->threadBudget = m->numThreads;
+    m->arenas = new (std::nothrow) ThreadArena[m->numThreads]();
+    if (!m->arenas) { delete m; return nullptr; }
+
+    size_t accLen = (size_t)(std::max(maxW, 0) + 1) * (size_t)(std::max(maxH, 0) + 1);
+    const int DEFAULT_TOPK = 8;
+    int fineCount = DEFAULT_TOPK * std::max(maxPoses, 1);
+    if (!EnsureAccumulator(m, accLen) ||
+        !EnsurePoints(m, std::max(maxModelPoints, 8)) ||
+        !EnsureCandidates(m, DEFAULT_TOPK, fineCount))
+    {
+        NvDestroyMatcher(m);
+        return nullptr;
+    }
+
+    m->refined.reserve((size_t)std::max(maxPoses, 1) * DEFAULT_TOPK);
+    m->poseScales.reserve(64);
+    m->poseBankCap = POSE_BANK_CAPACITY;
+    return m;
+}
+
+EXPORT void __cdecl NvDestroyMatcher(NvMatcher* m)
+{
+    if (!m) return;
+    if (m->arenas)
+    {
+        for (int t = 0; t < m->numThreads; t++)
+        {
+            ThreadArena& a = m->arenas[t];
+            _aligned_free(a.acc);
+            _aligned_free(a.acc8);
+            _aligned_free(a.rotX);
+            _aligned_free(a.rotY);
+            _aligned_free(a.offsets);
+            _aligned_free(a.rdx);
+            _aligned_free(a.rdy);
+            _aligned_free(a.rowX);
+            _aligned_free(a.rowY);
+            _aligned_free(a.rowDx);
+            _aligned_free(a.rowDy);
+            _aligned_free(a.rowOff);
+            _aligned_free(a.window);
+        }
+        delete[] m->arenas;
+    }
+    _aligned_free(m->candidates);
+    _aligned_free(m->threadBest);
+    _aligned_free(m->fineResults);
+    _aligned_free(m->lazyGrad.plane);
+    delete m;
+}
+
+// Per-caller thread budget: calls on this matcher lease at most `threads`
+// cores (clamped to the thread count it was created with; ≤ 0 restores that).
+EXPORT void __cdecl NvSetMatcherThreads(NvMatcher* m, int threads)
+{
+    if (!m) return;
+    m->threadBudget = threads > 0 ? std::min(threads, m->numThreads) : m->numThreads;
+}
+
+// Edge-density pruning (PruneSearchEdges): searches on this matcher skip
+// windows whose edge-support bound is below minScore, the score a match must
+// reach to be accepted. The bound is a heuristic, so this is opt-in: ≤ 0
+// turns it off (the default).
+EXPORT void __cdecl NvSetEdgePruning(NvMatcher* m, double minScore)
+{
+    if (!m) return;
+    m->pruneMinScore = std::max(minScore, 0.0);
+}
+
+// Starts a lazy full-resolution gradient of gray on this matcher and returns
+// its plane (null on allocation failure). Pass the plane wherever this
+// matcher's calls take a packed gradient; they compute the tiles they read.
+// gray must stay valid until the next NvBeginLazyGradient on the matcher.
+// Calls without a matcher (NvRefinePoseCompact) read the plane as is: they
+// must only refine a pose that a matcher call on this plane produced.
+EXPORT uint32_t* __cdecl NvBeginLazyGradient(
+    NvMatcher* m, const uint8_t* gray, int width, int height, int stride)
+{
+    LazyGradient& g = m->lazyGrad;
+    size_t pixels = (size_t)width * height;
+    if (width < 1 || height < 1) return nullptr;
+    if (pixels > g.planeCap)
+    {
+        // Not zeroed: pages are faulted in only when a tile is computed
+        uint32_t* p = (uint32_t*)_aligned_malloc(pixels * sizeof(uint32_t), 64);
+        if (!p) return nullptr;
+        _aligned_free(g.plane);
+        g.plane = p;
+        g.planeCap = pixels;
+    }
+    g.gray = gray;
+    g.width = width;
+    g.height = height;
+    g.stride = stride;
+    g.tilesX = (width + LAZY_TILE - 1) / LAZY_TILE;
+    g.tilesY = (height + LAZY_TILE - 1) / LAZY_TILE;
+    g.numThreads = m->numThreads;
+    g.valid.assign((size_t)g.tilesX * g.tilesY, 0);
+    return g.plane;
+}
+
+// Packed gradient handed to a matcher call: the matcher's lazy plane is
+// recognised by address
+static inline GradientView MatcherGradients(NvMatcher* m, const uint32_t* packed)
+{
+    GradientView v = CompactGradients(packed);
+    if (packed && packed == m->lazyGrad.plane && !m->lazyGrad.valid.empty())
+        v.lazy = &m->lazyGrad;
+    return v;
+}
+
+// ─── Per-pixel scoring (external API) ───────────────────────────────────────
+
+static double EvaluatePose(
+    NvMatcher* m,
+    int px, int py,
+    const int* __restrict rx, const int* __restrict ry,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const GradientView& grad,
+    int imgW, int N,
+    float thresh, float greedy,
+    int contrastInvariant)
+{
+    if (!EnsurePoints(m, N)) return 0.0;
+
+    if (grad.lazy)
+    {
+        int reach = 0;
+        for (int i = 0; i < N; i++)
+            reach = std::max(reach, std::max(abs(rx[i]), abs(ry[i])));
+        reach += LAZY_REFINE_PAD;
+        TouchGradient(grad, px - reach, py - reach, px + reach, py + reach);
+    }
+
+    // Build offsets into the caller's arena
+    int alignedN = (N + 7) & ~7;
+    int* offsets = m->arenas[0].offsets;
+    for (int i = 0; i < N; i++)
+        offsets[i] = ry[i] * imgW + rx[i];
+    // Zero-pad remainder for safe SIMD load
+    for (int i = N; i < alignedN; i++)
+        offsets[i] = 0;
+
+    double score = EvaluateNativeInternal(
+        px, py, offsets, rdx, rdy, grad,
+        imgW, N, thresh, greedy, contrastInvariant);
+    StatAdd(NV_COUNT_EVALUATIONS, 1);
+    if (score == 0.0 && greedy > 0.0f) StatAdd(NV_COUNT_EARLY_EXITS, 1);
+    return score;
+}
+
+EXPORT double __cdecl NvEvaluate(
+    NvMatcher* m,
+    int px, int py,
+    const int* __restrict rx, const int* __restrict ry,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const float* __restrict dxImg, const float* __restrict dyImg, const float* __restrict magImg,
+    int imgW, int N,
+    float thresh, float greedy,
+    int contrastInvariant)
+{
+    return EvaluatePose(m, px, py, rx, ry, rdx, rdy,
+        FloatGradients(dxImg, dyImg, magImg), imgW, N, thresh, greedy, contrastInvariant);
+}
+
+// Same, reading the packed int16 plane from ComputeGradientCompactNative
+EXPORT double __cdecl NvEvaluateCompact(
+    NvMatcher* m,
+    int px, int py,
+    const int* __restrict rx, const int* __restrict ry,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const uint32_t* __restrict packedImg,
+    int imgW, int N,
+    float thresh, float greedy,
+    int contrastInvariant)
+{
+    return EvaluatePose(m, px, py, rx, ry, rdx, rdy,
+        MatcherGradients(m, packedImg), imgW, N, thresh, greedy, contrastInvariant);
+}
+
+// Legacy signature: runs on a throw-away matcher
+EXPORT double __cdecl EvaluateNative(
+    int px, int py,
+    const int* __restrict rx, const int* __restrict ry,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const float* __restrict dxImg, const float* __restrict dyImg, const float* __restrict magImg,
+    int imgW, int N,
+    float thresh, float greedy,
+    int contrastInvariant)
+{
+    NvMatcher* m = NvCreateMatcher(0, 0, N, 1);
+    if (!m) return 0.0;
+    double result = NvEvaluate(m, px, py, rx, ry, rdx, rdy,
+        dxImg, dyImg, magImg, imgW, N, thresh, greedy, contrastInvariant);
+    NvDestroyMatcher(m);
+    return result;
+}
+
+// ─── Batch: score entire refinement grid for one pose ────────────────────────
+
+EXPORT double __cdecl NvEvaluateBatch(
+    NvMatcher* m,
+    int baseCx, int baseCy, int refRadius,
+    const int* __restrict rx, const int* __restrict ry,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const float* __restrict dxImg, const float* __restrict dyImg, const float* __restrict magImg,
+    int imgW, int imgH, int N, int margin,
+    float thresh, float greedy,
+    int* outDx, int* outDy,
+    int contrastInvariant)
+{
+    // Pre-compute offsets once for all grid positions
+    if (!EnsurePoints(m, N)) { *outDx = 0; *outDy = 0; return 0.0; }
+    int alignedN = (N + 7) & ~7;
+    int* offsets = m->arenas[0].offsets;
+    for (int i = 0; i < N; i++)
+        offsets[i] = ry[i] * imgW + rx[i];
+    for (int i = N; i < alignedN; i++)
+        offsets[i] = 0;
+
+    GradientView grad = FloatGradients(dxImg, dyImg, magImg);
+    double bestScore = 0.0;
+    int bestDx = 0, bestDy = 0;
+
+    for (int dy = -refRadius; dy <= refRadius; dy++)
+    {
+        int py = baseCy + dy;
+        if (py < margin || py >= imgH - margin) continue;
+
+        for (int dx = -refRadius; dx <= refRadius; dx++)
+        {
+            int px = baseCx + dx;
+            if (px < margin || px >= imgW - margin) continue;
+
+            double score = EvaluateNativeInternal(
+                px, py, offsets, rdx, rdy, grad,
+                imgW, N, thresh, greedy,
+                contrastInvariant);
+
+            if (score > bestScore)
+            {
+                bestScore = score;
+                bestDx = dx;
+                bestDy = dy;
+            }
+        }
+    }
+
+    *outDx = bestDx;
+    *outDy = bestDy;
+    return bestScore;
+}
+
+EXPORT double __cdecl EvaluateBatchNative(
+    int baseCx, int baseCy, int refRadius,
+    const int* __restrict rx, const int* __restrict ry,
+    const float* __restrict rdx, const float* __restrict rdy,
+    const float* __restrict dxImg, const float* __restrict dyImg, const float* __restrict magImg,
+    int imgW, int imgH, int N, int margin,
+    float thresh, float greedy,
+    int* outDx, int* outDy,
+    int contrastInvariant)
+{
+    NvMatcher* m = NvCreateMatcher(0, 0, N, 1);
+    if (!m) { *outDx = 0; *outDy = 0; return 0.0; }
+    double result = NvEvaluateBatch(m, baseCx, baseCy, refRadius, rx, ry, rdx, rdy,
+        dxImg, dyImg, magImg, imgW, imgH, N, margin, thresh, greedy,
+        outDx, outDy, contrastInvariant);
+    NvDestroyMatcher(m);
+    return result;
+}
+
+// ─── Hough voting helpers (shared by single- and multi-instance search) ─────
+
+// Model points in bin order (slot bi holds point binIndices[bi], the layout
+// the vote kernels expect), gathered once per call so every angle rotates
+// contiguous arrays. Returns the largest distance of a model point from the
+// origin.
+static double GatherVotePoints(
+    const float* modelX, const float* modelY, const int* binIndices, int modelCount,
+    float* voteX, float* voteY)
+{
+    double r2 = 0.0;
+    for (int bi = 0; bi < modelCount; bi++)
+    {
+        int i = binIndices[bi];
+        voteX[bi] = modelX[i];
+        voteY[bi] = modelY[i];
+        r2 = std::max(r2, (double)modelX[i] * modelX[i] + (double)modelY[i] * modelY[i]);
+    }
+    return sqrt(r2);
+}
+
+// Single-model form: the points land in m->voteX/voteY
+static double PrepareVotePoints(
+    NvMatcher* m, const float* modelX, const float* modelY, const int* binIndices, int modelCount)
+{
+    m->voteX.resize(modelCount);
+    m->voteY.resize(modelCount);
+    return GatherVotePoints(modelX, modelY, binIndices, modelCount, m->voteX.data(), m->voteY.data());
+}
+
+// Rotate + scale the bin-ordered points for one vote angle: float32, four
+// points per SSE2 step (x64 baseline), truncating v + 0.5 like the original
+// double-precision loop.
+static void RotateModelPoints(
+    const float* voteX, const float* voteY, int modelCount,
+    double angleDeg, double invScale,
+    int* rotX, int* rotY)
+{
+    const double DEG2RAD = 3.14159265358979323846 / 180.0;
+    double rad = angleDeg * DEG2RAD;
+    float c = (float)(cos(rad) * invScale);
+    float sn = (float)(sin(rad) * invScale);
+
+    __m128 vc = _mm_set1_ps(c), vs = _mm_set1_ps(sn), half = _mm_set1_ps(0.5f);
+    int i = 0;
+    for (; i + 4 <= modelCount; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(voteX + i);
+        __m128 y = _mm_loadu_ps(voteY + i);
+        __m128 rx = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(x, vc), _mm_mul_ps(y, vs)), half);
+        __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, vs), _mm_mul_ps(y, vc)), half);
+        _mm_storeu_si128((__m128i*)(rotX + i), _mm_cvttps_epi32(rx));
+        _mm_storeu_si128((__m128i*)(rotY + i), _mm_cvttps_epi32(ry));
+    }
+    for (; i < modelCount; i++)
+    {
+        rotX[i] = (int)(voteX[i] * c - voteY[i] * sn + 0.5f);
+        rotY[i] = (int)(voteX[i] * sn + voteY[i] * c + 0.5f);
+    }
+}
+
+static inline int AngleBinShift(double angleDeg, int numGradBins)
+{
+    double binWidthDeg = 360.0 / numGradBins;
+    return (int)(angleDeg / binWidthDeg + (angleDeg >= 0 ? 0.5 : -0.5));
+}
+
+// Clear the accumulator and cast every search edge's votes for one angle.
+// Each edge votes with model points from its own bin and the two neighbours.
+static void AccumulateVotes(
+    uint16_t* acc, int bW, int bH,
+    const int* rotX, const int* rotY,
+    const int* binOffsets, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    double angleDeg, int binShiftBits)
+{
+    memset(acc, 0, (size_t)bW * bH * sizeof(uint16_t));
+    g_kernels.vote(acc, bW, bH, 0, rotX, rotY, binOffsets, numGradBins,
+        searchX, searchY, searchBin, searchEdgeCount,
+        AngleBinShift(angleDeg, numGradBins), binShiftBits);
+    StatAdd(NV_COUNT_ANGLES_VOTED, 1);
+    StatAdd(NV_COUNT_EDGES_VOTED, searchEdgeCount);
+    StatAdd(NV_COUNT_ACC_CELLS, (int64_t)bW * bH);
+}
+
+// Accumulator bands are sized to stay resident in a typical L2
+static const size_t VOTE_BAND_BYTES = 256 * 1024;
+
+// Rows per accumulator band. Banding needs the edges sorted by y (both edge
+// extractors emit them row-major) so a band can find its edges by binary
+// search; a band is never thinner than the model's vote footprint, which would
+// make every edge vote in many bands.
+static int VoteBandRows(int bW, int bH, int reach, int binShiftBits,
+                        const int* searchY, int searchEdgeCount)
+{
+    int rows = (int)(VOTE_BAND_BYTES / ((size_t)bW * sizeof(uint16_t)));
+    rows = std::max(rows, 2 * ((reach >> binShiftBits) + 1));
+    if (rows >= bH || !std::is_sorted(searchY, searchY + searchEdgeCount)) return bH;
+    return rows;
+}
+
+// Vote one angle band by band and return its peak: votes, and the cell index
+// in the full bW × bH accumulator. reach bounds |rotY| for every point.
+// With runs (an edge-pruned model, PruneSearchEdges) only the cells the
+// edges reach are cleared and scanned.
+static int VoteAndFindPeak(
+    uint16_t* acc, int bW, int bH, int bandRows, int reach,
+    const int* rotX, const int* rotY,
+    const int* binOffsets, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    double angleDeg, int binShiftBits, int* outIdx,
+    const CellRuns* runs = nullptr)
+{
+    int binShift = AngleBinShift(angleDeg, numGradBins);
+    int best = 0, bestIdx = 0;
+    int64_t edgesVoted = 0, cells = 0;
+
+    for (int r0 = 0; r0 < bH; r0 += bandRows)
+    {
+        int rows = std::min(bandRows, bH - r0);
+        int lo = 0, hi = searchEdgeCount;
+        if (rows < bH)
+        {
+            // An edge reaches cell rows [(ey - reach) >> s, (ey + reach) >> s]
+            lo = (int)(std::lower_bound(searchY, searchY + searchEdgeCount,
+                (r0 << binShiftBits) - reach) - searchY);
+            hi = (int)(std::lower_bound(searchY + lo, searchY + searchEdgeCount,
+                ((r0 + rows) << binShiftBits) + reach) - searchY);
+        }
+
+        // A band no edge reaches stays all zero and cannot beat best
+        if (hi == lo) continue;
+
+        if (runs)
+        {
+            for (int y = r0; y < r0 + rows; y++)
+                for (int k = runs->rowStart[y]; k < runs->rowStart[y + 1]; k++)
+                {
+                    int x0 = runs->x0[k], len = runs->x1[k] - x0;
+                    memset(acc + (size_t)(y - r0) * bW + x0, 0, len * sizeof(uint16_t));
+                    cells += len;
+                }
+        }
+        else
+        {
+            memset(acc, 0, (size_t)bW * rows * sizeof(uint16_t));
+            cells += (int64_t)bW * rows;
+        }
+        g_kernels.vote(acc, bW, rows, r0, rotX, rotY, binOffsets, numGradBins,
+            searchX + lo, searchY + lo, searchBin + lo, hi - lo, binShift, binShiftBits);
+        edgesVoted += hi - lo;
+
+        int idx;
+        if (runs)
+        {
+            for (int y = r0; y < r0 + rows; y++)
+                for (int k = runs->rowStart[y]; k < runs->rowStart[y + 1]; k++)
+                {
+                    int x0 = runs->x0[k];
+                    int votes = g_kernels.peak(acc + (size_t)(y - r0) * bW + x0, runs->x1[k] - x0, &idx);
+                    if (votes > best) { best = votes; bestIdx = y * bW + x0 + idx; }
+                }
+            continue;
+        }
+        int votes = g_kernels.peak(acc, bW * rows, &idx);
+        if (votes > best) { best = votes; bestIdx = r0 * bW + idx; }
+    }
+    StatAdd(NV_COUNT_ANGLES_VOTED, 1);
+    StatAdd(NV_COUNT_EDGES_VOTED, edgesVoted);
+    StatAdd(NV_COUNT_ACC_CELLS, cells);
+    *outIdx = bestIdx;
+    return best;
+}
+
+// ─── Response maps (LINE-2D Phase 1) ────────────────────────────────────────
+// The Phase 1 engine of models with voteMode NV_VOTE_RESPONSE. Every search
+// edge's phase bin is quantised to one of 8 orientations over 180° and set
+// as a bit at its vote-level pixel; the bits are ORed over a (2·SPREAD+1)²
+// neighbourhood, so a feature still answers when the pose is up to SPREAD
+// pixels off. Per orientation, the response to those bits (RESPONSE_MAX for
+// the same orientation, 1 for a neighbouring one) is stored linearised:
+// RESPONSE_T² planes, plane (ky, kx) holding pixel (gy·T + ky, gx·T + kx) at
+// cell gy·gridW + gx. A feature at offset (rx, ry) then reads one plane at a
+// constant shift for every grid position, and a template is scored at all
+// of them by adding one contiguous row per feature. The cost is features ×
+// grid cells per angle, however cluttered the image; Hough voting costs
+// search edges × points per bin.
+
+static const int RESPONSE_T_BITS = 2;
+static const int RESPONSE_T = 1 << RESPONSE_T_BITS;     // grid stride (vote-level pixels)
+static const int RESPONSE_SPREAD = RESPONSE_T / 2;      // reaches the nearest grid node
+static const int RESPONSE_ORIENTATIONS = 8;
+static const int RESPONSE_MAX = 4;
+static const int RESPONSE_CHUNK = 255 / RESPONSE_MAX;   // features per byte fold
+
+// Response of orientation o to a spread bitmask: RESPONSE_MAX when its own
+// bit is set, else 1 when a neighbouring orientation's is. Plain byte
+// compares and selects, so the linearising loops vectorise.
+static inline uint8_t ResponseOf(uint8_t bits, uint8_t same, uint8_t near)
+{
+    return (bits & same) ? (uint8_t)RESPONSE_MAX : (uint8_t)((bits & near) != 0);
+}
+
+// Build the response maps of one search-edge list (vote-level coordinates)
+static void BuildResponseMaps(
+    ResponseMaps& rm, int threadBudget,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int numGradBins, int width, int height)
+{
+    const int T = RESPONSE_T;
+    rm.width = width;
+    rm.height = height;
+    rm.gridW = (width + T - 1) / T;
+    rm.gridH = (height + T - 1) / T;
+    size_t cells = (size_t)rm.gridW * rm.gridH;
+
+    rm.binOrientation.resize(numGradBins);
+    for (int b = 0; b < numGradBins; b++)
+    {
+        double deg = fmod((b + 0.5) * 360.0 / numGradBins, 180.0);
+        rm.binOrientation[b] = (uint8_t)((int)(deg * RESPONSE_ORIENTATIONS / 180.0) & (RESPONSE_ORIENTATIONS - 1));
+    }
+
+    rm.mask.assign((size_t)width * height, 0);
+    rm.rows.resize((size_t)width * height);
+    rm.maps.resize(RESPONSE_ORIENTATIONS * T * T * cells);
+    for (int e = 0; e < searchEdgeCount; e++)
+    {
+        int x = searchX[e], y = searchY[e];
+        if ((unsigned)x < (unsigned)width && (unsigned)y < (unsigned)height)
+            rm.mask[(size_t)y * width + x] |= (uint8_t)(1 << rm.binOrientation[searchBin[e]]);
+    }
+
+    WorkerLease lease(threadBudget);
+    #pragma omp parallel num_threads(lease.Threads())
+    {
+        lease.Pin();
+
+        #pragma omp for schedule(static)
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t* src = rm.mask.data() + (size_t)y * width;
+            uint8_t* dst = rm.rows.data() + (size_t)y * width;
+            auto clipped = [&](int x)
+            {
+                uint8_t v = 0;
+                for (int k = std::max(0, x - RESPONSE_SPREAD); k <= std::min(width - 1, x + RESPONSE_SPREAD); k++)
+                    v |= src[k];
+                return v;
+            };
+            int x0 = std::min(RESPONSE_SPREAD, width), x1 = std::max(x0, width - RESPONSE_SPREAD);
+            for (int x = 0; x < x0; x++) dst[x] = clipped(x);
+            for (int x = x0; x < x1; x++)
+            {
+                uint8_t v = 0;
+                for (int k = -RESPONSE_SPREAD; k <= RESPONSE_SPREAD; k++) v |= src[x + k];
+                dst[x] = v;
+            }
+            for (int x = x1; x < width; x++) dst[x] = clipped(x);
+        }
+
+        // Column pass back into mask: each output row ORs whole input rows
+        #pragma omp for schedule(static)
+        for (int y = 0; y < height; y++)
+        {
+            uint8_t* dst = rm.mask.data() + (size_t)y * width;
+            memcpy(dst, rm.rows.data() + (size_t)y * width, width);
+            for (int k = std::max(0, y - RESPONSE_SPREAD); k <= std::min(height - 1, y + RESPONSE_SPREAD); k++)
+            {
+                const uint8_t* src = rm.rows.data() + (size_t)k * width;
+                if (k != y)
+                    for (int x = 0; x < width; x++) dst[x] |= src[x];
+            }
+        }
+
+        // Linearise: grid row gy of every plane, written contiguously.
+        // Pixels past the image edge respond with 0.
+        #pragma omp for schedule(static)
+        for (int gy = 0; gy < rm.gridH; gy++)
+            for (int o = 0; o < RESPONSE_ORIENTATIONS; o++)
+            {
+                uint8_t same = (uint8_t)(1 << o);
+                uint8_t near = (uint8_t)(1 << ((o + 1) % RESPONSE_ORIENTATIONS)
+                             | 1 << ((o + RESPONSE_ORIENTATIONS - 1) % RESPONSE_ORIENTATIONS));
+                for (int ky = 0; ky < T; ky++)
+                    for (int kx = 0; kx < T; kx++)
+                    {
+                        uint8_t* dst = rm.maps.data() + ((size_t)(o * T + ky) * T + kx) * cells
+                                     + (size_t)gy * rm.gridW;
+                        int y = gy * T + ky;
+                        if (y >= height)
+                        {
+                            memset(dst, 0, rm.gridW);
+                            continue;
+                        }
+                        const uint8_t* src = rm.mask.data() + (size_t)y * width + kx;
+                        int inside = (width - kx + T - 1) / T;
+                        for (int gx = 0; gx < inside; gx++)
+                            dst[gx] = ResponseOf(src[gx * T], same, near);
+                        memset(dst + inside, 0, rm.gridW - inside);
+                    }
+            }
+    }
+}
+
+// Response sum of the rotated points with the template centred on vote-level
+// pixel (cx, cy)
+static int ResponseAt(
+    const ResponseMaps& rm, const int* rotX, const int* rotY,
+    const int* binOffsets, int numGradBins, int binShift, int cx, int cy)
+{
+    const int T = RESPONSE_T;
+    size_t cells = (size_t)rm.gridW * rm.gridH;
+    int sum = 0;
+    for (int b = 0; b < numGradBins; b++)
+    {
+        int o = rm.binOrientation[((b + binShift) % numGradBins + numGradBins) % numGradBins];
+        const uint8_t* planes = rm.maps.data() + (size_t)o * T * T * cells;
+        for (int i = binOffsets[b]; i < binOffsets[b + 1]; i++)
+        {
+            int x = cx + rotX[i], y = cy + rotY[i];
+            if ((unsigned)x >= (unsigned)(rm.gridW * T) || (unsigned)y >= (unsigned)(rm.gridH * T))
+                continue;
+            sum += planes[(size_t)((y & (T - 1)) * T + (x & (T - 1))) * cells
+                          + (size_t)(y >> RESPONSE_T_BITS) * rm.gridW + (x >> RESPONSE_T_BITS)];
+        }
+    }
+    return sum;
+}
+
+// Score one angle at every grid position, then search the pixels around the
+// best one. Returns its response sum and leaves its vote-level centre in
+// (*outX, *outY). rotX/rotY are the bin-ordered points (RotateModelPoints);
+// score must hold gridW × gridH cells and acc8 as many zeroed bytes, which
+// it is left as.
+static int ResponseAndFindPeak(
+    const ResponseMaps& rm, uint8_t* acc8, uint16_t* score,
+    const int* rotX, const int* rotY, const int* binOffsets, int numGradBins,
+    double angleDeg, int* outX, int* outY)
+{
+    const int T = RESPONSE_T;
+    int cells = rm.gridW * rm.gridH;
+    int binShift = AngleBinShift(angleDeg, numGradBins);
+    memset(score, 0, (size_t)cells * sizeof(uint16_t));
+
+    int pending = 0;
+    for (int b = 0; b < numGradBins; b++)
+    {
+        int o = rm.binOrientation[((b + binShift) % numGradBins + numGradBins) % numGradBins];
+        const uint8_t* planes = rm.maps.data() + (size_t)o * T * T * cells;
+        for (int i = binOffsets[b]; i < binOffsets[b + 1]; i++)
+        {
+            // Rows wrap at the grid edge; those positions put the template
+            // partly outside the image and score low anyway
+            const uint8_t* plane = planes + (size_t)((rotY[i] & (T - 1)) * T + (rotX[i] & (T - 1))) * cells;
+            int shift = (rotY[i] >> RESPONSE_T_BITS) * rm.gridW + (rotX[i] >> RESPONSE_T_BITS);
+            int lo = std::max(0, -shift), hi = std::min(cells, cells - shift);
+            if (lo < hi) g_kernels.responseAdd(acc8 + lo, plane + lo + shift, hi - lo);
+            if (++pending == RESPONSE_CHUNK)
+            {
+                g_kernels.responseFold(score, acc8, cells);
+                pending = 0;
+            }
+        }
+    }
+    if (pending) g_kernels.responseFold(score, acc8, cells);
+
+    int idx;
+    g_kernels.peak(score, cells, &idx);
+    int gx = (idx % rm.gridW) * T, gy = (idx / rm.gridW) * T;
+    int best = -1;
+    for (int dy = -RESPONSE_SPREAD; dy <= RESPONSE_SPREAD; dy++)
+        for (int dx = -RESPONSE_SPREAD; dx <= RESPONSE_SPREAD; dx++)
+        {
+            int v = ResponseAt(rm, rotX, rotY, binOffsets, numGradBins, binShift, gx + dx, gy + dy);
+            if (v > best || (v == best && dx == 0 && dy == 0))
+            {
+                best = v;
+                *outX = gx + dx;
+                *outY = gy + dy;
+            }
+        }
+    StatAdd(NV_COUNT_ANGLES_VOTED, 1);
+    StatAdd(NV_COUNT_ACC_CELLS, cells);
+    return best;
+}
+
+// ─── Scale-aware voting ─────────────────────────────────────────────────────
+// Phase 1 used to vote at scale 1 only and leave the whole scale range to
+// Phase 2, whose bank is angles × scales deep: MinScale 0.7 – MaxScale 1.3 at
+// 0.01 steps is 61 scales per angle, and a part far from scale 1 could lose
+// the vote to clutter. Voting now sweeps a few scales as well, as far apart
+// as the accumulator tolerates: a scale off by e moves a model point at
+// radius r by r·e, which stays within one vote bin (Hough) or the response
+// spread (LINE-2D) while e ≤ tolerance / footprint. The winning vote keeps
+// its scale and Phase 2 scores only the band the vote cannot resolve. A
+// range inside one tolerance keeps a single vote scale and the full Phase 2
+// range, as before.
+
+static const int MAX_VOTE_SCALES = 7;
+
+// footprint and tolerance in vote-level pixels
+static void PlanVoteScales(VoteScaleGrid& g, double center, double range, double step,
+    double footprint, double tolerance)
+{
+    g.center = center;
+    g.range = range;
+    g.step = step;
+    g.halfSteps = range > 0.0 && step > 0.0 ? (int)floor((range + 0.001) / step) : 0;
+    g.stride = 0;
+    g.offsets.assign(1, 0);
+    if (g.halfSteps == 0 || footprint <= 0.0) return;
+
+    // The range splits into cells at most 2e wide, one vote scale at the
+    // centre of each, so every scale of the range is within e of a vote
+    int cell = std::max(1, (int)(2.0 * tolerance / footprint / step));
+    int count = std::min((2 * g.halfSteps + cell - 1) / cell, MAX_VOTE_SCALES);
+    if (count <= 1) return;
+    double width = 2.0 * g.halfSteps / count;
+    g.stride = (int)ceil(width);
+    g.offsets.clear();
+    for (int k = 0; k < count; k++)
+        g.offsets.push_back((int)lround(-g.halfSteps + (k + 0.5) * width));
+}
+
+static inline double VoteScale(const VoteScaleGrid& g, int k)
+{
+    return g.center + g.offsets[k] * g.step;
+}
+
+// Phase 2 scale band for a vote at `scale`: half a cell and one fine step
+// either side, moved inside the range so its scales stay on the full grid;
+// the full range when that band would cover it anyway
+static void VoteScaleBand(const VoteScaleGrid& g, double scale, double* center, double* range)
+{
+    int h = g.stride / 2 + 1;
+    if (g.stride == 0 || h >= g.halfSteps)
+    {
+        *center = g.center;
+        *range = g.range;
+        return;
+    }
+    int v = (int)lround((scale - g.center) / g.step);
+    v = std::min(std::max(v, h - g.halfSteps), g.halfSteps - h);
+    *center = g.center + v * g.step;
+    *range = h * g.step;
+}
+
+// ─── Edge-density pruning ───────────────────────────────────────────────────
+// Voting and Phase 2 treat every position of the frame alike, yet on a large,
+// mostly featureless frame few windows hold enough edges for a match. A model
+// outline covers K distinct vote-level pixels; a pose that scores s shows a
+// good share of them as search edges, so a window with E search edges bounds
+// the score of every centre it covers by E / (K · PRUNE_SUPPORT). E comes
+// from an integral image of the edge counts per accumulator cell, so each
+// bound costs four reads; windows are widened to whole cells.
+//
+// The bound is a heuristic, not a proof: Phase 2 scores gradient direction,
+// not Canny edges. PRUNE_SUPPORT keeps it generous — a match only has to keep
+// that share of its outline through Canny at the vote level — and K is taken
+// at the smallest vote scale. With a minimum score set (NvSetEdgePruning) a
+// Hough model votes with only the edges that reach a cell whose bound
+// clears it, so every such cell keeps all its votes, and when those edges
+// reach a small part of the accumulator only that part is cleared and
+// scanned per angle. Phase 2 then skips models whose window bound is below
+// the minimum. Being a heuristic, the bound is never compared with the
+// running best score: that would drop poses depending on which thread scored
+// first. Response-map models vote with every edge (their maps are shared) but
+// get the same Phase 2 bound.
+
+static const double PRUNE_SUPPORT = 0.5;
+
+// Integral image of the search-edge counts per bW × bH accumulator cell,
+// (bW + 1) × (bH + 1)
+static void BuildEdgeIntegral(std::vector<int>& ii,
+    const int* searchX, const int* searchY, int searchEdgeCount, int w, int h, int binShiftBits)
+{
+    size_t stride = (size_t)w + 1;
+    ii.assign(stride * (h + 1), 0);
+    for (int e = 0; e < searchEdgeCount; e++)
+    {
+        int cx = searchX[e] >> binShiftBits, cy = searchY[e] >> binShiftBits;
+        if ((unsigned)cx < (unsigned)w && (unsigned)cy < (unsigned)h)
+            ii[(cy + 1) * stride + cx + 1]++;
+    }
+    for (int y = 1; y <= h; y++)
+    {
+        int* row = ii.data() + y * stride;
+        const int* above = row - stride;
+        int run = 0;
+        for (int x = 1; x <= w; x++)
+        {
+            run += row[x];
+            row[x] = above[x] + run;
+        }
+    }
+}
+
+// Sum of a (w + 1) × (h + 1) integral image over [x0, x1] × [y0, y1], clipped
+static inline int BoxSum(const int* ii, int w, int h, int x0, int y0, int x1, int y1)
+{
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, w - 1);
+    y1 = std::min(y1, h - 1);
+    if (x0 > x1 || y0 > y1) return 0;
+    size_t stride = (size_t)w + 1;
+    return ii[(y1 + 1) * stride + x1 + 1] - ii[(y1 + 1) * stride + x0]
+         - ii[y0 * stride + x1 + 1] + ii[y0 * stride + x0];
+}
+
+// Distinct pixels of the model outline at `scale` vote-level pixels per unit
+static int OutlinePixels(std::vector<int64_t>& keys,
+    const float* modelX, const float* modelY, int modelCount, double scale)
+{
+    keys.resize(modelCount);
+    for (int i = 0; i < modelCount; i++)
+        keys[i] = (int64_t)lround(modelY[i] * scale) * 65536 + lround(modelX[i] * scale);
+    std::sort(keys.begin(), keys.end());
+    return (int)(std::unique(keys.begin(), keys.end()) - keys.begin());
+}
+
+// Edge-support bound of the window [cx ± half] × [cy ± half] (vote level)
+// over a bW × bH cell grid
+static inline double WindowBound(const NvMatcher* m, int bW, int bH, int binShiftBits,
+    int outline, int cx, int cy, int half)
+{
+    int edges = BoxSum(m->edgeIntegral.data(), bW, bH, (cx - half) >> binShiftBits,
+        (cy - half) >> binShiftBits, (cx + half) >> binShiftBits, (cy + half) >> binShiftBits);
+    return edges / (std::max(outline, 1) * PRUNE_SUPPORT);
+}
+
+// Runs shorter than this gap are joined: one longer memset / peak scan is
+// cheaper than two calls
+static const int RUN_MERGE_GAP = 32;
+
+// Runs of the nonzero flags per row, gaps under RUN_MERGE_GAP joined.
+// Returns the cells they cover.
+static int64_t BuildCellRuns(CellRuns& r, const uint8_t* flags, int w, int h)
+{
+    r.rowStart.resize(h + 1);
+    r.x0.clear();
+    r.x1.clear();
+    int64_t cells = 0;
+    for (int y = 0; y < h; y++)
+    {
+        r.rowStart[y] = (int)r.x0.size();
+        const uint8_t* row = flags + (size_t)y * w;
+        for (int x = 0; x < w;)
+        {
+            if (!row[x]) { x++; continue; }
+            int x0 = x;
+            while (x < w && row[x]) x++;
+            if (r.x0.size() > (size_t)r.rowStart[y] && x0 - r.x1.back() < RUN_MERGE_GAP)
+            {
+                cells += x - r.x1.back();
+                r.x1.back() = x;
+                continue;
+            }
+            r.x0.push_back(x0);
+            r.x1.push_back(x);
+            cells += x - x0;
+        }
+    }
+    r.rowStart[h] = (int)r.x0.size();
+    return cells;
+}
+
+// Append to m->pruneX/Y/Bin the search edges of model s that can vote into a
+// cell whose bound reaches m->pruneMinScore, in their original (row-major)
+// order, and lay out the cells they reach (s.reached; s.sparse when that is
+// at most a quarter of the accumulator). m->edgeIntegral must hold this
+// search's edge counts. Returns the edge count.
+static int PruneSearchEdges(NvMatcher* m, ModelSearch& s,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int bW, int bH, int binShiftBits)
+{
+    // Cell (cx, cy) holds the centres [cx·bin, cx·bin + bin - 1]; their
+    // points lie within reach, so its window is that square plus reach:
+    // cells cx + lo … cx + hi
+    int lo = (-s.reach) >> binShiftBits, hi = ((1 << binShiftBits) - 1 + s.reach) >> binShiftBits;
+    int need = (int)ceil(m->pruneMinScore * PRUNE_SUPPORT * std::max(s.outline, 1) - 1e-9);
+    std::vector<int>& ci = m->cellIntegral;
+    std::vector<uint8_t>& flags = m->cellFlags;
+    size_t stride = (size_t)bW + 1;
+    ci.assign(stride * (bH + 1), 0);
+    int valid = 0;
+    for (int cy = 0; cy < bH; cy++)
+    {
+        int* row = ci.data() + (cy + 1) * stride;
+        const int* above = row - stride;
+        int run = 0;
+        for (int cx = 0; cx < bW; cx++)
+        {
+            run += BoxSum(m->edgeIntegral.data(), bW, bH, cx + lo, cy + lo, cx + hi, cy + hi) >= need;
+            row[cx + 1] = above[cx + 1] + run;
+        }
+        valid += run;
+    }
+    StatAdd(NV_COUNT_WINDOWS_BOUNDED, (int64_t)bW * bH);
+    StatAdd(NV_COUNT_WINDOWS_REJECTED, (int64_t)bW * bH - valid);
+
+    // An edge at (ex, ey) votes into cells [(ex - reach) >> s, (ex + reach) >> s]
+    // (both axes); keep it if any of them is valid
+    size_t first = m->pruneX.size();
+    for (int e = 0; e < searchEdgeCount && valid > 0; e++)
+    {
+        int ex = searchX[e], ey = searchY[e];
+        if (BoxSum(ci.data(), bW, bH, (ex - s.reach) >> binShiftBits, (ey - s.reach) >> binShiftBits,
+                (ex + s.reach) >> binShiftBits, (ey + s.reach) >> binShiftBits) == 0)
+            continue;
+        m->pruneX.push_back(ex);
+        m->pruneY.push_back(ey);
+        m->pruneBin.push_back(searchBin[e]);
+    }
+    int kept = (int)(m->pruneX.size() - first);
+    StatAdd(NV_COUNT_EDGES_PRUNED, searchEdgeCount - kept);
+
+    // Cells the kept edges reach: their squares summed in a difference table
+    ci.assign(stride * (bH + 1), 0);
+    flags.assign((size_t)bW * bH, 0);
+    for (size_t e = first; e < m->pruneX.size(); e++)
+    {
+        int x0 = std::max((m->pruneX[e] - s.reach) >> binShiftBits, 0);
+        int y0 = std::max((m->pruneY[e] - s.reach) >> binShiftBits, 0);
+        int x1 = std::min(((m->pruneX[e] + s.reach) >> binShiftBits) + 1, bW);
+        int y1 = std::min(((m->pruneY[e] + s.reach) >> binShiftBits) + 1, bH);
+        if (x0 >= x1 || y0 >= y1) continue;
+        ci[y0 * stride + x0]++;
+        ci[y0 * stride + x1]--;
+        ci[y1 * stride + x0]--;
+        ci[y1 * stride + x1]++;
+    }
+    for (int cy = 0; cy < bH; cy++)
+    {
+        int* row = ci.data() + cy * stride;
+        const int* above = cy > 0 ? row - stride : nullptr;
+        uint8_t* f = flags.data() + (size_t)cy * bW;
+        int run = 0;
+        for (int cx = 0; cx < bW; cx++)
+        {
+            run += row[cx];
+            row[cx] = run + (above ? above[cx] : 0);
+            f[cx] = row[cx] > 0;
+        }
+    }
+    s.sparse = BuildCellRuns(s.reached, flags.data(), bW, bH) * 4 <= (int64_t)bW * bH;
+    return kept;
+}
+
+// ─── Native Hough Voting with OpenMP (Phase 1) ──────────────────────────────
+
+// Insert c into a votes-descending top-K list if it beats the last entry
+static inline void InsertTopK(Candidate* list, int topK, const Candidate& c)
+{
+    if (c.votes <= list[topK - 1].votes) return;
+    list[topK - 1] = c;
+    for (int k = topK - 1; k > 0 && list[k].votes > list[k - 1].votes; k--)
+        std::swap(list[k], list[k - 1]);
+}
+
+// Phase 1 for models sharing one search-edge list. Every (model × vote
+// scale × coarse angle) is one work item of a single parallel region; after
+// the per-model top-K merge, every (model × candidate × fine angle) is
+// another, at the candidate's scale. Each model uses its own engine
+// (voteMode): Hough votes, or a response sum with a pixel-accurate centre.
+// Leaves each model's best vote (vote-level coordinates) and its Phase 2
+// scale band in m->searches.
+static bool VoteModels(
+    NvMatcher* m, const NvModelDesc* models, int numModels, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int voteWidth, int voteHeight,
+    double angleStart, double angleExtent,
+    double coarseAngleStep, double fineAngleStep, int topK,
+    double scaleCenter, double scaleRange, double scaleStep,
+    double invScale, int binShiftBits)
+{
+    StageTimer timer(NV_STAGE_VOTE_COARSE);
+    int bW = (voteWidth >> binShiftBits) + 1;
+    int bH = (voteHeight >> binShiftBits) + 1;
+    int binSize = 1 << binShiftBits;
+
+    std::vector<ModelSearch>& st = m->searches;
+    st.resize(numModels);
+    size_t totalPoints = 0;
+    int maxPoints = 0;
+    for (int mi = 0; mi < numModels; mi++)
+    {
+        st[mi].voteBase = totalPoints;
+        totalPoints += models[mi].modelCount;
+        maxPoints = std::max(maxPoints, models[mi].modelCount);
+    }
+    m->voteX.resize(totalPoints);
+    m->voteY.resize(totalPoints);
+
+    // One scale set for the batch, spaced for the widest model and the
+    // tighter engine
+    std::vector<double> footprints(numModels);
+    double maxFootprint = 0.0, tolerance = binSize;
+    for (int mi = 0; mi < numModels; mi++)
+    {
+        const NvModelDesc& md = models[mi];
+        footprints[mi] = GatherVotePoints(md.modelX, md.modelY, md.binIndices, md.modelCount,
+            m->voteX.data() + st[mi].voteBase, m->voteY.data() + st[mi].voteBase);
+        maxFootprint = std::max(maxFootprint, footprints[mi] * invScale);
+        if (md.voteMode == NV_VOTE_RESPONSE)
+            tolerance = std::min(tolerance, (double)RESPONSE_SPREAD);
+    }
+    VoteScaleGrid& scales = m->voteScales;
+    PlanVoteScales(scales, scaleCenter, scaleRange, scaleStep, maxFootprint, tolerance);
+    int numScales = (int)scales.offsets.size();
+    double maxVoteScale = VoteScale(scales, numScales - 1);
+
+    // Edge lists: every search edge, or with pruning on, a Hough model's
+    // edges near the cells that can still reach the minimum score
+    bool prune = m->pruneMinScore > 0.0;
+    if (prune)
+    {
+        StageTimer pruneTimer(NV_STAGE_PRUNE);
+        BuildEdgeIntegral(m->edgeIntegral, searchX, searchY, searchEdgeCount, bW, bH, binShiftBits);
+        m->pruneX.clear();
+        m->pruneY.clear();
+        m->pruneBin.clear();
+    }
+    std::vector<size_t> pruneBase(numModels, 0);
+    for (int mi = 0; mi < numModels; mi++)
+    {
+        const NvModelDesc& md = models[mi];
+        ModelSearch& s = st[mi];
+        s.reach = (int)ceil(footprints[mi] * invScale * maxVoteScale) + 1;
+        s.edgeX = searchX;
+        s.edgeY = searchY;
+        s.edgeBin = searchBin;
+        s.edgeCount = searchEdgeCount;
+        s.pruned = s.sparse = false;
+        s.bound = HUGE_VAL;
+        if (!prune) continue;
+
+        StageTimer pruneTimer(NV_STAGE_PRUNE);
+        s.outline = OutlinePixels(m->outlineKeys, md.modelX, md.modelY, md.modelCount,
+            invScale * VoteScale(scales, 0));
+        if (md.voteMode == NV_VOTE_RESPONSE) continue;
+        pruneBase[mi] = m->pruneX.size();
+        s.pruned = true;
+        s.edgeCount = PruneSearchEdges(m, s, searchX, searchY, searchBin, searchEdgeCount,
+            bW, bH, binShiftBits);
+    }
+
+    size_t accLen = 0, responseCells = 0;
+    for (int mi = 0; mi < numModels; mi++)
+    {
+        const NvModelDesc& md = models[mi];
+        ModelSearch& s = st[mi];
+        if (s.pruned)
+        {
+            // The lists are complete, so the vectors no longer move
+            s.edgeX = m->pruneX.data() + pruneBase[mi];
+            s.edgeY = m->pruneY.data() + pruneBase[mi];
+            s.edgeBin = m->pruneBin.data() + pruneBase[mi];
+        }
+        s.bandRows = VoteBandRows(bW, bH, s.reach, binShiftBits, s.edgeY, s.edgeCount);
+        if (md.voteMode == NV_VOTE_RESPONSE)
+            responseCells = (size_t)((voteWidth + RESPONSE_T - 1) / RESPONSE_T)
+                          * ((voteHeight + RESPONSE_T - 1) / RESPONSE_T);
+        else
+            accLen = std::max(accLen, (size_t)bW * s.bandRows);
+    }
+    if (responseCells > 0)
+    {
+        BuildResponseMaps(m->responseMaps, m->threadBudget, searchX, searchY, searchBin,
+            searchEdgeCount, numGradBins, voteWidth, voteHeight);
+        if (!EnsureResponseAccumulator(m, responseCells)) return false;
+        accLen = std::max(accLen, responseCells);
+    }
+    const float* voteX = m->voteX.data();
+    const float* voteY = m->voteY.data();
+
+    int numCoarseAngles = (int)(angleExtent / coarseAngleStep) + 1;
+    if (numCoarseAngles < 1) numCoarseAngles = 1;
+    int numFine = (int)(2.0 * coarseAngleStep / fineAngleStep) + 1;
+    // Several vote scales: the fine pass also tries a quarter cell either side
+    int quarter = scales.stride / 4;
+    int numFineScales = quarter > 0 ? 3 : 1;
+    int finePerCandidate = numFine * numFineScales;
+
+    // Candidate tables hold numModels × topK; each thread's slice of
+    // threadBest is candCap long
+    int candCount = numModels * topK;
+    if (!EnsureAccumulator(m, accLen) || !EnsurePoints(m, maxPoints) ||
+        !EnsureCandidates(m, candCount, candCount * finePerCandidate))
+        return false;
+
+    Candidate* candidates = m->candidates;
+    Candidate* threadBest = m->threadBest;
+    std::fill(candidates, candidates + candCount, Candidate());
+    for (int t = 0; t < m->numThreads; t++)
+        std::fill(threadBest + (size_t)t * m->candCap, threadBest + (size_t)t * m->candCap + candCount, Candidate());
+
+    std::vector<int>& fineBase = m->itemBase;
+    fineBase.resize(numModels + 1);
+    Candidate* fineResults = m->fineResults;
+    int itemsPerModel = numScales * numCoarseAngles;
+    int coarseItems = numModels * itemsPerModel;
+    int fineItems = 0;
+
+    // Best position of model mi at one angle and scale, with this thread's buffers
+    auto votePose = [&](int mi, double angle, double scale, ThreadArena& arena, Candidate& c)
+    {
+        const NvModelDesc& md = models[mi];
+        const ModelSearch& s = st[mi];
+        uint64_t busy = StatsClock();
+        RotateModelPoints(voteX + s.voteBase, voteY + s.voteBase, md.modelCount,
+            angle, invScale * scale, arena.rotX, arena.rotY);
+        c.angle = angle;
+        c.scale = scale;
+        if (md.voteMode == NV_VOTE_RESPONSE)
+        {
+            int x, y;
+            c.votes = ResponseAndFindPeak(m->responseMaps, arena.acc8, arena.acc,
+                arena.rotX, arena.rotY, md.binOffsets, numGradBins, angle, &x, &y);
+            c.cx = x;
+            c.cy = y;
+        }
+        else
+        {
+            int maxIdx;
+            c.votes = VoteAndFindPeak(arena.acc, bW, bH, s.bandRows, s.reach,
+                arena.rotX, arena.rotY, md.binOffsets, numGradBins,
+                s.edgeX, s.edgeY, s.edgeBin, s.edgeCount,
+                angle, binShiftBits, &maxIdx,
+                s.pruned && s.sparse ? &s.reached : nullptr);
+            c.cx = (maxIdx % bW) * binSize + binSize / 2;
+            c.cy = (maxIdx / bW) * binSize + binSize / 2;
+        }
+        StatsBusy(busy);
+    };
+
+    WorkerLease lease(m->threadBudget);
+    uint64_t span = StatsClock(), fineStart = 0;
+
+    #pragma omp parallel num_threads(lease.Threads())
+    {
+        lease.Pin();
+        int tid = omp_get_thread_num();
+        ThreadArena& arena = m->arenas[tid];
+        Candidate* myBest = threadBest + (size_t)tid * m->candCap;
+
+        // ── Pass 1: coarse scale × angle sweep ──
+        #pragma omp for schedule(dynamic)
+        for (int w = 0; w < coarseItems; w++)
+        {
+            int mi = w / itemsPerModel, local = w % itemsPerModel;
+            Candidate c;
+            votePose(mi, angleStart + (local % numCoarseAngles) * coarseAngleStep,
+                VoteScale(scales, local / numCoarseAngles), arena, c);
+            InsertTopK(myBest + mi * topK, topK, c);
+        }
+
+        // Merge thread-local top K per model and lay out the fine work items
+        #pragma omp single
+        {
+            fineStart = StatsClock();
+            for (int mi = 0; mi < numModels; mi++)
+            {
+                Candidate* cand = candidates + mi * topK;
+                for (int t = 0; t < m->numThreads; t++)
+                {
+                    const Candidate* tb = threadBest + (size_t)t * m->candCap + mi * topK;
+                    for (int i = 0; i < topK; i++)
+                        InsertTopK(cand, topK, tb[i]);
+                }
+
+                int validK = 0;
+                for (int i = 0; i < topK; i++)
+                    if (cand[i].votes > 0) validK++;
+                st[mi].validK = std::max(validK, 1);
+                fineBase[mi] = fineItems;
+                fineItems += st[mi].validK * finePerCandidate;
+            }
+            fineBase[numModels] = fineItems;
+        }
+
+        // ── Pass 2: fine refinement, every model × candidate × fine scale ×
+        // fine angle; the candidate's own scale first, so it wins ties ──
+        #pragma omp for schedule(dynamic)
+        for (int w = 0; w < fineItems; w++)
+        {
+            int mi = (int)(std::upper_bound(fineBase.begin(), fineBase.end(), w) - fineBase.begin()) - 1;
+            int local = w - fineBase[mi];
+            int ci = local / finePerCandidate, fs = local % finePerCandidate / numFine, fi = local % numFine;
+            const Candidate& cand = candidates[mi * topK + ci];
+            double angle = cand.angle - coarseAngleStep + fi * fineAngleStep;
+            int shift = fs == 0 ? 0 : fs == 1 ? -quarter : quarter;
+            double scale = std::min(std::max(cand.scale + shift * scales.step,
+                scales.center - scales.halfSteps * scales.step), scales.center + scales.halfSteps * scales.step);
+            Candidate& r = fineResults[w];
+            r.votes = 0;
+            if (angle < angleStart || angle > angleStart + angleExtent) continue;
+            votePose(mi, angle, scale, arena, r);
+        }
+    }
+
+    StatsSpan(span, lease.Threads());
+    timer.Switch(NV_STAGE_VOTE_FINE, fineStart);
+
+    // Per model: best fine result, or the coarse best if no fine angle voted
+    for (int mi = 0; mi < numModels; mi++)
+    {
+        ModelSearch& s = st[mi];
+        int bestIdx = fineBase[mi];
+        for (int w = fineBase[mi] + 1; w < fineBase[mi + 1]; w++)
+            if (fineResults[w].votes > fineResults[bestIdx].votes)
+                bestIdx = w;
+        s.vote = fineResults[bestIdx].votes > 0 ? fineResults[bestIdx] : candidates[mi * topK];
+        if (s.vote.votes == 0) s.vote.scale = scaleCenter;
+        VoteScaleBand(scales, s.vote.scale, &s.bandCenter, &s.bandRange);
+    }
+    return true;
+}
+
+EXPORT void __cdecl NvHoughVoting(
+    NvMatcher* m,
+    const float* modelX, const float* modelY, int modelCount,
+    const int* binOffsets, const int* binIndices,
+    int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int voteWidth, int voteHeight,
+    double angleStart, double angleExtent,
+    double coarseAngleStep, double fineAngleStep,
+    int topK,
+    double invScale,
+    int binShiftBits,
+    double* outBestCx, double* outBestCy, double* outBestAngle, int* outBestVotes)
+{
+    NvModelDesc md = { modelX, modelY, nullptr, nullptr, binOffsets, binIndices, modelCount, 0,
+                       NV_VOTE_HOUGH, 0 };
+    if (!VoteModels(m, &md, 1, numGradBins, searchX, searchY, searchBin, searchEdgeCount,
+            voteWidth, voteHeight, angleStart, angleExtent, coarseAngleStep, fineAngleStep, topK,
+            1.0, 0.0, 0.0, invScale, binShiftBits))
+    {
+        *outBestCx = *outBestCy = *outBestAngle = 0.0;
+        *outBestVotes = 0;
+        return;
+    }
+
+    const Candidate& v = m->searches[0].vote;
+    *outBestCx = v.cx;
+    *outBestCy = v.cy;
+    *outBestAngle = v.angle;
+    *outBestVotes = v.votes;
+}
+
+// NvHoughVoting that also votes over scaleCenter ± scaleRange (see
+// PlanVoteScales). Returns the voted scale and the Phase 2 scale band to
+// pass to NvAcquirePoseBank in place of the full range.
+EXPORT void __cdecl NvHoughVotingScaled(
+    NvMatcher* m,
+    const float* modelX, const float* modelY, int modelCount,
+    const int* binOffsets, const int* binIndices,
+    int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int voteWidth, int voteHeight,
+    double angleStart, double angleExtent,
+    double coarseAngleStep, double fineAngleStep,
+    int topK,
+    double scaleCenter, double scaleRange, double scaleStep,
+    double invScale,
+    int binShiftBits,
+    double* outBestCx, double* outBestCy, double* outBestAngle, double* outBestScale, int* outBestVotes,
+    double* outBandCenter, double* outBandRange)
+{
+    NvModelDesc md = { modelX, modelY, nullptr, nullptr, binOffsets, binIndices, modelCount, 0,
+                       NV_VOTE_HOUGH, 0 };
+    if (!VoteModels(m, &md, 1, numGradBins, searchX, searchY, searchBin, searchEdgeCount,
+            voteWidth, voteHeight, angleStart, angleExtent, coarseAngleStep, fineAngleStep, topK,
+            scaleCenter, scaleRange, scaleStep, invScale, binShiftBits))
+    {
+        *outBestCx = *outBestCy = *outBestAngle = 0.0;
+        *outBestScale = *outBandCenter = scaleCenter;
+        *outBandRange = scaleRange;
+        *outBestVotes = 0;
+        return;
+    }
+
+    const ModelSearch& s = m->searches[0];
+    *outBestCx = s.vote.cx;
+    *outBestCy = s.vote.cy;
+    *outBestAngle = s.vote.angle;
+    *outBestScale = s.vote.scale;
+    *outBestVotes = s.vote.votes;
+    *outBandCenter = s.bandCenter;
+    *outBandRange = s.bandRange;
+}
+
+EXPORT void __cdecl HoughVotingNative(
+    const float* modelX, const float* modelY, int modelCount,
+    const int* binOffsets, const int* binIndices,
+    int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int voteWidth, int voteHeight,
+    double angleStart, double angleExtent,
+    double coarseAngleStep, double fineAngleStep,
+    int topK,
+    double invScale,
+    int binShiftBits,
+    double* outBestCx, double* outBestCy, double* outBestAngle, int* outBestVotes)
+{
+    NvMatcher* m = NvCreateMatcher(voteWidth >> binShiftBits, voteHeight >> binShiftBits, modelCount,
+        (int)(2.0 * coarseAngleStep / fineAngleStep) + 1);
+    if (!m)
+    {
+        *outBestCx = *outBestCy = *outBestAngle = 0.0;
+        *outBestVotes = 0;
+        return;
+    }
+    NvHoughVoting(m, modelX, modelY, modelCount, binOffsets, binIndices, numGradBins,
+        searchX, searchY, searchBin, searchEdgeCount, voteWidth, voteHeight,
+        angleStart, angleExtent, coarseAngleStep, fineAngleStep, topK,
+        invScale, binShiftBits, outBestCx, outBestCy, outBestAngle, outBestVotes);
+    NvDestroyMatcher(m);
+}
+
+// ─── Batch: score ALL poses × entire refinement grid in one call ─────────────
+// Eliminates per-pose C#→native P/Invoke overhead; OpenMP across poses.
+
+// Score one pose at every position of the (2r+1)² window around (baseCx,
+// baseCy) that keeps the model inside the image. Updates the running best and
+// returns true if this pose improved it.
+static inline bool ScorePoseWindow(
+    int baseCx, int baseCy, int refRadius, int margin,
+    const int* offsets, const float* rdx, const float* rdy,
+    const GradientView& grad, int imgW, int imgH, int N,
+    float thresh, float greedy, int contrastInvariant,
+    double* best, int* bestDx, int* bestDy)
+{
+    bool improved = false;
+    int evaluations = 0, earlyExits = 0;
+    for (int dy = -refRadius; dy <= refRadius; dy++)
+    {
+        int py = baseCy + dy;
+        if (py < margin || py >= imgH - margin) continue;
+
+        for (int dx = -refRadius; dx <= refRadius; dx++)
+        {
+            int px = baseCx + dx;
+            if (px < margin || px >= imgW - margin) continue;
+
+            double score = EvaluateNativeInternal(
+                px, py, offsets, rdx, rdy, grad,
+                imgW, N, thresh, greedy,
+                contrastInvariant);
+            evaluations++;
+            if (score == 0.0 && greedy > 0.0f) earlyExits++;
+
+            if (score > *best)
+            {
+                *best = score;
+                *bestDx = dx;
+                *bestDy = dy;
+                improved = true;
+            }
+        }
+    }
+    StatAdd(NV_COUNT_POSES, 1);
+    StatAdd(NV_COUNT_POSITIONS, evaluations);
+    StatAdd(NV_COUNT_EVALUATIONS, evaluations);
+    StatAdd(NV_COUNT_EARLY_EXITS, earlyExits);
+    return improved;
+}
+
+static double EvaluateAllPoses(
+    NvMatcher* m,
+    int baseCx, int baseCy, int refRadius,
+    const int* allRx, const int* allRy,
+    const float* allRdx, const float* allRdy,
+    const int* margins,
+    int poseCount, int N,
+    const GradientView& grad,
+    int imgW, int imgH,
+    float thresh, float greedy,
+    int* outBestDx, int* outBestDy, int* outBestPoseIdx,
+    int contrastInvariant)
+{
+    StageTimer timer(NV_STAGE_SCORE);
+    double globalBestScore = 0.0;
+    int globalBestDx = 0, globalBestDy = 0, globalBestPose = 0;
+    int alignedN = (N + 7) & ~7;
+    if (!EnsurePoints(m, N))
+    {
+        *outBestDx = *outBestDy = *outBestPoseIdx = 0;
+        return 0.0;
+    }
+
+    if (grad.lazy)
+    {
+        int maxMargin = 0;
+        for (int pi = 0; pi < poseCount; pi++)
+            maxMargin = std::max(maxMargin, margins[pi]);
+        int reach = refRadius + maxMargin + LAZY_REFINE_PAD;
+        TouchGradient(grad, baseCx - reach, baseCy - reach, baseCx + reach, baseCy + reach);
+    }
+
+    WorkerLease lease(m->threadBudget);
+    uint64_t span = StatsClock();
+
+    #pragma omp parallel num_threads(lease.Threads())
+    {
+        lease.Pin();
+        double localBest = 0.0;
+        int localDx = 0, localDy = 0, localPose = 0;
+
+        int* offsets = m->arenas[omp_get_thread_num()].offsets;
+
+        #pragma omp for schedule(dynamic)
+        for (int pi = 0; pi < poseCount; pi++)
+        {
+            uint64_t busy = StatsClock();
+            const int* rx  = allRx  + (int64_t)pi * N;
+            const int* ry  = allRy  + (int64_t)pi * N;
+            const float* rdx = allRdx + (int64_t)pi * N;
+            const float* rdy = allRdy + (int64_t)pi * N;
+            int margin = margins[pi];
+
+            for (int i = 0; i < N; i++)
+                offsets[i] = ry[i] * imgW + rx[i];
+            for (int i = N; i < alignedN; i++)
+                offsets[i] = 0;
+
+            if (ScorePoseWindow(baseCx, baseCy, refRadius, margin,
+                    offsets, rdx, rdy, grad, imgW, imgH, N, thresh, greedy,
+                    contrastInvariant, &localBest, &localDx, &localDy))
+                localPose = pi;
+            StatsBusy(busy);
+        }
+
+        #pragma omp critical
+        {
+            if (localBest > globalBestScore)
+            {
+                globalBestScore = localBest;
+                globalBestDx = localDx;
+                globalBestDy = localDy;
+                globalBestPose = localPose;
+            }
+        }
+    }
+
+    StatsSpan(span, lease.Threads());
+
+    *outBestDx = globalBestDx;
+    *outBestDy = globalBestDy;
+    *outBestPoseIdx = globalBestPose;
+    return globalBestScore;
+}
+
+EXPORT double __cdecl NvEvaluateAllPoses(
+    NvMatcher* m,
+    int baseCx, int baseCy, int refRadius,
+    const int* allRx, const int* allRy,
+    const float* allRdx, const float* allRdy,
+    const int* margins,
+    int poseCount, int N,
+    const float* dxImg, const float* dyImg, const float* magImg,
+    int imgW, int imgH,
+    float thresh, float greedy,
+    int* outBestDx, int* outBestDy, int* outBestPoseIdx,
+    int contrastInvariant)
+{
+    return EvaluateAllPoses(m, baseCx, baseCy, refRadius,
+        allRx, allRy, allRdx, allRdy, margins, poseCount, N,
+        FloatGradients(dxImg, dyImg, magImg), imgW, imgH, thresh, greedy,
+        outBestDx, outBestDy, outBestPoseIdx, contrastInvariant);
+}
+
+EXPORT double __cdecl NvEvaluateAllPosesCompact(
+    NvMatcher* m,
+    int baseCx, int baseCy, int refRadius,
+    const int* allRx, const int* allRy,
+    const float* allRdx, const float* allRdy,
+    const int* margins,
+    int poseCount, int N,
+    const uint32_t* packedImg,
+    int imgW, int imgH,
+    float thresh, float greedy,
+    int* outBestDx, int* outBestDy, int* outBestPoseIdx,
+    int contrastInvariant)
+{
+    return EvaluateAllPoses(m, baseCx, baseCy, refRadius,
+        allRx, allRy, allRdx, allRdy, margins, poseCount, N,
+        MatcherGradients(m, packedImg), imgW, imgH, thresh, greedy,
+        outBestDx, outBestDy, outBestPoseIdx, contrastInvariant);
+}
+
+EXPORT double __cdecl EvaluateAllPosesNative(
+    int baseCx, int baseCy, int refRadius,
+    const int* allRx, const int* allRy,
+    const float* allRdx, const float* allRdy,
+    const int* margins,
+    int poseCount, int N,
+    const float* dxImg, const float* dyImg, const float* magImg,
+    int imgW, int imgH,
+    float thresh, float greedy,
+    int* outBestDx, int* outBestDy, int* outBestPoseIdx,
+    int contrastInvariant)
+{
+    NvMatcher* m = NvCreateMatcher(0, 0, N, poseCount);
+    if (!m)
+    {
+        *outBestDx = *outBestDy = *outBestPoseIdx = 0;
+        return 0.0;
+    }
+    double result = NvEvaluateAllPoses(m, baseCx, baseCy, refRadius,
+        allRx, allRy, allRdx, allRdy, margins, poseCount, N,
+        dxImg, dyImg, magImg, imgW, imgH, thresh, greedy,
+        outBestDx, outBestDy, outBestPoseIdx, contrastInvariant);
+    NvDestroyMatcher(m);
+    return result;
+}
+
+// ─── Multi-instance search: all peaks → NMS → parallel pose refinement ──────
+// For trays holding many identical parts. Votes once per coarse angle, keeps
+// every local accumulator maximum, suppresses peaks that fall inside another
+// peak's model footprint, then refines each survivor over the fine
+// angle × scale grid with the tiled window scorer. The footprint is the
+// model's bounding box turned to each instance's angle and scale, so
+// elongated parts lying side by side survive while a second peak on the same
+// part (any angle) is suppressed.
+
+// Rotate + scale the model for one pose, writing image offsets and/or the
+// rotated points (either may be null) and rotated gradient directions. Rounds
+// half-to-even to match C# Math.Round. Returns the border margin the pose needs.
+// Four points per iteration in SSE2 double lanes (x64 baseline, no dispatch):
+// the arithmetic is the same double expression as the scalar tail and
+// cvtpd_epi32 rounds like nearbyint, so both paths produce identical offsets.
+static int BuildPoseOffsets(
+    const float* modelX, const float* modelY,
+    const float* modelDx, const float* modelDy, int N,
+    double angleDeg, double scale, int imgW,
+    int* offsets, int* rotX, int* rotY, float* rdx, float* rdy)
+{
+    const double DEG2RAD = 3.14159265358979323846 / 180.0;
+    double rad = angleDeg * DEG2RAD;
+    double cosA = cos(rad);
+    double sinA = sin(rad);
+
+    const __m128d vCos = _mm_set1_pd(cosA);
+    const __m128d vSin = _mm_set1_pd(sinA);
+    const __m128d vScale = _mm_set1_pd(scale);
+    const __m128d vW = _mm_set1_pd((double)imgW);
+    const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+    __m128d vMax = _mm_setzero_pd();
+
+    int i = 0;
+    for (; i + 4 <= N; i += 4)
+    {
+        __m128 xf = _mm_loadu_ps(modelX + i);
+        __m128 yf = _mm_loadu_ps(modelY + i);
+        __m128 dxf = _mm_loadu_ps(modelDx + i);
+        __m128 dyf = _mm_loadu_ps(modelDy + i);
+        __m128i off[2], ix[2], iy[2];
+        __m128 gx[2], gy[2];
+        for (int h = 0; h < 2; h++)
+        {
+            __m128d x = _mm_cvtps_pd(h ? _mm_movehl_ps(xf, xf) : xf);
+            __m128d y = _mm_cvtps_pd(h ? _mm_movehl_ps(yf, yf) : yf);
+            __m128d gdx = _mm_cvtps_pd(h ? _mm_movehl_ps(dxf, dxf) : dxf);
+            __m128d gdy = _mm_cvtps_pd(h ? _mm_movehl_ps(dyf, dyf) : dyf);
+
+            __m128d rx = _mm_mul_pd(_mm_sub_pd(_mm_mul_pd(x, vCos), _mm_mul_pd(y, vSin)), vScale);
+            __m128d ry = _mm_mul_pd(_mm_add_pd(_mm_mul_pd(x, vSin), _mm_mul_pd(y, vCos)), vScale);
+            ix[h] = _mm_cvtpd_epi32(rx);
+            iy[h] = _mm_cvtpd_epi32(ry);
+            rx = _mm_cvtepi32_pd(ix[h]);
+            ry = _mm_cvtepi32_pd(iy[h]);
+            off[h] = _mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(ry, vW), rx));
+            vMax = _mm_max_pd(vMax, _mm_max_pd(_mm_and_pd(rx, absMask), _mm_and_pd(ry, absMask)));
+
+            gx[h] = _mm_cvtpd_ps(_mm_sub_pd(_mm_mul_pd(gdx, vCos), _mm_mul_pd(gdy, vSin)));
+            gy[h] = _mm_cvtpd_ps(_mm_add_pd(_mm_mul_pd(gdx, vSin), _mm_mul_pd(gdy, vCos)));
+        }
+        if (offsets)
+            _mm_storeu_si128((__m128i*)(offsets + i), _mm_unpacklo_epi64(off[0], off[1]));
+        if (rotX)
+        {
+            _mm_storeu_si128((__m128i*)(rotX + i), _mm_unpacklo_epi64(ix[0], ix[1]));
+            _mm_storeu_si128((__m128i*)(rotY + i), _mm_unpacklo_epi64(iy[0], iy[1]));
+        }
+        _mm_storeu_ps(rdx + i, _mm_movelh_ps(gx[0], gx[1]));
+        _mm_storeu_ps(rdy + i, _mm_movelh_ps(gy[0], gy[1]));
+    }
+    vMax = _mm_max_pd(vMax, _mm_unpackhi_pd(vMax, vMax));
+    int maxOff = (int)_mm_cvtsd_f64(vMax);
+
+    for (; i < N; i++)
+    {
+        int rx = (int)nearbyint((modelX[i] * cosA - modelY[i] * sinA) * scale);
+        int ry = (int)nearbyint((modelX[i] * sinA + modelY[i] * cosA) * scale);
+        if (offsets) offsets[i] = ry * imgW + rx;
+        if (rotX) { rotX[i] = rx; rotY[i] = ry; }
+        rdx[i] = (float)(modelDx[i] * cosA - modelDy[i] * sinA);
+        rdy[i] = (float)(modelDx[i] * sinA + modelDy[i] * cosA);
+
+        int ax = rx < 0 ? -rx : rx;
+        int ay = ry < 0 ? -ry : ry;
+        if (ax > maxOff) maxOff = ax;
+        if (ay > maxOff) maxOff = ay;
+    }
+    int alignedN = (N + 7) & ~7;
+    for (i = N; i < alignedN; i++)
+    {
+        if (offsets) offsets[i] = 0;
+        if (rotX) rotX[i] = rotY[i] = 0;
+        rdx[i] = rdy[i] = 0.0f;
+    }
+    return maxOff + 1;
+}
+
+// Model bounding box (template space) scaled by the caller's separation ratio
+struct InstanceFootprint
+{
+    double halfX, halfY;
+};
+
+static InstanceFootprint MeasureFootprint(
+    const float* modelX, const float* modelY, int modelCount, double ratio)
+{
+    double hx = 0.0, hy = 0.0;
+    for (int i = 0; i < modelCount; i++)
+    {
+        hx = std::max(hx, (double)fabsf(modelX[i]));
+        hy = std::max(hy, (double)fabsf(modelY[i]));
+    }
+    return { hx * ratio, hy * ratio };
+}
+
+// Does b's centre lie inside a's footprint box at a's angle and scale?
+static inline bool InsideFootprint(
+    const MatchInstance& a, const MatchInstance& b, const InstanceFootprint& fp)
+{
+    const double DEG2RAD = 3.14159265358979323846 / 180.0;
+    double c = cos(a.angle * DEG2RAD), sn = sin(a.angle * DEG2RAD);
+    double ddx = b.x - a.x, ddy = b.y - a.y;
+    double lx = ddx * c + ddy * sn;
+    double ly = -ddx * sn + ddy * c;
+    return fabs(lx) < fp.halfX * a.scale && fabs(ly) < fp.halfY * a.scale;
+}
+
+static inline bool Overlapping(
+    const MatchInstance& a, const MatchInstance& b, const InstanceFootprint& fp)
+{
+    return InsideFootprint(a, b, fp) || InsideFootprint(b, a, fp);
+}
+
+// Greedy NMS over instances already sorted best-first: keep an instance only
+// if it overlaps no kept instance. Returns the number kept (≤ maxKeep).
+static int SuppressOverlapping(MatchInstance* inst, int count, const InstanceFootprint& fp, int maxKeep)
+{
+    int kept = 0;
+    for (int i = 0; i < count && kept < maxKeep; i++)
+    {
+        bool overlaps = false;
+        for (int k = 0; k < kept; k++)
+            if (Overlapping(inst[k], inst[i], fp)) { overlaps = true; break; }
+        if (!overlaps) inst[kept++] = inst[i];
+    }
+    return kept;
+}
+
+static int MatchInstances(
+    NvMatcher* m,
+    const float* modelX, const float* modelY,
+    const float* modelDx, const float* modelDy, int modelCount,
+    const int* binOffsets, const int* binIndices, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int voteWidth, int voteHeight,
+    double angleStart, double angleExtent,
+    double coarseAngleStep, double fineAngleStep,
+    double scaleCenter, double scaleRange, double scaleStep,
+    double invScale, int binShiftBits,
+    const GradientView& grad,
+    int imgW, int imgH, int refRadius,
+    float thresh, float greedy, int contrastInvariant,
+    double minScore, double minDistRatio, int maxCount,
+    MatchInstance* outInstances)
+{
+    if (maxCount <= 0 || modelCount <= 0 || searchEdgeCount <= 0) return 0;
+    StageTimer timer(NV_STAGE_VOTE_COARSE);
+
+    int bW = (voteWidth >> binShiftBits) + 1;
+    int bH = (voteHeight >> binShiftBits) + 1;
+    int accLen = bW * bH;
+    int binSize = 1 << binShiftBits;
+    if (!EnsureAccumulator(m, (size_t)accLen) || !EnsurePoints(m, modelCount)) return 0;
+
+    int numCoarseAngles = (int)(angleExtent / coarseAngleStep) + 1;
+    if (numCoarseAngles < 1) numCoarseAngles = 1;
+
+    // Model footprint radius (template space) sizes the refinement tiles; its
+    // bounding box drives the suppression
+    double footprint = PrepareVotePoints(m, modelX, modelY, binIndices, modelCount);
+    const float* voteX = m->voteX.data();
+    const float* voteY = m->voteY.data();
+    InstanceFootprint nmsBox = MeasureFootprint(modelX, modelY, modelCount, minDistRatio);
+
+    // ── Pass 1: vote at every coarse angle, keep all local maxima ──
+    // A peak must beat half of its own angle's maximum; a second cut against
+    // the global maximum follows once all angles are in.
+    const double PEAK_RATIO = 0.5;
+    int peaksPerAngle = maxCount * 4;
+    std::vector<MatchInstance>& peaks = m->peaks;
+    peaks.clear();
+    WorkerLease lease(m->threadBudget);
+    uint64_t span = StatsClock();
+
+    #pragma omp parallel num_threads(lease.Threads())
+    {
+        lease.Pin();
+        ThreadArena& arena = m->arenas[omp_get_thread_num()];
+        uint16_t* acc = arena.acc;
+        int* rotXBuf = arena.rotX;
+        int* rotYBuf = arena.rotY;
+        std::vector<MatchInstance>& local = arena.peaks;
+        std::vector<MatchInstance>& anglePeaks = arena.anglePeaks;
+        local.clear();
+
+        #pragma omp for schedule(dynamic)
+        for (int ai = 0; ai < numCoarseAngles; ai++)
+        {
+            uint64_t busy = StatsClock();
+            double angle = angleStart + ai * coarseAngleStep;
+
+            RotateModelPoints(voteX, voteY, modelCount, angle, invScale, rotXBuf, rotYBuf);
+            AccumulateVotes(acc, bW, bH, rotXBuf, rotYBuf,
+                binOffsets, numGradBins,
+                searchX, searchY, searchBin, searchEdgeCount,
+                angle, binShiftBits);
+
+            int maxIdx;
+            int maxVote = g_kernels.peak(acc, accLen, &maxIdx);
+            if (maxVote == 0) { StatsBusy(busy); continue; }
+            int minVote = std::max(1, (int)(maxVote * PEAK_RATIO));
+
+            // 3×3 local maxima; ties broken toward the top-left cell
+            anglePeaks.clear();
+            for (int y = 0; y < bH; y++)
+            {
+                const uint16_t* row = acc + y * bW;
+                for (int x = 0; x < bW; x++)
+                {
+                    int v = row[x];
+                    if (v < minVote) continue;
+                    bool isMax = true;
+                    for (int ny = -1; ny <= 1 && isMax; ny++)
+                    {
+                        int yy = y + ny;
+                        if ((unsigned)yy >= (unsigned)bH) continue;
+                        for (int nx = -1; nx <= 1; nx++)
+                        {
+                            int xx = x + nx;
+                            if ((nx == 0 && ny == 0) || (unsigned)xx >= (unsigned)bW) continue;
+                            int nv = acc[yy * bW + xx];
+                            bool before = ny < 0 || (ny == 0 && nx < 0);
+                            if (nv > v || (before && nv == v)) { isMax = false; break; }
+                        }
+                    }
+                    if (!isMax) continue;
+
+                    MatchInstance p;
+                    p.x = (x * binSize + binSize / 2) / invScale;
+                    p.y = (y * binSize + binSize / 2) / invScale;
+                    p.angle = angle;
+                    p.scale = scaleCenter;
+                    p.score = v;
+                    anglePeaks.push_back(p);
+                }
+            }
+
+            if ((int)anglePeaks.size() > peaksPerAngle)
+            {
+                std::partial_sort(anglePeaks.begin(), anglePeaks.begin() + peaksPerAngle, anglePeaks.end(),
+                    [](const MatchInstance& a, const MatchInstance& b) { return a.score > b.score; });
+                anglePeaks.resize(peaksPerAngle);
+            }
+            local.insert(local.end(), anglePeaks.begin(), anglePeaks.end());
+            StatsBusy(busy);
+        }
+
+        #pragma omp critical
+        peaks.insert(peaks.end(), local.begin(), local.end());
+    }
+
+    StatsSpan(span, lease.Threads());
+    timer.Switch(NV_STAGE_INSTANCES, StatsClock());
+    if (peaks.empty()) return 0;
+
+    // Sort by votes (angle as a tie-breaker keeps the order thread-independent)
+    std::sort(peaks.begin(), peaks.end(), [](const MatchInstance& a, const MatchInstance& b) {
+        if (a.score != b.score) return a.score > b.score;
+        if (a.angle != b.angle) return a.angle < b.angle;
+        if (a.y != b.y) return a.y < b.y;
+        return a.x < b.x;
+    });
+
+    double globalMinVote = peaks[0].score * PEAK_RATIO;
+    int peakCount = 0;
+    while (peakCount < (int)peaks.size() && peaks[peakCount].score >= globalMinVote) peakCount++;
+
+    // Peaks of one part at neighbouring angles collapse onto the strongest;
+    // over-provision so parts that fail refinement don't starve the result.
+    int candidateCap = maxCount * 2 + 4;
+    std::vector<MatchInstance>& cands = m->cands;
+    cands.assign(peaks.begin(), peaks.begin() + peakCount);
+    int candCount = SuppressOverlapping(cands.data(), peakCount, nmsBox, candidateCap);
+
+    // Vote counts only resolve the angle to a bin or two, so the strongest
+    // peak of a cluster is not necessarily the right one. Score every peak
+    // of each cluster at its own angle and seed refinement from the winner.
+    {
+        std::vector<int>& clusterOf = m->clusterOf;
+        clusterOf.assign(peakCount, -1);
+        for (int i = 0; i < peakCount; i++)
+        {
+            for (int ci = 0; ci < candCount; ci++)
+                if (Overlapping(cands[ci], peaks[i], nmsBox)) { clusterOf[i] = ci; break; }
+        }
+
+        std::vector<MatchInstance>& seeds = m->seeds;
+        seeds.assign(peaks.begin(), peaks.begin() + peakCount);
+
+        if (grad.lazy)
+        {
+            int seedReach = refRadius + (int)ceil(footprint * scaleCenter) + 2 + LAZY_REFINE_PAD;
+            for (int i = 0; i < peakCount; i++)
+            {
+                if (clusterOf[i] < 0) continue;
+                int cx = (int)peaks[i].x, cy = (int)peaks[i].y;
+                TouchGradient(grad, cx - seedReach, cy - seedReach, cx + seedReach, cy + seedReach);
+            }
+        }
+
+        #pragma omp parallel num_threads(lease.Threads())
+        {
+            lease.Pin();
+            ThreadArena& arena = m->arenas[omp_get_thread_num()];
+            int* offsets = arena.offsets;
+            float* rdx = arena.rdx;
+            float* rdy = arena.rdy;
+
+            #pragma omp for schedule(dynamic)
+            for (int i = 0; i < peakCount; i++)
+            {
+                MatchInstance& sd = seeds[i];
+                sd.score = 0.0;
+                if (clusterOf[i] < 0) continue;
+                int64_t evaluations = 0, earlyExits = 0;
+
+                int margin = BuildPoseOffsets(modelX, modelY, modelDx, modelDy, modelCount,
+                    sd.angle, scaleCenter, imgW, offsets, nullptr, nullptr, rdx, rdy);
+                int baseCx = (int)peaks[i].x, baseCy = (int)peaks[i].y;
+                for (int dy = -refRadius; dy <= refRadius; dy++)
+                {
+                    int py = baseCy + dy;
+                    if (py < margin || py >= imgH - margin) continue;
+                    for (int dx = -refRadius; dx <= refRadius; dx++)
+                    {
+                        int px = baseCx + dx;
+                        if (px < margin || px >= imgW - margin) continue;
+                        double score = EvaluateNativeInternal(
+                            px, py, offsets, rdx, rdy, grad,
+                            imgW, modelCount, thresh, greedy,
+                            contrastInvariant);
+                        evaluations++;
+                        if (score == 0.0 && greedy > 0.0f) earlyExits++;
+                        if (score > sd.score) { sd.score = score; sd.x = px; sd.y = py; }
+                    }
+                }
+                StatAdd(NV_COUNT_EVALUATIONS, evaluations);
+                StatAdd(NV_COUNT_EARLY_EXITS, earlyExits);
+            }
+        }
+
+        std::vector<double>& bestSeed = m->bestSeed;
+        bestSeed.assign(candCount, -1.0);
+        for (int i = 0; i < peakCount; i++)
+        {
+            int ci = clusterOf[i];
+            if (ci >= 0 && seeds[i].score > bestSeed[ci])
+            {
+                bestSeed[ci] = seeds[i].score;
+                cands[ci].x = seeds[i].x;
+                cands[ci].y = seeds[i].y;
+                cands[ci].angle = seeds[i].angle;
+            }
+        }
+    }
+
+    // ── Pass 2: refine every (candidate × pose) pair in one parallel loop ──
+    int numAngles = 0;
+    for (double da = -coarseAngleStep; da <= coarseAngleStep + 0.001; da += fineAngleStep) numAngles++;
+    std::vector<double>& poseScales = m->poseScales;
+    poseScales.clear();
+    for (double ds = -scaleRange; ds <= scaleRange + 0.001; ds += scaleStep)
+        if (scaleCenter + ds >= 0.1) poseScales.push_back(scaleCenter + ds);
+    if (poseScales.empty()) poseScales.push_back(scaleCenter);
+    int numScales = (int)poseScales.size();
+    int posesPerCand = numAngles * numScales;
+    int totalWork = candCount * posesPerCand;
+
+    std::vector<MatchInstance>& refined = m->refined;
+    refined.resize(totalWork);
+
+    // One gradient tile per candidate, covering its window grown by the
+    // largest margin any pose can need
+    double maxScale = *std::max_element(poseScales.begin(), poseScales.end());
+    int reach = refRadius + (int)ceil(footprint * maxScale) + 2;
+    std::vector<GradientTile>& tiles = m->candTiles;
+    if ((int)tiles.size() < candCount) tiles.resize(candCount);
+    if (!EnsureWindow(m, refRadius)) return 0;
+
+    for (int ci = 0; ci < candCount && grad.lazy; ci++)
+    {
+        int cx = (int)cands[ci].x, cy = (int)cands[ci].y, r = reach + LAZY_REFINE_PAD;
+        TouchGradient(grad, cx - r, cy - r, cx + r, cy + r);
+    }
+
+    #pragma omp parallel for num_threads(lease.Threads()) schedule(dynamic)
+    for (int ci = 0; ci < candCount; ci++)
+    {
+        lease.Pin();
+        int cx = (int)cands[ci].x, cy = (int)cands[ci].y;
+        BuildGradientTile(tiles[ci], grad, imgW, imgH, cx - reach, cy - reach, cx + reach, cy + reach);
+    }
+
+    span = StatsClock();
+    #pragma omp parallel num_threads(lease.Threads())
+    {
+        lease.Pin();
+        ThreadArena& arena = m->arenas[omp_get_thread_num()];
+
+        #pragma omp for schedule(dynamic)
+        for (int w = 0; w < totalWork; w++)
+        {
+            uint64_t busy = StatsClock();
+            int ci = w / posesPerCand;
+            int pi = w % posesPerCand;
+            const MatchInstance& cand = cands[ci];
+            double angle = cand.angle - coarseAngleStep + (pi / numScales) * fineAngleStep;
+            double scale = poseScales[pi % numScales];
+
+            MatchInstance& r = refined[w];
+            r.angle = angle;
+            r.scale = scale;
+            r.score = 0.0;
+            r.x = cand.x;
+            r.y = cand.y;
+            if (angle < angleStart || angle > angleStart + angleExtent) { StatsBusy(busy); continue; }
+
+            int margin = BuildPoseOffsets(modelX, modelY, modelDx, modelDy, modelCount,
+                angle, scale, imgW, nullptr, arena.rotX, arena.rotY, arena.rdx, arena.rdy);
+            SortPoseByRow(arena.rotX, arena.rotY, arena.rdx, arena.rdy, modelCount, margin,
+                arena.rowStart, arena.rowX, arena.rowY, arena.rowDx, arena.rowDy);
+
+            int baseCx = (int)cand.x, baseCy = (int)cand.y;
+            int bestDx = 0, bestDy = 0;
+            if (ScorePoseWindowTiled(tiles[ci], baseCx, baseCy, refRadius, margin,
+                    arena.rowX, arena.rowY, arena.rowDx, arena.rowDy, modelCount,
+                    imgW, imgH, contrastInvariant, arena.window, arena.rowOff, 0.0,
+                    &r.score, &bestDx, &bestDy))
+            {
+                r.x = baseCx + bestDx;
+                r.y = baseCy + bestDy;
+            }
+            StatsBusy(busy);
+        }
+    }
+    StatsSpan(span, lease.Threads());
+
+    // Best pose per candidate
+    std::vector<MatchInstance>& results = m->results;
+    results.clear();
+    for (int ci = 0; ci < candCount; ci++)
+    {
+        const MatchInstance* poses = refined.data() + (size_t)ci * posesPerCand;
+        int best = 0;
+        for (int pi = 1; pi < posesPerCand; pi++)
+            if (poses[pi].score > poses[best].score) best = pi;
+        if (poses[best].score >= minScore)
+            results.push_back(poses[best]);
+    }
+    if (results.empty()) return 0;
+
+    // Refinement can pull neighbouring candidates onto the same part
+    std::sort(results.begin(), results.end(), [](const MatchInstance& a, const MatchInstance& b) {
+        if (a.score != b.score) return a.score > b.score;
+        if (a.y != b.y) return a.y < b.y;
+        return a.x < b.x;
+    });
+    int count = SuppressOverlapping(results.data(), (int)results.size(), nmsBox, maxCount);
+
+    memcpy(outInstances, results.data(), count * sizeof(MatchInstance));
+    return count;
+}
+
+EXPORT int __cdecl NvMatchInstances(
+    NvMatcher* m,
+    const float* modelX, const float* modelY,
+    const float* modelDx, const float* modelDy, int modelCount,
+    const int* binOffsets, const int* binIndices, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int voteWidth, int voteHeight,
+    double angleStart, double angleExtent,
+    double coarseAngleStep, double fineAngleStep,
+    double scaleCenter, double scaleRange, double scaleStep,
+    double invScale, int binShiftBits,
+    const float* dxImg, const float* dyImg, const float* magImg,
+    int imgW, int imgH, int refRadius,
+    float thresh, float greedy, int contrastInvariant,
+    double minScore, double minDistRatio, int maxCount,
+    MatchInstance* outInstances)
+{
+    return MatchInstances(m, modelX, modelY, modelDx, modelDy, modelCount,
+        binOffsets, binIndices, numGradBins,
+        searchX, searchY, searchBin, searchEdgeCount, voteWidth, voteHeight,
+        angleStart, angleExtent, coarseAngleStep, fineAngleStep,
+        scaleCenter, scaleRange, scaleStep, invScale, binShiftBits,
+        FloatGradients(dxImg, dyImg, magImg), imgW, imgH, refRadius,
+        thresh, greedy, contrastInvariant, minScore, minDistRatio, maxCount,
+        outInstances);
+}
+
+EXPORT int __cdecl NvMatchInstancesCompact(
+    NvMatcher* m,
+    const float* modelX, const float* modelY,
+    const float* modelDx, const float* modelDy, int modelCount,
+    const int* binOffsets, const int* binIndices, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int voteWidth, int voteHeight,
+    double angleStart, double angleExtent,
+    double coarseAngleStep, double fineAngleStep,
+    double scaleCenter, double scaleRange, double scaleStep,
+    double invScale, int binShiftBits,
+    const uint32_t* packedImg,
+    int imgW, int imgH, int refRadius,
+    float thresh, float greedy, int contrastInvariant,
+    double minScore, double minDistRatio, int maxCount,
+    MatchInstance* outInstances)
+{
+    return MatchInstances(m, modelX, modelY, modelDx, modelDy, modelCount,
+        binOffsets, binIndices, numGradBins,
+        searchX, searchY, searchBin, searchEdgeCount, voteWidth, voteHeight,
+        angleStart, angleExtent, coarseAngleStep, fineAngleStep,
+        scaleCenter, scaleRange, scaleStep, invScale, binShiftBits,
+        MatcherGradients(m, packedImg), imgW, imgH, refRadius,
+        thresh, greedy, contrastInvariant, minScore, minDistRatio, maxCount,
+        outInstances);
+}
+
+EXPORT int __cdecl MatchInstancesNative(
+    const float* modelX, const float* modelY,
+    const float* modelDx, const float* modelDy, int modelCount,
+    const int* binOffsets, const int* binIndices, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int voteWidth, int voteHeight,
+    double angleStart, double angleExtent,
+    double coarseAngleStep, double fineAngleStep,
+    double scaleCenter, double scaleRange, double scaleStep,
+    double invScale, int binShiftBits,
+    const float* dxImg, const float* dyImg, const float* magImg,
+    int imgW, int imgH, int refRadius,
+    float thresh, float greedy, int contrastInvariant,
+    double minScore, double minDistRatio, int maxCount,
+    MatchInstance* outInstances)
+{
+    NvMatcher* m = NvCreateMatcher(voteWidth >> binShiftBits, voteHeight >> binShiftBits, modelCount, 1);
+    if (!m) return 0;
+    int count = NvMatchInstances(m, modelX, modelY, modelDx, modelDy, modelCount,
+        binOffsets, binIndices, numGradBins,
+        searchX, searchY, searchBin, searchEdgeCount, voteWidth, voteHeight,
+        angleStart, angleExtent, coarseAngleStep, fineAngleStep,
+        scaleCenter, scaleRange, scaleStep, invScale, binShiftBits,
+        dxImg, dyImg, magImg, imgW, imgH, refRadius,
+        thresh, greedy, contrastInvariant, minScore, minDistRatio, maxCount,
+        outInstances);
+    NvDestroyMatcher(m);
+    return count;
+}
+
+// ─── Precompiled model files ────────────────────────────────────────────────
+// A recipe changeover used to retrain every model from its template (Canny,
+// Harris, sampling, bin tables) and then rebuild the pose banks on the first
+// frames. NvWriteModelFile stores a trained model once; NvOpenModelFile maps
+// the file read-only, checks the header and section bounds, and hands out
+// pointers straight into the mapping, with no parsing. Every section starts on a
+// 64-byte boundary, so the arrays can be used in place.
+//
+// The optional pose bank covers the whole search range: the fine poses of
+// every angle from angleStart - angleRange to angleStart + angleExtent +
+// angleRange, angle-major as NvAcquirePoseBank orders them. A bank request
+// with the same fine grid whose centre lies on the file's angle grid is then
+// a contiguous slice of it (MapPoseBank), so it costs no rotation or sort.
+// Files opened by the same path share one mapping per process, and the OS
+// shares the file's page-cache pages between processes, so cameras loading
+// the same model hold one physical copy of it.
+
+static const uint32_t MF_MAGIC = 0x464D564E;   // "NVMF"
+static const uint32_t MF_VERSION = 1;
+static const uint64_t MF_ALIGN = 64;
+static const int MF_MAX_POINTS = 1 << 20;
+
+enum ModelFileSection
+{
+    MF_X, MF_Y, MF_DX, MF_DY, MF_REFINE_X, MF_REFINE_Y, MF_MAGNITUDE,
+    MF_BIN_OFFSETS, MF_BIN_INDICES,
+    MF_POSE_ANGLES, MF_POSE_SCALES, MF_POSE_MARGINS,
+    MF_POSE_X, MF_POSE_Y, MF_POSE_DX, MF_POSE_DY,
+    MF_SECTION_COUNT
+};
+
+struct ModelFileHeader
+{
+    uint32_t magic, version;
+    uint64_t fileSize;
+    int32_t modelCount, numGradBins;
+    int32_t templateWidth, templateHeight;
+    int32_t angleCount, posesPerAngle;      // pose bank; both 0 when absent
+    double angleLo, angleStep;              // bank angle i = angleLo + i × angleStep
+    double scaleCenter, scaleRange, scaleStep;
+    double reserved;
+    uint64_t offsets[MF_SECTION_COUNT];     // from the start of the file
+};
+
+static_assert(sizeof(ModelFileHeader) % 8 == 0, "model file header must stay 8-byte sized");
+
+// Pose-bank range for NvWriteModelFile (C# NativeVision.ModelBankGrid)
+struct NvModelBankGrid
+{
+    double angleStart, angleExtent;     // vote angles the search can produce
+    double angleRange, angleStep;       // bank half-width and fine angle step
+    double scaleCenter, scaleRange, scaleStep;
+};
+
+// An open model file (C# NativeVision.ModelFileInfo); pointers into the
+// mapping, valid until NvCloseModelFile. refineX/refineY/magnitude are the
+// arrays written with the model, zero-filled when none were given.
+struct NvModelFileInfo
+{
+    const float* modelX;
+    const float* modelY;
+    const float* modelDx;
+    const float* modelDy;
+    const float* refineX;
+    const float* refineY;
+    const float* magnitude;
+    const int* binOffsets;
+    const int* binIndices;
+    int modelCount, numGradBins;
+    int templateWidth, templateHeight;
+    int modelKey;               // pass as NvModelDesc::modelKey to use the bank
+    int poseCount;              // poses in the precomputed bank (0 = none)
+};
+
+static inline uint64_t AlignUp64(uint64_t v)
+{
+    return (v + MF_ALIGN - 1) & ~(MF_ALIGN - 1);
+}
+
+static uint64_t SectionBytes(const ModelFileHeader& h, int section)
+{
+    uint64_t n = (uint64_t)h.modelCount;
+    uint64_t poses = (uint64_t)h.angleCount * (uint64_t)h.posesPerAngle;
+    switch (section)
+    {
+    case MF_BIN_OFFSETS:  return ((uint64_t)h.numGradBins + 1) * sizeof(int);
+    case MF_BIN_INDICES:  return n * sizeof(int);
+    case MF_POSE_ANGLES:
+    case MF_POSE_SCALES:  return poses * sizeof(double);
+    case MF_POSE_MARGINS: return poses * sizeof(int);
+    case MF_POSE_X:
+    case MF_POSE_Y:
+    case MF_POSE_DX:
+    case MF_POSE_DY:      return poses * n * 4;
+    default:              return n * sizeof(float);
+    }
+}
+
+template <typename T>
+static inline const T* Section(const uint8_t* base, const ModelFileHeader& h, int section)
+{
+    return (const T*)(base + h.offsets[section]);
+}
+
+#if defined(_WIN32)
+static std::wstring WidePath(const char* utf8)
+{
+    int len = MultiByteToWideChar(CP_UTF8, 0, utf8, -1, nullptr, 0);
+    std::wstring w(len > 0 ? len : 0, L'\0');
+    if (len > 0) MultiByteToWideChar(CP_UTF8, 0, utf8, -1, &w[0], len);
+    if (!w.empty()) w.pop_back();
+    return w;
+}
+#endif
+
+// Size and last-write stamp of a file, identifying one version of it
+static bool FileStamp(const char* path, uint64_t* size, int64_t* stamp)
+{
+#if defined(_WIN32)
+    WIN32_FILE_ATTRIBUTE_DATA a;
+    if (!GetFileAttributesExW(WidePath(path).c_str(), GetFileExInfoStandard, &a)) return false;
+    *size = ((uint64_t)a.nFileSizeHigh << 32) | a.nFileSizeLow;
+    *stamp = (int64_t)(((uint64_t)a.ftLastWriteTime.dwHighDateTime << 32) | a.ftLastWriteTime.dwLowDateTime);
+#else
+    struct stat st;
+    if (stat(path, &st) != 0) return false;
+    *size = (uint64_t)st.st_size;
+    *stamp = (int64_t)st.st_mtime;
+#endif
+    return true;
+}
+
+struct ModelMapping
+{
+    std::string path;
+    uint64_t size = 0;
+    int64_t stamp = 0;
+    int modelKey = 0;
+    const uint8_t* base = nullptr;
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE, mapping = nullptr;
+#endif
+
+    const ModelFileHeader& Header() const { return *(const ModelFileHeader*)base; }
+
+    ~ModelMapping()
+    {
+#if defined(_WIN32)
+        if (base) UnmapViewOfFile(base);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (base) munmap((void*)base, (size_t)size);
+#endif
+    }
+};
+
+struct NvModelFile
+{
+    std::shared_ptr<const ModelMapping> map;
+};
+
+// Open mappings, for sharing by path and for MapPoseBank's key lookup. Keys
+// start far above the per-model keys the C# side issues.
+static std::mutex g_modelFileLock;
+static std::vector<std::weak_ptr<const ModelMapping>> g_modelFiles;
+static int g_modelFileNextKey = 1 << 30;
+
+// Header and section bounds; the bin tables are small enough to check whole.
+// Bank contents are trusted: NvWriteModelFile publishes files atomically.
+static bool ValidModelFile(const uint8_t* base, uint64_t size)
+{
+    if (size < sizeof(ModelFileHeader)) return false;
+    const ModelFileHeader& h = *(const ModelFileHeader*)base;
+    if (h.magic != MF_MAGIC || h.version != MF_VERSION || h.fileSize != size) return false;
+    if (h.modelCount <= 0 || h.modelCount > MF_MAX_POINTS || h.numGradBins <= 0 || h.numGradBins > 4096)
+        return false;
+    if (h.angleCount < 0 || h.posesPerAngle < 0 || (h.angleCount == 0) != (h.posesPerAngle == 0))
+        return false;
+    if (h.angleCount > 0 && (!(h.angleStep > 0.0) || !(h.scaleStep > 0.0))) return false;
+    if ((uint64_t)h.angleCount * (uint64_t)h.posesPerAngle * (uint64_t)h.modelCount > (1ull << 34))
+        return false;
+
+    for (int s = 0; s < MF_SECTION_COUNT; s++)
+    {
+        uint64_t off = h.offsets[s], bytes = SectionBytes(h, s);
+        if (off % MF_ALIGN != 0 || off < sizeof(ModelFileHeader) || off > size || bytes > size - off)
+            return false;
+    }
+
+    const int* binOffsets = Section<int>(base, h, MF_BIN_OFFSETS);
+    const int* binIndices = Section<int>(base, h, MF_BIN_INDICES);
+    if (binOffsets[0] != 0 || binOffsets[h.numGradBins] > h.modelCount) return false;
+    for (int b = 0; b < h.numGradBins; b++)
+        if (binOffsets[b + 1] < binOffsets[b]) return false;
+    for (int i = 0; i < binOffsets[h.numGradBins]; i++)
+        if ((unsigned)binIndices[i] >= (unsigned)h.modelCount) return false;
+    return true;
+}
+
+static std::shared_ptr<ModelMapping> MapModelFile(const char* path, uint64_t size, int64_t stamp)
+{
+    auto map = std::make_shared<ModelMapping>();
+    map->path = path;
+    map->size = size;
+    map->stamp = stamp;
+    if (size < sizeof(ModelFileHeader) || size > (uint64_t)SIZE_MAX) return nullptr;
+
+#if defined(_WIN32)
+    map->file = CreateFileW(WidePath(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (map->file == INVALID_HANDLE_VALUE) return nullptr;
+    map->mapping = CreateFileMappingW(map->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!map->mapping) return nullptr;
+    map->base = (const uint8_t*)MapViewOfFile(map->mapping, FILE_MAP_READ, 0, 0, (SIZE_T)size);
+    if (!map->base) return nullptr;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return nullptr;
+    void* p = mmap(nullptr, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return nullptr;
+    map->base = (const uint8_t*)p;
+#endif
+    if (!ValidModelFile(map->base, size)) return nullptr;
+    return map;
+}
+
+// Writes a trained model (and, with grid, its full-range pose bank) to path.
+// The file is written beside path and renamed into place, so readers see
+// either the old file or the complete new one. refineX, refineY and
+// magnitude may be null. Returns 1 on success, 0 on failure.
+EXPORT int __cdecl NvWriteModelFile(
+    const char* path, const NvModelDesc* model, int numGradBins,
+    const float* refineX, const float* refineY, const float* magnitude,
+    int templateWidth, int templateHeight, const NvModelBankGrid* grid)
+{
+    if (!path || !model || numGradBins <= 0) return 0;
+    const NvModelDesc& d = *model;
+    int n = d.modelCount;
+    if (n <= 0 || n > MF_MAX_POINTS || !d.modelX || !d.modelY || !d.modelDx || !d.modelDy
+        || !d.binOffsets || !d.binIndices)
+        return 0;
+
+    try
+    {
+        ModelFileHeader h = {};
+        h.magic = MF_MAGIC;
+        h.version = MF_VERSION;
+        h.modelCount = n;
+        h.numGradBins = numGradBins;
+        h.templateWidth = templateWidth;
+        h.templateHeight = templateHeight;
+
+        // Bank poses in NvAcquirePoseBank order: angle-major, scales inside
+        std::vector<double> bankScales;
+        if (grid && grid->angleStep > 0.0 && grid->scaleStep > 0.0
+            && grid->angleExtent >= 0.0 && grid->angleRange >= 0.0)
+        {
+            for (double ds = -grid->scaleRange; ds <= grid->scaleRange + 0.001; ds += grid->scaleStep)
+                if (grid->scaleCenter + ds >= 0.1) bankScales.push_back(grid->scaleCenter + ds);
+            double span = grid->angleExtent + 2.0 * grid->angleRange;
+            h.angleLo = grid->angleStart - grid->angleRange;
+            h.angleStep = grid->angleStep;
+            h.angleCount = bankScales.empty() ? 0 : (int)std::floor(span / grid->angleStep + 1e-6) + 1;
+            h.posesPerAngle = h.angleCount > 0 ? (int)bankScales.size() : 0;
+            h.scaleCenter = grid->scaleCenter;
+            h.scaleRange = grid->scaleRange;
+            h.scaleStep = grid->scaleStep;
+        }
+
+        uint64_t off = AlignUp64(sizeof(ModelFileHeader));
+        for (int s = 0; s < MF_SECTION_COUNT; s++)
+        {
+            h.offsets[s] = off;
+            off = AlignUp64(off + SectionBytes(h, s));
+        }
+        h.fileSize = off;
+        if (off > (uint64_t)SIZE_MAX) return 0;
+
+        std::vector<uint8_t> buf((size_t)off);
+        uint8_t* base = buf.data();
+        memcpy(base, &h, sizeof(h));
+        auto put = [&](int section, const void* src)
+        {
+            if (src) memcpy(base + h.offsets[section], src, (size_t)SectionBytes(h, section));
+        };
+        put(MF_X, d.modelX);
+        put(MF_Y, d.modelY);
+        put(MF_DX, d.modelDx);
+        put(MF_DY, d.modelDy);
+        put(MF_REFINE_X, refineX);
+        put(MF_REFINE_Y, refineY);
+        put(MF_MAGNITUDE, magnitude);
+        put(MF_BIN_OFFSETS, d.binOffsets);
+        put(MF_BIN_INDICES, d.binIndices);
+
+        int poseCount = h.angleCount * h.posesPerAngle;
+        if (poseCount > 0)
+        {
+            double* angles = (double*)(base + h.offsets[MF_POSE_ANGLES]);
+            double* scales = (double*)(base + h.offsets[MF_POSE_SCALES]);
+            int* margins = (int*)(base + h.offsets[MF_POSE_MARGINS]);
+            int* px = (int*)(base + h.offsets[MF_POSE_X]);
+            int* py = (int*)(base + h.offsets[MF_POSE_Y]);
+            float* pdx = (float*)(base + h.offsets[MF_POSE_DX]);
+            float* pdy = (float*)(base + h.offsets[MF_POSE_DY]);
+            for (int ai = 0; ai < h.angleCount; ai++)
+                for (int si = 0; si < h.posesPerAngle; si++)
+                {
+                    angles[ai * h.posesPerAngle + si] = h.angleLo + ai * h.angleStep;
+                    scales[ai * h.posesPerAngle + si] = bankScales[si];
+                }
+
+            WorkerLease lease(omp_get_max_threads());
+            #pragma omp parallel num_threads(lease.Threads())
+            {
+                lease.Pin();
+                size_t padded = (size_t)(n + 7) & ~(size_t)7;  // BuildPoseOffsets zero-pads to 8
+                std::vector<int> rotX(padded), rotY(padded), rowStart;
+                std::vector<float> rdx(padded), rdy(padded);
+
+                #pragma omp for schedule(dynamic)
+                for (int pi = 0; pi < poseCount; pi++)
+                {
+                    size_t at = (size_t)pi * n;
+                    margins[pi] = BuildPoseOffsets(d.modelX, d.modelY, d.modelDx, d.modelDy, n,
+                        angles[pi], scales[pi], 0, nullptr, rotX.data(), rotY.data(), rdx.data(), rdy.data());
+                    SortPoseByRow(rotX.data(), rotY.data(), rdx.data(), rdy.data(), n, margins[pi],
+                        rowStart, px + at, py + at, pdx + at, pdy + at);
+                }
+            }
+        }
+
+        static std::atomic<int> s_writeSeq{ 0 };
+#if defined(_WIN32)
+        std::string temp = std::string(path) + "." + std::to_string(GetCurrentProcessId())
+            + "." + std::to_string(s_writeSeq++) + ".tmp";
+        FILE* f = _wfopen(WidePath(temp.c_str()).c_str(), L"wb");
+#else
+        std::string temp = std::string(path) + "." + std::to_string(getpid())
+            + "." + std::to_string(s_writeSeq++) + ".tmp";
+        FILE* f = fopen(temp.c_str(), "wb");
+#endif
+        if (!f) return 0;
+        bool ok = fwrite(base, 1, buf.size(), f) == buf.size();
+        ok = fclose(f) == 0 && ok;
+#if defined(_WIN32)
+        ok = ok && MoveFileExW(WidePath(temp.c_str()).c_str(), WidePath(path).c_str(), MOVEFILE_REPLACE_EXISTING);
+        if (!ok) DeleteFileW(WidePath(temp.c_str()).c_str());
+#else
+        ok = ok && rename(temp.c_str(), path) == 0;
+        if (!ok) unlink(temp.c_str());
+#endif
+        return ok ? 1 : 0;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return 0;
+    }
+}
+
+// Maps a model file written by NvWriteModelFile, or returns null when it is
+// missing, truncated or of another version. Opening a path that is already
+// open (and unchanged on disk) shares the existing mapping and model key.
+EXPORT NvModelFile* __cdecl NvOpenModelFile(const char* path)
+{
+    uint64_t size;
+    int64_t stamp;
+    if (!path || !FileStamp(path, &size, &stamp)) return nullptr;
+
+    try
+    {
+        std::lock_guard<std::mutex> guard(g_modelFileLock);
+        g_modelFiles.erase(std::remove_if(g_modelFiles.begin(), g_modelFiles.end(),
+            [](const std::weak_ptr<const ModelMapping>& w) { return w.expired(); }), g_modelFiles.end());
+        for (const auto& w : g_modelFiles)
+        {
+            auto open = w.lock();
+            if (open && open->path == path && open->size == size && open->stamp == stamp)
+                return new NvModelFile{ open };
+        }
+
+        auto map = MapModelFile(path, size, stamp);
+        if (!map) return nullptr;
+        map->modelKey = g_modelFileNextKey++;
+        g_modelFiles.push_back(map);
+        return new NvModelFile{ map };
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+EXPORT int __cdecl NvGetModelFileInfo(const NvModelFile* file, NvModelFileInfo* out)
+{
+    if (!file || !out) return 0;
+    const ModelMapping& map = *file->map;
+    const ModelFileHeader& h = map.Header();
+    out->modelX = Section<float>(map.base, h, MF_X);
+    out->modelY = Section<float>(map.base, h, MF_Y);
+    out->modelDx = Section<float>(map.base, h, MF_DX);
+    out->modelDy = Section<float>(map.base, h, MF_DY);
+    out->refineX = Section<float>(map.base, h, MF_REFINE_X);
+    out->refineY = Section<float>(map.base, h, MF_REFINE_Y);
+    out->magnitude = Section<float>(map.base, h, MF_MAGNITUDE);
+    out->binOffsets = Section<int>(map.base, h, MF_BIN_OFFSETS);
+    out->binIndices = Section<int>(map.base, h, MF_BIN_INDICES);
+    out->modelCount = h.modelCount;
+    out->numGradBins = h.numGradBins;
+    out->templateWidth = h.templateWidth;
+    out->templateHeight = h.templateHeight;
+    out->modelKey = map.modelKey;
+    out->poseCount = h.angleCount * h.posesPerAngle;
+    return 1;
+}
+
+// Releases the handle; the mapping stays while pose banks still use it.
+EXPORT void __cdecl NvCloseModelFile(NvModelFile* file)
+{
+    delete file;
+}
+
+// Points bank b (grid fields already set) at the slice of a mapped pose bank
+// that holds exactly its poses, when b's model key belongs to an open model
+// file whose bank has the same fine grid and covers the requested angles.
+static bool MapPoseBank(PoseBank& b, double centerAngle)
+{
+    std::shared_ptr<const ModelMapping> map;
+    {
+        std::lock_guard<std::mutex> guard(g_modelFileLock);
+        for (const auto& w : g_modelFiles)
+        {
+            auto open = w.lock();
+            if (open && open->modelKey == b.modelKey) { map = std::move(open); break; }
+        }
+    }
+    if (!map) return false;
+
+    const ModelFileHeader& h = map->Header();
+    if (h.angleCount == 0 || h.modelCount != b.modelCount || h.angleStep != b.angleStep
+        || h.scaleCenter != b.scaleCenter || h.scaleRange != b.scaleRange || h.scaleStep != b.scaleStep)
+        return false;
+
+    int angleCount = 0;
+    for (double da = -b.angleRange; da <= b.angleRange + 0.001; da += b.angleStep)
+        angleCount++;
+    double first = (centerAngle - b.angleRange - h.angleLo) / h.angleStep;
+    double firstIndex = std::floor(first + 0.5);
+    if (std::fabs(first - firstIndex) > 1e-6 || firstIndex < 0.0 || firstIndex + angleCount > h.angleCount)
+        return false;
+
+    size_t firstPose = (size_t)firstIndex * h.posesPerAngle;
+    size_t at = firstPose * (size_t)h.modelCount;
+    b.poseCount = angleCount * h.posesPerAngle;
+    b.poseX = Section<int>(map->base, h, MF_POSE_X) + at;
+    b.poseY = Section<int>(map->base, h, MF_POSE_Y) + at;
+    b.poseDx = Section<float>(map->base, h, MF_POSE_DX) + at;
+    b.poseDy = Section<float>(map->base, h, MF_POSE_DY) + at;
+    b.poseMargins = Section<int>(map->base, h, MF_POSE_MARGINS) + firstPose;
+    b.poseAngles = Section<double>(map->base, h, MF_POSE_ANGLES) + firstPose;
+    b.poseScales = Section<double>(map->base, h, MF_POSE_SCALES) + firstPose;
+    b.maxMargin = 0;
+    for (int pi = 0; pi < b.poseCount; pi++)
+        b.maxMargin = std::max(b.maxMargin, b.poseMargins[pi]);
+    b.mapping = std::move(map);
+    return true;
+}
+
+// ─── Pose banks: cached fine-pose offsets for Phase 2 ───────────────────────
+// Phase 2 scores the same fine angle × scale grid around the coarse vote angle
+// every frame. On a line the part's orientation barely changes, so the coarse
+// angle repeats and so does the grid. A bank holds that grid already rotated
+// and sorted by row for ScorePoseWindowTiled; banks are keyed by model, centre
+// angle (quantised to 1/1000°) and grid shape, and live in the matcher until
+// evicted least-recently-used. The caller changes modelKey whenever the model's
+// points change. A model opened from a precompiled file (NvOpenModelFile)
+// takes its banks from the file's mapped bank whenever the grid allows.
+
+static bool PoseBankMatches(
+    const PoseBank& b, int modelKey, int modelCount, int64_t angleKey,
+    double angleRange, double angleStep,
+    double scaleCenter, double scaleRange, double scaleStep)
+{
+    return b.modelKey == modelKey && b.modelCount == modelCount
+        && b.angleKey == angleKey
+        && b.angleRange == angleRange && b.angleStep == angleStep
+        && b.scaleCenter == scaleCenter && b.scaleRange == scaleRange
+        && b.scaleStep == scaleStep;
+}
+
+// Returns the bank index (valid until the next acquire) or -1.
+// Pose order and the angle/scale grid match PrecomputeFinePosesNative.
+EXPORT int __cdecl NvAcquirePoseBank(
+    NvMatcher* m, int modelKey,
+    const float* modelX, const float* modelY,
+    const float* modelDx, const float* modelDy, int modelCount,
+    double centerAngle, double angleRange, double angleStep,
+    double scaleCenter, double scaleRange, double scaleStep,
+    int* outPoseCount)
+{
+    *outPoseCount = 0;
+    if (modelCount <= 0 || angleStep <= 0.0 || scaleStep <= 0.0) return -1;
+    if (!EnsurePoints(m, modelCount)) return -1;
+
+    int64_t angleKey = (int64_t)llround(centerAngle * 1000.0);
+    std::vector<PoseBank>& banks = m->poseBanks;
+    m->poseBankClock++;
+
+    for (size_t i = 0; i < banks.size(); i++)
+    {
+        if (PoseBankMatches(banks[i], modelKey, modelCount, angleKey,
+                angleRange, angleStep, scaleCenter, scaleRange, scaleStep))
+        {
+            banks[i].lastUse = m->poseBankClock;
+            *outPoseCount = banks[i].poseCount;
+            StatAdd(NV_COUNT_POSE_BANK_HITS, 1);
+            return (int)i;
+        }
+    }
+
+    StageTimer timer(NV_STAGE_POSE_BANK);
+    StatAdd(NV_COUNT_POSE_BANK_MISSES, 1);
+    size_t slot = banks.size();
+    if (slot < (size_t)m->poseBankCap)
+        banks.emplace_back();
+    else
+    {
+        slot = 0;
+        for (size_t i = 1; i < banks.size(); i++)
+            if (banks[i].lastUse < banks[slot].lastUse) slot = i;
+    }
+
+    PoseBank& b = banks[slot];
+    b.modelKey = modelKey;
+    b.modelCount = modelCount;
+    b.angleKey = angleKey;
+    b.angleRange = angleRange;
+    b.angleStep = angleStep;
+    b.scaleCenter = scaleCenter;
+    b.scaleRange = scaleRange;
+    b.scaleStep = scaleStep;
+    b.lastUse = m->poseBankClock;
+    if (MapPoseBank(b, centerAngle))
+    {
+        *outPoseCount = b.poseCount;
+        return (int)slot;
+    }
+    b.mapping.reset();
+
+    b.angles.clear();
+    b.scales.clear();
+    for (double da = -angleRange; da <= angleRange + 0.001; da += angleStep)
+    {
+        for (double ds = -scaleRange; ds <= scaleRange + 0.001; ds += scaleStep)
+        {
+            double scale = scaleCenter + ds;
+            if (scale < 0.1) continue;
+            b.angles.push_back(centerAngle + da);
+            b.scales.push_back(scale);
+        }
+    }
+    b.poseCount = (int)b.angles.size();
+
+    size_t total = (size_t)b.poseCount * modelCount;
+    b.rx.resize(total);
+    b.ry.resize(total);
+    b.rdx.resize(total);
+    b.rdy.resize(total);
+    b.margins.resize(b.poseCount);
+
+    int poseCount = b.poseCount;
+    WorkerLease lease(m->threadBudget);
+    #pragma omp parallel num_threads(lease.Threads())
+    {
+        lease.Pin();
+        ThreadArena& a = m->arenas[omp_get_thread_num()];
+
+        #pragma omp for schedule(dynamic)
+        for (int pi = 0; pi < poseCount; pi++)
+        {
+            size_t base = (size_t)pi * modelCount;
+            b.margins[pi] = BuildPoseOffsets(modelX, modelY, modelDx, modelDy, modelCount,
+                b.angles[pi], b.scales[pi], 0, nullptr, a.rotX, a.rotY, a.rdx, a.rdy);
+            SortPoseByRow(a.rotX, a.rotY, a.rdx, a.rdy, modelCount, b.margins[pi],
+                a.rowStart, b.rx.data() + base, b.ry.data() + base, b.rdx.data() + base, b.rdy.data() + base);
+        }
+    }
+    b.maxMargin = 0;
+    for (int pi = 0; pi < poseCount; pi++)
+        b.maxMargin = std::max(b.maxMargin, b.margins[pi]);
+    b.poseX = b.rx.data();
+    b.poseY = b.ry.data();
+    b.poseDx = b.rdx.data();
+    b.poseDy = b.rdy.data();
+    b.poseMargins = b.margins.data();
+    b.poseAngles = b.angles.data();
+    b.poseScales = b.scales.data();
+
+    *outPoseCount = poseCount;
+    return (int)slot;
+}
+
+static double EvaluatePoseBank(
+    NvMatcher* m, int bankIndex,
+    int baseCx, int baseCy, int refRadius,
+    const GradientView& grad,
+    int imgW, int imgH,
+    int* outBestDx, int* outBestDy, double* outBestAngle, double* outBestScale,
+    int contrastInvariant)
+{
+    StageTimer timer(NV_STAGE_SCORE);
+    *outBestDx = *outBestDy = 0;
+    if (bankIndex < 0 || bankIndex >= (int)m->poseBanks.size()) return 0.0;
+    const PoseBank& b = m->poseBanks[bankIndex];
+    if (b.poseCount == 0 || !EnsureWindow(m, refRadius)) return 0.0;
+    *outBestAngle = b.poseAngles[0];
+    *outBestScale = b.poseScales[0];
+
+    int reach = refRadius + b.maxMargin;
+    TouchGradient(grad, baseCx - reach - LAZY_REFINE_PAD, baseCy - reach - LAZY_REFINE_PAD,
+        baseCx + reach + LAZY_REFINE_PAD, baseCy + reach + LAZY_REFINE_PAD);
+    BuildGradientTile(m->tile, grad, imgW, imgH,
+        baseCx - reach, baseCy - reach, baseCx + reach, baseCy + reach);
+
+    double globalBestScore = 0.0;
+    int globalBestDx = 0, globalBestDy = 0, globalBestPose = 0;
+    WorkerLease lease(m->threadBudget);
+    uint64_t span = StatsClock();
+
+    #pragma omp parallel num_threads(lease.Threads())
+    {
+        lease.Pin();
+        ThreadArena& arena = m->arenas[omp_get_thread_num()];
+        double localBest = 0.0;
+        int localDx = 0, localDy = 0, localPose = 0;
+
+        #pragma omp for schedule(dynamic)
+        for (int pi = 0; pi < b.poseCount; pi++)
+        {
+            uint64_t busy = StatsClock();
+            size_t base = (size_t)pi * b.modelCount;
+            if (ScorePoseWindowTiled(m->tile, baseCx, baseCy, refRadius, b.poseMargins[pi],
+                    b.poseX + base, b.poseY + base,
+                    b.poseDx + base, b.poseDy + base, b.modelCount,
+                    imgW, imgH, contrastInvariant, arena.window, arena.rowOff, 0.0,
+                    &localBest, &localDx, &localDy))
+                localPose = pi;
+            StatsBusy(busy);
+        }
+
+        #pragma omp critical
+        {
+            if (localBest > globalBestScore ||
+                (localBest == globalBestScore && localBest > 0.0 && localPose < globalBestPose))
+            {
+                globalBestScore = localBest;
+                globalBestDx = localDx;
+                globalBestDy = localDy;
+                globalBestPose = localPose;
+            }
+        }
+    }
+
+    StatsSpan(span, lease.Threads());
+
+    *outBestDx = globalBestDx;
+    *outBestDy = globalBestDy;
+    *outBestAngle = b.poseAngles[globalBestPose];
+    *outBestScale = b.poseScales[globalBestPose];
+    return globalBestScore;
+}
+
+EXPORT double __cdecl NvEvaluatePoseBank(
+    NvMatcher* m, int bankIndex,
+    int baseCx, int baseCy, int refRadius,
+    const float* dxImg, const float* dyImg, const float* magImg,
+    int imgW, int imgH,
+    int* outBestDx, int* outBestDy, double* outBestAngle, double* outBestScale,
+    int contrastInvariant)
+{
+    return EvaluatePoseBank(m, bankIndex, baseCx, baseCy, refRadius,
+        FloatGradients(dxImg, dyImg, magImg), imgW, imgH,
+        outBestDx, outBestDy, outBestAngle, outBestScale, contrastInvariant);
+}
+
+EXPORT double __cdecl NvEvaluatePoseBankCompact(
+    NvMatcher* m, int bankIndex,
+    int baseCx, int baseCy, int refRadius,
+    const uint32_t* packedImg,
+    int imgW, int imgH,
+    int* outBestDx, int* outBestDy, double* outBestAngle, double* outBestScale,
+    int contrastInvariant)
+{
+    return EvaluatePoseBank(m, bankIndex, baseCx, baseCy, refRadius,
+        MatcherGradients(m, packedImg), imgW, imgH,
+        outBestDx, outBestDy, outBestAngle, outBestScale, contrastInvariant);
+}
+
+// ─── Batched multi-model search ─────────────────────────────────────────────
+// A recipe with many enabled models used to run Phase 1 and Phase 2 once per
+// model, each with its own parallel regions. Here Phase 1 is one VoteModels
+// call over all models, and Phase 2 scores every (model × pose) of every
+// model's pose bank in one parallel loop against a shared best score. Models
+// are scored strongest vote first, so the shared best rises early; a pose of
+// any model is abandoned as soon as it can no longer reach that score, which
+// cuts a model that cannot win to about one point chunk per pose. With edge
+// pruning on, a model whose window bound is below the minimum score gets no
+// pose bank.
+//
+// The winner and its pose are exactly what the per-model calls would give
+// (first model on equal scores). Scores reported for losing models are the
+// best they reached before pruning, not necessarily their true maximum.
+
+static int MatchModels(
+    NvMatcher* m, const NvModelDesc* models, int numModels, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int voteWidth, int voteHeight,
+    double angleStart, double angleExtent,
+    double coarseAngleStep, double fineVoteAngleStep, int topK,
+    double invScale, int binShiftBits,
+    double fineAngleStep, double scaleCenter, double scaleRange, double scaleStep,
+    const GradientView& grad,
+    int imgW, int imgH, int refRadius, int contrastInvariant,
+    NvModelResult* outResults)
+{
+    StageTimer timer(NV_STAGE_SCORE);   // voting and bank builds are charged to their own stages
+    for (int mi = 0; mi < numModels; mi++)
+        outResults[mi] = NvModelResult();
+    if (numModels <= 0) return -1;
+    if (!VoteModels(m, models, numModels, numGradBins, searchX, searchY, searchBin, searchEdgeCount,
+            voteWidth, voteHeight, angleStart, angleExtent, coarseAngleStep, fineVoteAngleStep, topK,
+            scaleCenter, scaleRange, scaleStep, invScale, binShiftBits))
+        return -1;
+
+    // Pose banks, acquired up front; the cache is widened first so this
+    // batch's banks cannot evict each other
+    std::vector<ModelSearch>& st = m->searches;
+    double pyramidScale = 1.0 / invScale;
+    m->poseBankCap = std::max(m->poseBankCap, 2 * numModels);
+    for (int mi = 0; mi < numModels; mi++)
+    {
+        const NvModelDesc& md = models[mi];
+        ModelSearch& s = st[mi];
+        NvModelResult& r = outResults[mi];
+        r.x = s.vote.cx * pyramidScale;
+        r.y = s.vote.cy * pyramidScale;
+        r.angle = s.vote.angle;
+        r.scale = s.vote.scale;
+        r.votes = s.vote.votes;
+
+        s.baseCx = (int)r.x;
+        s.baseCy = (int)r.y;
+        s.score = 0.0;
+        s.bestDx = s.bestDy = s.bestPose = 0;
+        s.poseCount = 0;
+        s.bank = -1;
+
+        // Edge-density pruning: a window that cannot reach the minimum score
+        // gets no pose bank. It reaches refRadius beyond the vote footprint.
+        if (m->pruneMinScore > 0.0)
+        {
+            StageTimer pruneTimer(NV_STAGE_PRUNE);
+            int half = s.reach + (int)ceil(refRadius * invScale);
+            s.bound = WindowBound(m, (voteWidth >> binShiftBits) + 1, (voteHeight >> binShiftBits) + 1,
+                binShiftBits, s.outline, (int)s.vote.cx, (int)s.vote.cy, half);
+            StatAdd(NV_COUNT_WINDOWS_BOUNDED, 1);
+            if (s.bound < m->pruneMinScore)
+            {
+                StatAdd(NV_COUNT_WINDOWS_REJECTED, 1);
+                continue;
+            }
+        }
+
+        s.bank = md.modelDx && md.modelDy
+            ? NvAcquirePoseBank(m, md.modelKey, md.modelX, md.modelY, md.modelDx, md.modelDy,
+                md.modelCount, s.vote.angle, coarseAngleStep, fineAngleStep,
+                s.bandCenter, s.bandRange, scaleStep, &s.poseCount)
+            : -1;
+        if (s.bank < 0) s.poseCount = 0;
+    }
+    if (!EnsureWindow(m, refRadius)) return -1;
+
+    for (int mi = 0; mi < numModels && grad.lazy; mi++)
+    {
+        const ModelSearch& s = st[mi];
+        if (s.poseCount == 0) continue;
+        int reach = refRadius + m->poseBanks[s.bank].maxMargin + LAZY_REFINE_PAD;
+        TouchGradient(grad, s.baseCx - reach, s.baseCy - reach, s.baseCx + reach, s.baseCy + reach);
+    }
+
+    // Strongest vote first, then lay out the (model × pose) work items
+    std::vector<int>& order = m->searchOrder;
+    order.resize(numModels);
+    for (int mi = 0; mi < numModels; mi++) order[mi] = mi;
+    std::stable_sort(order.begin(), order.end(),
+        [&st](int a, int b) { return st[a].vote.votes > st[b].vote.votes; });
+    std::vector<int>& itemBase = m->itemBase;
+    itemBase.resize(numModels + 1);
+    itemBase[0] = 0;
+    for (int k = 0; k < numModels; k++)
+        itemBase[k + 1] = itemBase[k] + st[order[k]].poseCount;
+    int totalItems = itemBase[numModels];
+
+    if (m->candTiles.size() < (size_t)numModels) m->candTiles.resize(numModels);
+    m->poseBest.resize((size_t)m->numThreads * numModels);
+    std::atomic<double> sharedBest(0.0);
+    WorkerLease lease(m->threadBudget);
+    uint64_t span = StatsClock();
+
+    #pragma omp parallel num_threads(lease.Threads())
+    {
+        lease.Pin();
+        int tid = omp_get_thread_num();
+        ThreadArena& arena = m->arenas[tid];
+        PoseBest* local = m->poseBest.data() + (size_t)tid * numModels;
+        for (int mi = 0; mi < numModels; mi++)
+            local[mi] = PoseBest();
+
+        #pragma omp for schedule(dynamic)
+        for (int mi = 0; mi < numModels; mi++)
+        {
+            const ModelSearch& s = st[mi];
+            if (s.poseCount == 0) continue;
+            int reach = refRadius + m->poseBanks[s.bank].maxMargin;
+            BuildGradientTile(m->candTiles[mi], grad, imgW, imgH,
+                s.baseCx - reach, s.baseCy - reach, s.baseCx + reach, s.baseCy + reach);
+        }
+
+        #pragma omp for schedule(dynamic)
+        for (int w = 0; w < totalItems; w++)
+        {
+            int k = (int)(std::upper_bound(itemBase.begin(), itemBase.end(), w) - itemBase.begin()) - 1;
+            int mi = order[k];
+            int pi = w - itemBase[k];
+            const ModelSearch& s = st[mi];
+            const PoseBank& b = m->poseBanks[s.bank];
+            size_t base = (size_t)pi * b.modelCount;
+            PoseBest& lb = local[mi];
+            uint64_t busy = StatsClock();
+
+            if (ScorePoseWindowTiled(m->candTiles[mi], s.baseCx, s.baseCy, refRadius, b.poseMargins[pi],
+                    b.poseX + base, b.poseY + base,
+                    b.poseDx + base, b.poseDy + base, b.modelCount,
+                    imgW, imgH, contrastInvariant, arena.window, arena.rowOff,
+                    sharedBest.load(std::memory_order_relaxed),
+                    &lb.score, &lb.dx, &lb.dy))
+            {
+                lb.pose = pi;
+                double cur = sharedBest.load(std::memory_order_relaxed);
+                while (lb.score > cur &&
+                       !sharedBest.compare_exchange_weak(cur, lb.score, std::memory_order_relaxed)) {}
+            }
+            StatsBusy(busy);
+        }
+
+        // Equal scores within a model resolve to the lowest pose index, as
+        // in EvaluatePoseBank
+        #pragma omp critical
+        {
+            for (int mi = 0; mi < numModels; mi++)
+            {
+                const PoseBest& lb = local[mi];
+                ModelSearch& s = st[mi];
+                if (lb.score > s.score ||
+                    (lb.score == s.score && lb.score > 0.0 && lb.pose < s.bestPose))
+                {
+                    s.score = lb.score;
+                    s.bestDx = lb.dx;
+                    s.bestDy = lb.dy;
+                    s.bestPose = lb.pose;
+                }
+            }
+        }
+    }
+
+    StatsSpan(span, lease.Threads());
+
+    int winner = -1;
+    double winnerScore = 0.0;
+    for (int mi = 0; mi < numModels; mi++)
+    {
+        const ModelSearch& s = st[mi];
+        if (s.score <= 0.0) continue;
+        const PoseBank& b = m->poseBanks[s.bank];
+        NvModelResult& r = outResults[mi];
+        r.x = s.baseCx + s.bestDx;
+        r.y = s.baseCy + s.bestDy;
+        r.angle = b.poseAngles[s.bestPose];
+        r.scale = b.poseScales[s.bestPose];
+        r.score = s.score;
+        if (s.score > winnerScore)
+        {
+            winnerScore = s.score;
+            winner = mi;
+        }
+    }
+    return winner;
+}
+
+// Returns the index of the best-scoring model, or -1 if no model scored.
+// outResults receives numModels entries (full-resolution coordinates).
+EXPORT int __cdecl NvMatchModels(
+    NvMatcher* m, const NvModelDesc* models, int numModels, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int voteWidth, int voteHeight,
+    double angleStart, double angleExtent,
+    double coarseAngleStep, double fineVoteAngleStep, int topK,
+    double invScale, int binShiftBits,
+    double fineAngleStep, double scaleCenter, double scaleRange, double scaleStep,
+    const float* dxImg, const float* dyImg, const float* magImg,
+    int imgW, int imgH, int refRadius, int contrastInvariant,
+    NvModelResult* outResults)
+{
+    return MatchModels(m, models, numModels, numGradBins,
+        searchX, searchY, searchBin, searchEdgeCount, voteWidth, voteHeight,
+        angleStart, angleExtent, coarseAngleStep, fineVoteAngleStep, topK,
+        invScale, binShiftBits, fineAngleStep, scaleCenter, scaleRange, scaleStep,
+        FloatGradients(dxImg, dyImg, magImg), imgW, imgH, refRadius, contrastInvariant,
+        outResults);
+}
+
+EXPORT int __cdecl NvMatchModelsCompact(
+    NvMatcher* m, const NvModelDesc* models, int numModels, int numGradBins,
+    const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+    int voteWidth, int voteHeight,
+    double angleStart, double angleExtent,
+    double coarseAngleStep, double fineVoteAngleStep, int topK,
+    double invScale, int binShiftBits,
+    double fineAngleStep, double scaleCenter, double scaleRange, double scaleStep,
+    const uint32_t* packedImg,
+    int imgW, int imgH, int refRadius, int contrastInvariant,
+    NvModelResult* outResults)
+{
+    return MatchModels(m, models, numModels, numGradBins,
+        searchX, searchY, searchBin, searchEdgeCount, voteWidth, voteHeight,
+        angleStart, angleExtent, coarseAngleStep, fineVoteAngleStep, topK,
+        invScale, binShiftBits, fineAngleStep, scaleCenter, scaleRange, scaleStep,
+        MatcherGradients(m, packedImg), imgW, imgH, refRadius, contrastInvariant,
+        outResults);
+}
+
+// ─── Sub-pixel pose refinement (Gauss-Newton edge alignment) ────────────────
+// Phase 2 leaves the pose on its grid: whole pixels and fine angle / scale
+// steps. Refinement moves each model point to the nearest image edge along
+// its rotated normal — the peak of the bilinearly sampled gradient projected
+// on that normal — and solves the least-squares x, y, angle, scale update
+// that best explains those offsets, linearised around the current pose.
+// A few iterations reach well below 0.1 px / 0.05°, so the pose grid itself
+// can stay coarse.
+
+static const int REFINE_SPAN = 2;               // normal search: ±2 px
+static const double REFINE_MAX_SHIFT = 2.0;     // px from the starting pose
+static const double REFINE_MIN_ALIGNMENT = 0.5; // cos(model normal, gradient)
+
+// Bilinear gradient at (x, y); false outside the interpolable area
+static inline bool SampleGradient(
+    const GradientView& grad, int imgW, int imgH, double x, double y, double* gx, double* gy)
+{
+    if (!(x >= 0.0 && y >= 0.0 && x < imgW - 1 && y < imgH - 1)) return false;
+    int x0 = (int)x, y0 = (int)y;
+    double fx = x - x0, fy = y - y0;
+    double w00 = (1.0 - fx) * (1.0 - fy), w10 = fx * (1.0 - fy);
+    double w01 = (1.0 - fx) * fy, w11 = fx * fy;
+    size_t i = (size_t)y0 * imgW + x0;
+    if (grad.packed)
+    {
+        uint32_t a = grad.packed[i], b = grad.packed[i + 1];
+        uint32_t c = grad.packed[i + imgW], d = grad.packed[i + imgW + 1];
+        *gx = w00 * (int16_t)(a & 0xFFFF) + w10 * (int16_t)(b & 0xFFFF)
+            + w01 * (int16_t)(c & 0xFFFF) + w11 * (int16_t)(d & 0xFFFF);
+        *gy = w00 * (int16_t)(a >> 16) + w10 * (int16_t)(b >> 16)
+            + w01 * (int16_t)(c >> 16) + w11 * (int16_t)(d >> 16);
+    }
+    else
+    {
+        *gx = w00 * grad.dx[i] + w10 * grad.dx[i + 1] + w01 * grad.dx[i + imgW] + w11 * grad.dx[i + imgW + 1];
+        *gy = w00 * grad.dy[i] + w10 * grad.dy[i + 1] + w01 * grad.dy[i + imgW] + w11 * grad.dy[i + imgW + 1];
+    }
+    return true;
+}
+
+// Signed distance from (px, py) along the unit normal (nx, ny) to the
+// strongest edge within ±REFINE_SPAN, refined by a parabola through the
+// projected gradient. False if there is no edge aligned with the normal.
+static bool EdgeOffsetAlongNormal(
+    const GradientView& grad, int imgW, int imgH,
+    double px, double py, double nx, double ny, int contrastInvariant, double* offset)
+{
+    const int SAMPLES = 2 * REFINE_SPAN + 1;
+    double h[SAMPLES], m2[SAMPLES];
+    for (int k = 0; k < SAMPLES; k++)
+    {
+        double t = k - REFINE_SPAN, gx, gy;
+        if (!SampleGradient(grad, imgW, imgH, px + t * nx, py + t * ny, &gx, &gy)) return false;
+        double proj = gx * nx + gy * ny;
+        h[k] = contrastInvariant ? fabs(proj) : std::max(proj, 0.0);
+        m2[k] = gx * gx + gy * gy;
+    }
+
+    // Interior maximum only: a peak on the span's end has no parabola
+    int best = 1;
+    for (int k = 2; k < SAMPLES - 1; k++)
+        if (h[k] > h[best]) best = k;
+    if (h[best] <= 0.0 || h[best] < h[best - 1] || h[best] < h[best + 1]) return false;
+    if (h[best] < REFINE_MIN_ALIGNMENT * sqrt(m2[best])) return false;
+
+    double denom = h[best - 1] - 2.0 * h[best] + h[best + 1];
+    double vertex = denom < 0.0 ? 0.5 * (h[best - 1] - h[best + 1]) / denom : 0.0;
+    *offset = (best - REFINE_SPAN) + std::min(std::max(vertex, -0.5), 0.5);
+    return true;
+}
+
+// Solve the n × n system a·x = b in place (Gaussian elimination, partial
+// pivoting). False if singular.
+static bool SolveLinear(double a[4][4], double b[4], int n, double x[4])
+{
+    for (int c = 0; c < n; c++)
+    {
+        int piv = c;
+        for (int r = c + 1; r < n; r++)
+            if (fabs(a[r][c]) > fabs(a[piv][c])) piv = r;
+        if (fabs(a[piv][c]) < 1e-12) return false;
+        if (piv != c)
+        {
+            for (int k = 0; k < n; k++) std::swap(a[c][k], a[piv][k]);
+            std::swap(b[c], b[piv]);
+        }
+        for (int r = c + 1; r < n; r++)
+        {
+            double f = a[r][c] / a[c][c];
+            for (int k = c; k < n; k++) a[r][k] -= f * a[c][k];
+            b[r] -= f * b[c];
+        }
+    }
+    for (int r = n - 1; r >= 0; r--)
+    {
+        double v = b[r];
+        for (int k = r + 1; k < n; k++) v -= a[r][k] * x[k];
+        x[r] = v / a[r][r];
+    }
+    return true;
+}
+
+// Refine (x, y, angle°, scale) in place. angleLimit / scaleLimit bound how
+// far each may move from the starting pose (normally one grid step); 0
+// keeps it fixed. Returns the number of model points in the final solve, or
+// 0 if the refinement failed and the pose was left unchanged.
+static int RefinePose(
+    const float* modelX, const float* modelY,
+    const float* modelDx, const float* modelDy, int modelCount,
+    const GradientView& grad, int imgW, int imgH, int contrastInvariant,
+    double angleLimit, double scaleLimit, int maxIterations,
+    double* ioX, double* ioY, double* ioAngle, double* ioScale)
+{
+    StageTimer timer(NV_STAGE_REFINE);
+    const double DEG2RAD = 3.14159265358979323846 / 180.0;
+    const int MIN_POINTS = 8;
+
+    // Free parameters: x, y, then angle (radians) and scale if not fixed
+    int idxAngle = angleLimit > 0.0 ? 2 : -1;
+    int idxScale = scaleLimit > 0.0 ? (idxAngle >= 0 ? 3 : 2) : -1;
+    int n = 2 + (idxAngle >= 0) + (idxScale >= 0);
+
+    double x = *ioX, y = *ioY, theta = *ioAngle * DEG2RAD, scale = *ioScale;
+    if (grad.lazy)
+    {
+        double extent = 0.0;
+        for (int i = 0; i < modelCount; i++)
+            extent = std::max(extent, (double)modelX[i] * modelX[i] + (double)modelY[i] * modelY[i]);
+        int reach = (int)ceil(sqrt(extent) * (scale + scaleLimit) + REFINE_MAX_SHIFT) + REFINE_SPAN + 2;
+        TouchGradient(grad, (int)x - reach, (int)y - reach, (int)x + reach, (int)y + reach);
+    }
+
+    int used = 0;
+    for (int iter = 0; iter < maxIterations; iter++)
+    {
+        double c = cos(theta), sn = sin(theta);
+        double jtj[4][4] = {}, jtr[4] = {};
+        used = 0;
+
+        for (int i = 0; i < modelCount; i++)
+        {
+            // Rotated offset q and normal (nx, ny) of point i
+            double qx = scale * (modelX[i] * c - modelY[i] * sn);
+            double qy = scale * (modelX[i] * sn + modelY[i] * c);
+            double nx = modelDx[i] * c - modelDy[i] * sn;
+            double ny = modelDx[i] * sn + modelDy[i] * c;
+            double nLen = sqrt(nx * nx + ny * ny);
+            if (nLen < 1e-6) continue;
+            nx /= nLen;
+            ny /= nLen;
+
+            double d;
+            if (!EdgeOffsetAlongNormal(grad, imgW, imgH, x + qx, y + qy, nx, ny, contrastInvariant, &d))
+                continue;
+
+            // d ≈ n · Δp, with Δp = Δt + Δθ·(-qy, qx) + Δs·q / s
+            double j[4];
+            j[0] = nx;
+            j[1] = ny;
+            if (idxAngle >= 0) j[idxAngle] = -qy * nx + qx * ny;
+            if (idxScale >= 0) j[idxScale] = (qx * nx + qy * ny) / scale;
+            for (int r = 0; r < n; r++)
+            {
+                jtr[r] += j[r] * d;
+                for (int k = 0; k < n; k++) jtj[r][k] += j[r] * j[k];
+            }
+            used++;
+        }
+
+        double delta[4] = {};
+        if (used < MIN_POINTS || !SolveLinear(jtj, jtr, n, delta)) return 0;
+
+        x += delta[0];
+        y += delta[1];
+        if (idxAngle >= 0) theta += delta[idxAngle];
+        if (idxScale >= 0) scale += delta[idxScale];
+
+        if (fabs(x - *ioX) > REFINE_MAX_SHIFT || fabs(y - *ioY) > REFINE_MAX_SHIFT ||
+            fabs(theta / DEG2RAD - *ioAngle) > angleLimit + 1e-9 ||
+            fabs(scale - *ioScale) > scaleLimit + 1e-9)
+            return 0;
+
+        bool converged = fabs(delta[0]) < 1e-3 && fabs(delta[1]) < 1e-3 &&
+            (idxAngle < 0 || fabs(delta[idxAngle]) < 1e-4 * DEG2RAD) &&
+            (idxScale < 0 || fabs(delta[idxScale]) < 1e-5);
+        if (converged) break;
+    }
+
+    if (used < MIN_POINTS) return 0;
+    *ioX = x;
+    *ioY = y;
+    *ioAngle = theta / DEG2RAD;
+    *ioScale = scale;
+    return used;
+}
+
+EXPORT int __cdecl NvRefinePose(
+    const float* modelX, const float* modelY,
+    const float* modelDx, const float* modelDy, int modelCount,
+    const float* dxImg, const float* dyImg, const float* magImg,
+    int imgW, int imgH, int contrastInvariant,
+    double angleLimit, double scaleLimit, int maxIterations,
+    double* ioX, double* ioY, double* ioAngle, double* ioScale)
+{
+    return RefinePose(modelX, modelY, modelDx, modelDy, modelCount,
+        FloatGradients(dxImg, dyImg, magImg), imgW, imgH, contrastInvariant,
+        angleLimit, scaleLimit, maxIterations, ioX, ioY, ioAngle, ioScale);
+}
+
+EXPORT int __cdecl NvRefinePoseCompact(
+    const float* modelX, const float* modelY,
+    const float* modelDx, const float* modelDy, int modelCount,
+    const uint32_t* packedImg,
+    int imgW, int imgH, int contrastInvariant,
+    double angleLimit, double scaleLimit, int maxIterations,
+    double* ioX, double* ioY, double* ioAngle, double* ioScale)
+{
+    return RefinePose(modelX, modelY, modelDx, modelDy, modelCount,
+        CompactGradients(packedImg), imgW, imgH, contrastInvariant,
+        angleLimit, scaleLimit, maxIterations, ioX, ioY, ioAngle, ioScale);
+}
+
+// ─── Frame-to-frame tracking ────────────────────────────────────────────────
+// Once a part has been found, the next frame's pose is bounded by how far it
+// can move between frames. Tracking skips Phase 1 entirely: the gradient is
+// computed only for the window the part can reach, and Phase 2 scores a pose
+// bank spanning just the allowed rotation / scale change around the previous
+// pose, then refines the winner. The caller falls back to the full search
+// when the score drops below its threshold.
+//
+// Scores and poses equal a full search's Phase 2 over the same window and
+// bank: the window is grown by the bank margin, the refinement reach and the
+// gradient's zero border, so every pixel the scorers read is an interior one.
+
+// Returns the grid score (0 if nothing could be scored); the refined pose is
+// written in image coordinates. angleStep / scaleStep are the bank's grid.
+EXPORT double __cdecl NvTrackPose(
+    NvMatcher* m, int modelKey,
+    const float* modelX, const float* modelY,
+    const float* modelDx, const float* modelDy,
+    const float* refineX, const float* refineY, int modelCount,
+    const uint8_t* gray, int width, int height, int stride,
+    double prevX, double prevY, double prevAngle, double prevScale,
+    double maxShift, double maxRotation, double maxScaleChange,
+    double angleStep, double scaleStep, int contrastInvariant, int refineIterations,
+    double* outX, double* outY, double* outAngle, double* outScale)
+{
+    StageTimer timer(NV_STAGE_TRACK);   // gradient, scoring and refinement report under their own stages
+    *outX = prevX;
+    *outY = prevY;
+    *outAngle = prevAngle;
+    *outScale = prevScale;
+    if (modelCount <= 0 || angleStep <= 0.0 || scaleStep <= 0.0) return 0.0;
+    if (!(prevX >= 0.0 && prevY >= 0.0 && prevX < width && prevY < height)) return 0.0;
+
+    // The bank is centred on the grid pose nearest the previous one, so a
+    // part at rest keeps hitting the same cached bank
+    double centerAngle = std::round(prevAngle / angleStep) * angleStep;
+    double angleRange = std::ceil(std::max(maxRotation, 0.0) / angleStep - 1e-9) * angleStep;
+    // With no scale change allowed the scale is carried over as is
+    bool scaled = maxScaleChange > 0.0;
+    double scaleCenter = scaled ? std::round(prevScale / scaleStep) * scaleStep : prevScale;
+    double scaleRange = scaled ? std::ceil(maxScaleChange / scaleStep - 1e-9) * scaleStep : 0.0;
+
+    int poseCount = 0;
+    int bank = NvAcquirePoseBank(m, modelKey, modelX, modelY, modelDx, modelDy, modelCount,
+        centerAngle, angleRange, angleStep, scaleCenter, scaleRange, scaleStep, &poseCount);
+    if (bank < 0 || poseCount == 0) return 0.0;
+
+    int refRadius = std::max(1, (int)std::ceil(maxShift));
+    int half = refRadius + m->poseBanks[bank].maxMargin
+        + REFINE_SPAN + (int)std::ceil(REFINE_MAX_SHIFT) + 2;
+    int cx = (int)prevX, cy = (int)prevY;
+    int x0 = std::max(cx - half, 0), y0 = std::max(cy - half, 0);
+    int x1 = std::min(cx + half + 1, width), y1 = std::min(cy + half + 1, height);
+    int winW = x1 - x0, winH = y1 - y0;
+    if (winW < 3 || winH < 3) return 0.0;
+
+    std::vector<uint32_t>& g = m->trackGrad;
+    g.resize((size_t)winW * winH);
+    ComputeGradientCompactNative(gray + (size_t)y0 * stride + x0, winW, winH, stride, g.data(), nullptr);
+    GradientView grad = CompactGradients(g.data());
+
+    int bestDx = 0, bestDy = 0;
+    double angle = prevAngle, scale = prevScale;
+    double score = EvaluatePoseBank(m, bank, cx - x0, cy - y0, refRadius, grad, winW, winH,
+        &bestDx, &bestDy, &angle, &scale, contrastInvariant);
+    if (score <= 0.0) return 0.0;
+
+    double x = cx - x0 + bestDx, y = cy - y0 + bestDy;
+    if (refineX && refineY && refineIterations > 0)
+        RefinePose(refineX, refineY, modelDx, modelDy, modelCount, grad, winW, winH, contrastInvariant,
+            angleStep, scaled ? scaleStep : 0.0, refineIterations, &x, &y, &angle, &scale);
+
+    *outX = x + x0;
+    *outY = y + y0;
+    *outAngle = angle;
+    *outScale = scale;
+    return score;
+}
+
+// ─── Search-edge extraction: pyramid + Canny + phase bins (Phase 1 input) ───
+// One call replaces the PyrDown chain, Canny, two Sobels, Phase and both
+// managed scans. The gradient is computed once, at the vote level only; when
+// voting runs at full resolution the caller's packed plane from
+// ComputeGradientCompactNative is reused as is. Canny follows OpenCV (L1
+// magnitude, 22.5° sector NMS, 8-connected hysteresis) except that the
+// one-pixel image border never yields edges, as in the gradient kernels.
+
+static inline int Reflect101(int i, int n)
+{
+    if (n == 1) return 0;
+    while ((unsigned)i >= (unsigned)n)
+        i = i < 0 ? -i : 2 * n - 2 - i;
+    return i;
+}
+
+static inline int GradX(uint32_t g) { return (int16_t)(g & 0xFFFF); }
+static inline int GradY(uint32_t g) { return (int16_t)(g >> 16); }
+static inline int GradL1(uint32_t g) { return abs(GradX(g)) + abs(GradY(g)); }
+
+// 5×5 Gaussian [1 4 6 4 1]² / 256, keep even rows/columns — matches cv::pyrDown
+// (BORDER_REFLECT_101, output ((w+1)/2, (h+1)/2)).
+static void PyrDownNative(
+    NvMatcher* m, const uint8_t* src, int w, int h, int stride,
+    uint8_t* dst, int dw, int dh)
+{
+    int rowLen = w + 4;
+    m->pyrRows.resize((size_t)m->numThreads * rowLen);
+    int* rowsBase = m->pyrRows.data();
+
+    WorkerLease lease(m->threadBudget);
+    #pragma omp parallel num_threads(lease.Threads())
+    {
+        lease.Pin();
+        // v[-2 .. w+1]: vertical pass for one output row, padded for the horizontal pass
+        int* v = rowsBase + (size_t)omp_get_thread_num() * rowLen + 2;
+
+        #pragma omp for schedule(static)
+        for (int y = 0; y < dh; y++)
+        {
+            const uint8_t* s0 = src + Reflect101(2 * y - 2, h) * stride;
+            const uint8_t* s1 = src + Reflect101(2 * y - 1, h) * stride;
+            const uint8_t* s2 = src + Reflect101(2 * y,     h) * stride;
+            const uint8_t* s3 = src + Reflect101(2 * y + 1, h) * stride;
+            const uint8_t* s4 = src + Reflect101(2 * y + 2, h) * stride;
+            for (int x = 0; x < w; x++)
+                v[x] = s0[x] + 4 * (s1[x] + s3[x]) + 6 * s2[x] + s4[x];
+            v[-2] = v[Reflect101(-2, w)];
+            v[-1] = v[Reflect101(-1, w)];
+            v[w]     = v[Reflect101(w, w)];
+            v[w + 1] = v[Reflect101(w + 1, w)];
+
+            uint8_t* d = dst + (size_t)y * dw;
+            for (int x = 0; x < dw; x++)
+            {
+                const int* c = v + 2 * x;
+                d[x] = (uint8_t)((c[-2] + 4 * (c[-1] + c[1]) + 6 * c[0] + c[2] + 128) >> 8);
+            }
+        }
+    }
+}
+
+// Canny on a packed gradient plane, then collect edges in row-major order
+// with their orientation bin. Returns the edge count (kept in m->edgeX/Y/Bin).
+static int CannyEdgeList(
+    NvMatcher* m, const uint32_t* grad, int w, int h,
+    double lowThresh, double highThresh, int numGradBins)
+{
+    m->edgeX.clear();
+    m->edgeY.clear();
+    m->edgeBin.clear();
+    if (w < 3 || h < 3) return 0;
+
+    if (lowThresh > highThresh) std::swap(lowThresh, highThresh);
+    int low = (int)floor(lowThresh);
+    int high = (int)floor(highThresh);
+
+    // Map: 0 = weak candidate, 1 = not an edge, 2 = edge
+    m->edgeMap.resize((size_t)w * h);
+    uint8_t* map = m->edgeMap.data();
+    memset(map, 1, w);
+    memset(map + (size_t)(h - 1) * w, 1, w);
+
+    // tan(22.5°) in Q15, as in OpenCV
+    const int TG22 = (int)(0.4142135623730950488016887242097 * (1 << 15) + 0.5);
+
+    WorkerLease lease(m->threadBudget);
+    #pragma omp parallel for schedule(static) num_threads(lease.Threads())
+    for (int y = 1; y < h - 1; y++)
+    {
+        lease.Pin();
+        const uint32_t* g = grad + (size_t)y * w;
+        uint8_t* mp = map + (size_t)y * w;
+        mp[0] = mp[w - 1] = 1;
+
+        for (int x = 1; x < w - 1; x++)
+        {
+            int gx = GradX(g[x]), gy = GradY(g[x]);
+            int ax = abs(gx), ay = abs(gy);
+            int mag = ax + ay;
+            uint8_t v = 1;
+            if (mag > low)
+            {
+                int tg22x = ax * TG22;
+                int ys = ay << 15;
+                bool peak;
+                if (ys < tg22x)
+                    peak = mag > GradL1(g[x - 1]) && mag >= GradL1(g[x + 1]);
+                else if (ys > tg22x + (ax << 16))
+                    peak = mag > GradL1(g[x - w]) && mag >= GradL1(g[x + w]);
+                else
+                {
+                    int s = (gx ^ gy) < 0 ? -1 : 1;
+                    peak = mag > GradL1(g[x - w - s]) && mag > GradL1(g[x + w + s]);
+                }
+                if (peak) v = mag > high ? 2 : 0;
+            }
+            mp[x] = v;
+        }
+    }
+
+    // Hysteresis: grow strong edges through 8-connected weak candidates.
+    // Edges never touch the border, so every neighbour index is in range.
+    std::vector<int>& stack = m->edgeStack;
+    stack.clear();
+    size_t total = (size_t)w * h;
+    for (size_t i = 0; i < total; i++)
+        if (map[i] == 2) stack.push_back((int)i);
+
+    const int nb[8] = { -w - 1, -w, -w + 1, -1, 1, w - 1, w, w + 1 };
+    while (!stack.empty())
+    {
+        int i = stack.back();
+        stack.pop_back();
+        for (int k = 0; k < 8; k++)
+        {
+            int n = i + nb[k];
+            if (map[n] == 0) { map[n] = 2; stack.push_back(n); }
+        }
+    }
+
+    const double RAD2DEG = 180.0 / 3.14159265358979323846;
     double binWidthDeg = 360.0 / numGradBins;
+    for (int y = 1; y < h - 1; y++)
+    {
+        const uint8_t* mp = map + (size_t)y * w;
+        const uint32_t* g = grad + (size_t)y * w;
+        for (int x = 1; x < w - 1; x++)
+        {
+            if (mp[x] != 2) continue;
+            double phase = atan2((double)GradY(g[x]), (double)GradX(g[x])) * RAD2DEG;
+            if (phase < 0) phase += 360.0;
+            int b = (int)(phase / binWidthDeg);
+            if (b >= numGradBins) b = numGradBins - 1;
+            m->edgeX.push_back(x);
+            m->edgeY.push_back(y);
+            m->edgeBin.push_back(b);
+        }
+    }
+    return (int)m->edgeX.size();
+}
+
+// levels = pyramid levels (1 = vote at full resolution). fullGrad is the
+// packed gradient of gray (may be null); it is only read when levels == 1.
+// The vote level measures ((w+1)/2, (h+1)/2) applied levels-1 times.
+// Returns the edge count; fetch the edges with NvCopySearchEdges.
+EXPORT int __cdecl NvExtractSearchEdges(
+    NvMatcher* m,
+    const uint8_t* gray, int width, int height, int stride,
+    int levels,
+    const uint32_t* fullGrad,
+    double cannyLow, double cannyHigh, int numGradBins)
+{
+    StageTimer timer(NV_STAGE_SEARCH_EDGES);
+    const uint8_t* level = gray;
+    int w = width, h = height, levelStride = stride;
+
+    for (int lvl = 1; lvl < levels; lvl++)
+    {
+        int dw = (w + 1) / 2, dh = (h + 1) / 2;
+        std::vector<uint8_t>& dst = (lvl & 1) ? m->pyrA : m->pyrB;
+        dst.resize((size_t)dw * dh);
+        PyrDownNative(m, level, w, h, levelStride, dst.data(), dw, dh);
+        level = dst.data();
+        w = dw; h = dh; levelStride = dw;
+    }
+
+    const uint32_t* grad = fullGrad;
+    if (levels <= 1 && grad)
+    {
+        // Canny reads every pixel: a lazy plane is completed here
+        GradientView full = MatcherGradients(m, grad);
+        TouchGradient(full, 0, 0, width - 1, height - 1);
+    }
+    if (levels > 1 || !grad)
+    {
+        m->edgeGrad.resize((size_t)w * h);
+        ComputeGradientCompactNative(level, w, h, levelStride, m->edgeGrad.data(), nullptr);
+        grad = m->edgeGrad.data();
+    }
+
+    return CannyEdgeList(m, grad, w, h, cannyLow, cannyHigh, numGradBins);
+}
+
+// Copies the edge list of the last NvExtractSearchEdges call.
+EXPORT void __cdecl NvCopySearchEdges(NvMatcher* m, int* outX, int* outY, int* outBin)
+{
+    size_t n = m->edgeX.size();
+    if (n == 0) return;
+    memcpy(outX, m->edgeX.data(), n * sizeof(int));
+    memcpy(outY, m->edgeY.data(), n * sizeof(int));
+    memcpy(outBin, m->edgeBin.data(), n * sizeof(int));
+}
+
+// ─── Caliper measurement (CaliperTool / LineFitTool / CircleFitTool) ────────
+// A caliper is an oriented search rectangle: the profile runs from (x, y)
+// along the unit vector u for `length` px and is averaged across `width` px
+// along v. Sampling follows the WarpAffine strip the tools used to build —
+// profile column c, strip row r map to
+//   (x, y) - v·width/2 + c·u·length/L + r·v·width/R,  L = (int)length, R = max(1, (int)width)
+// with bilinear interpolation and reflect-101 borders — but each row is
+// accumulated straight into the projection, so no strip is ever stored.
+// The profile is then optionally smoothed (edge-renormalised taps), passed
+// through the caller's derivative taps, and scanned for local gradient
+// extrema above the threshold.
+
+struct NvCaliper
+{
+    double x, y;     // start of the search line
+    double ux, uy;   // unit search direction
+    double vx, vy;   // unit projection direction
+    double length;   // search length, px
+    double width;    // projection width, px
+};
+
+struct NvCaliperEdge
+{
+    double position; // sub-pixel profile position (parabola through |gradient|)
+    double contrast; // |gradient| at the peak
+    int index;       // integer profile position of the peak
+    int polarity;    // +1 dark → light, -1 light → dark
+};
+
+// Bilinear sample with reflect-101 taps (as WarpAffine's BORDER_REFLECT_101),
+// for calipers touching the image border
+static inline float BilinearU8Border(const uint8_t* img, int w, int h, int stride, double x, double y)
+{
+    double fxd = floor(x), fyd = floor(y);
+    int xi = (int)fxd, yi = (int)fyd;
+    float fx = (float)(x - fxd), fy = (float)(y - fyd);
+    int xa = Reflect101(xi, w), xb = Reflect101(xi + 1, w);
+    const uint8_t* ra = img + (size_t)Reflect101(yi, h) * stride;
+    const uint8_t* rb = img + (size_t)Reflect101(yi + 1, h) * stride;
+    float top = ra[xa] + fx * ((float)ra[xb] - (float)ra[xa]);
+    float bot = rb[xa] + fx * ((float)rb[xb] - (float)rb[xa]);
+    return top + fy * (bot - top);
+}
+
+// Projection of one caliper into acc[0 .. L). rowWeights sum to 1.
+static void ProjectCaliper(
+    const uint8_t* img, int w, int h, int stride,
+    const NvCaliper& cal, int L, int R, const float* rowWeights, float* acc)
+{
+    double cx = cal.ux * cal.length / L, cy = cal.uy * cal.length / L;
+    double rx = cal.vx * cal.width / R, ry = cal.vy * cal.width / R;
+    double ox = cal.x - cal.vx * cal.width * 0.5;
+    double oy = cal.y - cal.vy * cal.width * 0.5;
+
+    // Sample positions are affine in (c, r): the four corners bound them all
+    double minX = ox, maxX = ox, minY = oy, maxY = oy;
+    for (int k = 1; k < 4; k++)
+    {
+        double px = ox + ((k & 1) ? (L - 1) * cx : 0.0) + ((k & 2) ? (R - 1) * rx : 0.0);
+        double py = oy + ((k & 1) ? (L - 1) * cy : 0.0) + ((k & 2) ? (R - 1) * ry : 0.0);
+        minX = std::min(minX, px); maxX = std::max(maxX, px);
+        minY = std::min(minY, py); maxY = std::max(maxY, py);
+    }
+    bool inside = minX >= 0.0 && minY >= 0.0 && maxX <= w - 4.001 && maxY <= h - 2.001;
+
+    memset(acc, 0, L * sizeof(float));
+    for (int r = 0; r < R; r++)
+    {
+        double x0 = ox + r * rx, y0 = oy + r * ry;
+        if (inside)
+        {
+            g_kernels.project(img, stride, (float)x0, (float)y0, (float)cx, (float)cy,
+                              L, rowWeights[r], acc);
+            continue;
+        }
+        for (int c = 0; c < L; c++)
+            acc[c] += rowWeights[r] * BilinearU8Border(img, w, h, stride, x0 + c * cx, y0 + c * cy);
+    }
+}
+
+// Smooth (optional), differentiate and scan one profile. Gradient entries
+// closer than derivHalfWidth to either end stay 0. Returns the edges stored
+// (at most capacity, in profile order).
+static int DetectCaliperEdges(
+    const double* profile, int L,
+    const double* smoothKernel, int smoothHalfWidth,
+    const double* derivKernel, int derivHalfWidth,
+    double threshold, int polarity,
+    double* smoothed, double* gradient,
+    NvCaliperEdge* edges, int capacity)
+{
+    const double* p = profile;
+    if (smoothKernel && smoothHalfWidth > 0)
+    {
+        for (int i = 0; i < L; i++)
+        {
+            double sum = 0.0, wSum = 0.0;
+            int k0 = std::max(-smoothHalfWidth, -i), k1 = std::min(smoothHalfWidth, L - 1 - i);
+            for (int k = k0; k <= k1; k++)
+            {
+                double wk = smoothKernel[k + smoothHalfWidth];
+                sum += profile[i + k] * wk;
+                wSum += wk;
+            }
+            smoothed[i] = wSum > 0.0 ? sum / wSum : profile[i];
+        }
+        p = smoothed;
+    }
+
+    const int hw = derivHalfWidth;
+    memset(gradient, 0, L * sizeof(double));
+    for (int i = hw; i < L - hw; i++)
+    {
+        double sum = 0.0;
+        for (int j = -hw; j <= hw; j++)
+            sum += p[i + j] * derivKernel[j + hw];
+        gradient[i] = sum;
+    }
+
+    // polarity: 0 = dark → light, 1 = light → dark, 2 = any (EdgePolarity)
+    int count = 0;
+    for (int i = hw + 1; i < L - hw - 1 && count < capacity; i++)
+    {
+        double g = gradient[i];
+        int sign;
+        if (g > threshold && g > gradient[i - 1] && g > gradient[i + 1])
+            sign = 1;
+        else if (-g > threshold && g < gradient[i - 1] && g < gradient[i + 1])
+            sign = -1;
+        else
+            continue;
+        if ((polarity == 0 && sign < 0) || (polarity == 1 && sign > 0)) continue;
+
+        // Parabola through |gradient|, clamped to half a sample
+        double fPrev = fabs(gradient[i - 1]), fCurr = fabs(g), fNext = fabs(gradient[i + 1]);
+        double denom = 2.0 * fPrev - 4.0 * fCurr + 2.0 * fNext;
+        double offset = fabs(denom) < 1e-12 ? 0.0 : (fPrev - fNext) / denom;
+        offset = std::min(std::max(offset, -0.5), 0.5);
+
+        edges[count++] = { i + offset, fabs(g), i, sign };
+    }
+    return count;
+}
+
+// Measures `count` calipers in one parallel pass.
+//   gaussianProjection: 0 = uniform row average, 1 = Gaussian row weights
+//     (sigma R/4 around the centre row), as ProjectionMode in CaliperTool
+//   smoothKernel: 2·smoothHalfWidth+1 taps or null for no smoothing
+//   derivKernel: 2·derivHalfWidth+1 taps, positive response = dark → light
+//   polarity: 0 = dark → light, 1 = light → dark, 2 = any
+//   profiles / gradients: optional, count × profileStride doubles (raw
+//     projection and filtered gradient of caliper i at i·profileStride)
+//   edges: count × edgeCapacity; edgeCounts[i] = edges stored for caliper i.
+//     A capacity of L/2 + 1 can never truncate (extrema are never adjacent).
+// Returns the total number of edges, or -1 on invalid arguments.
+EXPORT int __cdecl NvMeasureCalipers(
+    const uint8_t* gray, int width, int height, int stride,
+    const NvCaliper* calipers, int count,
+    int gaussianProjection,
+    const double* smoothKernel, int smoothHalfWidth,
+    const double* derivKernel, int derivHalfWidth,
+    double threshold, int polarity,
+    double* profiles, double* gradients, int profileStride,
+    NvCaliperEdge* edges, int edgeCapacity, int* edgeCounts)
+{
+    if (!gray || width < 1 || height < 1 || stride < width || !calipers || count < 0
+        || !derivKernel || derivHalfWidth < 0 || smoothHalfWidth < 0
+        || !edges || edgeCapacity < 0 || !edgeCounts)
+        return -1;
+
+    int maxL = 1, maxR = 1;
+    for (int i = 0; i < count; i++)
+    {
+        int L = (int)calipers[i].length;
+        if ((profiles || gradients) && L > profileStride) return -1;
+        maxL = std::max(maxL, L);
+        maxR = std::max(maxR, (int)calipers[i].width);
+    }
+
+    int total = 0;
+    WorkerLease lease(std::min(omp_get_max_threads(), count));
+    #pragma omp parallel num_threads(lease.Threads()) if (count > 1) reduction(+:total)
+    {
+        lease.Pin();
+        std::vector<float> acc(maxL), rowWeights(maxR);
+        std::vector<double> profile(maxL), smoothed(maxL), gradient(maxL);
+
+        #pragma omp for schedule(dynamic)
+        for (int i = 0; i < count; i++)
+        {
+            const NvCaliper& cal = calipers[i];
+            int L = (int)cal.length;
+            int R = std::max(1, (int)cal.width);
+            edgeCounts[i] = 0;
+            if (L < 1) continue;
+
+            if (gaussianProjection && R > 1)
+            {
+                double centre = (R - 1) * 0.5, sigma = R / 4.0, sum = 0.0;
+                for (int r = 0; r < R; r++)
+                {
+                    double d = r - centre;
+                    sum += rowWeights[r] = (float)exp(-(d * d) / (2.0 * sigma * sigma));
+                }
+                for (int r = 0; r < R; r++)
+                    rowWeights[r] = (float)(rowWeights[r] / sum);
+            }
+            else
+            {
+                for (int r = 0; r < R; r++)
+                    rowWeights[r] = 1.0f / R;
+            }
+
+            ProjectCaliper(gray, width, height, stride, cal, L, R, rowWeights.data(), acc.data());
+
+            double* prof = profiles ? profiles + (size_t)i * profileStride : profile.data();
+            double* grad = gradients ? gradients + (size_t)i * profileStride : gradient.data();
+            for (int c = 0; c < L; c++)
+                prof[c] = acc[c];
+
+            int n = DetectCaliperEdges(prof, L, smoothKernel, smoothHalfWidth,
+                                       derivKernel, derivHalfWidth, threshold, polarity,
+                                       smoothed.data(), grad,
+                                       edges + (size_t)i * edgeCapacity, edgeCapacity);
+            edgeCounts[i] = n;
+            total += n;
+        }
+    }
+    return total;
+}
+
+// ─── Blob labeling: fused threshold + run-length connected components ──────
+// One pass over the image binarises each row (SIMD) and stores its
+// foreground runs; rows are split into bands across threads. Labeling then
+// works on runs only: union-find joins 8-connected runs of adjacent rows,
+// and per-blob area, bounding box, centroid and second-order moments follow
+// from closed-form run sums. Blobs below the span filter are dropped before
+// anything traces a contour; survivors keep their run lists so callers can
+// render one blob at a time (NvRenderBlobMask).
+//
+// externalOnly mirrors RETR_EXTERNAL: the gaps between runs are labeled as
+// 4-connected background, and a blob is dropped when the background to the
+// left of its first pixel — the region that surrounds it — never reaches the
+// image border, i.e. the blob sits in a hole of another blob.
+
+struct NvBlobStats
+{
+    int area;                     // pixel count
+    int left, top, right, bottom; // inclusive bounding box
+    int runs;                     // run count
+    double cx, cy;                // pixel centroid
+    double mu20, mu11, mu02;      // central second-order moments / area
+};
+
+struct BlobRun { int y, x0, x1; };  // inclusive
+
+struct NvBlobLabeler
+{
+    int width, height;
+    std::vector<BlobRun> runs;      // raster order
+    std::vector<int> rowStart;      // height + 1
+    std::vector<int> parent;        // foreground union-find over runs
+    std::vector<int> runLabel;      // run → compact label
+    std::vector<int> gapParent;     // background union-find; row y owns slots rowStart[y] + y ...
+    std::vector<uint8_t> gapBorder;
+    std::vector<int> labelBlob;     // label → surviving blob or -1
+    std::vector<NvBlobStats> blobs;
+    std::vector<int> blobRunStart, blobRuns;
+    std::vector<std::vector<BlobRun>> bandRuns;
+    std::vector<std::vector<uint64_t>> bandBits;
+
+    // per-label accumulation
+    struct Sums { int64_t n, sx, sy, sxx, sxy, syy; int left, top, right, bottom, runs, firstRun; };
+    std::vector<Sums> sums;
+};
+
+EXPORT NvBlobLabeler* __cdecl NvCreateBlobLabeler()
+{
+    return new (std::nothrow) NvBlobLabeler();
+}
+
+EXPORT void __cdecl NvDestroyBlobLabeler(NvBlobLabeler* l)
+{
+    delete l;
+}
+
+static inline int FindRoot(int* parent, int i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// Root is always the smaller index, so a set's root is its first run in
+// raster order.
+static inline void UniteRoots(int* parent, int a, int b)
+{
+    a = FindRoot(parent, a);
+    b = FindRoot(parent, b);
+    if (a < b) parent[b] = a;
+    else if (b < a) parent[a] = b;
+}
+
+// Appends the runs of one binarised row
+static void ExtractRuns(const uint64_t* bits, int width, int y, std::vector<BlobRun>& out)
+{
+    int words = (width + 63) / 64;
+    int w = 0;
+    uint64_t cur = bits[0];
+    for (;;)
+    {
+        while (cur == 0)
+        {
+            if (++w == words) return;
+            cur = bits[w];
+        }
+        int x0 = w * 64 + Ctz64(cur);
+        uint64_t gap = ~bits[w] & (~0ull << (x0 & 63));
+        while (gap == 0)
+        {
+            if (++w == words) { out.push_back({ y, x0, width - 1 }); return; }
+            gap = ~bits[w];
+        }
+        int x1 = w * 64 + Ctz64(gap);   // exclusive
+        if (x1 >= width) { out.push_back({ y, x0, width - 1 }); return; }
+        out.push_back({ y, x0, x1 - 1 });
+        cur = bits[w] & (~0ull << (x1 & 63));
+    }
+}
+
+// Σ k for k in [0, n], Σ k² for k in [0, n]
+static inline int64_t SumTo(int64_t n) { return n * (n + 1) / 2; }
+static inline int64_t SumSqTo(int64_t n) { return n * (n + 1) * (2 * n + 1) / 6; }
+
+// Foreground is gray > threshold (invert: gray <= threshold). binary, when
+// not null, receives the 0/255 mask (binaryStride bytes per row). Blobs whose
+// pixel-centre span (right-left)·(bottom-top) is below minSpanArea are dropped
+// — that span bounds the area of any contour through the blob's pixel
+// centres, so a contour-area filter can run on survivors only.
+// Returns the number of surviving blobs (NvCopyBlobStats), or -1.
+EXPORT int __cdecl NvLabelBlobs(
+    NvBlobLabeler* l,
+    const uint8_t* gray, int width, int height, int stride,
+    int threshold, int invert,
+    uint8_t* binary, int binaryStride,
+    int externalOnly, double minSpanArea)
+{
+    if (!l || !gray || width < 1 || height < 1 || stride < width
+        || (binary && binaryStride < width))
+        return -1;
+
+    l->width = width;
+    l->height = height;
+    int numThreads = omp_get_max_threads();
+    if ((int)l->bandRuns.size() < numThreads)
+    {
+        l->bandRuns.resize(numThreads);
+        l->bandBits.resize(numThreads);
+    }
+    l->rowStart.assign(height + 1, 0);
+
+    // Pass 1: binarise rows and collect runs, one contiguous band per thread
+    WorkerLease lease(numThreads);
+    #pragma omp parallel num_threads(lease.Threads())
+    {
+        lease.Pin();
+        int t = omp_get_thread_num(), nt = omp_get_num_threads();
+        int y0 = (int)((int64_t)height * t / nt), y1 = (int)((int64_t)height * (t + 1) / nt);
+        std::vector<BlobRun>& local = l->bandRuns[t];
+        std::vector<uint64_t>& bits = l->bandBits[t];
+        local.clear();
+        bits.resize((width + 63) / 64);
+        for (int y = y0; y < y1; y++)
+        {
+            size_t before = local.size();
+            g_kernels.binarize(gray + (size_t)y * stride, width, threshold, invert, bits.data(),
+                               binary ? binary + (size_t)y * binaryStride : nullptr);
+            ExtractRuns(bits.data(), width, y, local);
+            l->rowStart[y + 1] = (int)(local.size() - before);
+        }
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            for (int y = 0; y < height; y++)
+                l->rowStart[y + 1] += l->rowStart[y];
+            l->runs.resize(l->rowStart[height]);
+        }
+
+        if (!local.empty())
+            memcpy(l->runs.data() + l->rowStart[y0], local.data(), local.size() * sizeof(BlobRun));
+    }
+
+    // Pass 2: union 8-connected runs of adjacent rows
+    int runCount = l->rowStart[height];
+    const BlobRun* runs = l->runs.data();
+    const int* rs = l->rowStart.data();
+    l->parent.resize(runCount);
+    int* parent = l->parent.data();
+    for (int i = 0; i < runCount; i++) parent[i] = i;
+    for (int y = 1; y < height; y++)
+    {
+        int p = rs[y - 1], pEnd = rs[y];
+        for (int c = rs[y]; c < rs[y + 1]; c++)
+        {
+            while (p < pEnd && runs[p].x1 + 1 < runs[c].x0) p++;
+            for (int q = p; q < pEnd && runs[q].x0 <= runs[c].x1 + 1; q++)
+                UniteRoots(parent, c, q);
+        }
+    }
+
+    // Background gaps (RETR_EXTERNAL): row y has (runs in row + 1) slots,
+    // slot g spanning the pixels between run g-1 and run g
+    int* gapParent = nullptr;
+    if (externalOnly)
+    {
+        int slots = runCount + height;
+        l->gapParent.resize(slots);
+        l->gapBorder.assign(slots, 0);
+        gapParent = l->gapParent.data();
+        for (int i = 0; i < slots; i++) gapParent[i] = i;
+
+        auto gapSpan = [&](int y, int g, int* a, int* b)
+        {
+            int k = rs[y + 1] - rs[y];
+            *a = g == 0 ? 0 : runs[rs[y] + g - 1].x1 + 1;
+            *b = g == k ? width - 1 : runs[rs[y] + g].x0 - 1;
+        };
+        for (int y = 0; y < height; y++)
+        {
+            int k = rs[y + 1] - rs[y], base = rs[y] + y;
+            for (int g = 0; g <= k; g++)
+            {
+                int a, b;
+                gapSpan(y, g, &a, &b);
+                if (a > b) continue;
+                if (y == 0 || y == height - 1 || a == 0 || b == width - 1)
+                    l->gapBorder[base + g] = 1;
+            }
+            if (y == 0) continue;
+
+            // 4-connected: gaps of adjacent rows join when they overlap
+            int kp = rs[y] - rs[y - 1], pBase = rs[y - 1] + y - 1, p = 0;
+            for (int g = 0; g <= k; g++)
+            {
+                int a, b;
+                gapSpan(y, g, &a, &b);
+                if (a > b) continue;
+                for (;;)
+                {
+                    int pa, pb;
+                    if (p > kp) break;
+                    gapSpan(y - 1, p, &pa, &pb);
+                    if (pa > pb || pb < a) { p++; continue; }
+                    break;
+                }
+                for (int q = p; q <= kp; q++)
+                {
+                    int pa, pb;
+                    gapSpan(y - 1, q, &pa, &pb);
+                    if (pa > pb) continue;
+                    if (pa > b) break;
+                    UniteRoots(gapParent, base + g, pBase + q);
+                }
+            }
+        }
+        for (int i = 0; i < slots; i++)
+            if (l->gapBorder[i]) l->gapBorder[FindRoot(gapParent, i)] = 1;
+    }
+
+    // Pass 3: compact labels (raster order of first pixel) and run sums.
+    // Links always point to a smaller index, so one forward sweep flattens.
+    l->runLabel.resize(runCount);
+    int* runLabel = l->runLabel.data();
+    l->sums.clear();
+    for (int i = 0; i < runCount; i++)
+    {
+        parent[i] = parent[parent[i]];
+        if (parent[i] == i)
+        {
+            runLabel[i] = (int)l->sums.size();
+            NvBlobLabeler::Sums s = {};
+            s.left = INT32_MAX; s.top = runs[i].y; s.right = -1;
+            s.firstRun = i;
+            l->sums.push_back(s);
+        }
+        else
+        {
+            runLabel[i] = runLabel[parent[i]];
+        }
+
+        const BlobRun& run = runs[i];
+        NvBlobLabeler::Sums& s = l->sums[runLabel[i]];
+        int64_t n = run.x1 - run.x0 + 1, y = run.y;
+        int64_t sx = SumTo(run.x1) - (run.x0 > 0 ? SumTo(run.x0 - 1) : 0);
+        int64_t sxx = SumSqTo(run.x1) - (run.x0 > 0 ? SumSqTo(run.x0 - 1) : 0);
+        s.n += n; s.sx += sx; s.sy += n * y;
+        s.sxx += sxx; s.sxy += sx * y; s.syy += n * y * y;
+        s.left = std::min(s.left, run.x0); s.right = std::max(s.right, run.x1);
+        s.bottom = run.y;
+        s.runs++;
+    }
+
+    // Filters, then per-blob statistics of the survivors
+    int labels = (int)l->sums.size();
+    l->labelBlob.assign(labels, -1);
+    l->blobs.clear();
+    for (int k = 0; k < labels; k++)
+    {
+        const NvBlobLabeler::Sums& s = l->sums[k];
+        if ((double)(s.right - s.left) * (s.bottom - s.top) < minSpanArea) continue;
+        if (externalOnly)
+        {
+            // Gap slot g of a row lies just left of the row's run g
+            const BlobRun& first = runs[s.firstRun];
+            int g = s.firstRun - rs[first.y];
+            if (first.x0 > 0 && !l->gapBorder[FindRoot(gapParent, rs[first.y] + first.y + g)])
+                continue;
+        }
+
+        NvBlobStats b;
+        double n = (double)s.n;
+        b.area = (int)s.n;
+        b.left = s.left; b.top = s.top; b.right = s.right; b.bottom = s.bottom;
+        b.runs = s.runs;
+        b.cx = s.sx / n;
+        b.cy = s.sy / n;
+        b.mu20 = s.sxx / n - b.cx * b.cx;
+        b.mu11 = s.sxy / n - b.cx * b.cy;
+        b.mu02 = s.syy / n - b.cy * b.cy;
+        l->labelBlob[k] = (int)l->blobs.size();
+        l->blobs.push_back(b);
+    }
+
+    // Run lists of the survivors (counting sort by blob)
+    int blobCount = (int)l->blobs.size();
+    l->blobRunStart.assign(blobCount + 1, 0);
+    for (int k = 0; k < blobCount; k++)
+        l->blobRunStart[k + 1] = l->blobRunStart[k] + l->blobs[k].runs;
+    l->blobRuns.resize(l->blobRunStart[blobCount]);
+    std::vector<int>& fill = l->parent;     // reused as per-blob cursors
+    fill.assign(l->blobRunStart.begin(), l->blobRunStart.end() - 1);
+    for (int i = 0; i < runCount; i++)
+    {
+        int b = l->labelBlob[runLabel[i]];
+        if (b >= 0) l->blobRuns[fill[b]++] = i;
+    }
+    return blobCount;
+}
+
+// Copies the statistics of the last NvLabelBlobs call.
+EXPORT void __cdecl NvCopyBlobStats(NvBlobLabeler* l, NvBlobStats* out)
+{
+    if (!l->blobs.empty())
+        memcpy(out, l->blobs.data(), l->blobs.size() * sizeof(NvBlobStats));
+}
+
+// Draws blob `index` of the last NvLabelBlobs call as 255 into a zeroed
+// mask of (right-left+1+2·pad) × (bottom-top+1+2·pad) bytes whose (pad, pad)
+// is the bounding box corner. Read-only on the labeler, so survivors can be
+// rendered from several threads at once. Returns the pixel count, or -1.
+EXPORT int __cdecl NvRenderBlobMask(NvBlobLabeler* l, int index, uint8_t* mask, int maskStride, int pad)
+{
+    if (!l || index < 0 || index >= (int)l->blobs.size() || !mask || pad < 0)
+        return -1;
+    const NvBlobStats& b = l->blobs[index];
+    if (maskStride < b.right - b.left + 1 + 2 * pad)
+        return -1;
+
+    for (int k = l->blobRunStart[index]; k < l->blobRunStart[index + 1]; k++)
+    {
+        const BlobRun& run = l->runs[l->blobRuns[k]];
+        uint8_t* row = mask + (size_t)(run.y - b.top + pad) * maskStride + pad - b.left;
+        memset(row + run.x0, 255, run.x1 - run.x0 + 1);
+    }
+    return b.area;
+}
+
+// ─── Morphology (MorphologyTool) ────────────────────────────────────────────
+// Rectangular structuring elements, and with them 1 × k and k × 1 lines,
+// are separable: a kx × ky min or max is a row pass of kx followed by a
+// column pass of ky. The column pass is van Herk/Gil-Werman: the rows are
+// cut into blocks of ky, a running min/max is taken forward and backward
+// inside every block, and the window starting at row p is op(backward[p],
+// forward[p + ky − 1]), three row operations per output row whatever ky is.
+// Along a row the same scans would be scalar, so the row pass doubles
+// windows with whole-row SIMD operations instead (log2 kx of them).
+// Everything runs through g_kernels.morphRow. Pixels outside the image are
+// ignored, as with OpenCV's default morphology border.
+//
+// Iterations grow the element instead of repeating passes: n erosions by k
+// equal one erosion by (k − 1)·n + 1 with the anchor scaled by n, which is
+// what OpenCV does for rectangles. Open, close, top-hat and black-hat run
+// in strips of output rows; a thread keeps its strip's first-stage rows in
+// scratch, so no intermediate image is allocated.
+
+enum
+{
+    NV_MORPH_ERODE = 0,
+    NV_MORPH_DILATE,
+    NV_MORPH_OPEN,
+    NV_MORPH_CLOSE,
+    NV_MORPH_GRADIENT,
+    NV_MORPH_TOPHAT,
+    NV_MORPH_BLACKHAT           // C# MorphologyOperation order
+};
 
-    int bW = (voteWidth >> binShiftBits) + 1;
-    int bH = (voteHeight >> binShiftBits) + 1;
-    int accLen = bW * bH;
+// One separable min/max pass
+struct MorphPass
+{
+    int kx, ky, ax, ay;         // element size and anchor
+    int op;                     // MORPH_ROW_MIN or MORPH_ROW_MAX
+};
 
-    // ── Pass 1: Coarse angle sweep ──
-    int numCoarseAngles = (int)(angleExtent / coarseAngleStep) + 1;
-    if (numCoarseAngles < 1) numCoarseAngles = 1;
+// One thread's NvMorphology buffers
+struct MorphScratch
+{
+    std::vector<uint8_t> line;          // padded row-pass line
+    std::vector<uint8_t> rows;          // row-pass results of a strip's input rows
+    std::vector<uint8_t> suffix;        // backward column scan, same rows
+    std::vector<uint8_t> prefix;        // forward column scan (one row)
+    std::vector<uint8_t> stage;         // first-stage rows of a two-stage operation
+    std::vector<uint8_t> padMin, padMax;    // rows outside the image
+    std::vector<const uint8_t*> rowPtr;
+};
 
-    // Storage for top K candidates from coarse pass
-    // Each candidate: angle, cx, cy, voteCount
-    struct Candidate {
-        double angle, cx, cy;
-        int votes;
-    };
+// Output rows of a strip; a strip is at least four element heights tall so
+// the rows recomputed at strip edges stay a small share of the work
+static const int MORPH_STRIP_ROWS = 64;
 
-    Candidate* candidates = (Candidate*)_aligned_malloc(topK * sizeof(Candidate), 64);
-    for (int i = 0; i < topK; i++) {
-        candidates[i].angle = 0;
-        candidates[i].cx = 0;
-        candidates[i].cy = 0;
-        candidates[i].votes = 0;
+// Row pass of one row: dst[x] = op over src[x − ax … x − ax + kx − 1].
+// The windows of a row are built by doubling, A2m[x] = op(Am[x], Am[x + m]),
+// so every step is a whole-row SIMD pass rather than a scalar scan
+static void MorphRowPass(const uint8_t* src, uint8_t* dst, int width, const MorphPass& mp, MorphScratch& s)
+{
+    int k = mp.kx;
+    if (k == 1)
+    {
+        memcpy(dst, src, width);
+        return;
     }
+    int n = width + k - 1;
+    uint8_t identity = mp.op == MORPH_ROW_MAX ? 0 : 255;
+    uint8_t* a = s.line.data();
+    memset(a, identity, mp.ax);
+    memcpy(a + mp.ax, src, width);
+    memset(a + mp.ax + width, identity, n - mp.ax - width);
 
-    // Thread-local results for coarse pass
-    int maxThreads = omp_get_max_threads();
-    Candidate* threadBest = (Candidate*)_aligned_malloc(maxThreads * topK * sizeof(Candidate), 64);
-    for (int t = 0; t < maxThreads * topK; t++) {
-        threadBest[t].angle = 0;
-        threadBest[t].cx = 0;
-        threadBest[t].cy = 0;
-        threadBest[t].votes = 0;
-    }
+    // In place: the kernel reads a[x + m] before any store reaches it
+    int m = 1;
+    for (; 2 * m <= k; m *= 2)
+        g_kernels.morphRow(a, a, a + m, n - 2 * m + 1, mp.op);
+    g_kernels.morphRow(dst, a, a + k - m, width, mp.op);
+}
 
-    #pragma omp parallel
+// Rows [r0, r1) of one pass, written to out (row r0 first). Input row y is
+// in + (y − inRow0)·inStride; only rows of [0, height) the windows reach
+// are read.
+static void MorphStrip(
+    const uint8_t* in, size_t inStride, int inRow0, int width, int height,
+    const MorphPass& mp, int r0, int r1, uint8_t* out, size_t outStride, MorphScratch& s)
+{
+    int n = r1 - r0, total = n + mp.ky - 1, p0 = r0 - mp.ay;
+    size_t w = (size_t)width;
+    s.rows.resize(total * w);
+    s.suffix.resize(total * w);
+    s.rowPtr.resize(total);
+    const uint8_t* pad = mp.op == MORPH_ROW_MAX ? s.padMax.data() : s.padMin.data();
+    for (int i = 0; i < total; i++)
     {
-        int tid = omp_get_thread_num();
-        Candidate* myBest = threadBest + tid * topK;
+        int y = p0 + i;
+        if (y < 0 || y >= height)
+        {
+            s.rowPtr[i] = pad;
+            continue;
+        }
+        uint8_t* h = s.rows.data() + i * w;
+        MorphRowPass(in + (size_t)(y - inRow0) * inStride, h, width, mp, s);
+        s.rowPtr[i] = h;
+    }
 
-        // Each thread gets its own accumulator
-        int* acc = (int*)_aligned_malloc(accLen * sizeof(int), 64);
-        int* rotXBuf = (int*)_aligned_malloc(modelCount * sizeof(int), 32);
-        int* rotYBuf = (int*)_aligned_malloc(modelCount * sizeof(int), 32);
+    const uint8_t* const* rows = s.rowPtr.data();
+    if (mp.ky == 1)
+    {
+        for (int i = 0; i < n; i++)
+            memcpy(out + i * outStride, rows[i], w);
+        return;
+    }
 
-        #pragma omp for schedule(dynamic)
-        for (int ai = 0; ai < numCoarseAngles; ai++)
+    // Backward scan per block of ky rows, then the forward scan emits row
+    // p = j − ky + 1 once it reaches row j
+    uint8_t* suf = s.suffix.data();
+    uint8_t* pre = s.prefix.data();
+    for (int b = 0; b < total; b += mp.ky)
+    {
+        int e = std::min(b + mp.ky, total);
+        memcpy(suf + (e - 1) * w, rows[e - 1], w);
+        for (int j = e - 2; j >= b; j--)
+            g_kernels.morphRow(suf + j * w, suf + (j + 1) * w, rows[j], width, mp.op);
+    }
+    for (int b = 0; b < total; b += mp.ky)
+    {
+        int e = std::min(b + mp.ky, total);
+        for (int j = b; j < e; j++)
         {
-            double angle = angleStart + ai * coarseAngleStep;
-            double rad = angle * DEG2RAD;
-            double cosA = cos(rad);
-            double sinA = sin(rad);
-
-            // Rotate model points
-            for (int i = 0; i < modelCount; i++)
+            const uint8_t* g = rows[j];
+            if (j > b)
             {
-                rotXBuf[i] = (int)(( modelX[i] * cosA - modelY[i] * sinA) * invScale + 0.5);
-                rotYBuf[i] = (int)(( modelX[i] * sinA + modelY[i] * cosA) * invScale + 0.5);
+                g_kernels.morphRow(pre, j == b + 1 ? rows[b] : pre, rows[j], width, mp.op);
+                g = pre;
             }
+            int p = j - mp.ky + 1;
+            if (p >= 0)
+                g_kernels.morphRow(out + p * outStride, suf + p * w, g, width, mp.op);
+        }
+    }
+}
+
+// Applies one MorphologyOperation with a kernelW × kernelH rectangle
+// (anchor at its centre) `iterations` times, as cv::morphologyEx does.
+// Grayscale only; dst must not overlap src. Returns 0 on invalid arguments.
+EXPORT int __cdecl NvMorphology(
+    const uint8_t* src, int width, int height, int srcStride,
+    uint8_t* dst, int dstStride,
+    int op, int kernelW, int kernelH, int iterations)
+{
+    if (!src || !dst || width < 1 || height < 1 || srcStride < width || dstStride < width
+        || op < NV_MORPH_ERODE || op > NV_MORPH_BLACKHAT
+        || kernelW < 1 || kernelH < 1 || iterations < 1)
+        return 0;
+
+    MorphPass erode = { (kernelW - 1) * iterations + 1, (kernelH - 1) * iterations + 1,
+                        kernelW / 2 * iterations, kernelH / 2 * iterations, MORPH_ROW_MIN };
+    MorphPass dilate = erode;
+    dilate.op = MORPH_ROW_MAX;
+    const MorphPass& first = op == NV_MORPH_DILATE || op == NV_MORPH_CLOSE || op == NV_MORPH_BLACKHAT
+        ? dilate : erode;
+    const MorphPass& second = &first == &erode ? dilate : erode;
+    bool twoStage = op == NV_MORPH_OPEN || op == NV_MORPH_CLOSE || op == NV_MORPH_TOPHAT || op == NV_MORPH_BLACKHAT;
 
-            memset(acc, 0, accLen * sizeof(int));
-            int binShift = (int)(angle / binWidthDeg + (angle >= 0 ? 0.5 : -0.5));
+    int stripRows = std::max(MORPH_STRIP_ROWS, 4 * (erode.ky - 1));
+    int strips = (height + stripRows - 1) / stripRows;
+    WorkerLease lease(std::min(omp_get_max_threads(), strips));
 
-            for (int si = 0; si < searchEdgeCount; si++)
+    #pragma omp parallel num_threads(lease.Threads()) if (strips > 1)
+    {
+        lease.Pin();
+        MorphScratch s;
+        size_t w = (size_t)width, lineLen = w + erode.kx - 1;
+        s.line.resize(lineLen);
+        s.prefix.resize(w);
+        s.padMin.assign(w, 255);
+        s.padMax.assign(w, 0);
+
+        #pragma omp for schedule(dynamic)
+        for (int si = 0; si < strips; si++)
+        {
+            int r0 = si * stripRows, r1 = std::min(height, r0 + stripRows);
+            uint8_t* out = dst + (size_t)r0 * dstStride;
+            if (!twoStage)
             {
-                int ex = searchX[si], ey = searchY[si], sb = searchBin[si];
-                for (int db = -1; db <= 1; db++)
+                MorphStrip(src, srcStride, 0, width, height, op == NV_MORPH_GRADIENT ? dilate : first,
+                    r0, r1, out, dstStride, s);
+                if (op == NV_MORPH_GRADIENT)
                 {
-                    int modelBin = ((sb - binShift + db) % numGradBins + numGradBins) % numGradBins;
-                    int bStart = binOffsets[modelBin];
-                    int bEnd   = binOffsets[modelBin + 1];
-                    for (int bi = bStart; bi < bEnd; bi++)
-                    {
-                        int j = binIndices[bi];
-                        int cx = (ex - rotXBuf[j]) >> binShiftBits;
-                        int cy = (ey - rotYBuf[j]) >> binShiftBits;
-                        if ((unsigned)cx < (unsigned)bW && (unsigned)cy < (unsigned)bH)
-                            acc[cy * bW + cx]++;
-                    }
+                    s.stage.resize((size_t)(r1 - r0) * w);
+                    MorphStrip(src, srcStride, 0, width, height, erode, r0, r1, s.stage.data(), w, s);
+                    for (int y = r0; y < r1; y++)
+                        g_kernels.morphRow(out + (size_t)(y - r0) * dstStride, out + (size_t)(y - r0) * dstStride,
+                            s.stage.data() + (y - r0) * w, width, MORPH_ROW_SUB);
                 }
+                continue;
             }
 
-            // Find peak in accumulator
-            int maxVote = 0, maxIdx = 0;
-            for (int i = 0; i < accLen; i++)
-            {
-                if (acc[i] > maxVote) { maxVote = acc[i]; maxIdx = i; }
-            }
-
-            double peakCx = (maxIdx % bW) * (1 << binShiftBits) + (1 << binShiftBits) / 2;
-            double peakCy = (maxIdx / bW) * (1 << binShiftBits) + (1 << binShiftBits) / 2;
+            // First-stage rows the second stage reads
+            int q0 = std::max(0, r0 - second.ay);
+            int q1 = std::min(height, r1 - second.ay + second.ky - 1);
+            s.stage.resize((size_t)(q1 - q0) * w);
+            MorphStrip(src, srcStride, 0, width, height, first, q0, q1, s.stage.data(), w, s);
+            MorphStrip(s.stage.data(), w, q0, width, height, second, r0, r1, out, dstStride, s);
 
-            // Insertion sort into thread-local top K
-            if (maxVote > myBest[topK - 1].votes)
+            for (int y = r0; y < r1 && (op == NV_MORPH_TOPHAT || op == NV_MORPH_BLACKHAT); y++)
             {
-                myBest[topK - 1].angle = angle;
-                myBest[topK - 1].cx = peakCx;
-                myBest[topK - 1].cy = peakCy;
-                myBest[topK - 1].votes = maxVote;
-                // Bubble up
-                for (int k = topK - 1; k > 0 && myBest[k].votes > myBest[k-1].votes; k--)
-                {
-                    Candidate tmp = myBest[k];
-                    myBest[k] = myBest[k-1];
-                    myBest[k-1] = tmp;
-                }
+                uint8_t* d = out + (size_t)(y - r0) * dstStride;
+                const uint8_t* in = src + (size_t)y * srcStride;
+                if (op == NV_MORPH_TOPHAT)
+                    g_kernels.morphRow(d, in, d, width, MORPH_ROW_SUB);     // src − open
+                else
+                    g_kernels.morphRow(d, d, in, width, MORPH_ROW_SUB);     // close − src
             }
         }
+    }
+    return 1;
+}
+
+// ─── Depth slicing (HeightSlicerTool, height maps) ──────────────────────────
+// A height band of a 3D frame becomes an 8-bit image in one pass per row
+// (g_kernels.depthSlice) instead of OpenCV's InRange + ConvertTo + masked
+// CopyTo. Organized point clouds are sliced the same way: the height axis
+// is pulled out of the XYZ triplets into a row buffer, and while that row
+// is in cache it also yields the float height map, a histogram of the
+// in-range points per grey level and the point count of every requested
+// band (further slice-kernel passes that keep only the count). NaN heights
+// are invalid points and count nowhere.
+
+static const int SLICE_LEVELS = 256;    // grey levels of a slice
+static const int HIST_WAYS = 4;         // interleaved histogram copies
+
+// Byte-per-grey-level scale of [lo, hi]; a band narrower than 1e-4 maps to 0
+static float SliceScale(float lo, float hi)
+{
+    float range = hi - lo;
+    return range > 0.0001f ? 255.0f / range : 0.0f;
+}
+
+// dst = depth in [minZ, maxZ] scaled to 0‥255, 0 elsewhere and for NaN.
+// Strides are in bytes. Returns the number of pixels in range, −1 on
+// invalid arguments.
+EXPORT int __cdecl NvSliceDepth(
+    const float* depth, int width, int height, int depthStride,
+    float minZ, float maxZ, uint8_t* dst, int dstStride)
+{
+    if (!depth || !dst || width < 1 || height < 1
+        || depthStride < width * (int)sizeof(float) || dstStride < width)
+        return -1;
 
-        _aligned_free(acc);
-        _aligned_free(rotXBuf);
-        _aligned_free(rotYBuf);
+    float scale = SliceScale(minZ, maxZ);
+    int count = 0;
+    WorkerLease lease(omp_get_max_threads());
+    #pragma omp parallel num_threads(lease.Threads()) reduction(+:count)
+    {
+        lease.Pin();
+        #pragma omp for schedule(static)
+        for (int y = 0; y < height; y++)
+        {
+            const float* row = (const float*)((const uint8_t*)depth + (size_t)y * depthStride);
+            count += g_kernels.depthSlice(row, dst + (size_t)y * dstStride, width, minZ, maxZ, scale, 0);
+        }
     }
+    return count;
+}
 
-    // Merge thread-local top K into global top K
-    for (int t = 0; t < maxThreads; t++)
+// Slices an organized cloud of width × height XYZ triplets (row-major, as
+// System.Numerics.Vector3[]) along `axis` (0 = X, 1 = Y, 2 = Z). With
+// h = coordinate − reference:
+//   heightMap  h over [lo, hi] to 0‥255, saturated outside; 0 for NaN
+//   heights    h as float, NaN for invalid points (optional)
+//   histogram  SLICE_LEVELS counts, one per heightMap grey level, of the
+//              points inside [lo, hi] (optional)
+//   bandCounts points with bandLo[b] ≤ h ≤ bandHi[b] (optional)
+// Strides are in bytes. Returns the number of valid points, −1 on invalid
+// arguments.
+EXPORT int __cdecl NvSlicePointCloud(
+    const float* xyz, int width, int height, int axis, float reference,
+    float lo, float hi,
+    uint8_t* heightMap, int mapStride,
+    float* heights, int heightsStride,
+    const float* bandLo, const float* bandHi, int bandCount, int* bandCounts,
+    int* histogram)
+{
+    if (!xyz || !heightMap || width < 1 || height < 1 || axis < 0 || axis > 2 || mapStride < width
+        || (heights && heightsStride < width * (int)sizeof(float))
+        || bandCount < 0 || (bandCount > 0 && (!bandLo || !bandHi || !bandCounts)))
+        return -1;
+
+    float scale = SliceScale(lo, hi);
+    int valid = 0;
+    std::vector<int> hist(SLICE_LEVELS, 0), bands(bandCount, 0);
+
+    WorkerLease lease(omp_get_max_threads());
+    #pragma omp parallel num_threads(lease.Threads())
     {
-        Candidate* tb = threadBest + t * topK;
-        for (int i = 0; i < topK; i++)
+        lease.Pin();
+        std::vector<float> row(width);
+        std::vector<uint8_t> levels(width);
+        // Runs of equal levels would serialise on one counter
+        std::vector<int> localHist(SLICE_LEVELS * HIST_WAYS, 0), localBands(bandCount, 0);
+        int localValid = 0;
+
+        #pragma omp for schedule(static)
+        for (int y = 0; y < height; y++)
         {
-            if (tb[i].votes > candidates[topK - 1].votes)
+            const float* src = xyz + (size_t)y * width * 3 + axis;
+            float* h = heights ? (float*)((uint8_t*)heights + (size_t)y * heightsStride) : row.data();
+            for (int x = 0; x < width; x++)
+                h[x] = src[3 * x] - reference;
+            g_kernels.depthSlice(h, heightMap + (size_t)y * mapStride, width, lo, hi, scale, 1);
+
+            // Counting passes reuse the slice kernel; only its count is kept
+            uint8_t* lv = levels.data();
+            localValid += g_kernels.depthSlice(h, lv, width, -INFINITY, INFINITY, 0.0f, 0);
+            for (int b = 0; b < bandCount; b++)
+                localBands[b] += g_kernels.depthSlice(h, lv, width, bandLo[b], bandHi[b], 0.0f, 0);
+
+            if (histogram)
             {
-                candidates[topK - 1] = tb[i];
-                for (int k = topK - 1; k > 0 && candidates[k].votes > candidates[k-1].votes; k--)
-                {
-                    Candidate tmp = candidates[k];
-                    candidates[k] = candidates[k-1];
-                    candidates[k-1] = tmp;
-                }
+                // Unclamped levels: points outside [lo, hi] land on 0 and are
+                // taken off level 0 again
+                int inside = g_kernels.depthSlice(h, lv, width, lo, hi, scale, 0);
+                int* way = localHist.data();
+                int x = 0;
+                for (; x + HIST_WAYS <= width; x += HIST_WAYS)
+                    for (int w = 0; w < HIST_WAYS; w++) way[w * SLICE_LEVELS + lv[x + w]]++;
+                for (; x < width; x++) way[lv[x]]++;
+                way[0] -= width - inside;
             }
         }
+
+        #pragma omp critical
+        {
+            valid += localValid;
+            for (int w = 0; w < HIST_WAYS; w++)
+                for (int i = 0; i < SLICE_LEVELS; i++) hist[i] += localHist[w * SLICE_LEVELS + i];
+            for (int b = 0; b < bandCount; b++) bands[b] += localBands[b];
+        }
     }
-    _aligned_free(threadBest);
 
-    // Count actual valid candidates
-    int validK = 0;
-    for (int i = 0; i < topK; i++)
-        if (candidates[i].votes > 0) validK++;
-    if (validK == 0) validK = 1;
+    if (histogram) memcpy(histogram, hist.data(), SLICE_LEVELS * sizeof(int));
+    if (bandCount > 0) memcpy(bandCounts, bands.data(), bandCount * sizeof(int));
+    return valid;
+}
+
+// ─── Shared-frame ingestion: zero-copy view on the SharedFrame MMF ─────────
+// Mirrors VMS.Camera SharedFrameConstants. A frame is a 64-byte header plus
+// the 2D body (stride × height bytes). Version 3 keeps one frame at offset 0;
+// version 2 has a 64-byte control block at offset 0 and two page-aligned
+// slots, each holding a complete version-3 frame, so the writer fills one slot
+// while readers process the other. Version 1 is the same frame from older
+// writers, whose header word 60 is reserved (0) instead of a commit tag: it
+// can only be read under the writer's mutex, so it is reported as
+// NV_SF_UNTAGGED rather than viewed.
+//
+// Torn frames are caught seqlock-style: the writer clears the slot's commit
+// tag before touching it and stores the low 32 bits of the frame counter
+// there once header and body are complete. A view is valid only while tag and
+// counter still agree with what NvAcquireSharedFrame saw, so callers check
+// NvIsSharedFrameCurrent after they are done with the pixels.
+
+static const uint32_t SF_MAGIC = 0x564D5346;  // "VMSF"
+static const uint32_t SF_VERSION_UNTAGGED = 1;
+static const uint32_t SF_VERSION_SLOTTED = 2;
+static const uint32_t SF_VERSION_SINGLE = 3;
+static const uint32_t SF_FLAG_HAS_2D = 0x01;
+static const int SF_HEADER_SIZE = 64;
+static const int SF_SLOT_COUNT = 2;
+static const int64_t SF_SLOT_ALIGN = 4096;
+
+// Frame header offsets
+static const int SF_OFFSET_MAGIC = 0;
+static const int SF_OFFSET_VERSION = 4;
+static const int SF_OFFSET_FLAGS = 8;
+static const int SF_OFFSET_TIMESTAMP = 12;
+static const int SF_OFFSET_COUNTER = 20;
+static const int SF_OFFSET_WIDTH = 28;
+static const int SF_OFFSET_HEIGHT = 32;
+static const int SF_OFFSET_CHANNELS = 36;
+static const int SF_OFFSET_STRIDE = 40;
+static const int SF_OFFSET_COMMIT = 60;
+
+// Control block offsets (version 2); counter sits where a frame keeps its own
+static const int SF_OFFSET_SLOT_COUNT = 8;
+static const int SF_OFFSET_SLOT_STRIDE = 12;
+static const int SF_OFFSET_PUBLISHED_SLOT = 16;
+
+enum NvSharedFrameStatus
+{
+    NV_SF_OK = 1,          // new frame, view filled
+    NV_SF_SAME = 0,        // published frame is lastFrameCounter
+    NV_SF_BAD_HEADER = -1, // no writer, unknown layout, channel count or out-of-range geometry
+    NV_SF_TORN = -2,       // slot is being rewritten
+    NV_SF_NO_IMAGE = -3,   // frame carries no 2D image
+    NV_SF_UNTAGGED = -4    // version-1 frame without a commit tag (older writer)
+};
+
+struct NvSharedFrame
+{
+    const uint8_t* pixels;  // first pixel, inside the mapping
+    int64_t frameCounter;
+    int64_t timestamp;      // UTC ticks
+    int width, height, channels, stride;
+    int slot;               // -1 for the single-frame layout
+    int reserved;
+    int64_t slotOffset;     // frame header offset from the mapping base
+};
+
+// Header fields live in memory another process writes; read them through
+// volatile so the compiler re-loads them on every validation.
+template <typename T>
+static inline T SfLoad(const uint8_t* base, int64_t offset)
+{
+    T v;
+    const volatile uint8_t* p = base + offset;
+    uint8_t tmp[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); i++) tmp[i] = p[i];
+    memcpy(&v, tmp, sizeof(T));
+    return v;
+}
+
+template <typename T>
+static inline void SfStore(uint8_t* base, int64_t offset, T v)
+{
+    uint8_t tmp[sizeof(T)];
+    memcpy(tmp, &v, sizeof(T));
+    volatile uint8_t* p = base + offset;
+    for (size_t i = 0; i < sizeof(T); i++) p[i] = tmp[i];
+}
+
+static inline int64_t SlotStride(int64_t capacity)
+{
+    return ((capacity - SF_SLOT_ALIGN) / SF_SLOT_COUNT) & ~(SF_SLOT_ALIGN - 1);
+}
+
+// Parses the version-3 frame at `offset` whose body must end before `limit`.
+static int ParseSharedSlot(const uint8_t* base, int64_t offset, int64_t limit,
+    int64_t lastFrameCounter, NvSharedFrame* out)
+{
+    if (offset < 0 || offset + SF_HEADER_SIZE > limit)
+        return NV_SF_BAD_HEADER;
+
+    uint32_t tag = SfLoad<uint32_t>(base, offset + SF_OFFSET_COMMIT);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    int64_t counter = SfLoad<int64_t>(base, offset + SF_OFFSET_COUNTER);
+    if (tag == 0 || tag != (uint32_t)counter)
+        return NV_SF_TORN;
+    if (counter == lastFrameCounter)
+        return NV_SF_SAME;
+
+    if (SfLoad<uint32_t>(base, offset + SF_OFFSET_MAGIC) != SF_MAGIC
+        || SfLoad<uint32_t>(base, offset + SF_OFFSET_VERSION) != SF_VERSION_SINGLE)
+        return NV_SF_BAD_HEADER;
+
+    uint32_t flags = SfLoad<uint32_t>(base, offset + SF_OFFSET_FLAGS);
+    int w = SfLoad<int32_t>(base, offset + SF_OFFSET_WIDTH);
+    int h = SfLoad<int32_t>(base, offset + SF_OFFSET_HEIGHT);
+    int c = SfLoad<int32_t>(base, offset + SF_OFFSET_CHANNELS);
+    int stride = SfLoad<int32_t>(base, offset + SF_OFFSET_STRIDE);
+    if (!(flags & SF_FLAG_HAS_2D) || w <= 0 || h <= 0 || c <= 0)
+        return NV_SF_NO_IMAGE;
+    if ((c != 1 && c != 3 && c != 4) || stride < w * c || offset + SF_HEADER_SIZE + (int64_t)stride * h > limit)
+        return NV_SF_BAD_HEADER;
+
+    out->pixels = base + offset + SF_HEADER_SIZE;
+    out->frameCounter = counter;
+    out->timestamp = SfLoad<int64_t>(base, offset + SF_OFFSET_TIMESTAMP);
+    out->width = w;
+    out->height = h;
+    out->channels = c;
+    out->stride = stride;
+    out->slotOffset = offset;
+
+    // Fields above may mix two frames if the writer started meanwhile
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (SfLoad<uint32_t>(base, offset + SF_OFFSET_COMMIT) != tag)
+        return NV_SF_TORN;
+    return NV_SF_OK;
+}
+
+// Fills `out` with a view on the newest committed frame of a mapped SharedFrame
+// region. No pixel is copied: out->pixels points into the mapping and stays
+// meaningful only while NvIsSharedFrameCurrent holds. Returns NvSharedFrameStatus.
+EXPORT int __cdecl NvAcquireSharedFrame(
+    const uint8_t* base, int64_t capacity, int64_t lastFrameCounter,
+    NvSharedFrame* out)
+{
+    if (!base || !out || capacity < SF_HEADER_SIZE)
+        return NV_SF_BAD_HEADER;
+    if (SfLoad<uint32_t>(base, SF_OFFSET_MAGIC) != SF_MAGIC)
+        return NV_SF_BAD_HEADER;
 
-    // ── Pass 2: Fine refinement around each candidate ──
-    int fineResultCount = 0;
-    for (int ci = 0; ci < validK; ci++)
+    uint32_t version = SfLoad<uint32_t>(base, SF_OFFSET_VERSION);
+    if (version == SF_VERSION_UNTAGGED)
+        return NV_SF_UNTAGGED;
+    if (version == SF_VERSION_SINGLE)
     {
-        int numFine = (int)(2.0 * coarseAngleStep / fineAngleStep) + 1;
-        fineResultCount += numFine;
+        out->slot = -1;
+        return ParseSharedSlot(base, 0, capacity, lastFrameCounter, out);
     }
+    if (version != SF_VERSION_SLOTTED)
+        return NV_SF_BAD_HEADER;
 
-    Candidate* fineResults = (Candidate*)_aligned_malloc(fineResultCount * sizeof(Candidate), 64);
-    for (int i = 0; i < fineResultCount; i++) {
-        fineResults[i].votes = 0;
-    }
+    int slots = SfLoad<int32_t>(base, SF_OFFSET_SLOT_COUNT);
+    int64_t slotStride = SfLoad<int32_t>(base, SF_OFFSET_SLOT_STRIDE);
+    int slot = SfLoad<int32_t>(base, SF_OFFSET_PUBLISHED_SLOT);
+    if (slots != SF_SLOT_COUNT || slotStride <= SF_HEADER_SIZE
+        || SF_SLOT_ALIGN + slotStride * slots > capacity)
+        return NV_SF_BAD_HEADER;
+    if (slot < 0)
+        return NV_SF_NO_IMAGE;  // nothing published yet
+    if (slot >= slots)
+        return NV_SF_BAD_HEADER;
 
-    int fineOffset = 0;
-    for (int ci = 0; ci < validK; ci++)
-    {
-        double centerAngle = candidates[ci].angle;
-        double fineStart = centerAngle - coarseAngleStep;
-        double fineEnd   = centerAngle + coarseAngleStep;
-        int numFine = (int)(2.0 * coarseAngleStep / fineAngleStep) + 1;
+    int64_t offset = SF_SLOT_ALIGN + slot * slotStride;
+    out->slot = slot;
+    return ParseSharedSlot(base, offset, offset + slotStride, lastFrameCounter, out);
+}
 
-        #pragma omp parallel
-        {
-            int* acc = (int*)_aligned_malloc(accLen * sizeof(int), 64);
-            int* rotXBuf = (int*)_aligned_malloc(modelCount * sizeof(int), 32);
-            int* rotYBuf = (int*)_aligned_malloc(modelCount * sizeof(int), 32);
+// 1 while the slot behind `view` still holds the frame it was acquired from.
+EXPORT int __cdecl NvIsSharedFrameCurrent(const uint8_t* base, const NvSharedFrame* view)
+{
+    if (!base || !view)
+        return 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t tag = SfLoad<uint32_t>(base, view->slotOffset + SF_OFFSET_COMMIT);
+    int64_t counter = SfLoad<int64_t>(base, view->slotOffset + SF_OFFSET_COUNTER);
+    return tag == (uint32_t)view->frameCounter && counter == view->frameCounter ? 1 : 0;
+}
 
-            #pragma omp for schedule(dynamic)
-            for (int fi = 0; fi < numFine; fi++)
-            {
-                double angle = fineStart + fi * fineAngleStep;
-                if (angle < angleStart || angle > angleStart + angleExtent) {
-                    fineResults[fineOffset + fi].votes = 0;
-                    continue;
-                }
+// Compact gradient of a ROI read straight from the mapped pixels. Output is
+// roiW × roiH as in ComputeGradientCompactNative. Returns 1 when the frame was
+// still current after the pass, 0 when it was overwritten (output is garbage),
+// -1 for a bad ROI or a non-gray frame.
+EXPORT int __cdecl NvComputeGradientCompactShared(
+    const uint8_t* base, const NvSharedFrame* view,
+    int roiX, int roiY, int roiW, int roiH,
+    uint32_t* outPacked, uint16_t* outMag)
+{
+    if (!base || !view || view->channels != 1 || roiX < 0 || roiY < 0
+        || roiW < 3 || roiH < 3 || roiX + roiW > view->width || roiY + roiH > view->height)
+        return -1;
 
-                double rad = angle * DEG2RAD;
-                double cosA = cos(rad);
-                double sinA = sin(rad);
+    ComputeGradientCompactNative(view->pixels + (size_t)roiY * view->stride + roiX,
+        roiW, roiH, view->stride, outPacked, outMag);
+    return NvIsSharedFrameCurrent(base, view);
+}
 
-                for (int i = 0; i < modelCount; i++)
-                {
-                    rotXBuf[i] = (int)((modelX[i] * cosA - modelY[i] * sinA) * invScale + 0.5);
-                    rotYBuf[i] = (int)((modelX[i] * sinA + modelY[i] * cosA) * invScale + 0.5);
-                }
+// Writer side of the protocol, used by native producers and by the Linux
+// stand-in. Lays out the region on first use, picks the slot readers are not
+// on (version 2) and publishes it after the commit tag is stored. Returns the
+// new frame counter, or -1 if the frame does not fit.
+EXPORT int64_t __cdecl NvPublishSharedFrame(
+    uint8_t* base, int64_t capacity, int slotted,
+    const uint8_t* pixels, int width, int height, int stride, int channels,
+    int64_t timestamp)
+{
+    if (!base || !pixels || width <= 0 || height <= 0
+        || (channels != 1 && channels != 3 && channels != 4) || stride < width * channels)
+        return -1;
 
-                memset(acc, 0, accLen * sizeof(int));
-                int binShift = (int)(angle / binWidthDeg + (angle >= 0 ? 0.5 : -0.5));
+    uint32_t version = slotted ? SF_VERSION_SLOTTED : SF_VERSION_SINGLE;
+    int64_t slotStride = slotted ? SlotStride(capacity) : capacity;
+    int64_t body = (int64_t)stride * height;
+    if (slotStride < SF_HEADER_SIZE + body)
+        return -1;
 
-                for (int si = 0; si < searchEdgeCount; si++)
-                {
-                    int ex = searchX[si], ey = searchY[si], sb = searchBin[si];
-                    for (int db = -1; db <= 1; db++)
-                    {
-                        int modelBin = ((sb - binShift + db) % numGradBins + numGradBins) % numGradBins;
-                        int bStart = binOffsets[modelBin];
-                        int bEnd   = binOffsets[modelBin + 1];
-                        for (int bi = bStart; bi < bEnd; bi++)
-                        {
-                            int j = binIndices[bi];
-                            int cx = (ex - rotXBuf[j]) >> binShiftBits;
-                            int cy = (ey - rotYBuf[j]) >> binShiftBits;
-                            if ((unsigned)cx < (unsigned)bW && (unsigned)cy < (unsigned)bH)
-                                acc[cy * bW + cx]++;
-                        }
-                    }
-                }
+    bool fresh = SfLoad<uint32_t>(base, SF_OFFSET_MAGIC) != SF_MAGIC
+        || SfLoad<uint32_t>(base, SF_OFFSET_VERSION) != version;
+    int64_t last = fresh ? 0 : SfLoad<int64_t>(base, SF_OFFSET_COUNTER);
+    int64_t counter = last + 1;
+    if ((uint32_t)counter == 0)
+        counter++;  // tag 0 means "in progress"
 
-                int maxVote = 0, maxIdx = 0;
-                for (int i = 0; i < accLen; i++)
-                {
-                    if (acc[i] > maxVote) { maxVote = acc[i]; maxIdx = i; }
-                }
+    int slot = slotted ? (int)(counter % SF_SLOT_COUNT) : -1;
+    int64_t offset = slotted ? SF_SLOT_ALIGN + slot * slotStride : 0;
+
+    if (slotted && fresh)
+    {
+        SfStore<int32_t>(base, SF_OFFSET_PUBLISHED_SLOT, -1);
+        SfStore<int32_t>(base, SF_OFFSET_SLOT_COUNT, SF_SLOT_COUNT);
+        SfStore<int32_t>(base, SF_OFFSET_SLOT_STRIDE, (int32_t)slotStride);
+        SfStore<int64_t>(base, SF_OFFSET_COUNTER, 0);
+        SfStore<uint32_t>(base, SF_OFFSET_VERSION, version);
+        std::atomic_thread_fence(std::memory_order_release);
+        SfStore<uint32_t>(base, SF_OFFSET_MAGIC, SF_MAGIC);
+    }
 
-                double peakCx = (maxIdx % bW) * (1 << binShiftBits) + (1 << binShiftBits) / 2;
-                double peakCy = (maxIdx / bW) * (1 << binShiftBits) + (1 << binShiftBits) / 2;
+    SfStore<uint32_t>(base, offset + SF_OFFSET_COMMIT, 0);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
 
-                fineResults[fineOffset + fi].angle = angle;
-                fineResults[fineOffset + fi].cx = peakCx;
-                fineResults[fineOffset + fi].cy = peakCy;
-                fineResults[fineOffset + fi].votes = maxVote;
-            }
+    uint8_t* frame = base + offset;
+    SfStore<uint32_t>(frame, SF_OFFSET_MAGIC, SF_MAGIC);
+    SfStore<uint32_t>(frame, SF_OFFSET_VERSION, SF_VERSION_SINGLE);
+    SfStore<uint32_t>(frame, SF_OFFSET_FLAGS, SF_FLAG_HAS_2D);
+    SfStore<int64_t>(frame, SF_OFFSET_TIMESTAMP, timestamp);
+    SfStore<int64_t>(frame, SF_OFFSET_COUNTER, counter);
+    SfStore<int32_t>(frame, SF_OFFSET_WIDTH, width);
+    SfStore<int32_t>(frame, SF_OFFSET_HEIGHT, height);
+    SfStore<int32_t>(frame, SF_OFFSET_CHANNELS, channels);
+    SfStore<int32_t>(frame, SF_OFFSET_STRIDE, stride);
+    memset(frame + 44, 0, SF_OFFSET_COMMIT - 44);  // no point cloud
+    memcpy(frame + SF_HEADER_SIZE, pixels, (size_t)body);
 
-            _aligned_free(acc);
-            _aligned_free(rotXBuf);
-            _aligned_free(rotYBuf);
-        }
-        fineOffset += numFine;
+    std::atomic_thread_fence(std::memory_order_release);
+    SfStore<uint32_t>(frame, SF_OFFSET_COMMIT, (uint32_t)counter);
+
+    if (slotted)
+    {
+        std::atomic_thread_fence(std::memory_order_release);
+        SfStore<int32_t>(base, SF_OFFSET_PUBLISHED_SLOT, slot);
+        SfStore<int64_t>(base, SF_OFFSET_COUNTER, counter);
     }
+    return counter;
+}
+
+// Maps a SharedFrame region by name so native consumers need no managed
+// accessor. Windows opens (or creates) the named file mapping the writer uses;
+// elsewhere a POSIX shm object named after the last path segment stands in
+// ("Local\VMS_SharedFrame_Mmf" → "/VMS_SharedFrame_Mmf").
+struct NvSharedRegion
+{
+    uint8_t* base;
+    int64_t capacity;
+#if defined(_WIN32)
+    HANDLE mapping;
+#endif
+};
 
-    // Find overall best from fine results
-    int bestIdx = 0;
-    for (int i = 1; i < fineResultCount; i++)
+EXPORT NvSharedRegion* __cdecl NvOpenSharedFrameRegion(const char* name, int64_t capacity, int create)
+{
+    if (!name || capacity < SF_HEADER_SIZE)
+        return nullptr;
+    NvSharedRegion* r = new (std::nothrow) NvSharedRegion();
+    if (!r)
+        return nullptr;
+    r->capacity = capacity;
+
+#if defined(_WIN32)
+    r->mapping = create
+        ? CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            (DWORD)((uint64_t)capacity >> 32), (DWORD)capacity, name)
+        : OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, name);
+    if (r->mapping)
+        r->base = (uint8_t*)MapViewOfFile(r->mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, (SIZE_T)capacity);
+    if (!r->base)
     {
-        if (fineResults[i].votes > fineResults[bestIdx].votes)
-            bestIdx = i;
+        if (r->mapping) CloseHandle(r->mapping);
+        delete r;
+        return nullptr;
     }
+#else
+    const char* leaf = strrchr(name, '\\');
+    leaf = leaf ? leaf + 1 : (name[0] == '/' ? name + 1 : name);
+    std::string shmName = std::string("/") + leaf;
 
-    if (fineResults[bestIdx].votes > 0)
+    int fd = shm_open(shmName.c_str(), create ? (O_RDWR | O_CREAT) : O_RDWR, 0600);
+    if (fd < 0 || (create && ftruncate(fd, (off_t)capacity) != 0))
     {
-        *outBestCx = fineResults[bestIdx].cx;
-        *outBestCy = fineResults[bestIdx].cy;
-        *outBestAngle = fineResults[bestIdx].angle;
-        *outBestVotes = fineResults[bestIdx].votes;
+        if (fd >= 0) close(fd);
+        delete r;
+        return nullptr;
     }
-    else
+    void* p = mmap(nullptr, (size_t)capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
     {
-        // Fall back to coarse best
-        *outBestCx = candidates[0].cx;
-        *outBestCy = candidates[0].cy;
-        *outBestAngle = candidates[0].angle;
-        *outBestVotes = candidates[0].votes;
+        delete r;
+        return nullptr;
     }
+    r->base = (uint8_t*)p;
+#endif
+    return r;
+}
 
-    _aligned_free(fineResults);
-    _aligned_free(candidates);
+EXPORT uint8_t* __cdecl NvSharedRegionBase(NvSharedRegion* r)
+{
+    return r ? r->base : nullptr;
 }
 
-// ─── Batch: score ALL poses × entire refinement grid in one call ─────────────
-// Eliminates per-pose C#→native P/Invoke overhead; OpenMP across poses.
+EXPORT void __cdecl NvCloseSharedFrameRegion(NvSharedRegion* r)
+{
+    if (!r)
+        return;
+#if defined(_WIN32)
+    UnmapViewOfFile(r->base);
+    CloseHandle(r->mapping);
+#else
+    munmap(r->base, (size_t)r->capacity);
+#endif
+    delete r;
+}
 
-EXPORT double __cdecl EvaluateAllPosesNative(
-    int baseCx, int baseCy, int refRadius,
-    const int* allRx, const int* allRy,
-    const float* allRdx, const float* allRdy,
-    const int* margins,
-    int poseCount, int N,
-    const float* dxImg, const float* dyImg, const float* magImg,
-    int imgW, int imgH,
-    float thresh, float greedy,
-    int* outBestDx, int* outBestDy, int* outBestPoseIdx,
-    int contrastInvariant)
+// ─── Asynchronous match pipeline ────────────────────────────────────────────
+// A synchronous search runs gradient, pyramid/Canny, voting, Phase 2 and
+// refinement back to back, so frame throughput is capped by their sum. The
+// pipeline splits that into two stages on their own threads, joined by a
+// bounded ring of job slots:
+//
+//   prepare: frame copy → compact gradient → search edges (own matcher)
+//   match:   MatchModels → Gauss-Newton refinement of the winner (own matcher)
+//
+// While frame N is voted and scored, frame N+1 is already being prepared.
+// Each stage gets its own share of the OpenMP threads so the two never
+// oversubscribe the cores. Both stages take jobs strictly in ticket order,
+// so results complete in submission order. NvPipelineSubmit blocks while
+// every slot holds an uncollected job; a slot is recycled once its result
+// has been fetched.
+
+// Models of a pipeline search, copied so the caller may release its arrays.
+// The handle only holds a reference: jobs still queued keep their own, so a
+// set may be released (or replaced) at any time.
+struct ModelSetData
 {
-    double globalBestScore = 0.0;
-    int globalBestDx = 0, globalBestDy = 0, globalBestPose = 0;
-    int alignedN = (N + 7) & ~7;
+    struct Model
+    {
+        std::vector<float> x, y, dx, dy, refineX, refineY;
+        std::vector<int> binOffsets, binIndices;
+    };
+    std::vector<Model> models;
+    std::vector<NvModelDesc> descs;
+    int numGradBins;
+};
+
+struct NvModelSet
+{
+    std::shared_ptr<const ModelSetData> data;
+};
+
+// Search parameters of one job; mirrors C# NativeVision.SearchParams
+struct NvSearchParams
+{
+    int levels;                 // pyramid levels (1 = vote at full resolution)
+    int numGradBins;
+    double cannyLow, cannyHigh;
+    double angleStart, angleExtent;
+    double coarseAngleStep, fineVoteAngleStep;
+    int topK, binShiftBits;
+    double fineAngleStep, scaleCenter, scaleRange, scaleStep;
+    int refRadius, contrastInvariant;
+    double refineMinScore;      // refine only winners scoring at least this
+    double refineScaleLimit;    // 0 keeps the scale fixed
+    int refineIterations, reserved;
+};
+
+struct NvPipelineResult
+{
+    int64_t ticket;
+    int winner;                 // model index, or -1
+    int votes;
+    double x, y, angle, scale, score;
+    int refined;                // 1 when the Gauss-Newton solve moved the pose
+    int reserved;
+    double prepareMs, matchMs;  // stage times of this job
+};
 
-    #pragma omp parallel
+enum PipelineSlotState { SLOT_FREE, SLOT_QUEUED, SLOT_PREPARED, SLOT_DONE };
+
+struct PipelineSlot
+{
+    PipelineSlotState state;
+    int64_t ticket;
+    std::shared_ptr<const ModelSetData> set;
+    NvSearchParams params;
+    int width, height;
+    std::vector<uint8_t> frame;         // contiguous copy of the submitted ROI
+    std::vector<uint32_t> packed;       // full-resolution compact gradient
+    std::vector<int> edgeX, edgeY, edgeBin;
+    std::vector<NvModelResult> modelResults;
+    NvPipelineResult result;
+};
+
+struct NvPipeline
+{
+    std::vector<PipelineSlot> slots;
+    int prepareThreads, matchThreads;
+    std::mutex lock;
+    std::condition_variable changed;
+    int64_t nextTicket, prepareNext, matchNext;
+    bool stopping;
+    std::thread prepareWorker, matchWorker;
+};
+
+static double MsSince(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void PreparePipelineJob(NvMatcher* m, PipelineSlot& s)
+{
+    const NvSearchParams& p = s.params;
+    int w = s.width, h = s.height;
+    s.packed.resize((size_t)w * h);
+    ComputeGradientCompactNative(s.frame.data(), w, h, w, s.packed.data(), nullptr);
+
+    int n = NvExtractSearchEdges(m, s.frame.data(), w, h, w, p.levels, s.packed.data(),
+        p.cannyLow, p.cannyHigh, p.numGradBins);
+    s.edgeX.assign(m->edgeX.begin(), m->edgeX.begin() + n);
+    s.edgeY.assign(m->edgeY.begin(), m->edgeY.begin() + n);
+    s.edgeBin.assign(m->edgeBin.begin(), m->edgeBin.begin() + n);
+}
+
+static void MatchPipelineJob(NvMatcher* m, PipelineSlot& s)
+{
+    const NvSearchParams& p = s.params;
+    const ModelSetData& set = *s.set;
+    int numModels = (int)set.descs.size();
+    int vW = s.width, vH = s.height;
+    for (int lvl = 1; lvl < p.levels; lvl++)
     {
-        double localBest = 0.0;
-        int localDx = 0, localDy = 0, localPose = 0;
+        vW = (vW + 1) / 2;
+        vH = (vH + 1) / 2;
+    }
+    double invScale = 1.0 / (double)(1 << (std::max(p.levels, 1) - 1));
+    GradientView grad = CompactGradients(s.packed.data());
 
-        int* offsets = (int*)_aligned_malloc(alignedN * sizeof(int), 32);
+    s.modelResults.resize(std::max(numModels, 1));
+    int winner = MatchModels(m, set.descs.data(), numModels, set.numGradBins,
+        s.edgeX.data(), s.edgeY.data(), s.edgeBin.data(), (int)s.edgeX.size(),
+        vW, vH, p.angleStart, p.angleExtent, p.coarseAngleStep, p.fineVoteAngleStep, p.topK,
+        invScale, p.binShiftBits, p.fineAngleStep, p.scaleCenter, p.scaleRange, p.scaleStep,
+        grad, s.width, s.height, p.refRadius, p.contrastInvariant, s.modelResults.data());
 
-        #pragma omp for schedule(dynamic)
-        for (int pi = 0; pi < poseCount; pi++)
-        {
-            const int* rx  = allRx  + (int64_t)pi * N;
-            const int* ry  = allRy  + (int64_t)pi * N;
-            const float* rdx = allRdx + (int64_t)pi * N;
-            const float* rdy = allRdy + (int64_t)pi * N;
-            int margin = margins[pi];
+    NvPipelineResult& r = s.result;
+    r.winner = winner;
+    r.refined = 0;
+    if (winner < 0)
+    {
+        r.x = r.y = r.angle = r.score = 0.0;
+        r.scale = 1.0;
+        r.votes = 0;
+        return;
+    }
 
-            for (int i = 0; i < N; i++)
-                offsets[i] = ry[i] * imgW + rx[i];
-            for (int i = N; i < alignedN; i++)
-                offsets[i] = 0;
+    const NvModelResult& best = s.modelResults[winner];
+    r.x = best.x;
+    r.y = best.y;
+    r.angle = best.angle;
+    r.scale = best.scale;
+    r.score = best.score;
+    r.votes = best.votes;
+    if (best.score < p.refineMinScore)
+        return;
 
-            for (int dy = -refRadius; dy <= refRadius; dy++)
-            {
-                int py = baseCy + dy;
-                if (py < margin || py >= imgH - margin) continue;
+    const ModelSetData::Model& md = set.models[winner];
+    const float* rx = md.refineX.empty() ? md.x.data() : md.refineX.data();
+    const float* ry = md.refineY.empty() ? md.y.data() : md.refineY.data();
+    double x = r.x, y = r.y, angle = r.angle, scale = r.scale;
+    if (RefinePose(rx, ry, md.dx.data(), md.dy.data(), (int)md.x.size(), grad,
+            s.width, s.height, p.contrastInvariant, p.fineAngleStep, p.refineScaleLimit,
+            p.refineIterations, &x, &y, &angle, &scale) > 0)
+    {
+        r.x = x;
+        r.y = y;
+        r.angle = angle;
+        r.scale = scale;
+        r.refined = 1;
+    }
+}
 
-                for (int dx = -refRadius; dx <= refRadius; dx++)
-                {
-                    int px = baseCx + dx;
-                    if (px < margin || px >= imgW - margin) continue;
+// One stage worker: takes the job `next` once it reaches `from`, runs it
+// outside the lock and hands it on as `to`.
+static void PipelineStage(NvPipeline* p, int threads, int64_t NvPipeline::* next,
+    PipelineSlotState from, PipelineSlotState to, bool prepare)
+{
+    omp_set_num_threads(threads);
+    NvMatcher* m = NvCreateMatcher(1, 1, 8, 1);
 
-                    double score = EvaluateNativeInternal(
-                        px, py, offsets, rdx, rdy,
-                        dxImg, dyImg, magImg,
-                        imgW, N, thresh, greedy,
-                        contrastInvariant);
+    for (;;)
+    {
+        PipelineSlot* s;
+        {
+            std::unique_lock<std::mutex> guard(p->lock);
+            p->changed.wait(guard, [&] {
+                if (p->stopping) return true;
+                const PipelineSlot& c = p->slots[p->*next % p->slots.size()];
+                return c.ticket == p->*next && c.state == from;
+            });
+            if (p->stopping) break;
+            s = &p->slots[p->*next % p->slots.size()];
+        }
 
-                    if (score > localBest)
-                    {
-                        localBest = score;
-                        localDx = dx;
-                        localDy = dy;
-                        localPose = pi;
-                    }
-                }
-            }
+        auto t0 = std::chrono::steady_clock::now();
+        if (!m)
+            s->result.winner = -1;
+        else if (prepare)
+            PreparePipelineJob(m, *s);
+        else
+            MatchPipelineJob(m, *s);
+        (prepare ? s->result.prepareMs : s->result.matchMs) = MsSince(t0);
+
+        {
+            std::lock_guard<std::mutex> guard(p->lock);
+            s->state = to;
+            p->*next += 1;
         }
+        p->changed.notify_all();
+    }
+    NvDestroyMatcher(m);
+}
 
-        _aligned_free(offsets);
+EXPORT void __cdecl NvDestroyPipeline(NvPipeline* p);
 
-        #pragma omp critical
+// queueDepth: jobs in flight (≥ 2 for any overlap). prepareThreads /
+// matchThreads: OpenMP threads per stage, 0 = split the cores about 1 : 2.
+EXPORT NvPipeline* __cdecl NvCreatePipeline(int queueDepth, int prepareThreads, int matchThreads)
+{
+    NvPipeline* p = new (std::nothrow) NvPipeline();
+    if (!p) return nullptr;
+
+    int cores = std::max(omp_get_max_threads(), 1);
+    p->prepareThreads = prepareThreads > 0 ? prepareThreads : std::max(1, cores / 3);
+    p->matchThreads = matchThreads > 0 ? matchThreads : std::max(1, cores - p->prepareThreads);
+    p->slots.resize(std::max(queueDepth, 2));
+    for (PipelineSlot& s : p->slots)
+    {
+        s.state = SLOT_FREE;
+        s.ticket = 0;
+    }
+    p->nextTicket = p->prepareNext = p->matchNext = 1;
+    p->stopping = false;
+
+    try
+    {
+        p->prepareWorker = std::thread(PipelineStage, p, p->prepareThreads,
+            &NvPipeline::prepareNext, SLOT_QUEUED, SLOT_PREPARED, true);
+        p->matchWorker = std::thread(PipelineStage, p, p->matchThreads,
+            &NvPipeline::matchNext, SLOT_PREPARED, SLOT_DONE, false);
+    }
+    catch (...)
+    {
+        NvDestroyPipeline(p);
+        return nullptr;
+    }
+    return p;
+}
+
+// Stops both stages; jobs still queued are dropped.
+EXPORT void __cdecl NvDestroyPipeline(NvPipeline* p)
+{
+    if (!p) return;
+    {
+        std::lock_guard<std::mutex> guard(p->lock);
+        p->stopping = true;
+    }
+    p->changed.notify_all();
+    if (p->prepareWorker.joinable()) p->prepareWorker.join();
+    if (p->matchWorker.joinable()) p->matchWorker.join();
+    delete p;
+}
+
+// Copies the models; refineX/refineY (arrays of numModels pointers, or null,
+// entries may be null) give the sub-pixel edge positions used by refinement.
+// Every model needs modelDx/modelDy. binOffsets holds numGradBins + 1 entries.
+EXPORT NvModelSet* __cdecl NvCreateModelSet(
+    const NvModelDesc* models, int numModels, int numGradBins,
+    const float* const* refineX, const float* const* refineY)
+{
+    if (!models || numModels <= 0 || numGradBins <= 0)
+        return nullptr;
+
+    try
+    {
+        auto data = std::make_shared<ModelSetData>();
+        data->numGradBins = numGradBins;
+        data->models.resize(numModels);
+        data->descs.resize(numModels);
+        for (int i = 0; i < numModels; i++)
         {
-            if (localBest > globalBestScore)
+            const NvModelDesc& d = models[i];
+            ModelSetData::Model& md = data->models[i];
+            int n = d.modelCount;
+            if (n <= 0 || !d.modelX || !d.modelY || !d.modelDx || !d.modelDy
+                || !d.binOffsets || !d.binIndices)
+                return nullptr;
+            md.x.assign(d.modelX, d.modelX + n);
+            md.y.assign(d.modelY, d.modelY + n);
+            md.dx.assign(d.modelDx, d.modelDx + n);
+            md.dy.assign(d.modelDy, d.modelDy + n);
+            md.binOffsets.assign(d.binOffsets, d.binOffsets + numGradBins + 1);
+            md.binIndices.assign(d.binIndices, d.binIndices + n);
+            if (refineX && refineY && refineX[i] && refineY[i])
             {
-                globalBestScore = localBest;
-                globalBestDx = localDx;
-                globalBestDy = localDy;
-                globalBestPose = localPose;
+                md.refineX.assign(refineX[i], refineX[i] + n);
+                md.refineY.assign(refineY[i], refineY[i] + n);
             }
+
+            NvModelDesc& o = data->descs[i];
+            o.modelX = md.x.data();
+            o.modelY = md.y.data();
+            o.modelDx = md.dx.data();
+            o.modelDy = md.dy.data();
+            o.binOffsets = md.binOffsets.data();
+            o.binIndices = md.binIndices.data();
+            o.modelCount = n;
+            o.modelKey = d.modelKey;
+            o.voteMode = d.voteMode;
         }
+        return new NvModelSet{ std::move(data) };
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
     }
+}
 
-    *outBestDx = globalBestDx;
-    *outBestDy = globalBestDy;
-    *outBestPoseIdx = globalBestPose;
-    return globalBestScore;
+EXPORT void __cdecl NvDestroyModelSet(NvModelSet* set)
+{
+    delete set;
+}
+
+// Queues one 8-bit gray frame (copied, so the caller's buffer is free on
+// return) and returns its ticket, or -1. Blocks while every slot is in use.
+EXPORT int64_t __cdecl NvPipelineSubmit(
+    NvPipeline* p, NvModelSet* models,
+    const uint8_t* gray, int width, int height, int stride,
+    const NvSearchParams* params)
+{
+    if (!p || !models || !gray || !params || width < 3 || height < 3 || stride < width)
+        return -1;
+
+    PipelineSlot* s;
+    int64_t ticket;
+    {
+        std::unique_lock<std::mutex> guard(p->lock);
+        p->changed.wait(guard, [&] {
+            return p->stopping || p->slots[p->nextTicket % p->slots.size()].state == SLOT_FREE;
+        });
+        if (p->stopping) return -1;
+        ticket = p->nextTicket++;
+        s = &p->slots[ticket % p->slots.size()];
+        s->state = SLOT_QUEUED;  // claimed; stages wait for the ticket below
+        s->ticket = 0;
+    }
+
+    // Fill outside the lock; the prepare stage only starts once ticket is set
+    s->set = models->data;
+    s->params = *params;
+    s->width = width;
+    s->height = height;
+    s->frame.resize((size_t)width * height);
+    for (int y = 0; y < height; y++)
+        memcpy(s->frame.data() + (size_t)y * width, gray + (size_t)y * stride, width);
+    s->result = NvPipelineResult();
+    s->result.ticket = ticket;
+
+    {
+        std::lock_guard<std::mutex> guard(p->lock);
+        s->ticket = ticket;
+    }
+    p->changed.notify_all();
+    return ticket;
+}
+
+// Waits up to timeoutMs (-1 = forever, 0 = poll) for `ticket`. Returns 1 and
+// frees its slot when the result is ready, 0 on timeout, -1 for a ticket
+// that is unknown or already collected.
+EXPORT int __cdecl NvPipelineWait(NvPipeline* p, int64_t ticket, int timeoutMs, NvPipelineResult* out)
+{
+    if (!p || ticket <= 0)
+        return -1;
+
+    std::unique_lock<std::mutex> guard(p->lock);
+    if (ticket >= p->nextTicket)
+        return -1;
+    PipelineSlot& s = p->slots[ticket % p->slots.size()];
+    auto ready = [&] { return p->stopping || s.ticket != ticket || s.state == SLOT_DONE; };
+    if (timeoutMs < 0)
+        p->changed.wait(guard, ready);
+    else if (!p->changed.wait_for(guard, std::chrono::milliseconds(timeoutMs), ready))
+        return 0;
+
+    if (s.ticket != ticket || s.state != SLOT_DONE)
+        return -1;
+    if (out) *out = s.result;
+    s.state = SLOT_FREE;
+    s.set.reset();
+    guard.unlock();
+    p->changed.notify_all();
+    return 1;
 }
@@ -0,0 +1,1704 @@
+// nv_bench.cpp — benchmark and regression suite for the NativeVision exports
+// Builds synthetic scenes (rotated, scaled copies of a machined part on a
+// noisy, cluttered background) at the requested sizes, checks every export
+// against the scalar reference implementations below and the known ground
+// truth, then times each export across thread counts.
+//
+// Usage: nv_bench [--sizes 1,3,5,12] [--threads 1,2,4,8] [--reps 5] [--seed 1]
+//                 [--check] [--stats]
+//   --sizes    scene sizes in megapixels (4:3)
+//   --threads  OpenMP thread counts; results must be identical across them
+//   --check    run the correctness checks only
+//   --stats    print the native stage breakdown (NvGetStats) per scene
+// NATIVEVISION_ISA=scalar|sse41|avx2|avx512 caps the DLL's kernel set, so
+// every ISA can be verified on one machine. Exit code 1 on any failed check.
+
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+// ─── Exports (prototypes mirror NativeVision.cpp) ───────────────────────────
+
+extern "C"
+{
+    struct NvMatcher;
+    struct NvBlobLabeler;
+
+    struct NvModelDesc
+    {
+        const float *x, *y, *dx, *dy;
+        const int *binOffsets, *binIndices;
+        int modelCount, modelKey;
+        int voteMode, reserved;
+    };
+
+    struct NvModelResult
+    {
+        double x, y, angle, scale, score;
+        int votes, reserved;
+    };
+
+    struct MatchInstance
+    {
+        double x, y, angle, scale, score;
+    };
+
+    struct NvBlobStats
+    {
+        int area;
+        int left, top, right, bottom;
+        int runs;
+        double cx, cy;
+        double mu20, mu11, mu02;
+    };
+
+    struct NvCaliper
+    {
+        double x, y, ux, uy, vx, vy, length, width;
+    };
+
+    struct NvCaliperEdge
+    {
+        double position, contrast;
+        int index, polarity;
+    };
+
+    struct NvPipeline;
+    struct NvModelSet;
+
+    struct NvSearchParams
+    {
+        int levels, numGradBins;
+        double cannyLow, cannyHigh;
+        double angleStart, angleExtent;
+        double coarseAngleStep, fineVoteAngleStep;
+        int topK, binShiftBits;
+        double fineAngleStep, scaleCenter, scaleRange, scaleStep;
+        int refRadius, contrastInvariant;
+        double refineMinScore, refineScaleLimit;
+        int refineIterations, reserved;
+    };
+
+    struct NvPipelineResult
+    {
+        int64_t ticket;
+        int winner, votes;
+        double x, y, angle, scale, score;
+        int refined, reserved;
+        double prepareMs, matchMs;
+    };
+
+    struct NvSharedRegion;
+
+    struct NvSharedFrame
+    {
+        const uint8_t* pixels;
+        int64_t frameCounter, timestamp;
+        int width, height, channels, stride;
+        int slot, reserved;
+        int64_t slotOffset;
+    };
+
+    struct NvModelFile;
+
+    struct NvModelBankGrid
+    {
+        double angleStart, angleExtent, angleRange, angleStep;
+        double scaleCenter, scaleRange, scaleStep;
+    };
+
+    struct NvModelFileInfo
+    {
+        const float *x, *y, *dx, *dy, *refineX, *refineY, *magnitude;
+        const int *binOffsets, *binIndices;
+        int modelCount, numGradBins, templateWidth, templateHeight;
+        int modelKey, poseCount;
+    };
+
+    struct NvStats
+    {
+        int64_t stageCalls[16];
+        int64_t stageTicks[16];
+        int64_t counters[16];
+        double ticksPerSecond;
+        int threads;
+        int enabled;
+    };
+
+    const char* NvGetIsaName();
+    void ComputeGradientNative(const uint8_t* gray, int width, int height, int stride,
+        float* outDx, float* outDy, float* outMag);
+    void ComputeGradientCompactNative(const uint8_t* gray, int width, int height, int stride,
+        uint32_t* outPacked, uint16_t* outMag);
+    NvMatcher* NvCreateMatcher(int maxW, int maxH, int maxModelPoints, int maxPoses);
+    void NvDestroyMatcher(NvMatcher* m);
+    uint32_t* NvBeginLazyGradient(NvMatcher* m, const uint8_t* gray, int width, int height, int stride);
+    double NvEvaluate(NvMatcher* m, int px, int py, const int* rx, const int* ry,
+        const float* rdx, const float* rdy, const float* dxImg, const float* dyImg, const float* magImg,
+        int imgW, int N, float thresh, float greedy, int contrastInvariant);
+    double NvEvaluateCompact(NvMatcher* m, int px, int py, const int* rx, const int* ry,
+        const float* rdx, const float* rdy, const uint32_t* packedImg,
+        int imgW, int N, float thresh, float greedy, int contrastInvariant);
+    int NvExtractSearchEdges(NvMatcher* m, const uint8_t* gray, int width, int height, int stride,
+        int levels, const uint32_t* fullGrad, double cannyLow, double cannyHigh, int numGradBins);
+    void NvCopySearchEdges(NvMatcher* m, int* outX, int* outY, int* outBin);
+    int NvMatchModelsCompact(NvMatcher* m, const NvModelDesc* models, int numModels, int numGradBins,
+        const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+        int voteWidth, int voteHeight, double angleStart, double angleExtent,
+        double coarseAngleStep, double fineVoteAngleStep, int topK,
+        double invScale, int binShiftBits,
+        double fineAngleStep, double scaleCenter, double scaleRange, double scaleStep,
+        const uint32_t* packedImg, int imgW, int imgH, int refRadius, int contrastInvariant,
+        NvModelResult* outResults);
+    int NvMatchInstancesCompact(NvMatcher* m,
+        const float* modelX, const float* modelY, const float* modelDx, const float* modelDy, int modelCount,
+        const int* binOffsets, const int* binIndices, int numGradBins,
+        const int* searchX, const int* searchY, const int* searchBin, int searchEdgeCount,
+        int voteWidth, int voteHeight, double angleStart, double angleExtent,
+        double coarseAngleStep, double fineAngleStep,
+        double scaleCenter, double scaleRange, double scaleStep,
+        double invScale, int binShiftBits, const uint32_t* packedImg,
+        int imgW, int imgH, int refRadius, float thresh, float greedy, int contrastInvariant,
+        double minScore, double minDistRatio, int maxCount, MatchInstance* outInstances);
+    int NvRefinePoseCompact(const float* modelX, const float* modelY,
+        const float* modelDx, const float* modelDy, int modelCount,
+        const uint32_t* packedImg, int imgW, int imgH, int contrastInvariant,
+        double angleLimit, double scaleLimit, int maxIterations,
+        double* ioX, double* ioY, double* ioAngle, double* ioScale);
+    double NvTrackPose(NvMatcher* m, int modelKey,
+        const float* modelX, const float* modelY, const float* modelDx, const float* modelDy,
+        const float* refineX, const float* refineY, int modelCount,
+        const uint8_t* gray, int width, int height, int stride,
+        double prevX, double prevY, double prevAngle, double prevScale,
+        double maxShift, double maxRotation, double maxScaleChange,
+        double angleStep, double scaleStep, int contrastInvariant, int refineIterations,
+        double* outX, double* outY, double* outAngle, double* outScale);
+    NvBlobLabeler* NvCreateBlobLabeler();
+    void NvDestroyBlobLabeler(NvBlobLabeler* l);
+    int NvLabelBlobs(NvBlobLabeler* l, const uint8_t* gray, int width, int height, int stride,
+        int threshold, int invert, uint8_t* binary, int binaryStride,
+        int externalOnly, double minSpanArea);
+    void NvCopyBlobStats(NvBlobLabeler* l, NvBlobStats* out);
+    int NvMorphology(const uint8_t* src, int width, int height, int srcStride,
+        uint8_t* dst, int dstStride, int op, int kernelW, int kernelH, int iterations);
+    int NvSliceDepth(const float* depth, int width, int height, int depthStride,
+        float minZ, float maxZ, uint8_t* dst, int dstStride);
+    int NvSlicePointCloud(const float* xyz, int width, int height, int axis, float reference,
+        float lo, float hi, uint8_t* heightMap, int mapStride, float* heights, int heightsStride,
+        const float* bandLo, const float* bandHi, int bandCount, int* bandCounts, int* histogram);
+    int NvMeasureCalipers(const uint8_t* gray, int width, int height, int stride,
+        const NvCaliper* calipers, int count, int gaussianProjection,
+        const double* smoothKernel, int smoothHalfWidth, const double* derivKernel, int derivHalfWidth,
+        double threshold, int polarity, double* profiles, double* gradients, int profileStride,
+        NvCaliperEdge* edges, int edgeCapacity, int* edgeCounts);
+    NvPipeline* NvCreatePipeline(int queueDepth, int prepareThreads, int matchThreads);
+    void NvDestroyPipeline(NvPipeline* p);
+    NvModelSet* NvCreateModelSet(const NvModelDesc* models, int numModels, int numGradBins,
+        const float* const* refineX, const float* const* refineY);
+    void NvDestroyModelSet(NvModelSet* set);
+    int64_t NvPipelineSubmit(NvPipeline* p, NvModelSet* models,
+        const uint8_t* gray, int width, int height, int stride, const NvSearchParams* params);
+    int NvPipelineWait(NvPipeline* p, int64_t ticket, int timeoutMs, NvPipelineResult* out);
+    NvSharedRegion* NvOpenSharedFrameRegion(const char* name, int64_t capacity, int create);
+    uint8_t* NvSharedRegionBase(NvSharedRegion* r);
+    void NvCloseSharedFrameRegion(NvSharedRegion* r);
+    int64_t NvPublishSharedFrame(uint8_t* base, int64_t capacity, int slotted,
+        const uint8_t* pixels, int width, int height, int stride, int channels, int64_t timestamp);
+    int NvAcquireSharedFrame(const uint8_t* base, int64_t capacity, int64_t lastFrameCounter, NvSharedFrame* out);
+    int NvIsSharedFrameCurrent(const uint8_t* base, const NvSharedFrame* view);
+    int NvComputeGradientCompactShared(const uint8_t* base, const NvSharedFrame* view,
+        int roiX, int roiY, int roiW, int roiH, uint32_t* outPacked, uint16_t* outMag);
+    int NvWriteModelFile(const char* path, const NvModelDesc* model, int numGradBins,
+        const float* refineX, const float* refineY, const float* magnitude,
+        int templateWidth, int templateHeight, const NvModelBankGrid* grid);
+    NvModelFile* NvOpenModelFile(const char* path);
+    int NvGetModelFileInfo(const NvModelFile* file, NvModelFileInfo* out);
+    void NvCloseModelFile(NvModelFile* file);
+    void NvSetEdgePruning(NvMatcher* m, double minScore);
+    void NvSetStatsEnabled(int enabled);
+    void NvGetStats(NvStats* out);
+    void NvResetStats();
+}
+
+// ─── Search parameters (FeatureMatchTool defaults: AngleStep 1, 3 levels) ───
+
+static const int NUM_GRAD_BINS = 36;
+static const int LEVELS = 3;
+static const int BIN_SHIFT = 1;
+static const int TOP_K = 5;
+static const int REF_RADIUS = 6;
+static const int REFINE_ITERATIONS = 8;
+static const double CANNY_LOW = 30, CANNY_HIGH = 90;
+static const double COARSE_ANGLE_STEP = 4.0, FINE_VOTE_ANGLE_STEP = 1.0, FINE_ANGLE_STEP = 0.5;
+static const double SCALE_RANGE = 0.05, SCALE_STEP = 0.025;
+// Scale voting: a model trained at SCALED_MODEL_SCALE sees the parts at about
+// 1 / SCALED_MODEL_SCALE, searched over 1 ± WIDE_SCALE_RANGE
+static const double SCALED_MODEL_SCALE = 1.3, WIDE_SCALE_RANGE = 0.3;
+static const double MIN_SCORE = 0.5;
+static const int BLOB_THRESHOLD = 150;
+static const int PARTS_PER_SCENE = 4;
+static const int MODEL_KEY = 1, SCALED_MODEL_KEY = 2;
+static const int VOTE_RESPONSE = 1;     // NvModelDesc::voteMode of the LINE-2D engine
+static const int MORPH_OPS = 7;         // NV_MORPH_ERODE … NV_MORPH_BLACKHAT
+static const int MORPH_TOPHAT = 5, MORPH_KERNEL = 51;   // the timed NvMorphology call
+// Calipers on a crop around part 0: spokes through the part plus calipers
+// hanging over the crop border (the scalar reflect-101 path)
+static const int CALIPER_SPOKES = 12, CALIPER_BORDER = 4;
+static const int CALIPER_COUNT = CALIPER_SPOKES + CALIPER_BORDER;
+static const int CALIPER_STRIDE = 128, CALIPER_EDGES = CALIPER_STRIDE / 2 + 1;
+static const int CALIPER_CROP_W = 192, CALIPER_CROP_H = 144;
+static const double CALIPER_THRESHOLD = 6.0;
+static const double SMOOTH_TAPS[5] = { 1 / 16.0, 4 / 16.0, 6 / 16.0, 4 / 16.0, 1 / 16.0 };
+static const double DERIV_TAPS[3] = { -0.5, 0.0, 0.5 };
+// Pipeline frames: PIPELINE_FRAMES ROIs of the scene, each shifted by
+// PIPELINE_SHIFT px, through a PIPELINE_DEPTH-slot pipeline
+static const int PIPELINE_FRAMES = 4, PIPELINE_DEPTH = 3, PIPELINE_SHIFT = 24;
+// SharedFrame region (a POSIX shm object off Windows): NvSharedFrameStatus
+// codes, the version-2 slot alignment and the frame header's commit tag
+static const char* const SHARED_REGION = "Local\\nv_bench_shared_frame";
+static const int SF_OK = 1, SF_SAME = 0, SF_BAD_HEADER = -1, SF_TORN = -2, SF_UNTAGGED = -4;
+static const int64_t SF_SLOT_ALIGN = 4096;
+static const int SF_HEADER = 64, SF_VERSION = 4, SF_WIDTH = 28, SF_CHANNELS = 36, SF_COMMIT = 60;
+// Depth frames: depth = 2 × gray mm with every DEPTH_HOLE-th pixel NaN,
+// sliced over [SLICE_LO, SLICE_HI] and counted in SLICE_BANDS bands
+static const int DEPTH_HOLE = 97, SLICE_BANDS = 3, SLICE_LEVELS = 256;
+static const float SLICE_LO = 150.0f, SLICE_HI = 400.0f;
+static const float BAND_LO[SLICE_BANDS] = { 0.0f, 200.0f, 300.0f };
+static const float BAND_HI[SLICE_BANDS] = { 120.0f, 260.0f, 510.0f };
+
+// Pose tolerances against ground truth
+static const double SEARCH_POS_TOL = 1.5, SEARCH_ANGLE_TOL = 1.5;
+static const double REFINE_POS_TOL = 0.35, REFINE_ANGLE_TOL = 0.25, REFINE_SCALE_TOL = 0.01;
+// Native kernels use float sums and reciprocal approximations
+static const double SCORE_TOL = 2e-3;
+// Native projections accumulate in float; a weak extremum (flat parabola)
+// magnifies the profile error in its sub-pixel position
+static const double PROFILE_TOL = 1e-3, EDGE_POS_TOL = 1e-3;
+
+static const double DEG2RAD = 3.14159265358979323846 / 180.0;
+
+// ─── Synthetic scenes ───────────────────────────────────────────────────────
+
+// Deterministic across platforms (std:: distributions are not)
+struct Rng
+{
+    uint64_t s;
+    explicit Rng(uint64_t seed) : s(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint32_t Next()
+    {
+        s ^= s << 13; s ^= s >> 7; s ^= s << 17;
+        return (uint32_t)(s >> 16);
+    }
+    double Uniform(double lo, double hi) { return lo + (hi - lo) * (Next() / 4294967296.0); }
+};
+
+struct Pose { double x, y, angle, scale; };
+
+struct Scene
+{
+    int width = 0, height = 0;
+    std::vector<uint8_t> gray;
+    std::vector<Pose> parts;
+};
+
+static const double PART_HALF_W = 40, PART_HALF_H = 25;
+static const int PART_GRAY = 220;
+
+// The part in its own frame: a plate with a bore and a chamfered corner
+static bool PartCovers(double u, double v)
+{
+    if (fabs(u) >= PART_HALF_W || fabs(v) >= PART_HALF_H) return false;
+    if ((u - 15) * (u - 15) + v * v < 100) return false;
+    return !(u < -20 && v > 10 && u + 40 > v - 10);
+}
+
+// 4×4 supersampled coverage, blended over the existing pixels
+static void DrawPart(std::vector<uint8_t>& img, int w, int h, const Pose& p)
+{
+    double c = cos(p.angle * DEG2RAD), s = sin(p.angle * DEG2RAD);
+    int reach = (int)ceil(hypot(PART_HALF_W, PART_HALF_H) * p.scale) + 2;
+    int x0 = std::max(0, (int)p.x - reach), x1 = std::min(w - 1, (int)p.x + reach);
+    int y0 = std::max(0, (int)p.y - reach), y1 = std::min(h - 1, (int)p.y + reach);
+    for (int y = y0; y <= y1; y++)
+    {
+        for (int x = x0; x <= x1; x++)
+        {
+            int cover = 0;
+            for (int sy = 0; sy < 4; sy++)
+            {
+                for (int sx = 0; sx < 4; sx++)
+                {
+                    double px = x + (sx + 0.5) / 4 - 0.5 - p.x;
+                    double py = y + (sy + 0.5) / 4 - 0.5 - p.y;
+                    double u = (c * px + s * py) / p.scale, v = (-s * px + c * py) / p.scale;
+                    cover += PartCovers(u, v);
+                }
+            }
+            uint8_t& d = img[(size_t)y * w + x];
+            d = (uint8_t)((d * (16 - cover) + PART_GRAY * cover + 8) / 16);
+        }
+    }
+}
+
+static Scene MakeScene(double megapixels, uint64_t seed)
+{
+    Scene sc;
+    sc.width = ((int)lround(sqrt(megapixels * 1e6 * 4.0 / 3.0)) + 15) & ~15;
+    sc.height = sc.width * 3 / 4;
+    int w = sc.width, h = sc.height;
+    sc.gray.resize((size_t)w * h);
+    Rng rng(seed);
+
+    // Shaded background with sensor noise
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            sc.gray[(size_t)y * w + x] = (uint8_t)(60 + 30.0 * x / w + 20.0 * y / h + rng.Uniform(-3, 3));
+
+    // Parts on a coarse grid so they never overlap; clutter keeps clear of them
+    int cols = 2, rows = (PARTS_PER_SCENE + 1) / 2;
+    double cellW = (double)w / cols, cellH = (double)h / rows;
+    for (int i = 0; i < PARTS_PER_SCENE; i++)
+    {
+        Pose p;
+        p.x = cellW * (i % cols) + rng.Uniform(0.3, 0.7) * cellW;
+        p.y = cellH * (i / cols) + rng.Uniform(0.3, 0.7) * cellH;
+        p.angle = rng.Uniform(-180, 180);
+        p.scale = rng.Uniform(1.0 - SCALE_RANGE, 1.0 + SCALE_RANGE);
+        sc.parts.push_back(p);
+    }
+
+    double keepOut = hypot(PART_HALF_W, PART_HALF_H) * (1.0 + SCALE_RANGE) + 50;
+    int clutter = (int)(megapixels * 15);
+    for (int i = 0; i < clutter; i++)
+    {
+        double cx = rng.Uniform(0, w), cy = rng.Uniform(0, h), r = rng.Uniform(5, 30);
+        bool clear = true;
+        for (const Pose& p : sc.parts)
+            if (hypot(cx - p.x, cy - p.y) < keepOut + r * 1.5) clear = false;
+        if (!clear) continue;
+        bool disc = rng.Next() & 1;
+        uint8_t g = (uint8_t)rng.Uniform(30, 240);
+        for (int y = std::max(0, (int)(cy - r)); y < std::min(h, (int)(cy + r)); y++)
+            for (int x = std::max(0, (int)(cx - r * 1.5)); x < std::min(w, (int)(cx + r * 1.5)); x++)
+                if (!disc || (x - cx) * (x - cx) / 2.25 + (y - cy) * (y - cy) < r * r)
+                    sc.gray[(size_t)y * w + x] = g;
+    }
+
+    for (const Pose& p : sc.parts) DrawPart(sc.gray, w, h, p);
+    return sc;
+}
+
+// ─── Model ──────────────────────────────────────────────────────────────────
+
+struct Model
+{
+    std::vector<float> x, y, dx, dy;
+    std::vector<int> binOffsets, binIndices;
+    int key = MODEL_KEY;
+    NvModelDesc Desc() const
+    {
+        return { x.data(), y.data(), dx.data(), dy.data(),
+                 binOffsets.data(), binIndices.data(), (int)x.size(), key, 0, 0 };
+    }
+};
+
+// Edge points of the part rendered upright at `scale`: magnitude threshold,
+// non-maximum suppression along the gradient, every second point kept
+static Model TrainModel(double scale = 1.0, int key = MODEL_KEY)
+{
+    const int w = 121, h = 81;
+    std::vector<uint8_t> tpl((size_t)w * h, 40);
+    DrawPart(tpl, w, h, { 60, 40, 0, scale });
+    std::vector<uint32_t> packed((size_t)w * h);
+    std::vector<uint16_t> mag((size_t)w * h);
+    ComputeGradientCompactNative(tpl.data(), w, h, w, packed.data(), mag.data());
+
+    Model md;
+    md.key = key;
+    std::vector<std::vector<int>> bins(NUM_GRAD_BINS);
+    int kept = 0;
+    for (int y = 2; y < h - 2; y++)
+    {
+        for (int x = 2; x < w - 2; x++)
+        {
+            int m = mag[(size_t)y * w + x];
+            if (m < 150) continue;
+            uint32_t g = packed[(size_t)y * w + x];
+            int gx = (int16_t)(g & 0xFFFF), gy = (int16_t)(g >> 16);
+            double len = sqrt((double)gx * gx + (double)gy * gy);
+            int ox = (int)lround(gx / len), oy = (int)lround(gy / len);
+            if (mag[(size_t)(y + oy) * w + x + ox] > m || mag[(size_t)(y - oy) * w + x - ox] > m) continue;
+            if (kept++ % 2) continue;
+
+            md.x.push_back((float)(x - 60));
+            md.y.push_back((float)(y - 40));
+            md.dx.push_back((float)(gx / len));
+            md.dy.push_back((float)(gy / len));
+            double deg = atan2((double)gy, (double)gx) / DEG2RAD;
+            if (deg < 0) deg += 360;
+            bins[(int)(deg * NUM_GRAD_BINS / 360) % NUM_GRAD_BINS].push_back((int)md.x.size() - 1);
+        }
+    }
+    for (const std::vector<int>& b : bins)
+    {
+        md.binOffsets.push_back((int)md.binIndices.size());
+        md.binIndices.insert(md.binIndices.end(), b.begin(), b.end());
+    }
+    md.binOffsets.push_back((int)md.binIndices.size());
+    return md;
+}
+
+// ─── Scalar references ──────────────────────────────────────────────────────
+
+static inline int SobelX(const uint8_t* g, int stride, int x, int y)
+{
+    const uint8_t* r0 = g + (size_t)(y - 1) * stride;
+    const uint8_t* r1 = r0 + stride;
+    const uint8_t* r2 = r1 + stride;
+    return -r0[x - 1] + r0[x + 1] - 2 * r1[x - 1] + 2 * r1[x + 1] - r2[x - 1] + r2[x + 1];
+}
+
+static inline int SobelY(const uint8_t* g, int stride, int x, int y)
+{
+    const uint8_t* r0 = g + (size_t)(y - 1) * stride;
+    const uint8_t* r2 = r0 + 2 * (size_t)stride;
+    return -r0[x - 1] - 2 * r0[x] - r0[x + 1] + r2[x - 1] + 2 * r2[x] + r2[x + 1];
+}
+
+// Mean normalised dot product of the rotated model gradients with the image
+// gradients, no early exit; -1 when a point falls outside the image
+static double ReferenceScore(const Model& md, const Scene& sc, int px, int py, double angle, double scale)
+{
+    double c = cos(angle * DEG2RAD), s = sin(angle * DEG2RAD);
+    int n = (int)md.x.size();
+    double sum = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int x = px + (int)lrint((md.x[i] * c - md.y[i] * s) * scale);
+        int y = py + (int)lrint((md.x[i] * s + md.y[i] * c) * scale);
+        if (x < 1 || y < 1 || x >= sc.width - 1 || y >= sc.height - 1) return -1;
+        double gx = SobelX(sc.gray.data(), sc.width, x, y);
+        double gy = SobelY(sc.gray.data(), sc.width, x, y);
+        double m = sqrt(gx * gx + gy * gy);
+        if (m <= 0.001) continue;
+        double mdx = md.dx[i] * c - md.dy[i] * s, mdy = md.dx[i] * s + md.dy[i] * c;
+        sum += (mdx * gx + mdy * gy) / m;
+    }
+    return sum / n;
+}
+
+// 8-connected components of gray > threshold: count and total area
+static void ReferenceBlobs(const Scene& sc, int threshold, int* outCount, int64_t* outArea)
+{
+    int w = sc.width, h = sc.height;
+    std::vector<uint8_t> seen((size_t)w * h, 0);
+    std::vector<int> stack;
+    int count = 0;
+    int64_t area = 0;
+    for (int i = 0; i < w * h; i++)
+    {
+        if (seen[i] || sc.gray[i] <= threshold) continue;
+        count++;
+        seen[i] = 1;
+        stack.push_back(i);
+        while (!stack.empty())
+        {
+            int p = stack.back();
+            stack.pop_back();
+            area++;
+            int x = p % w, y = p / w;
+            for (int dy = -1; dy <= 1; dy++)
+            {
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    int xx = x + dx, yy = y + dy;
+                    if ((unsigned)xx >= (unsigned)w || (unsigned)yy >= (unsigned)h) continue;
+                    int q = yy * w + xx;
+                    if (seen[q] || sc.gray[q] <= threshold) continue;
+                    seen[q] = 1;
+                    stack.push_back(q);
+                }
+            }
+        }
+    }
+    *outCount = count;
+    *outArea = area;
+}
+
+// Brute-force min (isMax 0) or max over a kw × kh window anchored at (ax, ay);
+// pixels outside the image are skipped
+static void ReferenceMinMax(const uint8_t* src, int w, int h, int stride, int isMax,
+    int kw, int kh, int ax, int ay, std::vector<uint8_t>& out)
+{
+    out.assign((size_t)w * h, 0);
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            int v = isMax ? 0 : 255;
+            for (int yy = std::max(0, y - ay); yy < std::min(h, y - ay + kh); yy++)
+                for (int xx = std::max(0, x - ax); xx < std::min(w, x - ax + kw); xx++)
+                    v = isMax ? std::max(v, (int)src[yy * stride + xx]) : std::min(v, (int)src[yy * stride + xx]);
+            out[(size_t)y * w + x] = (uint8_t)v;
+        }
+    }
+}
+
+// One depth pixel to 8-bit: round((z − lo)·scale) in [0, 255]; out-of-range
+// pixels are 0 unless clamped, NaN always
+static uint8_t ReferenceSlice(float z, float lo, float hi, bool clampOutside)
+{
+    float range = hi - lo, scale = range > 0.0001f ? 255.0f / range : 0.0f;
+    bool keep = clampOutside ? !std::isnan(z) : (z >= lo && z <= hi);
+    if (!keep) return 0;
+    float v = std::min(std::max((z - lo) * scale, 0.0f), 255.0f);
+    return (uint8_t)lrintf(v);
+}
+
+// cv::morphologyEx with a kw × kh rectangle, applied `iterations` times
+static void ReferenceMorphology(const uint8_t* src, int w, int h, int stride,
+    int op, int kw, int kh, int iterations, std::vector<uint8_t>& out)
+{
+    int gw = (kw - 1) * iterations + 1, gh = (kh - 1) * iterations + 1;
+    int ax = kw / 2 * iterations, ay = kh / 2 * iterations;
+    std::vector<uint8_t> a, b;
+    bool maxFirst = op == 1 || op == 3 || op == 6;
+    ReferenceMinMax(src, w, h, stride, maxFirst, gw, gh, ax, ay, a);
+    if (op <= 1)
+    {
+        out = a;
+        return;
+    }
+    if (op == 4)
+        ReferenceMinMax(src, w, h, stride, 1, gw, gh, ax, ay, b);
+    else
+        ReferenceMinMax(a.data(), w, h, w, !maxFirst, gw, gh, ax, ay, b);
+    out.resize((size_t)w * h);
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            size_t i = (size_t)y * w + x;
+            int s = src[y * stride + x];
+            int v = op == 4 ? b[i] - a[i] : op == 5 ? s - b[i] : op == 6 ? b[i] - s : b[i];
+            out[i] = (uint8_t)std::max(v, 0);
+        }
+    }
+}
+
+static int Reflect101(int i, int n)
+{
+    if (n == 1) return 0;
+    while (i < 0 || i >= n)
+        i = i < 0 ? -i : 2 * n - 2 - i;
+    return i;
+}
+
+// Caliper projection in double: each strip sample (c, r) bilinearly
+// interpolated with reflect-101 borders, rows averaged uniformly or with
+// Gaussian weights (sigma R/4 around the centre row)
+static void ReferenceProjection(const uint8_t* img, int w, int h, int stride,
+    const NvCaliper& cal, bool gaussian, std::vector<double>& out)
+{
+    int L = (int)cal.length, R = std::max(1, (int)cal.width);
+    std::vector<double> weights(R, 1.0 / R);
+    if (gaussian && R > 1)
+    {
+        double centre = (R - 1) * 0.5, sigma = R / 4.0, sum = 0.0;
+        for (int r = 0; r < R; r++)
+            sum += weights[r] = exp(-(r - centre) * (r - centre) / (2.0 * sigma * sigma));
+        for (double& wt : weights) wt /= sum;
+    }
+    out.assign(L, 0.0);
+    for (int r = 0; r < R; r++)
+    {
+        for (int c = 0; c < L; c++)
+        {
+            double x = cal.x - cal.vx * cal.width * 0.5 + c * cal.ux * cal.length / L + r * cal.vx * cal.width / R;
+            double y = cal.y - cal.vy * cal.width * 0.5 + c * cal.uy * cal.length / L + r * cal.vy * cal.width / R;
+            double fx = floor(x), fy = floor(y);
+            int x0 = Reflect101((int)fx, w), x1 = Reflect101((int)fx + 1, w);
+            const uint8_t* r0 = img + (size_t)Reflect101((int)fy, h) * stride;
+            const uint8_t* r1 = img + (size_t)Reflect101((int)fy + 1, h) * stride;
+            double top = r0[x0] + (x - fx) * (r0[x1] - r0[x0]);
+            double bot = r1[x0] + (x - fx) * (r1[x1] - r1[x0]);
+            out[c] += weights[r] * (top + (y - fy) * (bot - top));
+        }
+    }
+}
+
+// Smoothing (edge-renormalised), derivative taps and the parabolic
+// sub-pixel extrema of any polarity above the threshold
+static void ReferenceCaliperEdges(const std::vector<double>& profile, std::vector<NvCaliperEdge>& out)
+{
+    int L = (int)profile.size();
+    std::vector<double> sm(L), g(L, 0.0);
+    for (int i = 0; i < L; i++)
+    {
+        double sum = 0.0, wSum = 0.0;
+        for (int k = std::max(-2, -i); k <= std::min(2, L - 1 - i); k++)
+        {
+            sum += profile[i + k] * SMOOTH_TAPS[k + 2];
+            wSum += SMOOTH_TAPS[k + 2];
+        }
+        sm[i] = sum / wSum;
+    }
+    for (int i = 1; i < L - 1; i++)
+        g[i] = sm[i - 1] * DERIV_TAPS[0] + sm[i + 1] * DERIV_TAPS[2];
+    out.clear();
+    for (int i = 2; i < L - 2; i++)
+    {
+        bool peak = g[i] > CALIPER_THRESHOLD && g[i] > g[i - 1] && g[i] > g[i + 1];
+        bool trough = -g[i] > CALIPER_THRESHOLD && g[i] < g[i - 1] && g[i] < g[i + 1];
+        if (!peak && !trough) continue;
+        double a = fabs(g[i - 1]), b = fabs(g[i]), c = fabs(g[i + 1]);
+        double denom = 2.0 * a - 4.0 * b + 2.0 * c;
+        double offset = fabs(denom) < 1e-12 ? 0.0 : std::min(std::max((a - c) / denom, -0.5), 0.5);
+        out.push_back({ i + offset, b, i, peak ? 1 : -1 });
+    }
+}
+
+// ─── Checks ─────────────────────────────────────────────────────────────────
+
+static int g_failures = 0;
+
+static void Check(bool ok, const char* what, const char* fmt, ...)
+{
+    if (ok) return;
+    g_failures++;
+    char detail[512];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(detail, sizeof(detail), fmt, args);
+    va_end(args);
+    printf("  FAIL %-22s %s\n", what, detail);
+}
+
+static double AngleDiff(double a, double b)
+{
+    double d = fmod(a - b, 360.0);
+    if (d > 180) d -= 360;
+    if (d < -180) d += 360;
+    return fabs(d);
+}
+
+// Index of the ground-truth part nearest (x, y)
+static int NearestPart(const Scene& sc, double x, double y)
+{
+    int best = 0;
+    for (int i = 1; i < (int)sc.parts.size(); i++)
+        if (hypot(sc.parts[i].x - x, sc.parts[i].y - y) < hypot(sc.parts[best].x - x, sc.parts[best].y - y))
+            best = i;
+    return best;
+}
+
+// ─── One run of every export ────────────────────────────────────────────────
+
+struct Buffers
+{
+    std::vector<float> dx, dy, mag;
+    std::vector<uint32_t> packed;
+    std::vector<uint16_t> packedMag;
+    std::vector<int> seX, seY, seBin;
+    std::vector<uint8_t> binary;
+    std::vector<NvBlobStats> blobs;
+    std::vector<uint8_t> morph;
+    std::vector<float> depth, cloud;    // depth frame and its organized XYZ cloud
+    std::vector<uint8_t> slice;
+    std::vector<NvCaliper> calipers;    // relative to the caliper crop
+    std::vector<double> profiles;
+    std::vector<NvCaliperEdge> caliperEdges;
+    std::vector<int> caliperCounts;
+};
+
+struct Results
+{
+    int edgeCount = 0;
+    int winner = -1;
+    NvModelResult search = {};
+    NvModelResult lazySearch = {};
+    int lazyWinner = -1;
+    NvModelResult mappedSearch = {};
+    int mappedWinner = -1;
+    NvModelResult responseSearch = {};
+    int responseWinner = -1;
+    NvModelResult scaledSearch = {};    // scaled model over the wide scale range
+    int scaledWinner = -1;
+    NvModelResult prunedSearch = {};    // the two searches above with edge pruning at MIN_SCORE
+    int prunedWinner = -1;
+    NvModelResult prunedScaled = {};
+    int prunedScaledWinner = -1;
+    std::vector<MatchInstance> instances;
+    Pose refined = {};
+    int refinedOk = 0;
+    Pose tracked = {};
+    double trackScore = 0;
+    int blobCount = 0;
+    int64_t blobArea = 0;
+    int64_t morphSum = 0;
+    int sliceCount = 0;
+    int caliperEdges = 0;               // Gaussian projection
+    int cloudValid = 0;
+    int bandCounts[SLICE_BANDS] = {};
+    int histogram[SLICE_LEVELS] = {};
+};
+
+struct Context
+{
+    const Scene& sc;
+    const Model& md;
+    const Model& scaled;        // trained at SCALED_MODEL_SCALE
+    NvMatcher* m;
+    NvBlobLabeler* labeler;
+    Buffers& buf;
+    const NvModelDesc* mapped;  // the model read back from its file, or null
+};
+
+static void RunGradient(Context& c)
+{
+    ComputeGradientNative(c.sc.gray.data(), c.sc.width, c.sc.height, c.sc.width,
+        c.buf.dx.data(), c.buf.dy.data(), c.buf.mag.data());
+}
+
+static void RunGradientCompact(Context& c)
+{
+    ComputeGradientCompactNative(c.sc.gray.data(), c.sc.width, c.sc.height, c.sc.width,
+        c.buf.packed.data(), c.buf.packedMag.data());
+}
+
+static int RunSearchEdges(Context& c, const uint32_t* grad)
+{
+    int n = NvExtractSearchEdges(c.m, c.sc.gray.data(), c.sc.width, c.sc.height, c.sc.width,
+        LEVELS, grad, CANNY_LOW, CANNY_HIGH, NUM_GRAD_BINS);
+    if (n > 0) NvCopySearchEdges(c.m, c.buf.seX.data(), c.buf.seY.data(), c.buf.seBin.data());
+    return n;
+}
+
+static int VoteWidth(const Scene& sc) { return (sc.width + (1 << (LEVELS - 1)) - 1) >> (LEVELS - 1); }
+static int VoteHeight(const Scene& sc) { return (sc.height + (1 << (LEVELS - 1)) - 1) >> (LEVELS - 1); }
+
+static int RunMatchModels(Context& c, int edgeCount, const uint32_t* grad, NvModelResult* out,
+    const NvModelDesc* model = nullptr, double scaleRange = SCALE_RANGE)
+{
+    NvModelDesc desc = model ? *model : c.md.Desc();
+    return NvMatchModelsCompact(c.m, &desc, 1, NUM_GRAD_BINS,
+        c.buf.seX.data(), c.buf.seY.data(), c.buf.seBin.data(), edgeCount,
+        VoteWidth(c.sc), VoteHeight(c.sc), -180, 360,
+        COARSE_ANGLE_STEP, FINE_VOTE_ANGLE_STEP, TOP_K,
+        1.0 / (1 << (LEVELS - 1)), BIN_SHIFT,
+        FINE_ANGLE_STEP, 1.0, scaleRange, SCALE_STEP,
+        grad, c.sc.width, c.sc.height, REF_RADIUS, 0, out);
+}
+
+static int RunMatchInstances(Context& c, int edgeCount, MatchInstance* out, int maxCount)
+{
+    const Model& md = c.md;
+    return NvMatchInstancesCompact(c.m,
+        md.x.data(), md.y.data(), md.dx.data(), md.dy.data(), (int)md.x.size(),
+        md.binOffsets.data(), md.binIndices.data(), NUM_GRAD_BINS,
+        c.buf.seX.data(), c.buf.seY.data(), c.buf.seBin.data(), edgeCount,
+        VoteWidth(c.sc), VoteHeight(c.sc), -180, 360,
+        COARSE_ANGLE_STEP, FINE_ANGLE_STEP, 1.0, SCALE_RANGE, SCALE_STEP,
+        1.0 / (1 << (LEVELS - 1)), BIN_SHIFT, c.buf.packed.data(),
+        c.sc.width, c.sc.height, REF_RADIUS, (float)MIN_SCORE, 0.8f, 0,
+        MIN_SCORE, 1.0, maxCount, out);
+}
+
+static int RunRefine(Context& c, Pose* io)
+{
+    const Model& md = c.md;
+    return NvRefinePoseCompact(md.x.data(), md.y.data(), md.dx.data(), md.dy.data(), (int)md.x.size(),
+        c.buf.packed.data(), c.sc.width, c.sc.height, 0, FINE_ANGLE_STEP, SCALE_STEP, REFINE_ITERATIONS,
+        &io->x, &io->y, &io->angle, &io->scale);
+}
+
+// Starts from the ground truth displaced by a few pixels and degrees
+static double RunTrack(Context& c, Pose* out)
+{
+    const Model& md = c.md;
+    const Pose& p = c.sc.parts[0];
+    return NvTrackPose(c.m, MODEL_KEY,
+        md.x.data(), md.y.data(), md.dx.data(), md.dy.data(), md.x.data(), md.y.data(), (int)md.x.size(),
+        c.sc.gray.data(), c.sc.width, c.sc.height, c.sc.width,
+        p.x + 3.0, p.y - 2.0, p.angle + 1.5, 1.0,
+        8.0, 3.0, SCALE_RANGE, FINE_ANGLE_STEP, SCALE_STEP, 0, REFINE_ITERATIONS,
+        &out->x, &out->y, &out->angle, &out->scale);
+}
+
+static int RunBlobs(Context& c)
+{
+    return NvLabelBlobs(c.labeler, c.sc.gray.data(), c.sc.width, c.sc.height, c.sc.width,
+        BLOB_THRESHOLD, 0, c.buf.binary.data(), c.sc.width, 0, 0.0);
+}
+
+static int RunMorphology(Context& c)
+{
+    return NvMorphology(c.sc.gray.data(), c.sc.width, c.sc.height, c.sc.width,
+        c.buf.morph.data(), c.sc.width, MORPH_TOPHAT, MORPH_KERNEL, MORPH_KERNEL, 1);
+}
+
+static int RunSliceDepth(Context& c)
+{
+    return NvSliceDepth(c.buf.depth.data(), c.sc.width, c.sc.height, c.sc.width * (int)sizeof(float),
+        SLICE_LO, SLICE_HI, c.buf.slice.data(), c.sc.width);
+}
+
+static int RunSliceCloud(Context& c, Results* r)
+{
+    int scratch[SLICE_BANDS + SLICE_LEVELS];
+    return NvSlicePointCloud(c.buf.cloud.data(), c.sc.width, c.sc.height, 2, 0.0f, SLICE_LO, SLICE_HI,
+        c.buf.slice.data(), c.sc.width, nullptr, 0,
+        BAND_LO, BAND_HI, SLICE_BANDS, r ? r->bandCounts : scratch, r ? r->histogram : scratch + SLICE_BANDS);
+}
+
+// Top-left pixel of the caliper crop: part 0 kept inside, clamped to the scene
+static const uint8_t* CaliperCrop(const Scene& sc)
+{
+    const Pose& p = sc.parts[0];
+    int cx = std::min(std::max((int)p.x - CALIPER_CROP_W / 2, 0), sc.width - CALIPER_CROP_W);
+    int cy = std::min(std::max((int)p.y - CALIPER_CROP_H / 2, 0), sc.height - CALIPER_CROP_H);
+    return sc.gray.data() + (size_t)cy * sc.width + cx;
+}
+
+// Spokes through part 0 at fractional lengths and widths, then calipers
+// starting or ending outside the crop
+static std::vector<NvCaliper> MakeCalipers(const Scene& sc)
+{
+    const uint8_t* crop = CaliperCrop(sc);
+    size_t offset = crop - sc.gray.data();
+    double px = sc.parts[0].x - (double)(offset % sc.width);
+    double py = sc.parts[0].y - (double)(offset / sc.width);
+    std::vector<NvCaliper> cal;
+    for (int k = 0; k < CALIPER_SPOKES; k++)
+    {
+        double a = sc.parts[0].angle * DEG2RAD + k * 3.14159265358979323846 / CALIPER_SPOKES;
+        double ux = cos(a), uy = sin(a), length = 100.5 + k % 3, width = 9 + 2 * (k % 4) + 0.5;
+        cal.push_back({ px - ux * length / 2, py - uy * length / 2, ux, uy, -uy, ux, length, width });
+    }
+    double w = CALIPER_CROP_W, h = CALIPER_CROP_H;
+    cal.push_back({ -6, h / 2 - 10, 1, 0, 0, 1, 90, 10 });
+    cal.push_back({ w / 2 + 10, -5, 0, 1, -1, 0, 70, 9 });
+    cal.push_back({ w + 4, h / 2 + 8, -1, 0, 0, -1, 90.5, 8 });
+    cal.push_back({ w / 2 - 15, h + 3, 0.6, -0.8, 0.8, 0.6, 80, 20 });
+    return cal;
+}
+
+static int RunCalipers(Context& c, int gaussian)
+{
+    Buffers& b = c.buf;
+    return NvMeasureCalipers(CaliperCrop(c.sc), CALIPER_CROP_W, CALIPER_CROP_H, c.sc.width,
+        b.calipers.data(), CALIPER_COUNT, gaussian, SMOOTH_TAPS, 2, DERIV_TAPS, 1,
+        CALIPER_THRESHOLD, 2, b.profiles.data(), nullptr, CALIPER_STRIDE,
+        b.caliperEdges.data(), CALIPER_EDGES, b.caliperCounts.data());
+}
+
+static Results RunAll(Context& c)
+{
+    Results r;
+    RunGradient(c);
+    RunGradientCompact(c);
+    r.edgeCount = RunSearchEdges(c, c.buf.packed.data());
+    r.winner = RunMatchModels(c, r.edgeCount, c.buf.packed.data(), &r.search);
+    NvModelDesc response = c.md.Desc();
+    response.voteMode = VOTE_RESPONSE;
+    r.responseWinner = RunMatchModels(c, r.edgeCount, c.buf.packed.data(), &r.responseSearch, &response);
+    NvModelDesc scaled = c.scaled.Desc();
+    r.scaledWinner = RunMatchModels(c, r.edgeCount, c.buf.packed.data(), &r.scaledSearch, &scaled,
+        WIDE_SCALE_RANGE);
+    NvSetEdgePruning(c.m, MIN_SCORE);
+    r.prunedWinner = RunMatchModels(c, r.edgeCount, c.buf.packed.data(), &r.prunedSearch);
+    r.prunedScaledWinner = RunMatchModels(c, r.edgeCount, c.buf.packed.data(), &r.prunedScaled, &scaled,
+        WIDE_SCALE_RANGE);
+    NvSetEdgePruning(c.m, 0.0);
+
+    const uint32_t* lazy = NvBeginLazyGradient(c.m, c.sc.gray.data(), c.sc.width, c.sc.height, c.sc.width);
+    if (lazy)
+    {
+        int n = RunSearchEdges(c, lazy);
+        r.lazyWinner = RunMatchModels(c, n, lazy, &r.lazySearch);
+    }
+    if (c.mapped)
+    {
+        RunSearchEdges(c, c.buf.packed.data());
+        r.mappedWinner = RunMatchModels(c, r.edgeCount, c.buf.packed.data(), &r.mappedSearch, c.mapped);
+    }
+
+    r.instances.resize(PARTS_PER_SCENE * 2);
+    r.instances.resize(RunMatchInstances(c, r.edgeCount, r.instances.data(), (int)r.instances.size()));
+
+    if (r.winner >= 0)
+    {
+        r.refined = { r.search.x, r.search.y, r.search.angle, r.search.scale };
+        r.refinedOk = RunRefine(c, &r.refined);
+    }
+    r.trackScore = RunTrack(c, &r.tracked);
+
+    int blobs = RunBlobs(c);
+    r.blobCount = blobs;
+    if (blobs > 0)
+    {
+        c.buf.blobs.resize(blobs);
+        NvCopyBlobStats(c.labeler, c.buf.blobs.data());
+        for (const NvBlobStats& b : c.buf.blobs) r.blobArea += b.area;
+    }
+
+    if (RunMorphology(c))
+        for (uint8_t v : c.buf.morph) r.morphSum += v;
+    r.cloudValid = RunSliceCloud(c, &r);
+    r.sliceCount = RunSliceDepth(c);
+    r.caliperEdges = RunCalipers(c, 1);
+    return r;
+}
+
+// ─── Verification ───────────────────────────────────────────────────────────
+
+static void VerifyGradients(Context& c)
+{
+    const Scene& sc = c.sc;
+    int w = sc.width, h = sc.height;
+    int64_t badFloat = 0, badCompact = 0;
+    for (int y = 1; y < h - 1; y++)
+    {
+        for (int x = 1; x < w - 1; x++)
+        {
+            size_t i = (size_t)y * w + x;
+            int gx = SobelX(sc.gray.data(), w, x, y), gy = SobelY(sc.gray.data(), w, x, y);
+            float m = sqrtf((float)(gx * gx + gy * gy));
+            if (c.buf.dx[i] != (float)gx || c.buf.dy[i] != (float)gy || fabsf(c.buf.mag[i] - m) > 1e-3f * (m + 1))
+                badFloat++;
+            uint32_t packed = (uint16_t)gx | ((uint32_t)(uint16_t)gy << 16);
+            if (c.buf.packed[i] != packed || c.buf.packedMag[i] != (uint16_t)(m + 0.5f))
+                badCompact++;
+        }
+    }
+    Check(badFloat == 0, "ComputeGradientNative", "%lld pixels differ from the scalar Sobel", (long long)badFloat);
+    Check(badCompact == 0, "ComputeGradientCompact", "%lld pixels differ from the scalar Sobel", (long long)badCompact);
+}
+
+// Native window score at the pose against the reference, through
+// NvEvaluateCompact (no greedy exit) and the reference directly
+static void VerifyScore(Context& c, const char* what, double x, double y, double angle, double scale, double score,
+    const Model* model = nullptr)
+{
+    const Model& md = model ? *model : c.md;
+    int n = (int)md.x.size(), px = (int)lrint(x), py = (int)lrint(y);
+    double ref = ReferenceScore(md, c.sc, px, py, angle, scale);
+    Check(fabs(score - ref) <= SCORE_TOL, what, "score %.5f, reference %.5f", score, ref);
+
+    double cs = cos(angle * DEG2RAD), sn = sin(angle * DEG2RAD);
+    std::vector<int> rx(n), ry(n);
+    std::vector<float> rdx(n), rdy(n);
+    for (int i = 0; i < n; i++)
+    {
+        rx[i] = (int)lrint((md.x[i] * cs - md.y[i] * sn) * scale);
+        ry[i] = (int)lrint((md.x[i] * sn + md.y[i] * cs) * scale);
+        rdx[i] = (float)(md.dx[i] * cs - md.dy[i] * sn);
+        rdy[i] = (float)(md.dx[i] * sn + md.dy[i] * cs);
+    }
+    double eval = NvEvaluateCompact(c.m, px, py, rx.data(), ry.data(), rdx.data(), rdy.data(),
+        c.buf.packed.data(), c.sc.width, n, 0.0f, 0.0f, 0);
+    Check(fabs(eval - ref) <= SCORE_TOL, "NvEvaluateCompact", "score %.5f, reference %.5f", eval, ref);
+}
+
+// Borderline poses for the greedy exit: a row of N points where only those in
+// [goodFrom, goodTo) match. The running mean is tested every 16 points inside
+// the full 16-point blocks, so with N = 44 the only checkpoint is 16 — a pose
+// that dips below thresh*(1-greedy) at 8 or 40 must still be scored, whatever
+// NATIVEVISION_ISA selects, while one that dips at 16 is rejected.
+static void VerifyEarlyExit(Context& c)
+{
+    const int n = 44, w = 64;
+    const float thresh = 0.8f, greedy = 0.5f;
+    struct Case { const char* name; int goodFrom, goodTo; double expect; };
+    const Case cases[] = {
+        { "early exit, low start",   8, n, (double)(n - 8) / n },
+        { "early exit, low tail",    0, 14, 14.0 / n },
+        { "early exit, rejected",   16, n, 0.0 },
+    };
+
+    std::vector<int> rx(n), ry(n, 0);
+    std::vector<float> rdx(n, 1.0f), rdy(n, 0.0f);
+    for (int i = 0; i < n; i++) rx[i] = i;
+
+    for (const Case& k : cases)
+    {
+        std::vector<float> dx(2 * w, 0.0f), dy(2 * w, 0.0f), mag(2 * w, 0.0f);
+        std::vector<uint32_t> packed(2 * w, 0);
+        for (int i = k.goodFrom; i < k.goodTo; i++)
+        {
+            dx[i] = mag[i] = 100.0f;
+            packed[i] = 100;
+        }
+        double f = NvEvaluate(c.m, 0, 0, rx.data(), ry.data(), rdx.data(), rdy.data(),
+            dx.data(), dy.data(), mag.data(), w, n, thresh, greedy, 0);
+        double p = NvEvaluateCompact(c.m, 0, 0, rx.data(), ry.data(), rdx.data(), rdy.data(),
+            packed.data(), w, n, thresh, greedy, 0);
+        Check(fabs(f - k.expect) <= SCORE_TOL, k.name, "NvEvaluate %.5f, expected %.5f", f, k.expect);
+        Check(fabs(p - k.expect) <= SCORE_TOL, k.name, "NvEvaluateCompact %.5f, expected %.5f", p, k.expect);
+    }
+}
+
+static void VerifyResults(Context& c, const Results& r)
+{
+    const Scene& sc = c.sc;
+    VerifyGradients(c);
+    Check(r.edgeCount > 0, "NvExtractSearchEdges", "no search edges");
+
+    Check(r.winner == 0 && r.search.score >= MIN_SCORE, "NvMatchModels", "winner %d, score %.3f", r.winner, r.search.score);
+    if (r.winner == 0)
+    {
+        const Pose& t = sc.parts[NearestPart(sc, r.search.x, r.search.y)];
+        double dPos = hypot(r.search.x - t.x, r.search.y - t.y), dAng = AngleDiff(r.search.angle, t.angle);
+        Check(dPos <= SEARCH_POS_TOL && dAng <= SEARCH_ANGLE_TOL, "NvMatchModels",
+            "pose off by %.2f px, %.2f deg", dPos, dAng);
+        VerifyScore(c, "NvMatchModels", r.search.x, r.search.y, r.search.angle, r.search.scale, r.search.score);
+    }
+    // Phase 1 by response maps may settle on another part than Hough voting
+    Check(r.responseWinner == 0 && r.responseSearch.score >= MIN_SCORE, "response maps",
+        "winner %d, score %.3f", r.responseWinner, r.responseSearch.score);
+    if (r.responseWinner == 0)
+    {
+        const NvModelResult& rs = r.responseSearch;
+        const Pose& t = sc.parts[NearestPart(sc, rs.x, rs.y)];
+        double dPos = hypot(rs.x - t.x, rs.y - t.y), dAng = AngleDiff(rs.angle, t.angle);
+        Check(dPos <= SEARCH_POS_TOL && dAng <= SEARCH_ANGLE_TOL, "response maps",
+            "pose off by %.2f px, %.2f deg", dPos, dAng);
+        VerifyScore(c, "response maps", rs.x, rs.y, rs.angle, rs.scale, rs.score);
+    }
+    // The vote picks the scale band, so Phase 2 must land on the part's scale
+    Check(r.scaledWinner == 0 && r.scaledSearch.score >= MIN_SCORE, "scale voting",
+        "winner %d, score %.3f", r.scaledWinner, r.scaledSearch.score);
+    if (r.scaledWinner == 0)
+    {
+        const NvModelResult& ss = r.scaledSearch;
+        const Pose& t = sc.parts[NearestPart(sc, ss.x, ss.y)];
+        double dPos = hypot(ss.x - t.x, ss.y - t.y), dAng = AngleDiff(ss.angle, t.angle);
+        double dScale = fabs(ss.scale - t.scale / SCALED_MODEL_SCALE);
+        Check(dPos <= SEARCH_POS_TOL && dAng <= SEARCH_ANGLE_TOL && dScale <= SCALE_STEP, "scale voting",
+            "pose off by %.2f px, %.2f deg, scale %.3f", dPos, dAng, dScale);
+        VerifyScore(c, "scale voting", ss.x, ss.y, ss.angle, ss.scale, ss.score, &c.scaled);
+    }
+    // Pruning drops only windows that cannot clear MIN_SCORE, so a search
+    // that clears it must not move
+    auto samePose = [](const NvModelResult& a, const NvModelResult& b)
+    {
+        return a.x == b.x && a.y == b.y && a.angle == b.angle && a.scale == b.scale && a.score == b.score;
+    };
+    Check(r.prunedWinner == r.winner && samePose(r.prunedSearch, r.search), "NvSetEdgePruning",
+        "pruned search (%.2f, %.2f, %.2f, %.5f) differs", r.prunedSearch.x, r.prunedSearch.y,
+        r.prunedSearch.angle, r.prunedSearch.score);
+    Check(r.prunedScaledWinner == r.scaledWinner && samePose(r.prunedScaled, r.scaledSearch), "NvSetEdgePruning",
+        "pruned scale search (%.2f, %.2f, %.2f, %.3f, %.5f) differs", r.prunedScaled.x, r.prunedScaled.y,
+        r.prunedScaled.angle, r.prunedScaled.scale, r.prunedScaled.score);
+    Check(r.lazyWinner == r.winner && r.lazySearch.x == r.search.x && r.lazySearch.y == r.search.y
+          && r.lazySearch.angle == r.search.angle && r.lazySearch.score == r.search.score,
+        "NvBeginLazyGradient", "lazy search (%.2f, %.2f, %.2f, %.5f) differs from eager",
+        r.lazySearch.x, r.lazySearch.y, r.lazySearch.angle, r.lazySearch.score);
+    // Mapped bank angles are angleLo + i × step, the computed ones centre + da
+    if (c.mapped)
+        Check(r.mappedWinner == r.winner && r.mappedSearch.x == r.search.x && r.mappedSearch.y == r.search.y
+              && fabs(r.mappedSearch.angle - r.search.angle) <= 1e-9 && r.mappedSearch.score == r.search.score,
+            "NvOpenModelFile", "search on the mapped model (%.2f, %.2f, %.2f, %.5f) differs",
+            r.mappedSearch.x, r.mappedSearch.y, r.mappedSearch.angle, r.mappedSearch.score);
+
+    std::vector<int> hits(sc.parts.size(), 0);
+    for (const MatchInstance& in : r.instances)
+    {
+        int k = NearestPart(sc, in.x, in.y);
+        const Pose& t = sc.parts[k];
+        if (hypot(in.x - t.x, in.y - t.y) <= SEARCH_POS_TOL && AngleDiff(in.angle, t.angle) <= SEARCH_ANGLE_TOL)
+            hits[k]++;
+        VerifyScore(c, "NvMatchInstances", in.x, in.y, in.angle, in.scale, in.score);
+    }
+    for (size_t k = 0; k < hits.size(); k++)
+        Check(hits[k] == 1, "NvMatchInstances", "part %zu found %d times", k, hits[k]);
+
+    // Refinement may move one grid step at most; a grid pose a full step off
+    // is left as is, so only a converged refinement is held to sub-pixel
+    if (r.winner == 0)
+    {
+        const Pose& t = sc.parts[NearestPart(sc, r.refined.x, r.refined.y)];
+        double dPos = hypot(r.refined.x - t.x, r.refined.y - t.y), dAng = AngleDiff(r.refined.angle, t.angle);
+        double dScale = fabs(r.refined.scale - t.scale);
+        if (r.refinedOk)
+            Check(dPos <= REFINE_POS_TOL && dAng <= REFINE_ANGLE_TOL && dScale <= REFINE_SCALE_TOL,
+                "NvRefinePose", "pose off by %.3f px, %.3f deg, scale %.4f", dPos, dAng, dScale);
+        else
+            printf("  note: refinement left the grid pose (%.2f px, %.2f deg off)\n", dPos, dAng);
+    }
+
+    // NvTrackPose does not report whether its refinement converged
+    const Pose& t = sc.parts[0];
+    double dPos = hypot(r.tracked.x - t.x, r.tracked.y - t.y), dAng = AngleDiff(r.tracked.angle, t.angle);
+    Check(r.trackScore >= MIN_SCORE && dPos <= SEARCH_POS_TOL && dAng <= SEARCH_ANGLE_TOL, "NvTrackPose",
+        "score %.3f, pose off by %.3f px, %.3f deg", r.trackScore, dPos, dAng);
+
+    int refCount;
+    int64_t refArea;
+    ReferenceBlobs(sc, BLOB_THRESHOLD, &refCount, &refArea);
+    Check(r.blobCount == refCount && r.blobArea == refArea, "NvLabelBlobs",
+        "%d blobs / %lld px, reference %d / %lld", r.blobCount, (long long)r.blobArea, refCount, (long long)refArea);
+
+    // Every operation on a strided crop through a part, against brute force
+    static const int kernels[][3] = { { 5, 3, 2 }, { 23, 9, 2 }, { 1, 31, 1 } };
+    int cw = 160, ch = 120;
+    const Pose& p = sc.parts[0];
+    int cx = std::min(std::max((int)p.x - cw / 2, 0), sc.width - cw);
+    int cy = std::min(std::max((int)p.y - ch / 2, 0), sc.height - ch);
+    const uint8_t* crop = sc.gray.data() + (size_t)cy * sc.width + cx;
+    std::vector<uint8_t> got((size_t)cw * ch), ref;
+    for (const int* k : kernels)
+    {
+        for (int op = 0; op < MORPH_OPS; op++)
+        {
+            int ok = NvMorphology(crop, cw, ch, sc.width, got.data(), cw, op, k[0], k[1], k[2]);
+            ReferenceMorphology(crop, cw, ch, sc.width, op, k[0], k[1], k[2], ref);
+            int64_t bad = 0;
+            for (size_t i = 0; i < got.size(); i++) bad += got[i] != ref[i];
+            Check(ok && bad == 0, "NvMorphology", "op %d, %dx%d x%d: %lld pixels differ",
+                op, k[0], k[1], k[2], (long long)bad);
+        }
+    }
+
+    // c.buf.slice holds the depth slice (RunAll slices the cloud first)
+    int inRange = 0, valid = 0, bands[SLICE_BANDS] = {};
+    std::vector<int> hist(SLICE_LEVELS, 0);
+    int64_t badSlice = 0;
+    for (size_t i = 0; i < c.buf.depth.size(); i++)
+    {
+        float z = c.buf.depth[i];
+        uint8_t level = ReferenceSlice(z, SLICE_LO, SLICE_HI, false);
+        badSlice += c.buf.slice[i] != level;
+        if (std::isnan(z)) continue;
+        valid++;
+        if (z >= SLICE_LO && z <= SLICE_HI)
+        {
+            inRange++;
+            hist[level]++;
+        }
+        for (int b = 0; b < SLICE_BANDS; b++) bands[b] += z >= BAND_LO[b] && z <= BAND_HI[b];
+    }
+    Check(badSlice == 0 && r.sliceCount == inRange, "NvSliceDepth",
+        "%lld pixels differ, %d in range (reference %d)", (long long)badSlice, r.sliceCount, inRange);
+    int histDiff = 0;
+    for (int l = 0; l < SLICE_LEVELS; l++) histDiff += r.histogram[l] != hist[l];
+    Check(r.cloudValid == valid && histDiff == 0 && r.bandCounts[0] == bands[0]
+          && r.bandCounts[1] == bands[1] && r.bandCounts[2] == bands[2], "NvSlicePointCloud",
+        "%d valid, %d histogram levels differ, bands %d/%d/%d; reference %d, %d/%d/%d",
+        r.cloudValid, histDiff, r.bandCounts[0], r.bandCounts[1], r.bandCounts[2],
+        valid, bands[0], bands[1], bands[2]);
+
+    // Both projections against the double-precision reference
+    const uint8_t* calCrop = CaliperCrop(sc);
+    std::vector<double> refProfile;
+    std::vector<NvCaliperEdge> refEdges;
+    for (int gaussian = 0; gaussian <= 1; gaussian++)
+    {
+        int total = RunCalipers(c, gaussian);
+        Check(total >= CALIPER_SPOKES * 2, "NvMeasureCalipers", "%d edges on %d spokes", total, CALIPER_SPOKES);
+        for (int i = 0; i < CALIPER_COUNT; i++)
+        {
+            const NvCaliper& cal = c.buf.calipers[i];
+            ReferenceProjection(calCrop, CALIPER_CROP_W, CALIPER_CROP_H, sc.width, cal, gaussian != 0, refProfile);
+            ReferenceCaliperEdges(refProfile, refEdges);
+            const double* prof = c.buf.profiles.data() + (size_t)i * CALIPER_STRIDE;
+            double profErr = 0.0, posErr = 0.0;
+            for (size_t k = 0; k < refProfile.size(); k++)
+                profErr = std::max(profErr, fabs(prof[k] - refProfile[k]));
+            int n = c.buf.caliperCounts[i];
+            const NvCaliperEdge* e = c.buf.caliperEdges.data() + (size_t)i * CALIPER_EDGES;
+            bool sameEdges = n == (int)refEdges.size();
+            for (int k = 0; sameEdges && k < n; k++)
+            {
+                sameEdges = e[k].index == refEdges[k].index && e[k].polarity == refEdges[k].polarity;
+                posErr = std::max(posErr, fabs(e[k].position - refEdges[k].position));
+            }
+            Check(profErr <= PROFILE_TOL && sameEdges && posErr <= EDGE_POS_TOL, "NvMeasureCalipers",
+                "caliper %d (%s): profile off by %.5f, %d edges (reference %zu), position off by %.5f px",
+                i, gaussian ? "gaussian" : "uniform", profErr, n, refEdges.size(), posErr);
+        }
+    }
+}
+
+// Publishes the scene into a mapped SharedFrame region in both layouts and
+// reads it back in place: the shared gradient must equal the copied one, a
+// frame the writer has started to rewrite must be refused, and a view must go
+// stale once its slot is reused — after one frame single-slotted, after two
+// double-buffered (the writer fills slot B while slot A is being read).
+static void VerifySharedFrame(Context& c)
+{
+    const Scene& sc = c.sc;
+    int w = sc.width, h = sc.height;
+    int64_t slot = (SF_HEADER + (int64_t)w * h + SF_SLOT_ALIGN - 1) & ~(SF_SLOT_ALIGN - 1);
+    int64_t capacity = SF_SLOT_ALIGN + 2 * slot;
+    NvSharedRegion* region = NvOpenSharedFrameRegion(SHARED_REGION, capacity, 1);
+    Check(region != nullptr, "NvOpenSharedFrameRegion", "cannot map %lld bytes", (long long)capacity);
+    if (!region) return;
+    uint8_t* base = NvSharedRegionBase(region);
+
+    std::vector<uint32_t> packed((size_t)w * h);
+    std::vector<uint16_t> mag((size_t)w * h);
+    for (int slotted = 0; slotted <= 1; slotted++)
+    {
+        const char* layout = slotted ? "double-buffered" : "single";
+        memset(base, 0, (size_t)capacity);
+        int64_t first = NvPublishSharedFrame(base, capacity, slotted, sc.gray.data(), w, h, w, 1, 1);
+        NvSharedFrame view = {};
+        int status = NvAcquireSharedFrame(base, capacity, 0, &view);
+        Check(first > 0 && status == SF_OK && view.frameCounter == first && view.width == w && view.height == h,
+            "NvAcquireSharedFrame", "%s: status %d, frame %lld of %lld", layout, status,
+            (long long)view.frameCounter, (long long)first);
+        if (status != SF_OK) continue;
+
+        NvSharedFrame again;
+        Check(NvAcquireSharedFrame(base, capacity, first, &again) == SF_SAME, "NvAcquireSharedFrame",
+            "%s: an unchanged frame was reported as new", layout);
+
+        int current = NvComputeGradientCompactShared(base, &view, 0, 0, w, h, packed.data(), mag.data());
+        Check(current == 1 && packed == c.buf.packed && mag == c.buf.packedMag, "NvComputeGradientCompactShared",
+            "%s: current %d, gradient %s", layout, current, packed == c.buf.packed ? "equal" : "differs");
+
+        // The writer clears the commit tag before it touches a frame
+        uint8_t* tag = base + view.slotOffset + SF_COMMIT;
+        uint8_t saved[4];
+        memcpy(saved, tag, 4);
+        memset(tag, 0, 4);
+        status = NvAcquireSharedFrame(base, capacity, 0, &again);
+        Check(status == SF_TORN && !NvIsSharedFrameCurrent(base, &view), "NvAcquireSharedFrame",
+            "%s: frame under rewrite accepted (status %d)", layout, status);
+        memcpy(tag, saved, 4);
+
+        // Only 1, 3 and 4 channels have a pixel layout; anything else is a bad
+        // header even when the stride would hold it (half width, 2 channels)
+        uint8_t* geometry = base + view.slotOffset + SF_WIDTH;
+        uint8_t savedGeometry[12];
+        memcpy(savedGeometry, geometry, 12);
+        int32_t halfWidth = w / 2, two = 2;
+        memcpy(geometry, &halfWidth, 4);
+        memcpy(geometry + (SF_CHANNELS - SF_WIDTH), &two, 4);
+        status = NvAcquireSharedFrame(base, capacity, 0, &again);
+        Check(status == SF_BAD_HEADER, "NvAcquireSharedFrame",
+            "%s: 2-channel frame accepted (status %d)", layout, status);
+        memcpy(geometry, savedGeometry, 12);
+
+        // An older writer's version-1 frame has no commit tag to validate a view
+        if (!slotted)
+        {
+            uint8_t* version = base + SF_VERSION;
+            memcpy(saved, version, 4);
+            int32_t untagged = 1;
+            memcpy(version, &untagged, 4);
+            status = NvAcquireSharedFrame(base, capacity, 0, &again);
+            Check(status == SF_UNTAGGED, "NvAcquireSharedFrame",
+                "version-1 frame returned status %d", status);
+            memcpy(version, saved, 4);
+        }
+
+        // Rewrites until the writer is back on the view's slot
+        int64_t latest = NvPublishSharedFrame(base, capacity, slotted, sc.gray.data(), w, h, w, 1, 2);
+        bool heldDuringB = NvIsSharedFrameCurrent(base, &view) == 1;
+        if (slotted)
+            latest = NvPublishSharedFrame(base, capacity, slotted, sc.gray.data(), w, h, w, 1, 3);
+        current = NvComputeGradientCompactShared(base, &view, 0, 0, w, h, packed.data(), mag.data());
+        Check(heldDuringB == (slotted == 1) && current == 0 && !NvIsSharedFrameCurrent(base, &view),
+            "NvIsSharedFrameCurrent", "%s: view held during the next frame %d, after reuse %d",
+            layout, heldDuringB, current);
+        status = NvAcquireSharedFrame(base, capacity, first, &again);
+        Check(status == SF_OK && again.frameCounter == latest, "NvAcquireSharedFrame",
+            "%s: status %d, frame %lld of %lld", layout, status,
+            (long long)again.frameCounter, (long long)latest);
+    }
+    NvCloseSharedFrameRegion(region);
+#if !defined(_WIN32)
+    shm_unlink("/nv_bench_shared_frame");
+#endif
+}
+
+// ROI k of the pipeline check
+static void PipelineFrame(const Scene& sc, int k, const uint8_t** roi, int* w, int* h)
+{
+    int margin = PIPELINE_SHIFT * PIPELINE_FRAMES;
+    *roi = sc.gray.data() + (size_t)(k * PIPELINE_SHIFT / 2) * sc.width + k * PIPELINE_SHIFT;
+    *w = sc.width - margin;
+    *h = sc.height - margin / 2;
+}
+
+// The same search as a pipeline job, run synchronously: gradient, edges,
+// NvMatchModels and the winner's refinement
+static NvPipelineResult SyncPipelineJob(Context& c, const NvSearchParams& sp, int k)
+{
+    const uint8_t* roi;
+    int w, h;
+    PipelineFrame(c.sc, k, &roi, &w, &h);
+    std::vector<uint32_t> packed((size_t)w * h);
+    std::vector<int> ex((size_t)w * h), ey((size_t)w * h), eb((size_t)w * h);
+    ComputeGradientCompactNative(roi, w, h, c.sc.width, packed.data(), nullptr);
+    int n = NvExtractSearchEdges(c.m, roi, w, h, c.sc.width, sp.levels, packed.data(),
+        sp.cannyLow, sp.cannyHigh, sp.numGradBins);
+    if (n > 0) NvCopySearchEdges(c.m, ex.data(), ey.data(), eb.data());
+
+    int vW = w, vH = h;
+    for (int l = 1; l < sp.levels; l++)
+    {
+        vW = (vW + 1) / 2;
+        vH = (vH + 1) / 2;
+    }
+    NvModelDesc desc = c.md.Desc();
+    NvModelResult mr;
+    NvPipelineResult r = {};
+    r.winner = NvMatchModelsCompact(c.m, &desc, 1, sp.numGradBins, ex.data(), ey.data(), eb.data(), n,
+        vW, vH, sp.angleStart, sp.angleExtent, sp.coarseAngleStep, sp.fineVoteAngleStep, sp.topK,
+        1.0 / (1 << (sp.levels - 1)), sp.binShiftBits, sp.fineAngleStep, sp.scaleCenter, sp.scaleRange,
+        sp.scaleStep, packed.data(), w, h, sp.refRadius, sp.contrastInvariant, &mr);
+    if (r.winner < 0) return r;
+    r.x = mr.x, r.y = mr.y, r.angle = mr.angle, r.scale = mr.scale, r.score = mr.score;
+    if (r.score >= sp.refineMinScore)
+    {
+        const Model& md = c.md;
+        r.refined = NvRefinePoseCompact(md.x.data(), md.y.data(), md.dx.data(), md.dy.data(), (int)md.x.size(),
+            packed.data(), w, h, sp.contrastInvariant, sp.fineAngleStep, sp.refineScaleLimit,
+            sp.refineIterations, &r.x, &r.y, &r.angle, &r.scale) > 0;
+    }
+    return r;
+}
+
+// Submits PIPELINE_FRAMES frames, collects them newest first, and checks
+// each against the synchronous search; then the poll timeout, stale and
+// unknown tickets, and a destroy with jobs still in flight.
+static void VerifyPipeline(Context& c)
+{
+    NvSearchParams sp = { LEVELS, NUM_GRAD_BINS, CANNY_LOW, CANNY_HIGH, -180, 360,
+        COARSE_ANGLE_STEP, FINE_VOTE_ANGLE_STEP, TOP_K, BIN_SHIFT,
+        FINE_ANGLE_STEP, 1.0, SCALE_RANGE, SCALE_STEP, REF_RADIUS, 0,
+        MIN_SCORE, SCALE_STEP, REFINE_ITERATIONS, 0 };
+    NvModelDesc desc = c.md.Desc();
+    NvModelSet* set = NvCreateModelSet(&desc, 1, NUM_GRAD_BINS, nullptr, nullptr);
+    NvPipeline* p = NvCreatePipeline(PIPELINE_DEPTH, 0, 0);
+    Check(set && p, "NvCreatePipeline", "pipeline or model set not created");
+    if (!set || !p)
+    {
+        NvDestroyPipeline(p);
+        NvDestroyModelSet(set);
+        return;
+    }
+
+    auto submit = [&](int k)
+    {
+        const uint8_t* roi;
+        int w, h;
+        PipelineFrame(c.sc, k, &roi, &w, &h);
+        return NvPipelineSubmit(p, set, roi, w, h, c.sc.width, &sp);
+    };
+
+    std::vector<int64_t> tickets;
+    std::vector<NvPipelineResult> got(PIPELINE_FRAMES);
+    for (int k = 0; k < PIPELINE_DEPTH; k++) tickets.push_back(submit(k));
+    NvPipelineResult polled;
+    int early = NvPipelineWait(p, tickets.back(), 0, &polled);
+    for (int k = PIPELINE_DEPTH - 1; k >= 0; k--)
+        Check(NvPipelineWait(p, tickets[k], -1, &got[k]) == 1, "NvPipelineWait", "frame %d not collected", k);
+    for (int k = PIPELINE_DEPTH; k < PIPELINE_FRAMES; k++)
+    {
+        tickets.push_back(submit(k));
+        Check(NvPipelineWait(p, tickets[k], 10000, &got[k]) == 1, "NvPipelineWait", "frame %d timed out", k);
+    }
+    // A poll straight after submitting finds the job still in the prepare stage
+    Check(early == 0, "NvPipelineWait", "poll on a fresh ticket returned %d", early);
+    Check(NvPipelineWait(p, tickets[0], 0, &polled) == -1 && NvPipelineWait(p, tickets.back() + 1, 0, &polled) == -1,
+        "NvPipelineWait", "collected or unknown ticket accepted");
+
+    for (int k = 0; k < PIPELINE_FRAMES; k++)
+    {
+        NvPipelineResult ref = SyncPipelineJob(c, sp, k);
+        const NvPipelineResult& r = got[k];
+        bool same = r.ticket == tickets[k] && r.winner == ref.winner && r.refined == ref.refined
+            && r.x == ref.x && r.y == ref.y && r.angle == ref.angle && r.scale == ref.scale && r.score == ref.score;
+        Check(same, "NvPipelineSubmit", "frame %d: (%d, %.3f, %.3f, %.3f, %.5f), synchronous (%d, %.3f, %.3f, %.3f, %.5f)",
+            k, r.winner, r.x, r.y, r.angle, r.score, ref.winner, ref.x, ref.y, ref.angle, ref.score);
+    }
+
+    // Queued jobs are dropped; the set may go before the jobs holding it
+    for (int k = 0; k < PIPELINE_DEPTH; k++) submit(k);
+    NvDestroyModelSet(set);
+    NvDestroyPipeline(p);
+}
+
+// Every thread count must reproduce the first one's results exactly
+static void VerifySame(const Results& a, const Results& b, int threads)
+{
+    bool same = a.edgeCount == b.edgeCount && a.winner == b.winner
+        && a.search.x == b.search.x && a.search.y == b.search.y
+        && a.search.angle == b.search.angle && a.search.scale == b.search.scale && a.search.score == b.search.score
+        && a.responseSearch.x == b.responseSearch.x && a.responseSearch.y == b.responseSearch.y
+        && a.responseSearch.angle == b.responseSearch.angle && a.responseSearch.score == b.responseSearch.score
+        && a.scaledSearch.x == b.scaledSearch.x && a.scaledSearch.y == b.scaledSearch.y
+        && a.scaledSearch.scale == b.scaledSearch.scale && a.scaledSearch.score == b.scaledSearch.score
+        && a.instances.size() == b.instances.size()
+        && a.refined.x == b.refined.x && a.refined.y == b.refined.y && a.refined.angle == b.refined.angle
+        && a.tracked.x == b.tracked.x && a.tracked.y == b.tracked.y && a.trackScore == b.trackScore
+        && a.blobCount == b.blobCount && a.blobArea == b.blobArea && a.morphSum == b.morphSum
+        && a.sliceCount == b.sliceCount && a.cloudValid == b.cloudValid && a.caliperEdges == b.caliperEdges
+        && !memcmp(a.bandCounts, b.bandCounts, sizeof(a.bandCounts))
+        && !memcmp(a.histogram, b.histogram, sizeof(a.histogram));
+    for (size_t i = 0; same && i < a.instances.size(); i++)
+        same = a.instances[i].x == b.instances[i].x && a.instances[i].y == b.instances[i].y
+            && a.instances[i].angle == b.instances[i].angle && a.instances[i].score == b.instances[i].score;
+    Check(same, "thread determinism", "results at %d threads differ from the first thread count", threads);
+}
+
+// ─── Timing ─────────────────────────────────────────────────────────────────
+
+static double NowMs()
+{
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <class F>
+static double MedianMs(int reps, F&& f)
+{
+    std::vector<double> t(reps);
+    for (int i = 0; i < reps; i++)
+    {
+        double t0 = NowMs();
+        f();
+        t[i] = NowMs() - t0;
+    }
+    std::sort(t.begin(), t.end());
+    return t[reps / 2];
+}
+
+static const char* const BENCH_NAMES[] =
+{
+    "ComputeGradientNative", "ComputeGradientCompact", "NvBeginLazyGradient", "NvExtractSearchEdges",
+    "NvMatchModels", "NvMatchModels (pruned)", "NvMatchModels (LINE-2D)", "NvMatchModels (scale ±0.3)",
+    "lazy gradient+edges+match", "NvMatchInstances", "NvRefinePose", "NvTrackPose", "NvLabelBlobs",
+    "NvMorphology (tophat 51)", "NvSliceDepth", "NvSlicePointCloud", "NvMeasureCalipers (16)"
+};
+static const int BENCH_COUNT = sizeof(BENCH_NAMES) / sizeof(BENCH_NAMES[0]);
+
+static void TimeExports(Context& c, const Results& r, int reps, double* outMs)
+{
+    std::vector<MatchInstance> inst(PARTS_PER_SCENE * 2);
+    NvModelResult res;
+    int i = 0;
+    outMs[i++] = MedianMs(reps, [&] { RunGradient(c); });
+    outMs[i++] = MedianMs(reps, [&] { RunGradientCompact(c); });
+    outMs[i++] = MedianMs(reps, [&] { NvBeginLazyGradient(c.m, c.sc.gray.data(), c.sc.width, c.sc.height, c.sc.width); });
+    outMs[i++] = MedianMs(reps, [&] { RunSearchEdges(c, c.buf.packed.data()); });
+    outMs[i++] = MedianMs(reps, [&] { RunMatchModels(c, r.edgeCount, c.buf.packed.data(), &res); });
+    NvSetEdgePruning(c.m, MIN_SCORE);
+    outMs[i++] = MedianMs(reps, [&] { RunMatchModels(c, r.edgeCount, c.buf.packed.data(), &res); });
+    NvSetEdgePruning(c.m, 0.0);
+    NvModelDesc response = c.md.Desc();
+    response.voteMode = VOTE_RESPONSE;
+    outMs[i++] = MedianMs(reps, [&] { RunMatchModels(c, r.edgeCount, c.buf.packed.data(), &res, &response); });
+    NvModelDesc scaled = c.scaled.Desc();
+    outMs[i++] = MedianMs(reps, [&] {
+        RunMatchModels(c, r.edgeCount, c.buf.packed.data(), &res, &scaled, WIDE_SCALE_RANGE);
+    });
+    // The lazy plane is rebuilt per frame, so its cost is the whole search
+    outMs[i++] = MedianMs(reps, [&] {
+        const uint32_t* lazy = NvBeginLazyGradient(c.m, c.sc.gray.data(), c.sc.width, c.sc.height, c.sc.width);
+        RunMatchModels(c, RunSearchEdges(c, lazy), lazy, &res);
+    });
+    RunSearchEdges(c, c.buf.packed.data());
+    outMs[i++] = MedianMs(reps, [&] { RunMatchInstances(c, r.edgeCount, inst.data(), (int)inst.size()); });
+    outMs[i++] = MedianMs(reps, [&] {
+        Pose p = { r.search.x, r.search.y, r.search.angle, r.search.scale };
+        RunRefine(c, &p);
+    });
+    outMs[i++] = MedianMs(reps, [&] { Pose p; RunTrack(c, &p); });
+    outMs[i++] = MedianMs(reps, [&] { RunBlobs(c); });
+    outMs[i++] = MedianMs(reps, [&] { RunMorphology(c); });
+    outMs[i++] = MedianMs(reps, [&] { RunSliceDepth(c); });
+    outMs[i++] = MedianMs(reps, [&] { RunSliceCloud(c, nullptr); });
+    outMs[i++] = MedianMs(reps, [&] { RunCalipers(c, 1); });
+}
+
+static void PrintStats()
+{
+    static const char* const stages[] =
+        { "gradient", "search edges", "vote coarse", "vote fine", "pose bank",
+          "score", "instances", "refine", "track", "alloc", "prune" };
+    NvStats s;
+    NvGetStats(&s);
+    if (s.ticksPerSecond <= 0) return;
+    printf("  stage breakdown (all runs above):\n");
+    for (int i = 0; i < (int)(sizeof(stages) / sizeof(stages[0])); i++)
+        if (s.stageCalls[i])
+            printf("    %-14s %8lld calls %10.2f ms\n", stages[i], (long long)s.stageCalls[i],
+                s.stageTicks[i] * 1e3 / s.ticksPerSecond);
+    int64_t evals = s.counters[6], exits = s.counters[7], busy = s.counters[11], span = s.counters[12];
+    printf("    early exits %.1f%% of %lld evaluations, thread utilisation %.1f%%\n",
+        evals ? 100.0 * exits / evals : 0.0, (long long)evals, span ? 100.0 * busy / span : 0.0);
+    int64_t bounded = s.counters[13], rejected = s.counters[14], dropped = s.counters[15];
+    if (bounded)
+        printf("    edge pruning rejected %.1f%% of %lld windows, dropped %lld vote edges\n",
+            100.0 * rejected / bounded, (long long)bounded, (long long)dropped);
+}
+
+// ─── Driver ─────────────────────────────────────────────────────────────────
+
+static std::vector<double> ParseList(const char* s)
+{
+    std::vector<double> v;
+    for (const char* p = s; *p;)
+    {
+        char* end;
+        double d = strtod(p, &end);
+        if (end == p) break;
+        v.push_back(d);
+        p = *end == ',' ? end + 1 : end;
+    }
+    return v;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<double> sizes = { 1, 3, 5, 12 };
+    std::vector<double> threadList;
+    int reps = 5;
+    uint64_t seed = 1;
+    bool checkOnly = false, stats = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (a == "--sizes" && hasValue) sizes = ParseList(argv[++i]);
+        else if (a == "--threads" && hasValue) threadList = ParseList(argv[++i]);
+        else if (a == "--reps" && hasValue) reps = std::max(1, atoi(argv[++i]));
+        else if (a == "--seed" && hasValue) seed = strtoull(argv[++i], nullptr, 10);
+        else if (a == "--check") checkOnly = true;
+        else if (a == "--stats") stats = true;
+        else
+        {
+            printf("usage: %s [--sizes 1,3,5,12] [--threads 1,2,4] [--reps N] [--seed N] [--check] [--stats]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (threadList.empty())
+        for (int t = 1; t <= omp_get_num_procs(); t *= 2) threadList.push_back(t);
+
+    printf("NativeVision %s, %d processors\n", NvGetIsaName(), omp_get_num_procs());
+    Model md = TrainModel();
+    Model scaled = TrainModel(SCALED_MODEL_SCALE, SCALED_MODEL_KEY);
+    printf("model: %zu points (%zu at scale %.2f)\n", md.x.size(), scaled.x.size(), SCALED_MODEL_SCALE);
+
+    // The model written with its full-range pose bank and mapped back
+    const char* modelPath = "nv_bench_model.nvm";
+    NvModelDesc desc = md.Desc();
+    NvModelBankGrid grid = { -180, 360, COARSE_ANGLE_STEP, FINE_ANGLE_STEP, 1.0, SCALE_RANGE, SCALE_STEP };
+    NvModelFile* modelFile = NvWriteModelFile(modelPath, &desc, NUM_GRAD_BINS, nullptr, nullptr, nullptr,
+        121, 81, &grid) ? NvOpenModelFile(modelPath) : nullptr;
+    NvModelFileInfo info = {};
+    bool mappedOk = modelFile && NvGetModelFileInfo(modelFile, &info) && info.modelCount == desc.modelCount
+        && info.poseCount > 0 && memcmp(info.x, desc.x, desc.modelCount * sizeof(float)) == 0
+        && memcmp(info.binIndices, desc.binIndices, desc.modelCount * sizeof(int)) == 0;
+    Check(mappedOk, "NvOpenModelFile", "model file did not round-trip");
+    NvModelDesc mapped = { info.x, info.y, info.dx, info.dy, info.binOffsets, info.binIndices,
+                           info.modelCount, info.modelKey, 0, 0 };
+
+    for (size_t si = 0; si < sizes.size(); si++)
+    {
+        Scene sc = MakeScene(sizes[si], seed + si);
+        size_t pixels = (size_t)sc.width * sc.height;
+        printf("\nscene %.1f MP (%dx%d)\n", pixels / 1e6, sc.width, sc.height);
+
+        Buffers buf;
+        buf.dx.resize(pixels);
+        buf.dy.resize(pixels);
+        buf.mag.resize(pixels);
+        buf.packed.resize(pixels);
+        buf.packedMag.resize(pixels);
+        buf.seX.resize(pixels);
+        buf.seY.resize(pixels);
+        buf.seBin.resize(pixels);
+        buf.binary.resize(pixels);
+        buf.morph.resize(pixels);
+        buf.depth.resize(pixels);
+        buf.cloud.resize(pixels * 3);
+        buf.slice.resize(pixels);
+        buf.calipers = MakeCalipers(sc);
+        buf.profiles.resize((size_t)CALIPER_COUNT * CALIPER_STRIDE);
+        buf.caliperEdges.resize((size_t)CALIPER_COUNT * CALIPER_EDGES);
+        buf.caliperCounts.resize(CALIPER_COUNT);
+        for (size_t i = 0; i < pixels; i++)
+        {
+            float z = i % DEPTH_HOLE == 0 ? NAN : sc.gray[i] * 2.0f;
+            buf.depth[i] = z;
+            buf.cloud[3 * i] = (float)(i % sc.width);
+            buf.cloud[3 * i + 1] = (float)(i / sc.width);
+            buf.cloud[3 * i + 2] = z;
+        }
+
+        std::vector<std::vector<double>> ms(threadList.size(), std::vector<double>(BENCH_COUNT));
+        Results first;
+        int failuresBefore = g_failures;
+        if (stats)
+        {
+            NvSetStatsEnabled(1);
+            NvResetStats();
+        }
+        for (size_t ti = 0; ti < threadList.size(); ti++)
+        {
+            int threads = (int)threadList[ti];
+            omp_set_num_threads(threads);
+            NvMatcher* m = NvCreateMatcher(VoteWidth(sc), VoteHeight(sc), (int)std::max(md.x.size(), scaled.x.size()), 1024);
+            NvBlobLabeler* labeler = NvCreateBlobLabeler();
+            Context c = { sc, md, scaled, m, labeler, buf, mappedOk ? &mapped : nullptr };
+
+            Results r = RunAll(c);
+            if (ti == 0)
+            {
+                VerifyResults(c, r);
+                VerifyEarlyExit(c);
+                VerifySharedFrame(c);
+                VerifyPipeline(c);
+                first = r;
+            }
+            else
+            {
+                VerifySame(first, r, threads);
+            }
+            if (!checkOnly) TimeExports(c, r, reps, ms[ti].data());
+
+            NvDestroyBlobLabeler(labeler);
+            NvDestroyMatcher(m);
+        }
+        printf("  checks: %s\n", g_failures == failuresBefore ? "pass" : "FAIL");
+        if (stats)
+        {
+            PrintStats();
+            NvSetStatsEnabled(0);
+        }
+        if (checkOnly) continue;
+
+        printf("  %-24s", "median ms / threads");
+        for (double t : threadList) printf("%10d", (int)t);
+        printf("\n");
+        for (int b = 0; b < BENCH_COUNT; b++)
+        {
+            printf("  %-24s", BENCH_NAMES[b]);
+            for (size_t ti = 0; ti < threadList.size(); ti++) printf("%10.3f", ms[ti][b]);
+            printf("\n");
+        }
+    }
+
+    if (modelFile) NvCloseModelFile(modelFile);
+    remove(modelPath);
+
+    printf("\n%s (%d failed checks)\n", g_failures ? "FAILED" : "PASSED", g_failures);
+    return g_failures ? 1 : 0;
+}
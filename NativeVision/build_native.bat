@@ -2,7 +2,8 @@
 setlocal
 
 REM ── NativeVision build script ──
-REM Compiles NativeVision.cpp → NativeVision.dll using MSVC cl.exe with AVX2+FMA
+REM Compiles NativeVision.cpp → NativeVision.dll using MSVC cl.exe
+REM No /arch switch: SIMD kernels (SSE4.1 / AVX2 / AVX-512) are picked at load time via CPUID
 
 set "CL_EXE=C:\Program Files\Microsoft Visual Studio\18\Insiders\VC\Tools\MSVC\14.50.35717\bin\Hostx64\x64\cl.exe"
 set "MSVC_INC=C:\Program Files\Microsoft Visual Studio\18\Insiders\VC\Tools\MSVC\14.50.35717\include"
@@ -23,7 +24,7 @@ pushd "%~dp0"
 
 echo Building NativeVision.dll ...
 
-"%CL_EXE%" /O2 /arch:AVX2 /fp:fast /LD /EHsc /MD /openmp ^
+"%CL_EXE%" /O2 /fp:fast /LD /EHsc /MD /openmp ^
     /I"%MSVC_INC%" ^
     /I"%SDK_INC%\ucrt" ^
     /I"%SDK_INC%\um" ^
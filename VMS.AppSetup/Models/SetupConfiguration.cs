@@ -18,6 +18,10 @@ namespace VMS.AppSetup.Models
         public string ApplicationName { get; set; } = "BODA Vision System";
         public string SystemIpAddress { get; set; } = "192.168.0.1";
 
+        // Page 2: Native Vision workers (0 = all processors)
+        public int NativeWorkerCores { get; set; }
+        public bool PinNativeWorkers { get; set; }
+
         // Page 3: Camera Mode
         public CameraMode CameraMode { get; set; } = CameraMode.Virtual;
         public List<CameraConfiguration> Cameras { get; set; } = new();
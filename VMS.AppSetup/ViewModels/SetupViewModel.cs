@@ -34,6 +34,12 @@ namespace VMS.AppSetup.ViewModels
         [ObservableProperty]
         private string _systemIpAddress = "192.168.0.1";
 
+        [ObservableProperty]
+        private int _nativeWorkerCores;
+
+        [ObservableProperty]
+        private bool _pinNativeWorkers;
+
         // Page 3: Camera Settings
         [ObservableProperty]
         private CameraMode _cameraMode = CameraMode.Virtual;
@@ -147,6 +153,8 @@ namespace VMS.AppSetup.ViewModels
             {
                 ApplicationName = config.ApplicationName;
                 SystemIpAddress = config.SystemIpAddress;
+                NativeWorkerCores = config.NativeWorkerCores;
+                PinNativeWorkers = config.PinNativeWorkers;
                 CameraMode = config.CameraMode;
 
                 // PLC Vendor & Communication
@@ -324,6 +332,8 @@ namespace VMS.AppSetup.ViewModels
             {
                 ApplicationName = ApplicationName,
                 SystemIpAddress = SystemIpAddress,
+                NativeWorkerCores = NativeWorkerCores,
+                PinNativeWorkers = PinNativeWorkers,
                 CameraMode = CameraMode,
                 Cameras = Cameras.ToList(),
 
@@ -17,7 +17,9 @@ namespace VMS.Camera.Models
         // ── 헤더 레이아웃 ──
         public const int HeaderSize = 64;
         public const uint Magic = 0x564D5346; // "VMSF"
-        public const uint Version = 1;
+        public const uint Version = 3;              // CommitTag가 있는 프레임
+        public const uint VersionUntagged = 1;      // 이전 Writer: 오프셋 60은 Reserved(0), Mutex 아래에서만 유효
+        public const uint VersionSlotted = 2;
 
         // DataFlags
         public const uint FlagHas2D = 0x01;
@@ -37,6 +39,25 @@ namespace VMS.Camera.Models
         public const int OffsetGridWidth = 48;
         public const int OffsetGridHeight = 52;
         public const int OffsetNameLengthBytes = 56;
-        public const int OffsetReserved = 60;
+        public const int OffsetCommitTag = 60;
+
+        // ── 더블 버퍼 슬롯 레이아웃 (Version 2) ──
+        // 오프셋 0: 64B 제어 블록 (Magic, Version, 슬롯 정보, 최신 FrameCounter)
+        // 오프셋 SlotAlignment + i × SlotStride: 슬롯 i, 각각 완전한 Version 3 프레임 (헤더 + 바디)
+        // Writer는 Reader가 처리 중인 슬롯과 다른 슬롯에 쓴 뒤 PublishedSlot을 갱신.
+        //
+        // Torn 프레임 검출: Writer는 슬롯을 쓰기 전에 CommitTag를 0으로 지우고,
+        // 헤더와 바디를 모두 쓴 후 FrameCounter의 하위 32비트를 기록.
+        // CommitTag == (uint)FrameCounter인 동안만 프레임이 유효함.
+        public const int SlotCount = 2;
+        public const int SlotAlignment = 4096;
+        public const int OffsetSlotCount = 8;
+        public const int OffsetSlotStride = 12;
+        public const int OffsetPublishedSlot = 16;
+        public const int OffsetLatestFrameCounter = OffsetFrameCounter;
+
+        public const long SlotStride = ((MmfCapacity - SlotAlignment) / SlotCount) & ~(long)(SlotAlignment - 1);
+
+        public static long SlotOffset(int slot) => SlotAlignment + slot * SlotStride;
     }
 }
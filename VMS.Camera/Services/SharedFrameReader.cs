@@ -79,6 +79,7 @@ namespace VMS.Camera.Services
         /// <summary>
         /// MMF에서 프레임 읽기 (deep copy).
         /// skipIfSameFrame=true면 이전과 동일한 FrameCounter일 때 null 반환.
+        /// 복사 도중 Writer가 슬롯을 덮어쓰면 (CommitTag 불일치) null 반환.
         /// </summary>
         public SharedFrameData? TryReadFrame(bool skipIfSameFrame = true)
         {
@@ -96,26 +97,41 @@ namespace VMS.Camera.Services
                 uint magic = accessor.ReadUInt32(SharedFrameConstants.OffsetMagic);
                 if (magic != SharedFrameConstants.Magic) return null;
 
+                // ── 프레임 위치: 더블 버퍼면 게시된 슬롯 ──
                 uint version = accessor.ReadUInt32(SharedFrameConstants.OffsetVersion);
-                if (version != SharedFrameConstants.Version) return null;
+                long frameOffset = 0;
+                if (version == SharedFrameConstants.VersionSlotted)
+                {
+                    int slot = accessor.ReadInt32(SharedFrameConstants.OffsetPublishedSlot);
+                    if (slot < 0 || slot >= SharedFrameConstants.SlotCount) return null;
+                    frameOffset = SharedFrameConstants.SlotOffset(slot);
+                    version = accessor.ReadUInt32(frameOffset + SharedFrameConstants.OffsetVersion);
+                }
+                // 이전 Writer의 Version 1 프레임은 CommitTag가 없음 (Mutex로만 보호, 단일 레이아웃)
+                bool tagged = version == SharedFrameConstants.Version;
+                if (!tagged && (version != SharedFrameConstants.VersionUntagged || frameOffset != 0)) return null;
 
-                uint flags = accessor.ReadUInt32(SharedFrameConstants.OffsetDataFlags);
-                long timestamp = accessor.ReadInt64(SharedFrameConstants.OffsetTimestamp);
-                long frameCounter = accessor.ReadInt64(SharedFrameConstants.OffsetFrameCounter);
+                uint commitTag = tagged ? accessor.ReadUInt32(frameOffset + SharedFrameConstants.OffsetCommitTag) : 0;
+                Thread.MemoryBarrier();
+                uint flags = accessor.ReadUInt32(frameOffset + SharedFrameConstants.OffsetDataFlags);
+                long timestamp = accessor.ReadInt64(frameOffset + SharedFrameConstants.OffsetTimestamp);
+                long frameCounter = accessor.ReadInt64(frameOffset + SharedFrameConstants.OffsetFrameCounter);
 
+                if (tagged && (commitTag == 0 || commitTag != (uint)frameCounter))
+                    return null; // 쓰는 중
                 if (skipIfSameFrame && frameCounter == _lastFrameCounter)
                     return null;
 
-                int imgW = accessor.ReadInt32(SharedFrameConstants.OffsetImageWidth);
-                int imgH = accessor.ReadInt32(SharedFrameConstants.OffsetImageHeight);
-                int imgC = accessor.ReadInt32(SharedFrameConstants.OffsetImageChannels);
-                int imgStride = accessor.ReadInt32(SharedFrameConstants.OffsetImageStride);
-                int ptCount = accessor.ReadInt32(SharedFrameConstants.OffsetPointCount);
-                int gridW = accessor.ReadInt32(SharedFrameConstants.OffsetGridWidth);
-                int gridH = accessor.ReadInt32(SharedFrameConstants.OffsetGridHeight);
-                int nameLenBytes = accessor.ReadInt32(SharedFrameConstants.OffsetNameLengthBytes);
+                int imgW = accessor.ReadInt32(frameOffset + SharedFrameConstants.OffsetImageWidth);
+                int imgH = accessor.ReadInt32(frameOffset + SharedFrameConstants.OffsetImageHeight);
+                int imgC = accessor.ReadInt32(frameOffset + SharedFrameConstants.OffsetImageChannels);
+                int imgStride = accessor.ReadInt32(frameOffset + SharedFrameConstants.OffsetImageStride);
+                int ptCount = accessor.ReadInt32(frameOffset + SharedFrameConstants.OffsetPointCount);
+                int gridW = accessor.ReadInt32(frameOffset + SharedFrameConstants.OffsetGridWidth);
+                int gridH = accessor.ReadInt32(frameOffset + SharedFrameConstants.OffsetGridHeight);
+                int nameLenBytes = accessor.ReadInt32(frameOffset + SharedFrameConstants.OffsetNameLengthBytes);
 
-                long offset = SharedFrameConstants.HeaderSize;
+                long offset = frameOffset + SharedFrameConstants.HeaderSize;
                 var data = new SharedFrameData
                 {
                     FrameCounter = frameCounter,
@@ -130,13 +146,15 @@ namespace VMS.Camera.Services
                     accessor.ReadArray(offset, buffer, 0, totalBytes);
                     offset += totalBytes;
 
-                    var matType = imgC switch
+                    MatType matType;
+                    switch (imgC)
                     {
-                        1 => MatType.CV_8UC1,
-                        3 => MatType.CV_8UC3,
-                        4 => MatType.CV_8UC4,
-                        _ => MatType.CV_8UC3
-                    };
+                        case 1: matType = MatType.CV_8UC1; break;
+                        case 3: matType = MatType.CV_8UC3; break;
+                        case 4: matType = MatType.CV_8UC4; break;
+                        default: return null; // 지원하지 않는 채널 수 (손상된 헤더)
+                    }
+                    if (imgStride < imgW * imgC) return null;
 
                     var mat = new Mat(imgH, imgW, matType);
                     Marshal.Copy(buffer, 0, mat.Data, totalBytes);
@@ -194,6 +212,14 @@ namespace VMS.Camera.Services
                     };
                 }
 
+                // ── 복사 중 덮어쓰기 검증 ──
+                Thread.MemoryBarrier();
+                if (tagged && accessor.ReadUInt32(frameOffset + SharedFrameConstants.OffsetCommitTag) != commitTag)
+                {
+                    data.Image2D?.Dispose();
+                    return null;
+                }
+
                 _lastFrameCounter = frameCounter;
                 return data;
             }
@@ -43,6 +43,7 @@ namespace VMS.Camera.Services
         /// <summary>
         /// AcquisitionResult를 MMF에 직렬화.
         /// Mutex를 100ms 내에 획득하지 못하면 프레임 드롭 (카메라 루프 차단 방지).
+        /// Mutex 없이 읽는 소비자를 위해 CommitTag로 쓰기 완료를 표시.
         /// </summary>
         public void WriteFrame(AcquisitionResult result)
         {
@@ -66,6 +67,8 @@ namespace VMS.Camera.Services
                     flags |= SharedFrameConstants.FlagHas3D;
 
                 var counter = Interlocked.Increment(ref _frameCounter);
+                if ((uint)counter == 0)
+                    counter = Interlocked.Increment(ref _frameCounter); // CommitTag 0 = 쓰는 중
 
                 // ── 2D 이미지 정보 ──
                 int imgW = 0, imgH = 0, imgC = 0, imgStride = 0;
@@ -100,6 +103,10 @@ namespace VMS.Camera.Services
                 if (bodySize > SharedFrameConstants.MmfCapacity)
                     return; // 용량 초과 시 스킵
 
+                // ── CommitTag 무효화: 이후 Reader는 이 프레임을 torn으로 판정 ──
+                accessor.Write(SharedFrameConstants.OffsetCommitTag, 0u);
+                Thread.MemoryBarrier();
+
                 // ── 헤더 쓰기 (64B) ──
                 accessor.Write(SharedFrameConstants.OffsetMagic, SharedFrameConstants.Magic);
                 accessor.Write(SharedFrameConstants.OffsetVersion, SharedFrameConstants.Version);
@@ -114,7 +121,6 @@ namespace VMS.Camera.Services
                 accessor.Write(SharedFrameConstants.OffsetGridWidth, gridW);
                 accessor.Write(SharedFrameConstants.OffsetGridHeight, gridH);
                 accessor.Write(SharedFrameConstants.OffsetNameLengthBytes, nameBytes.Length);
-                accessor.Write(SharedFrameConstants.OffsetReserved, 0);
 
                 offset = SharedFrameConstants.HeaderSize;
 
@@ -163,6 +169,10 @@ namespace VMS.Camera.Services
                     accessor.WriteArray(offset, colorBytes, 0, colorBytes.Length);
                 }
 
+                // ── 커밋 ──
+                Thread.MemoryBarrier();
+                accessor.Write(SharedFrameConstants.OffsetCommitTag, (uint)counter);
+
                 // ── 새 프레임 알림 ──
                 _frameReadyEvent?.Set();
             }
@@ -16,6 +16,16 @@ namespace VMS.VisionSetup.Models
         /// </summary>
         public Vector3?[] PixelTo3D { get; set; } = Array.Empty<Vector3?>();
 
+        /// <summary>
+        /// Number of points with a valid (non-NaN) height.
+        /// </summary>
+        public int ValidPointCount { get; set; }
+
+        /// <summary>
+        /// Number of points in [ZMin, ZMax] per height-map grey level; empty when the native slicer is unavailable.
+        /// </summary>
+        public int[] HeightHistogram { get; set; } = Array.Empty<int>();
+
         public Vector3? GetPoint3D(int u, int v)
         {
             if (u < 0 || u >= Width || v < 0 || v >= Height)
@@ -117,6 +117,14 @@ namespace VMS.VisionSetup.Models
                     ["MaxScale"] = "검색할 최대 스케일. 1.1 = 110% 크기.",
                     ["ScaleStep"] = "스케일 검색 간격. 작을수록 정밀하지만 보정 단계에서 계산량 증가.",
                     ["ScoreThreshold"] = "최종 그래디언트 내적 점수 임계값 (0~1). 이 값 이상이면 매칭 성공.\n• 0.5: 느슨한 매칭\n• 0.7: 일반적\n• 0.85: 엄격한 매칭",
+                    ["MaxInstances"] = "한 이미지에서 검출할 최대 패턴 개수. 트레이처럼 동일 부품이 여러 개 있을 때 사용합니다.\n• 1: 최고 점수 1개만 검출 (기본)\n• 2 이상: 서로 겹치지 않는 매칭을 점수 순으로 최대 N개 검출 (NativeVision 필요)",
+                    ["UseTracking"] = "추적 모드. 한 번 검출된 부품은 다음 프레임에서 직전 위치 주변 창만 검색합니다 (Hough Voting 생략).\n• 점수가 ScoreThreshold 미만이면 자동으로 전체 검색으로 돌아갑니다\n• MaxInstances=1, NativeVision 필요",
+                    ["TrackMaxShift"] = "추적 시 프레임 간 최대 이동량 (픽셀). 부품 이동 속도보다 약간 크게 설정하세요.",
+                    ["TrackMaxRotation"] = "추적 시 프레임 간 최대 회전량 (도).",
+                    ["TrackMaxScaleChange"] = "추적 시 프레임 간 최대 스케일 변화. 0이면 직전 스케일을 유지합니다 (MinScale < MaxScale일 때만 적용).",
+                    ["Phase1Engine"] = "선택한 모델의 1단계(후보 위치 검색) 방식.\n• HoughVoting: 검색 이미지의 에지가 중심 위치에 투표 (기본). 에지가 적은 이미지에서 빠름\n• ResponseMaps: LINE-2D 방식의 방향 응답 맵으로 모든 위치를 점수화. 계산량이 모델 포인트 수에만 비례하므로 배경 에지가 많은 이미지에서 유리\n• NativeVision 필요, MaxInstances=1에서만 적용",
+                    ["MaxThreads"] = "한 번의 검색이 사용할 최대 스레드 수.\n• 0: 자동 (동시에 실행 중인 검색들과 코어를 공평하게 나눔)\n• 여러 카메라/툴을 동시에 실행할 때 값을 제한하면 서로 코어를 빼앗지 않습니다",
+                    ["UseEdgePruning"] = "에지 밀도 가지치기. 에지가 너무 적어 ScoreThreshold에 도달할 수 없는 검색 창을 투표/점수 계산 전에 건너뜁니다.\n• 에지가 드문 이미지에서 빠름\n• 추정 기반이므로 흐리거나 일부 가려진 부품을 놓칠 수 있어 기본값은 꺼짐\n• NativeVision 필요",
                     ["UseContrastInvariant"] = "대비 불변 매칭 활성화. 활성화하면 조명 변화로 인한 대비 차이에 강건해집니다.\n그래디언트 방향만 비교하여 밝기 변화에 영향을 덜 받습니다.",
                     ["IsAutoTuneEnabled"] = "자동 튜닝 활성화. 활성화하면 매칭 실행 시 파라미터를 자동으로 최적화합니다.\n초기 설정이 어려운 경우 활성화하면 도움이 됩니다.",
                     ["CurvatureWeight"] = "곡률 가중치 (0~1). 에지 포인트 샘플링 시 곡률이 높은 부분(코너, 곡선)에 가중치를 부여합니다.\n• 0: 균일 샘플링\n• 0.5: 곡률 부분 가중 (권장)\n• 1.0: 곡률 부분만 집중",
@@ -132,6 +132,13 @@ namespace VMS.VisionSetup.Services
                     config.Parameters["SearchRegionHeight"] = match.SearchRegionHeight;
                     config.Parameters["UseContrastInvariant"] = match.UseContrastInvariant;
                     config.Parameters["CurvatureWeight"] = match.CurvatureWeight;
+                    config.Parameters["MaxInstances"] = match.MaxInstances;
+                    config.Parameters["UseTracking"] = match.UseTracking;
+                    config.Parameters["TrackMaxShift"] = match.TrackMaxShift;
+                    config.Parameters["TrackMaxRotation"] = match.TrackMaxRotation;
+                    config.Parameters["TrackMaxScaleChange"] = match.TrackMaxScaleChange;
+                    config.Parameters["MaxThreads"] = match.MaxThreads;
+                    config.Parameters["UseEdgePruning"] = match.UseEdgePruning;
                     config.Parameters["IsAutoTuneEnabled"] = match.IsAutoTuneEnabled;
 
                     // Serialize trained models (TemplateImage as base64 PNG)
@@ -141,7 +148,8 @@ namespace VMS.VisionSetup.Services
                         var modelData = new Dictionary<string, object>
                         {
                             ["Name"] = model.Name,
-                            ["IsEnabled"] = model.IsEnabled
+                            ["IsEnabled"] = model.IsEnabled,
+                            ["Phase1Engine"] = model.Phase1Engine.ToString()
                         };
 
                         if (model.TemplateImage != null && !model.TemplateImage.Empty())
@@ -593,6 +601,20 @@ namespace VMS.VisionSetup.Services
                 tool.UseContrastInvariant = GetBool(uci);
             if (p.TryGetValue("CurvatureWeight", out var cw))
                 tool.CurvatureWeight = GetDouble(cw);
+            if (p.TryGetValue("MaxInstances", out var maxInst))
+                tool.MaxInstances = GetInt(maxInst);
+            if (p.TryGetValue("UseTracking", out var ut))
+                tool.UseTracking = GetBool(ut);
+            if (p.TryGetValue("TrackMaxShift", out var tms))
+                tool.TrackMaxShift = GetDouble(tms);
+            if (p.TryGetValue("TrackMaxRotation", out var tmr))
+                tool.TrackMaxRotation = GetDouble(tmr);
+            if (p.TryGetValue("TrackMaxScaleChange", out var tmsc))
+                tool.TrackMaxScaleChange = GetDouble(tmsc);
+            if (p.TryGetValue("MaxThreads", out var mth))
+                tool.MaxThreads = GetInt(mth);
+            if (p.TryGetValue("UseEdgePruning", out var uep))
+                tool.UseEdgePruning = GetBool(uep);
             if (p.TryGetValue("IsAutoTuneEnabled", out var iate))
                 tool.IsAutoTuneEnabled = GetBool(iate);
 
@@ -604,32 +626,37 @@ namespace VMS.VisionSetup.Services
                 {
                     string modelName = "";
                     bool modelEnabled = true;
+                    var modelEngine = Phase1Engine.HoughVoting;
                     Mat? templateImage = null;
+                    byte[]? templateBytes = null;
 
                     if (entry.TryGetValue("Name", out var nameVal))
                         modelName = GetString(nameVal);
                     if (entry.TryGetValue("IsEnabled", out var enabledVal))
                         modelEnabled = GetBool(enabledVal);
+                    if (entry.TryGetValue("Phase1Engine", out var engineVal))
+                        modelEngine = Enum.Parse<Phase1Engine>(GetString(engineVal));
 
                     if (entry.TryGetValue("TemplateImageBase64", out var b64Val))
                     {
                         var b64 = GetString(b64Val);
                         if (!string.IsNullOrEmpty(b64))
                         {
-                            var pngBytes = Convert.FromBase64String(b64);
-                            templateImage = Cv2.ImDecode(pngBytes, ImreadModes.Unchanged);
+                            templateBytes = Convert.FromBase64String(b64);
+                            templateImage = Cv2.ImDecode(templateBytes, ImreadModes.Unchanged);
                         }
                     }
 
                     if (templateImage != null && !templateImage.Empty())
                     {
-                        tool.TrainPattern(templateImage, null);
+                        tool.TrainPatternCached(templateImage, templateBytes!);
                         templateImage.Dispose();
                         var lastModel = tool.Models.LastOrDefault();
                         if (lastModel != null)
                         {
                             lastModel.Name = modelName;
                             lastModel.IsEnabled = modelEnabled;
+                            lastModel.Phase1Engine = modelEngine;
                         }
                     }
                 }
@@ -995,26 +995,51 @@ namespace VMS.VisionSetup.Services
             float range = zMax - zMin;
             if (range <= 0) range = 1f;
 
-            var heightMap = new Mat(h, w, MatType.CV_8UC1, Scalar.All(0));
             var pixelTo3D = new Vector3?[w * h];
-
-            unsafe
+            var positions = pointCloud.Positions;
+            Mat heightMap;
+            int[] histogram = Array.Empty<int>();
+            int validCount;
+
+            // 높이 맵 + 히스토그램을 네이티브 한 패스로 (Y축 높이, NaN은 무효 포인트)
+            if (NativeDepthSlicing.TrySlicePointCloud(pointCloud, 1, zRef, zMin, zMin + range,
+                    null, true, false, out var slice))
+            {
+                heightMap = slice.HeightMap;
+                histogram = slice.Histogram;
+                validCount = slice.ValidCount;
+                for (int i = 0; i < w * h; i++)
+                {
+                    if (!float.IsNaN(positions[i].Y))
+                        pixelTo3D[i] = positions[i];
+                }
+            }
+            else
             {
-                byte* ptr = (byte*)heightMap.Data;
-                var positions = pointCloud.Positions;
+                // 네이티브 커널과 동일: round((h − zMin)·scale)을 0‥255로 포화, NaN은 0이고 무효
+                heightMap = new Mat(h, w, MatType.CV_8UC1, Scalar.All(0));
+                validCount = 0;
+                float scale = range > 0.0001f ? 255f / range : 0f;
 
-                for (int row = 0; row < h; row++)
+                unsafe
                 {
-                    for (int col = 0; col < w; col++)
+                    byte* ptr = (byte*)heightMap.Data;
+
+                    for (int row = 0; row < h; row++)
                     {
-                        int idx = row * w + col;
-                        var pos = positions[idx];
-                        pixelTo3D[idx] = pos;
-
-                        float normalizedY = pos.Y - zRef;
-                        float t = (normalizedY - zMin) / range;
-                        t = Math.Clamp(t, 0f, 1f);
-                        ptr[idx] = (byte)(t * 255f);
+                        for (int col = 0; col < w; col++)
+                        {
+                            int idx = row * w + col;
+                            var pos = positions[idx];
+                            if (float.IsNaN(pos.Y)) continue;
+
+                            pixelTo3D[idx] = pos;
+                            validCount++;
+
+                            float v = (pos.Y - zRef - zMin) * scale;
+                            v = Math.Clamp(v, 0f, 255f);
+                            ptr[idx] = (byte)MathF.Round(v);
+                        }
                     }
                 }
             }
@@ -1026,7 +1051,9 @@ namespace VMS.VisionSetup.Services
                 ZReference = zRef,
                 ZMin = zMin,
                 ZMax = zMax,
-                PixelTo3D = pixelTo3D
+                PixelTo3D = pixelTo3D,
+                ValidPointCount = validCount,
+                HeightHistogram = histogram
             };
 
             return (heightMap, metadata);
@@ -88,6 +88,15 @@ namespace VMS.VisionSetup.ViewModels.ToolSettings
         public int MaxModelPoints { get => TypedTool.MaxModelPoints; set => TypedTool.MaxModelPoints = value; }
         public bool UseContrastInvariant { get => TypedTool.UseContrastInvariant; set => TypedTool.UseContrastInvariant = value; }
         public double CurvatureWeight { get => TypedTool.CurvatureWeight; set => TypedTool.CurvatureWeight = value; }
+        public int MaxInstances { get => TypedTool.MaxInstances; set => TypedTool.MaxInstances = value; }
+        public int MaxThreads { get => TypedTool.MaxThreads; set => TypedTool.MaxThreads = value; }
+        public bool UseEdgePruning { get => TypedTool.UseEdgePruning; set => TypedTool.UseEdgePruning = value; }
+
+        // Tracking
+        public bool UseTracking { get => TypedTool.UseTracking; set => TypedTool.UseTracking = value; }
+        public double TrackMaxShift { get => TypedTool.TrackMaxShift; set => TypedTool.TrackMaxShift = value; }
+        public double TrackMaxRotation { get => TypedTool.TrackMaxRotation; set => TypedTool.TrackMaxRotation = value; }
+        public double TrackMaxScaleChange { get => TypedTool.TrackMaxScaleChange; set => TypedTool.TrackMaxScaleChange = value; }
 
         // Auto-tune
         public bool IsAutoTuneEnabled { get => TypedTool.IsAutoTuneEnabled; set => TypedTool.IsAutoTuneEnabled = value; }
@@ -5,6 +5,8 @@ using System;
 using System.Collections.Generic;
 using System.Diagnostics;
 using System.Linq;
+using System.Runtime.InteropServices;
+using System.Threading.Tasks;
 
 namespace VMS.VisionSetup.VisionTools.BlobAnalysis
 {
@@ -12,8 +14,69 @@ namespace VMS.VisionSetup.VisionTools.BlobAnalysis
     /// Blob 분석 도구 (Cognex VisionPro CogBlobTool 대체)
     /// 이진화된 이미지에서 객체(Blob)를 검출하고 분석
     /// </summary>
-    public class BlobTool : VisionToolBase
+    public unsafe class BlobTool : VisionToolBase
     {
+        #region Native Interop
+
+        [StructLayout(LayoutKind.Sequential)]
+        private struct BlobStats
+        {
+            public int Area;                     // 픽셀 수
+            public int Left, Top, Right, Bottom; // 경계 상자 (포함)
+            public int Runs;
+            public double CenterX, CenterY;      // 픽셀 무게중심
+            public double Mu20, Mu11, Mu02;      // 2차 중심 모멘트 / 면적
+        }
+
+        private static class NativeVision
+        {
+            private const string DllName = NativeVisionLibrary.DllName;
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern LabelerHandle NvCreateBlobLabeler();
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvDestroyBlobLabeler(IntPtr labeler);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvLabelBlobs(
+                LabelerHandle labeler,
+                byte* gray, int width, int height, int stride,
+                int threshold, int invert,
+                byte* binary, int binaryStride,
+                int externalOnly, double minSpanArea);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvCopyBlobStats(LabelerHandle labeler, BlobStats* outStats);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvRenderBlobMask(LabelerHandle labeler, int index, byte* mask, int maskStride, int pad);
+
+            private static readonly bool _isAvailable = NativeVisionLibrary.HasExport("NvLabelBlobs");
+
+            public static bool IsAvailable => _isAvailable;
+        }
+
+        /// <summary>
+        /// 네이티브 라벨러 (run 목록 등 작업 버퍼 보유). 도구가 수집될 때 finalizer가 해제.
+        /// </summary>
+        private sealed class LabelerHandle : SafeHandle
+        {
+            public LabelerHandle() : base(IntPtr.Zero, true) { }
+
+            public override bool IsInvalid => handle == IntPtr.Zero;
+
+            protected override bool ReleaseHandle()
+            {
+                NativeVision.NvDestroyBlobLabeler(handle);
+                return true;
+            }
+        }
+
+        private LabelerHandle? _labeler;
+
+        #endregion
+
         // Threshold 설정 (내부 이진화용)
         private bool _useInternalThreshold = true;
         public bool UseInternalThreshold
@@ -268,42 +331,31 @@ namespace VMS.VisionSetup.VisionTools.BlobAnalysis
                 else
                     grayImage = workImage.Clone();
 
-                // 이진화 처리
-                if (UseInternalThreshold)
+                // 이진화 + Blob 검출
+                // 네이티브 (External): 이진화·라벨링·면적/모멘트 집계를 한 번에, 통과한 Blob만 윤곽 추적
+                // 그 외: Threshold → FindContours → 윤곽별 특성 계산
+                List<BlobResult> blobs;
+                if (RetrievalMode == RetrievalModes.External && NativeVision.IsAvailable &&
+                    grayImage.Type() == MatType.CV_8UC1)
                 {
-                    var threshType = SegmentationPolarity == SegmentationPolarity.DarkOnLight
-                        ? ThresholdTypes.BinaryInv : ThresholdTypes.Binary;
-                    Cv2.Threshold(grayImage, binaryImage, ThresholdValue, 255, threshType);
+                    blobs = DetectBlobsNative(grayImage, offsetX, offsetY, out binaryImage);
                 }
                 else
                 {
-                    binaryImage = grayImage.Clone();
-                    if (SegmentationPolarity == SegmentationPolarity.DarkOnLight)
-                        Cv2.BitwiseNot(binaryImage, binaryImage);
-                }
-
-                // Contour 검출 (잘라낸 이미지 기준 상대 좌표 반환, 0,0 기준)
-                Cv2.FindContours(binaryImage, out Point[][] contours, out HierarchyIndex[] hierarchy,
-                    RetrievalMode, ApproximationMode);
-
-                var blobs = new List<BlobResult>();
-                int blobId = 0;
-
-                foreach (var contour in contours)
-                {
-                    // 상대 좌표(ROI 기준)를 절대 좌표(원본 이미지 기준)로 즉시 변환
-                    // 이후 CalculateBlobProperties가 반환하는 모든 속성
-                    // (CenterX, CenterY, BoundingRect 등)이 절대 좌표로 저장됨
-                    Point[] absoluteContour = OffsetPoints(contour, offsetX, offsetY);
-                    var blob = CalculateBlobProperties(absoluteContour, blobId);
-
-                    if (blob.Area >= MinArea && blob.Area <= MaxArea &&
-                        blob.Circularity >= MinCircularity && blob.Circularity <= MaxCircularity &&
-                        blob.Convexity >= MinConvexity)
+                    if (UseInternalThreshold)
+                    {
+                        var threshType = SegmentationPolarity == SegmentationPolarity.DarkOnLight
+                            ? ThresholdTypes.BinaryInv : ThresholdTypes.Binary;
+                        Cv2.Threshold(grayImage, binaryImage, ThresholdValue, 255, threshType);
+                    }
+                    else
                     {
-                        blobs.Add(blob);
-                        blobId++;
+                        binaryImage = grayImage.Clone();
+                        if (SegmentationPolarity == SegmentationPolarity.DarkOnLight)
+                            Cv2.BitwiseNot(binaryImage, binaryImage);
                     }
+
+                    blobs = DetectBlobsWithContours(binaryImage, offsetX, offsetY);
                 }
 
                 // 결과 정렬 및 최대 개수 제한
@@ -455,6 +507,135 @@ namespace VMS.VisionSetup.VisionTools.BlobAnalysis
             return result;
         }
 
+        /// <summary>
+        /// 기존 경로: 이진 영상 전체 FindContours → 윤곽마다 특성 계산 후 필터
+        /// </summary>
+        private List<BlobResult> DetectBlobsWithContours(Mat binaryImage, int offsetX, int offsetY)
+        {
+            // Contour 검출 (잘라낸 이미지 기준 상대 좌표 반환, 0,0 기준)
+            Cv2.FindContours(binaryImage, out Point[][] contours, out HierarchyIndex[] hierarchy,
+                RetrievalMode, ApproximationMode);
+
+            var blobs = new List<BlobResult>();
+            int blobId = 0;
+
+            foreach (var contour in contours)
+            {
+                // 상대 좌표(ROI 기준)를 절대 좌표(원본 이미지 기준)로 즉시 변환
+                // 이후 CalculateBlobProperties가 반환하는 모든 속성
+                // (CenterX, CenterY, BoundingRect 등)이 절대 좌표로 저장됨
+                Point[] absoluteContour = OffsetPoints(contour, offsetX, offsetY);
+                var blob = CalculateBlobProperties(absoluteContour, blobId);
+
+                if (blob.Area >= MinArea && blob.Area <= MaxArea &&
+                    blob.Circularity >= MinCircularity && blob.Circularity <= MaxCircularity &&
+                    blob.Convexity >= MinConvexity)
+                {
+                    blobs.Add(blob);
+                    blobId++;
+                }
+            }
+
+            return blobs;
+        }
+
+        /// <summary>
+        /// 네이티브 경로: 이진화와 run 기반 라벨링을 한 번에 수행하고 면적·경계 상자·모멘트를 집계.
+        /// 경계 상자로 MinArea를 만족할 수 없는 Blob은 윤곽 추적 전에 제외되고,
+        /// 통과한 Blob만 개별 마스크에서 윤곽을 추적해 병렬로 특성을 계산.
+        /// 윤곽·특성·순서는 FindContours(External) 경로와 동일 (면적 0인 선/점 Blob만 픽셀 모멘트로 보완).
+        /// </summary>
+        private List<BlobResult> DetectBlobsNative(Mat grayImage, int offsetX, int offsetY, out Mat binaryImage)
+        {
+            _labeler ??= NativeVision.NvCreateBlobLabeler();
+
+            // THRESH_BINARY: v > ⌊T⌋, BINARY_INV: v <= ⌊T⌋
+            // 외부 이진 영상: 0이 아닌 픽셀 (DarkOnLight는 반전 후이므로 255가 아닌 픽셀)
+            int threshold, invert;
+            bool dark = SegmentationPolarity == SegmentationPolarity.DarkOnLight;
+            if (UseInternalThreshold)
+            {
+                binaryImage = new Mat(grayImage.Rows, grayImage.Cols, MatType.CV_8UC1);
+                threshold = (int)Math.Floor(ThresholdValue);
+                invert = dark ? 1 : 0;
+            }
+            else
+            {
+                binaryImage = grayImage.Clone();
+                if (dark)
+                    Cv2.BitwiseNot(binaryImage, binaryImage);
+                threshold = dark ? 254 : 0;
+                invert = dark ? 1 : 0;
+            }
+
+            // 픽셀 중심을 지나는 윤곽의 면적은 (right-left)·(bottom-top) 이하
+            int count = NativeVision.NvLabelBlobs(_labeler,
+                (byte*)grayImage.Data, grayImage.Width, grayImage.Height, (int)grayImage.Step(),
+                threshold, invert,
+                UseInternalThreshold ? (byte*)binaryImage.Data : null, (int)binaryImage.Step(),
+                1, MinArea);
+            if (count <= 0)
+                return new List<BlobResult>();
+
+            var stats = new BlobStats[count];
+            fixed (BlobStats* pStats = stats)
+                NativeVision.NvCopyBlobStats(_labeler, pStats);
+
+            var labeler = _labeler;
+            var candidates = new BlobResult[count];
+            Parallel.For(0, count, i =>
+            {
+                var s = stats[i];
+                using var mask = new Mat(s.Bottom - s.Top + 3, s.Right - s.Left + 3, MatType.CV_8UC1, Scalar.All(0));
+                NativeVision.NvRenderBlobMask(labeler, i, (byte*)mask.Data, (int)mask.Step(), 1);
+                Cv2.FindContours(mask, out Point[][] contours, out _, RetrievalModes.External, ApproximationMode,
+                    new Point(s.Left - 1 + offsetX, s.Top - 1 + offsetY));
+
+                var blob = CalculateBlobProperties(contours[0], 0);
+
+                // 선·점 형태 (윤곽 면적 0 / 점 5개 미만): 픽셀 모멘트로 중심과 타원 보완
+                if (blob.Area <= 0)
+                {
+                    blob.CenterX = s.CenterX + offsetX;
+                    blob.CenterY = s.CenterY + offsetY;
+                }
+                if (contours[0].Length < 5)
+                    blob.FitEllipse = MomentEllipse(s, offsetX, offsetY);
+
+                candidates[i] = blob;
+            });
+
+            // FindContours(External)는 역 래스터 순서로 윤곽을 반환 → 같은 순서로 ID 부여
+            var blobs = new List<BlobResult>();
+            int blobId = 0;
+            for (int i = count - 1; i >= 0; i--)
+            {
+                var blob = candidates[i];
+                if (blob.Area >= MinArea && blob.Area <= MaxArea &&
+                    blob.Circularity >= MinCircularity && blob.Circularity <= MaxCircularity &&
+                    blob.Convexity >= MinConvexity)
+                {
+                    blob.Id = blobId++;
+                    blobs.Add(blob);
+                }
+            }
+            return blobs;
+        }
+
+        /// <summary>
+        /// 2차 중심 모멘트와 같은 관성을 갖는 타원 (균일 타원: 분산 = 반축² / 4)
+        /// </summary>
+        private static RotatedRect MomentEllipse(BlobStats s, int offsetX, int offsetY)
+        {
+            double common = Math.Sqrt((s.Mu20 - s.Mu02) * (s.Mu20 - s.Mu02) + 4 * s.Mu11 * s.Mu11);
+            double major = Math.Sqrt(Math.Max(0, (s.Mu20 + s.Mu02 + common) / 2));
+            double minor = Math.Sqrt(Math.Max(0, (s.Mu20 + s.Mu02 - common) / 2));
+            double angle = 0.5 * Math.Atan2(2 * s.Mu11, s.Mu20 - s.Mu02) * 180 / Math.PI;
+            return new RotatedRect(
+                new Point2f((float)(s.CenterX + offsetX), (float)(s.CenterY + offsetY)),
+                new Size2f(4 * major, 4 * minor), (float)angle);
+        }
+
         private BlobResult CalculateBlobProperties(Point[] contour, int id)
         {
             var blob = new BlobResult
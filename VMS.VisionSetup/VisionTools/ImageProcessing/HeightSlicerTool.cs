@@ -45,21 +45,33 @@ namespace VMS.VisionSetup.VisionTools.ImageProcessing
                 }
 
                 Mat workImage = GetROIImage(inputImage);
-                Mat mask = new Mat();
-                Mat normalized = new Mat();
-                Mat outputImage = new Mat();
+                Mat outputImage;
 
-                // 1. 범위 필터링 (InRange)
-                Cv2.InRange(workImage, new Scalar(MinZ), new Scalar(MaxZ), mask);
+                // 범위 마스크 + 8비트 정규화를 네이티브 한 패스로 (NaN은 범위 밖)
+                if (NativeDepthSlicing.TrySliceDepth(workImage, MinZ, MaxZ, out var sliced, out int inRangeCount))
+                {
+                    outputImage = sliced;
+                    result.Data["InRangePixels"] = inRangeCount;
+                }
+                else
+                {
+                    using var mask = new Mat();
+                    using var normalized = new Mat();
+                    outputImage = new Mat();
 
-                // 2. 8비트 정규화 변환
-                double range = MaxZ - MinZ;
-                double scale = range > 0.0001 ? 255.0 / range : 0;
-                double shift = range > 0.0001 ? -MinZ * scale : 0;
-                workImage.ConvertTo(normalized, MatType.CV_8UC1, scale, shift);
+                    // 1. 범위 필터링 (InRange)
+                    Cv2.InRange(workImage, new Scalar(MinZ), new Scalar(MaxZ), mask);
 
-                // 3. 마스크 적용 및 결과 생성
-                normalized.CopyTo(outputImage, mask);
+                    // 2. 8비트 정규화 변환
+                    double range = MaxZ - MinZ;
+                    double scale = range > 0.0001 ? 255.0 / range : 0;
+                    double shift = range > 0.0001 ? -MinZ * scale : 0;
+                    workImage.ConvertTo(normalized, MatType.CV_8UC1, scale, shift);
+
+                    // 3. 마스크 적용 및 결과 생성
+                    normalized.CopyTo(outputImage, mask);
+                    result.Data["InRangePixels"] = Cv2.CountNonZero(mask);
+                }
 
                 // ROI 결과 적용 (필요시)
                 Mat finalOutput = UseROI ? ApplyROIResult(inputImage, outputImage) : outputImage;
@@ -71,8 +83,6 @@ namespace VMS.VisionSetup.VisionTools.ImageProcessing
                 result.Message = $"Slicing 완료 ({MinZ}mm ~ {MaxZ}mm)";
 
                 // 메모리 해제
-                mask.Dispose();
-                normalized.Dispose();
                 if (outputImage != finalOutput) outputImage.Dispose();
                 if (workImage != inputImage) workImage.Dispose();
             }
@@ -65,39 +65,49 @@ namespace VMS.VisionSetup.VisionTools.ImageProcessing
                 // 커널 생성
                 var kernel = Cv2.GetStructuringElement(KernelShape, new Size(KernelWidth, KernelHeight));
 
-                switch (Operation)
+                // 사각형 커널의 그레이 이미지는 네이티브 경로 (커널 크기와 무관한 처리 시간)
+                if (NativeMorphology.TryApply(workImage, Operation, KernelShape,
+                        KernelWidth, KernelHeight, Iterations, out var nativeOutput))
                 {
-                    case MorphologyOperation.Erode:
-                        Cv2.Erode(workImage, outputImage, kernel, iterations: Iterations);
-                        break;
-
-                    case MorphologyOperation.Dilate:
-                        Cv2.Dilate(workImage, outputImage, kernel, iterations: Iterations);
-                        break;
-
-                    case MorphologyOperation.Open:
-                        Cv2.MorphologyEx(workImage, outputImage, MorphTypes.Open, kernel, iterations: Iterations);
-                        break;
-
-                    case MorphologyOperation.Close:
-                        Cv2.MorphologyEx(workImage, outputImage, MorphTypes.Close, kernel, iterations: Iterations);
-                        break;
-
-                    case MorphologyOperation.Gradient:
-                        Cv2.MorphologyEx(workImage, outputImage, MorphTypes.Gradient, kernel, iterations: Iterations);
-                        break;
-
-                    case MorphologyOperation.TopHat:
-                        Cv2.MorphologyEx(workImage, outputImage, MorphTypes.TopHat, kernel, iterations: Iterations);
-                        break;
-
-                    case MorphologyOperation.BlackHat:
-                        Cv2.MorphologyEx(workImage, outputImage, MorphTypes.BlackHat, kernel, iterations: Iterations);
-                        break;
-
-                    default:
-                        outputImage = workImage.Clone();
-                        break;
+                    outputImage.Dispose();
+                    outputImage = nativeOutput;
+                }
+                else
+                {
+                    switch (Operation)
+                    {
+                        case MorphologyOperation.Erode:
+                            Cv2.Erode(workImage, outputImage, kernel, iterations: Iterations);
+                            break;
+
+                        case MorphologyOperation.Dilate:
+                            Cv2.Dilate(workImage, outputImage, kernel, iterations: Iterations);
+                            break;
+
+                        case MorphologyOperation.Open:
+                            Cv2.MorphologyEx(workImage, outputImage, MorphTypes.Open, kernel, iterations: Iterations);
+                            break;
+
+                        case MorphologyOperation.Close:
+                            Cv2.MorphologyEx(workImage, outputImage, MorphTypes.Close, kernel, iterations: Iterations);
+                            break;
+
+                        case MorphologyOperation.Gradient:
+                            Cv2.MorphologyEx(workImage, outputImage, MorphTypes.Gradient, kernel, iterations: Iterations);
+                            break;
+
+                        case MorphologyOperation.TopHat:
+                            Cv2.MorphologyEx(workImage, outputImage, MorphTypes.TopHat, kernel, iterations: Iterations);
+                            break;
+
+                        case MorphologyOperation.BlackHat:
+                            Cv2.MorphologyEx(workImage, outputImage, MorphTypes.BlackHat, kernel, iterations: Iterations);
+                            break;
+
+                        default:
+                            outputImage = workImage.Clone();
+                            break;
+                    }
                 }
 
                 // ROI가 사용된 경우 원본 이미지 크기로 결과 적용
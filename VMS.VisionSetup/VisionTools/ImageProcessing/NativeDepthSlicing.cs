@@ -0,0 +1,148 @@
+using VMS.Camera.Models;
+using OpenCvSharp;
+using System;
+using System.Diagnostics.CodeAnalysis;
+using System.Numerics;
+using System.Runtime.InteropServices;
+
+namespace VMS.VisionSetup.VisionTools.ImageProcessing
+{
+    /// <summary>
+    /// 3D 프레임 높이 슬라이싱 네이티브 경로 (NvSliceDepth / NvSlicePointCloud).
+    /// Depth Map: 범위 마스크 + 8비트 정규화를 SIMD 한 패스로 처리 (InRange + ConvertTo + CopyTo 대체).
+    /// 정렬된 포인트 클라우드: 한 패스로 Height Map, float 높이 맵, 높이 히스토그램, 여러 높이 밴드의 포인트 수 생성.
+    /// NaN 높이는 무효 포인트로 간주 (출력 0, 어떤 통계에도 포함되지 않음).
+    /// DLL(또는 이 export)이 없으면 Try* 메서드가 false를 반환하고 호출자는 관리 코드 경로를 사용.
+    /// </summary>
+    internal static unsafe class NativeDepthSlicing
+    {
+        #region Native Interop
+
+        private static class NativeVision
+        {
+            private const string DllName = NativeVisionLibrary.DllName;
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvSliceDepth(
+                float* depth, int width, int height, int depthStride,
+                float minZ, float maxZ, byte* dst, int dstStride);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvSlicePointCloud(
+                float* xyz, int width, int height, int axis, float reference,
+                float lo, float hi,
+                byte* heightMap, int mapStride,
+                float* heights, int heightsStride,
+                float* bandLo, float* bandHi, int bandCount, int* bandCounts,
+                int* histogram);
+
+            private static readonly bool _isAvailable = NativeVisionLibrary.HasExports("NvSliceDepth", "NvSlicePointCloud");
+
+            public static bool IsAvailable => _isAvailable;
+        }
+
+        #endregion
+
+        // Height Map 명암 단계 수 (히스토그램 길이)
+        public const int HistogramLevels = 256;
+
+        /// <summary>
+        /// 포인트 클라우드 슬라이싱 결과. Heights / Histogram은 요청한 경우에만 채워짐.
+        /// </summary>
+        internal sealed class CloudSlice
+        {
+            public Mat HeightMap { get; set; } = null!;     // CV_8UC1, [lo, hi] → 0‥255 (범위 밖은 포화)
+            public Mat? Heights { get; set; }               // CV_32FC1, 좌표 − reference (무효 포인트는 NaN)
+            public int ValidCount { get; set; }
+            public int[] Histogram { get; set; } = Array.Empty<int>();    // [lo, hi] 안 포인트의 HeightMap 명암별 개수
+            public int[] BandCounts { get; set; } = Array.Empty<int>();   // bands[i] 구간(양끝 포함)의 포인트 수
+        }
+
+        /// <summary>
+        /// CV_32FC1 Depth Map의 [minZ, maxZ] 구간을 0‥255로 정규화 (범위 밖·NaN은 0).
+        /// 네이티브 경로를 쓸 수 없으면 false.
+        /// </summary>
+        public static bool TrySliceDepth(Mat depth, float minZ, float maxZ,
+            [NotNullWhen(true)] out Mat? dst, out int inRangeCount)
+        {
+            dst = null;
+            inRangeCount = 0;
+            if (!NativeVision.IsAvailable || depth.Type() != MatType.CV_32FC1 || depth.Empty())
+                return false;
+
+            var output = new Mat(depth.Size(), MatType.CV_8UC1);
+            int count = NativeVision.NvSliceDepth(
+                (float*)depth.Data, depth.Width, depth.Height, (int)depth.Step(),
+                minZ, maxZ, (byte*)output.Data, (int)output.Step());
+            if (count < 0)
+            {
+                output.Dispose();
+                return false;
+            }
+
+            dst = output;
+            inRangeCount = count;
+            return true;
+        }
+
+        /// <summary>
+        /// 정렬된 포인트 클라우드를 axis(0 = X, 1 = Y, 2 = Z) 방향 높이로 한 번에 슬라이싱.
+        /// 높이 h = 좌표 − reference. 네이티브 경로를 쓸 수 없으면 false.
+        /// </summary>
+        public static bool TrySlicePointCloud(PointCloudData cloud, int axis, float reference,
+            float lo, float hi, (float Lo, float Hi)[]? bands, bool keepHistogram, bool keepHeights,
+            [NotNullWhen(true)] out CloudSlice? slice)
+        {
+            slice = null;
+            if (!NativeVision.IsAvailable || !cloud.IsOrganized)
+                return false;
+
+            int w = cloud.GridWidth;
+            int h = cloud.GridHeight;
+            int bandCount = bands?.Length ?? 0;
+            var bandLo = new float[bandCount];
+            var bandHi = new float[bandCount];
+            for (int i = 0; i < bandCount; i++)
+            {
+                bandLo[i] = bands![i].Lo;
+                bandHi[i] = bands[i].Hi;
+            }
+            var bandCounts = new int[bandCount];
+            var histogram = keepHistogram ? new int[HistogramLevels] : Array.Empty<int>();
+
+            var heightMap = new Mat(h, w, MatType.CV_8UC1);
+            var heights = keepHeights ? new Mat(h, w, MatType.CV_32FC1) : null;
+            int valid;
+            fixed (Vector3* pPos = cloud.Positions)
+            fixed (float* pLo = bandLo)
+            fixed (float* pHi = bandHi)
+            fixed (int* pCounts = bandCounts)
+            fixed (int* pHist = histogram)
+            {
+                valid = NativeVision.NvSlicePointCloud(
+                    (float*)pPos, w, h, axis, reference, lo, hi,
+                    (byte*)heightMap.Data, (int)heightMap.Step(),
+                    heights != null ? (float*)heights.Data : null, heights != null ? (int)heights.Step() : 0,
+                    pLo, pHi, bandCount, pCounts,
+                    keepHistogram ? pHist : null);
+            }
+
+            if (valid < 0)
+            {
+                heightMap.Dispose();
+                heights?.Dispose();
+                return false;
+            }
+
+            slice = new CloudSlice
+            {
+                HeightMap = heightMap,
+                Heights = heights,
+                ValidCount = valid,
+                Histogram = histogram,
+                BandCounts = bandCounts
+            };
+            return true;
+        }
+    }
+}
@@ -0,0 +1,65 @@
+using OpenCvSharp;
+using System.Diagnostics.CodeAnalysis;
+using System.Runtime.InteropServices;
+
+namespace VMS.VisionSetup.VisionTools.ImageProcessing
+{
+    /// <summary>
+    /// MorphologyTool의 네이티브 사각형 형태학 처리 (NvMorphology).
+    /// 분리 가능한 사각형/선 커널을 행·열 패스로 나누고, 열 방향은 van Herk/Gil-Werman으로
+    /// 커널 크기와 무관하게 픽셀당 3회 비교. 반복 횟수는 커널을 키워 한 번에 처리하고,
+    /// Open/Close/TopHat/BlackHat은 중간 전체 이미지 없이 행 스트립 단위로 처리.
+    /// 결과는 Cv2.MorphologyEx(기본 경계)와 비트 단위로 동일.
+    /// DLL(또는 이 export)이 없거나 사각형 커널의 8비트 단일 채널이 아니면 TryApply가 false를 반환.
+    /// </summary>
+    internal static unsafe class NativeMorphology
+    {
+        #region Native Interop
+
+        private static class NativeVision
+        {
+            private const string DllName = NativeVisionLibrary.DllName;
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvMorphology(
+                byte* src, int width, int height, int srcStride,
+                byte* dst, int dstStride,
+                int op, int kernelW, int kernelH, int iterations);
+
+            private static readonly bool _isAvailable = NativeVisionLibrary.HasExport("NvMorphology");
+
+            public static bool IsAvailable => _isAvailable;
+        }
+
+        #endregion
+
+        /// <summary>
+        /// kernelWidth × kernelHeight 사각형(앵커 중심)으로 operation을 iterations회 적용.
+        /// 네이티브 경로를 쓸 수 없으면 false (호출자는 OpenCV 경로 사용).
+        /// </summary>
+        public static bool TryApply(Mat src, MorphologyOperation operation, MorphShapes shape,
+            int kernelWidth, int kernelHeight, int iterations, [NotNullWhen(true)] out Mat? dst)
+        {
+            dst = null;
+            // 1×k, k×1 Cross는 사각형과 같은 선 (Ellipse k×1은 한 점뿐이라 제외)
+            bool separable = shape == MorphShapes.Rect
+                || (shape == MorphShapes.Cross && (kernelWidth == 1 || kernelHeight == 1));
+            if (!NativeVision.IsAvailable || !separable || src.Type() != MatType.CV_8UC1 || src.Empty())
+                return false;
+
+            var output = new Mat(src.Size(), MatType.CV_8UC1);
+            int ok = NativeVision.NvMorphology(
+                (byte*)src.Data, src.Width, src.Height, (int)src.Step(),
+                (byte*)output.Data, (int)output.Step(),
+                (int)operation, kernelWidth, kernelHeight, iterations);
+            if (ok == 0)
+            {
+                output.Dispose();
+                return false;
+            }
+
+            dst = output;
+            return true;
+        }
+    }
+}
@@ -0,0 +1,189 @@
+using OpenCvSharp;
+using System;
+using System.Diagnostics.CodeAnalysis;
+using System.Runtime.InteropServices;
+
+namespace VMS.VisionSetup.VisionTools.Measurement
+{
+    /// <summary>
+    /// CaliperTool / LineFitTool / CircleFitTool 공용 네이티브 캘리퍼 측정 (NvMeasureCalipers).
+    /// N개의 회전된 검색 사각형을 한 번의 병렬 호출로 처리:
+    /// 바이리니어 샘플링 → 균일/가우시안 투영 (중간 strip 없음) → 미분 필터 → 서브픽셀 에지.
+    /// 샘플링 기하는 기존 WarpAffine strip과 동일하므로 결과가 관리 코드 경로와 일치함.
+    /// DLL(또는 이 export)이 없으면 TryMeasure가 false를 반환하고 각 도구는 관리 코드 경로를 사용.
+    /// </summary>
+    internal static unsafe class CaliperProjection
+    {
+        #region Structs
+
+        /// <summary>
+        /// 검색 사각형: (X, Y)에서 (Ux, Uy) 방향으로 Length, (Vx, Vy) 방향으로 Width만큼 투영
+        /// </summary>
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct Caliper
+        {
+            public double X, Y;
+            public double Ux, Uy;
+            public double Vx, Vy;
+            public double Length, Width;
+
+            /// <summary>
+            /// start → end 검색 라인 (각 도구의 FindEdgeAlongLine / ExtractProfile과 같은 수직 벡터 규약)
+            /// </summary>
+            public static Caliper FromSegment(Point2d start, Point2d end, double width)
+            {
+                double dx = end.X - start.X;
+                double dy = end.Y - start.Y;
+                double length = Math.Sqrt(dx * dx + dy * dy);
+                double ux = length > 0 ? dx / length : 1;
+                double uy = length > 0 ? dy / length : 0;
+                return new Caliper
+                {
+                    X = start.X, Y = start.Y,
+                    Ux = ux, Uy = uy,
+                    Vx = -uy, Vy = ux,
+                    Length = length, Width = width
+                };
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct Edge
+        {
+            public double Position;  // 서브픽셀 위치 (|gradient| 포물선 보간)
+            public double Contrast;  // 피크의 |gradient|
+            public int Index;        // 정수 위치
+            public int Polarity;     // +1 DarkToLight, -1 LightToDark
+        }
+
+        #endregion
+
+        #region Native Interop
+
+        private static class NativeVision
+        {
+            private const string DllName = NativeVisionLibrary.DllName;
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvMeasureCalipers(
+                byte* gray, int width, int height, int stride,
+                Caliper* calipers, int count,
+                int gaussianProjection,
+                double* smoothKernel, int smoothHalfWidth,
+                double* derivKernel, int derivHalfWidth,
+                double threshold, int polarity,
+                double* profiles, double* gradients, int profileStride,
+                Edge* edges, int edgeCapacity, int* edgeCounts);
+
+            private static readonly bool _isAvailable = NativeVisionLibrary.HasExport("NvMeasureCalipers");
+
+            public static bool IsAvailable => _isAvailable;
+        }
+
+        #endregion
+
+        /// <summary>
+        /// 에지 검출 필터 설정. DerivativeKernel 양수 응답 = DarkToLight.
+        /// </summary>
+        internal sealed class Filter
+        {
+            public bool GaussianProjection { get; set; }
+            public double[]? SmoothKernel { get; set; }
+            public double[] DerivativeKernel { get; set; } = Array.Empty<double>();
+            public double Threshold { get; set; }
+            public EdgePolarity Polarity { get; set; }
+        }
+
+        /// <summary>
+        /// 캘리퍼별 결과 (평탄화 배열). Profiles/Gradients는 keepProfiles일 때만 채워짐.
+        /// </summary>
+        internal sealed class Batch
+        {
+            public Edge[] Edges { get; set; } = Array.Empty<Edge>();
+            public int[] EdgeCounts { get; set; } = Array.Empty<int>();
+            public int EdgeCapacity { get; set; }
+            public double[]? Profiles { get; set; }
+            public double[]? Gradients { get; set; }
+            public int ProfileStride { get; set; }
+
+            public ReadOnlySpan<Edge> EdgesOf(int i) => new(Edges, i * EdgeCapacity, EdgeCounts[i]);
+
+            public double[] ProfileOf(int i, int length) => Slice(Profiles, i, length);
+
+            public double[] GradientOf(int i, int length) => Slice(Gradients, i, length);
+
+            private double[] Slice(double[]? data, int i, int length) =>
+                data == null ? Array.Empty<double>() : data.AsSpan(i * ProfileStride, length).ToArray();
+        }
+
+        /// <summary>
+        /// 이동 평균 미분 커널: k[j] = j / (2·halfWidth + 1)
+        /// </summary>
+        public static double[] BoxDerivativeKernel(int halfWidth)
+        {
+            var kernel = new double[halfWidth * 2 + 1];
+            for (int j = -halfWidth; j <= halfWidth; j++)
+                kernel[j + halfWidth] = (double)j / (halfWidth * 2 + 1);
+            return kernel;
+        }
+
+        /// <summary>
+        /// 모든 캘리퍼를 한 번에 측정. 네이티브 경로를 쓸 수 없으면 false.
+        /// gray는 CV_8UC1이어야 함.
+        /// </summary>
+        public static bool TryMeasure(Mat gray, Caliper[] calipers, Filter filter, bool keepProfiles,
+            [NotNullWhen(true)] out Batch? batch)
+        {
+            batch = null;
+            if (!NativeVision.IsAvailable || gray.Type() != MatType.CV_8UC1 || calipers.Length == 0)
+                return false;
+
+            // 국부 극값은 인접할 수 없으므로 L/2 + 1 슬롯이면 절단되지 않음
+            int maxLength = 1;
+            foreach (var c in calipers)
+                maxLength = Math.Max(maxLength, (int)c.Length);
+            int capacity = maxLength / 2 + 1;
+
+            var edges = new Edge[calipers.Length * capacity];
+            var counts = new int[calipers.Length];
+            var profiles = keepProfiles ? new double[calipers.Length * maxLength] : null;
+            var gradients = keepProfiles ? new double[calipers.Length * maxLength] : null;
+            int derivHalfWidth = filter.DerivativeKernel.Length / 2;
+            int smoothHalfWidth = filter.SmoothKernel != null ? filter.SmoothKernel.Length / 2 : 0;
+
+            int total;
+            fixed (Caliper* pCal = calipers)
+            fixed (double* pSmooth = filter.SmoothKernel)
+            fixed (double* pDeriv = filter.DerivativeKernel)
+            fixed (double* pProf = profiles)
+            fixed (double* pGrad = gradients)
+            fixed (Edge* pEdges = edges)
+            fixed (int* pCounts = counts)
+            {
+                total = NativeVision.NvMeasureCalipers(
+                    (byte*)gray.Data, gray.Width, gray.Height, (int)gray.Step(),
+                    pCal, calipers.Length,
+                    filter.GaussianProjection ? 1 : 0,
+                    pSmooth, smoothHalfWidth,
+                    pDeriv, derivHalfWidth,
+                    filter.Threshold, (int)filter.Polarity,
+                    pProf, pGrad, maxLength,
+                    pEdges, capacity, pCounts);
+            }
+
+            if (total < 0)
+                return false;
+
+            batch = new Batch
+            {
+                Edges = edges,
+                EdgeCounts = counts,
+                EdgeCapacity = capacity,
+                Profiles = profiles,
+                Gradients = gradients,
+                ProfileStride = maxLength
+            };
+            return true;
+        }
+    }
+}
@@ -331,11 +331,22 @@ namespace VMS.VisionSetup.VisionTools.Measurement
                 double vx = -uy;
                 double vy = ux;
 
-                // [개선1] 검색 라인을 따라 프로파일 추출 (바이리니어 보간 + 가우시안 투영)
-                var profile = ExtractProfile(grayImage, searchStart, ux, uy, vx, vy, length, searchWidth);
-
-                // Edge 검출
-                var edges = DetectEdges(profile, length, out var gradient);
+                // [개선1] 검색 라인을 따라 프로파일 추출 (바이리니어 보간 + 가우시안 투영) + Edge 검출
+                // 네이티브: strip 없이 투영·미분·에지 검출을 한 번에, 없으면 WarpAffine 경로
+                double[] profile, gradient;
+                List<EdgeResult> edges;
+                var caliper = CaliperProjection.Caliper.FromSegment(searchStart, searchEnd, searchWidth);
+                if (CaliperProjection.TryMeasure(grayImage, new[] { caliper }, CreateProjectionFilter(), true, out var batch))
+                {
+                    profile = batch.ProfileOf(0, (int)length);
+                    gradient = batch.GradientOf(0, (int)length);
+                    edges = DetectEdges(batch.EdgesOf(0), profile, gradient, length);
+                }
+                else
+                {
+                    profile = ExtractProfile(grayImage, searchStart, ux, uy, vx, vy, length, searchWidth);
+                    edges = DetectEdges(profile, length, out gradient);
+                }
 
                 // Store for visualization
                 LastProfile = profile;
@@ -566,8 +577,6 @@ namespace VMS.VisionSetup.VisionTools.Measurement
 
         private List<EdgeResult> DetectEdges(double[] rawProfile, double length, out double[] gradient)
         {
-            var edges = new List<EdgeResult>();
-
             // [개선2] 가우시안 필터 적용 (옵션)
             double[] profile;
             if (UseGaussianFilter)
@@ -607,27 +616,7 @@ namespace VMS.VisionSetup.VisionTools.Measurement
                 absGradient[i] = Math.Abs(gradient[i]);
 
             // [개선3] 정규화된 대비를 위한 국부 평균 계산
-            double[]? localMean = null;
-            if (UseNormalizedContrast)
-            {
-                localMean = new double[profile.Length];
-                int meanRadius = Math.Max(FilterHalfWidth * 2, 5);
-                for (int i = 0; i < profile.Length; i++)
-                {
-                    double sum = 0;
-                    int count = 0;
-                    for (int j = -meanRadius; j <= meanRadius; j++)
-                    {
-                        int idx = i + j;
-                        if (idx >= 0 && idx < profile.Length)
-                        {
-                            sum += profile[idx];
-                            count++;
-                        }
-                    }
-                    localMean[i] = count > 0 ? sum / count : 128.0;
-                }
-            }
+            double[]? localMean = UseNormalizedContrast ? ComputeLocalMean(profile) : null;
 
             // Edge 검출 (Local Maxima/Minima)
             var candidates = new List<EdgeResult>();
@@ -691,6 +680,99 @@ namespace VMS.VisionSetup.VisionTools.Measurement
                 }
             }
 
+            return ScoreEdges(candidates, length);
+        }
+
+        /// <summary>
+        /// 네이티브 에지 목록(NvMeasureCalipers) → EdgeResult 후보 → 관리 코드 경로와 같은 점수화.
+        /// 네이티브 서브픽셀은 포물선 보간이므로 다른 SubPixelMethod는 gradient에서 다시 계산.
+        /// </summary>
+        private List<EdgeResult> DetectEdges(ReadOnlySpan<CaliperProjection.Edge> found, double[] rawProfile, double[] gradient, double length)
+        {
+            double[]? absGradient = null;
+            if (SubPixelMethod != SubPixelMethod.Parabolic)
+                absGradient = gradient.Select(g => Math.Abs(g)).ToArray();
+
+            double[]? localMean = null;
+            if (UseNormalizedContrast)
+            {
+                var profile = UseGaussianFilter
+                    ? ApplyGaussianSmoothing(rawProfile, FilterHalfWidth, GaussianSigma)
+                    : rawProfile;
+                localMean = ComputeLocalMean(profile);
+            }
+
+            var candidates = new List<EdgeResult>(found.Length);
+            foreach (var e in found)
+            {
+                double normalizedContrast = e.Contrast;
+                if (localMean != null)
+                {
+                    double lm = localMean[e.Index];
+                    normalizedContrast = lm > 1.0 ? e.Contrast / lm : e.Contrast;
+                }
+
+                candidates.Add(new EdgeResult
+                {
+                    Position = e.Index,
+                    SubPixelPosition = absGradient != null ? ComputeSubPixelPosition(absGradient, e.Index) : e.Position,
+                    Score = e.Contrast,
+                    NormalizedContrast = normalizedContrast,
+                    Polarity = e.Polarity > 0 ? EdgePolarity.DarkToLight : EdgePolarity.LightToDark,
+                    PolarityScore = 1.0
+                });
+            }
+
+            return ScoreEdges(candidates, length);
+        }
+
+        /// <summary>
+        /// DetectEdges와 같은 필터 설정의 네이티브 캘리퍼 파라미터
+        /// </summary>
+        private CaliperProjection.Filter CreateProjectionFilter()
+        {
+            return new CaliperProjection.Filter
+            {
+                GaussianProjection = ProjectionMode == ProjectionMode.Gaussian,
+                SmoothKernel = UseGaussianFilter ? CreateGaussianKernel(FilterHalfWidth, GaussianSigma) : null,
+                DerivativeKernel = UseGaussianFilter
+                    ? CreateGaussianDerivativeKernel(FilterHalfWidth, GaussianSigma)
+                    : CaliperProjection.BoxDerivativeKernel(FilterHalfWidth),
+                Threshold = EdgeThreshold,
+                Polarity = Polarity
+            };
+        }
+
+        /// <summary>
+        /// [개선3] 정규화된 대비를 위한 국부 평균
+        /// </summary>
+        private double[] ComputeLocalMean(double[] profile)
+        {
+            var localMean = new double[profile.Length];
+            int meanRadius = Math.Max(FilterHalfWidth * 2, 5);
+            for (int i = 0; i < profile.Length; i++)
+            {
+                double sum = 0;
+                int count = 0;
+                for (int j = -meanRadius; j <= meanRadius; j++)
+                {
+                    int idx = i + j;
+                    if (idx >= 0 && idx < profile.Length)
+                    {
+                        sum += profile[idx];
+                        count++;
+                    }
+                }
+                localMean[i] = count > 0 ? sum / count : 128.0;
+            }
+            return localMean;
+        }
+
+        /// <summary>
+        /// Multi-scorer: contrast / position / polarity 점수 → 점수순 상위 MaxEdges
+        /// </summary>
+        private List<EdgeResult> ScoreEdges(List<EdgeResult> candidates, double length)
+        {
             // Multi-scorer system
             double maxGrad = candidates.Count > 0 ? candidates.Max(e => e.Score) : 1.0;
             if (maxGrad < 1e-12) maxGrad = 1.0;
@@ -724,9 +806,7 @@ namespace VMS.VisionSetup.VisionTools.Measurement
             }
 
             // 점수순 정렬
-            edges = candidates.OrderByDescending(e => e.Score).Take(MaxEdges).ToList();
-
-            return edges;
+            return candidates.OrderByDescending(e => e.Score).Take(MaxEdges).ToList();
         }
 
         /// <summary>
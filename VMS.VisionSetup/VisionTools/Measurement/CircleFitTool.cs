@@ -162,6 +162,8 @@ namespace VMS.VisionSetup.VisionTools.Measurement
                 var foundPoints = new List<Point2d>();
                 double angleRange = EndAngle - StartAngle;
 
+                var searchLines = new (Point2d Start, Point2d End)[NumCalipers];
+                var calipers = new CaliperProjection.Caliper[NumCalipers];
                 for (int i = 0; i < NumCalipers; i++)
                 {
                     double angle = StartAngle + angleRange * i / NumCalipers;
@@ -183,8 +185,27 @@ namespace VMS.VisionSetup.VisionTools.Measurement
                     var searchStart = SearchDirection == CircleSearchDirection.InwardToOutward ? innerPoint : outerPoint;
                     var searchEnd = SearchDirection == CircleSearchDirection.InwardToOutward ? outerPoint : innerPoint;
 
+                    searchLines[i] = (searchStart, searchEnd);
+                    calipers[i] = CaliperProjection.Caliper.FromSegment(searchStart, searchEnd, SearchWidth);
+                }
+
+                // 네이티브: 모든 Caliper를 한 번의 병렬 호출로 투영·미분·에지 검출
+                var filter = new CaliperProjection.Filter
+                {
+                    DerivativeKernel = DerivativeKernel,
+                    Threshold = EdgeThreshold,
+                    Polarity = Polarity
+                };
+                CaliperProjection.TryMeasure(grayImage, calipers, filter, false, out var batch);
+
+                for (int i = 0; i < NumCalipers; i++)
+                {
+                    var (searchStart, searchEnd) = searchLines[i];
+
                     // Edge 검출
-                    var edge = FindEdgeAlongLine(grayImage, searchStart, searchEnd, SearchWidth);
+                    var edge = batch != null
+                        ? SelectStrongestEdge(batch.EdgesOf(i), calipers[i])
+                        : FindEdgeAlongLine(grayImage, searchStart, searchEnd, SearchWidth);
 
                     // Caliper 검색 영역 표시
                     Cv2.Line(overlayImage,
@@ -287,6 +308,32 @@ namespace VMS.VisionSetup.VisionTools.Measurement
             return result;
         }
 
+        // FindEdgeAlongLine의 4탭 미분: (-p[i-2] - p[i-1] + p[i+1] + p[i+2]) / 4
+        private static readonly double[] DerivativeKernel = { -0.25, -0.25, 0, 0.25, 0.25 };
+
+        /// <summary>
+        /// 네이티브 에지 목록에서 contrast 최대 에지 선택 (서브픽셀 위치 사용)
+        /// </summary>
+        private static (Point2d Point, double Score)? SelectStrongestEdge(
+            ReadOnlySpan<CaliperProjection.Edge> edges, CaliperProjection.Caliper caliper)
+        {
+            if (edges.IsEmpty)
+                return null;
+
+            int best = 0;
+            for (int k = 1; k < edges.Length; k++)
+            {
+                if (edges[k].Contrast > edges[best].Contrast)
+                    best = k;
+            }
+
+            var edge = edges[best];
+            var edgePoint = new Point2d(
+                caliper.X + caliper.Ux * edge.Position,
+                caliper.Y + caliper.Uy * edge.Position);
+            return (edgePoint, edge.Contrast);
+        }
+
         private (Point2d Point, double Score)? FindEdgeAlongLine(Mat image, Point2d start, Point2d end, double width)
         {
             double dx = end.X - start.X;
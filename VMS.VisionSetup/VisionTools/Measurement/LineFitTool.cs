@@ -212,6 +212,9 @@ namespace VMS.VisionSetup.VisionTools.Measurement
                 var foundEdges = new List<(Point2d Point, double Score)>();
                 var caliperResults = new List<CaliperResult>();
 
+                // Caliper 검색 영역 (수직 방향, 절대 좌표)
+                var searchLines = new (Point2d Start, Point2d End)[NumCalipers];
+                var calipers = new CaliperProjection.Caliper[NumCalipers];
                 for (int i = 0; i < NumCalipers; i++)
                 {
                     // Caliper 중심 위치 (절대 좌표)
@@ -219,12 +222,31 @@ namespace VMS.VisionSetup.VisionTools.Measurement
                     double cx = baselineStart.X + dx * t;
                     double cy = baselineStart.Y + dy * t;
 
-                    // Caliper 검색 영역 (수직 방향, 절대 좌표)
-                    var searchStart = new Point2d(cx - vx * searchLength / 2, cy - vy * searchLength / 2);
-                    var searchEnd = new Point2d(cx + vx * searchLength / 2, cy + vy * searchLength / 2);
+                    searchLines[i] = (new Point2d(cx - vx * searchLength / 2, cy - vy * searchLength / 2),
+                                      new Point2d(cx + vx * searchLength / 2, cy + vy * searchLength / 2));
+                    calipers[i] = CaliperProjection.Caliper.FromSegment(
+                        searchLines[i].Start, searchLines[i].End, SearchWidth);
+                }
+
+                // 네이티브: 모든 Caliper를 한 번의 병렬 호출로 투영·미분·에지 검출
+                var filter = new CaliperProjection.Filter
+                {
+                    DerivativeKernel = CaliperProjection.BoxDerivativeKernel(FilterHalfWidth),
+                    Threshold = EdgeThreshold,
+                    Polarity = Polarity
+                };
+                CaliperProjection.TryMeasure(grayImage, calipers, filter, false, out var batch);
+
+                for (int i = 0; i < NumCalipers; i++)
+                {
+                    var (searchStart, searchEnd) = searchLines[i];
+                    double cx = (searchStart.X + searchEnd.X) / 2;
+                    double cy = (searchStart.Y + searchEnd.Y) / 2;
 
                     // Edge 검출 (전체 이미지에서 절대 좌표로 검색)
-                    var edge = FindEdgeAlongLine(grayImage, searchStart, searchEnd, SearchWidth);
+                    var edge = batch != null
+                        ? SelectEdge(batch.EdgesOf(i), calipers[i])
+                        : FindEdgeAlongLine(grayImage, searchStart, searchEnd, SearchWidth);
 
                     var caliperResult = new CaliperResult
                     {
@@ -492,6 +514,38 @@ namespace VMS.VisionSetup.VisionTools.Measurement
             return (edgePoint, best.Contrast);
         }
 
+        /// <summary>
+        /// 네이티브 에지 목록에서 FindEdgeAlongLine과 같은 규칙으로 선택
+        /// (최대 contrast의 50% 이상 중 검색선 중심에 가장 가까운 것)
+        /// </summary>
+        private static (Point2d Point, double Score)? SelectEdge(
+            ReadOnlySpan<CaliperProjection.Edge> edges, CaliperProjection.Caliper caliper)
+        {
+            if (edges.IsEmpty)
+                return null;
+
+            double maxContrast = 0;
+            foreach (var e in edges)
+                maxContrast = Math.Max(maxContrast, e.Contrast);
+            double contrastFloor = maxContrast * 0.5;
+            double centerPos = caliper.Length / 2.0;
+
+            int best = -1;
+            for (int k = 0; k < edges.Length; k++)
+            {
+                if (edges[k].Contrast < contrastFloor)
+                    continue;
+                if (best < 0 || Math.Abs(edges[k].Index - centerPos) < Math.Abs(edges[best].Index - centerPos))
+                    best = k;
+            }
+
+            var edge = edges[best];
+            var edgePoint = new Point2d(
+                caliper.X + caliper.Ux * edge.Position,
+                caliper.Y + caliper.Uy * edge.Position);
+            return (edgePoint, edge.Contrast);
+        }
+
         /// <summary>
         /// 1D 가우시안 스무딩: FilterHalfWidth를 sigma로 사용하여 프로파일 노이즈 제거
         /// </summary>
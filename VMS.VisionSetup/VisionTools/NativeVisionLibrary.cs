@@ -0,0 +1,52 @@
+using System;
+using System.Runtime.InteropServices;
+
+namespace VMS.VisionSetup.VisionTools
+{
+    /// <summary>
+    /// NativeVision.dll 공용 로더. DLL은 프로세스당 한 번만 로드하고,
+    /// 각 도구는 HasExport로 필요한 export를 확인한 뒤 없으면 관리 코드 경로를 사용.
+    /// (이전 버전 DLL에는 나중에 추가된 export가 없음)
+    /// </summary>
+    internal static class NativeVisionLibrary
+    {
+        public const string DllName = "NativeVision.dll";
+
+        private static readonly IntPtr _handle = Load();
+
+        /// <summary>DLL 로드 성공 여부</summary>
+        public static bool IsLoaded => _handle != IntPtr.Zero;
+
+        /// <summary>DLL이 로드되었고 name export가 있으면 true</summary>
+        public static bool HasExport(string name) => TryGetExport(name, out _);
+
+        /// <summary>names의 export가 모두 있으면 true</summary>
+        public static bool HasExports(params string[] names)
+        {
+            foreach (var name in names)
+                if (!HasExport(name))
+                    return false;
+            return true;
+        }
+
+        /// <summary>export 주소 조회 (함수 포인터로 직접 호출할 때)</summary>
+        public static bool TryGetExport(string name, out IntPtr address)
+        {
+            address = IntPtr.Zero;
+            return _handle != IntPtr.Zero && NativeLibrary.TryGetExport(_handle, name, out address);
+        }
+
+        private static IntPtr Load()
+        {
+            try
+            {
+                return NativeLibrary.TryLoad(DllName, typeof(NativeVisionLibrary).Assembly, null, out var lib)
+                    ? lib : IntPtr.Zero;
+            }
+            catch
+            {
+                return IntPtr.Zero;
+            }
+        }
+    }
+}
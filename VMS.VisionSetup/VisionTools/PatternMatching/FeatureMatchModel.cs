@@ -3,6 +3,7 @@ using OpenCvSharp;
 using System;
 using System.Collections.Generic;
 using System.Runtime.InteropServices;
+using System.Threading;
 
 namespace VMS.VisionSetup.VisionTools.PatternMatching
 {
@@ -26,6 +27,19 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
             set => SetProperty(ref _isEnabled, value);
         }
 
+        private Phase1Engine _phase1Engine = Phase1Engine.HoughVoting;
+        /// <summary>
+        /// How the native search finds this model's candidate poses. Response maps
+        /// cost grows with the model's point count instead of the image's edge
+        /// count, which pays off on cluttered images. The managed fallback and the
+        /// multi-instance search always use Hough voting.
+        /// </summary>
+        public Phase1Engine Phase1Engine
+        {
+            get => _phase1Engine;
+            set => SetProperty(ref _phase1Engine, value);
+        }
+
         private Mat? _templateImage;
         public Mat? TemplateImage
         {
@@ -43,6 +57,11 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
         internal List<FeatureMatchTool.EdgePoint> ModelEdges { get; set; } = new();
         internal float[]? ModelXArray { get; set; }
         internal float[]? ModelYArray { get; set; }
+        internal float[]? ModelDxArray { get; set; }
+        internal float[]? ModelDyArray { get; set; }
+        // Model points moved to their sub-pixel edge position (pose refinement only)
+        internal float[]? RefineXArray { get; set; }
+        internal float[]? RefineYArray { get; set; }
         internal int TemplateWidth { get; set; }
         internal int TemplateHeight { get; set; }
         internal double TrainedCenterX { get; set; }
@@ -64,6 +83,33 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
         internal int PoseBufferCapacity;
         internal int PoseModelN;
 
+        // Identifies this point set to the native pose-bank cache; renewed on retraining
+        private static int _nextPoseBankKey;
+        internal int PoseBankKey { get; private set; } = Interlocked.Increment(ref _nextPoseBankKey);
+
+        // Precompiled model file this point set was loaded from; its key lets the native
+        // search slice pose banks out of the file instead of building them
+        internal FeatureMatchTool.ModelFileHandle? ModelFile { get; private set; }
+
+        internal void RenewPoseBankKey()
+        {
+            ReleaseModelFile();
+            PoseBankKey = Interlocked.Increment(ref _nextPoseBankKey);
+        }
+
+        internal void UseModelFile(FeatureMatchTool.ModelFileHandle file, int poseBankKey)
+        {
+            ReleaseModelFile();
+            ModelFile = file;
+            PoseBankKey = poseBankKey;
+        }
+
+        private void ReleaseModelFile()
+        {
+            ModelFile?.Dispose();
+            ModelFile = null;
+        }
+
         public bool IsTrained => ModelEdges.Count >= 10;
 
         internal void EnsurePoseBufferCapacity(int requiredPoses, int modelPoints)
@@ -101,10 +147,22 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
         public void Dispose()
         {
             FreeNativePoseBuffers();
+            ReleaseModelFile();
             _templateImage?.Dispose();
             _templateImage = null;
             _trainedFeatureImage?.Dispose();
             _trainedFeatureImage = null;
         }
     }
+
+    /// <summary>
+    /// Candidate-pose search of a model (NativeVision ModelDesc.VoteMode).
+    /// </summary>
+    public enum Phase1Engine
+    {
+        /// <summary>Generalized Hough voting over the search edges</summary>
+        HoughVoting,
+        /// <summary>LINE-2D spread-orientation response maps</summary>
+        ResponseMaps
+    }
 }
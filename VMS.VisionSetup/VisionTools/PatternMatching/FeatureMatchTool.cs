@@ -6,11 +6,13 @@ using System.Buffers;
 using System.Collections.Generic;
 using System.Collections.ObjectModel;
 using System.Diagnostics;
+using System.IO;
 using System.Linq;
 using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
 using System.Runtime.Intrinsics;
 using System.Runtime.Intrinsics.X86;
+using System.Security.Cryptography;
 using System.Threading.Tasks;
 
 namespace VMS.VisionSetup.VisionTools.PatternMatching
@@ -31,6 +33,7 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
             public float Dx, Dy; // normalized gradient direction
             public float Magnitude; // gradient magnitude (for weighted selection)
             public float CurvatureScore; // Harris corner response (0..1)
+            public float EdgeOffset; // sub-pixel edge position along (Dx, Dy), pixels
         }
 
         #endregion
@@ -39,7 +42,7 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
 
         private static class NativeVision
         {
-            private const string DllName = "NativeVision.dll";
+            private const string DllName = NativeVisionLibrary.DllName;
 
             [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
             public static extern void ComputeGradientNative(
@@ -48,7 +51,25 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                 float* outDx, float* outDy, float* outMag);
 
             [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
-            public static extern double EvaluateBatchNative(
+            public static extern void ComputeGradientCompactNative(
+                byte* gray,
+                int width, int height, int stride,
+                uint* outPacked, ushort* outMag);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern uint* NvBeginLazyGradient(
+                MatcherHandle matcher, byte* gray, int width, int height, int stride);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern MatcherHandle NvCreateMatcher(
+                int maxW, int maxH, int maxModelPoints, int maxPoses);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvDestroyMatcher(IntPtr matcher);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern double NvEvaluateBatch(
+                MatcherHandle matcher,
                 int baseCx, int baseCy, int refRadius,
                 int* rx, int* ry, float* rdx, float* rdy,
                 float* dxImg, float* dyImg, float* magImg,
@@ -58,20 +79,66 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                 int contrastInvariant);
 
             [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
-            public static extern double EvaluateAllPosesNative(
+            public static extern double NvEvaluateCompact(
+                MatcherHandle matcher,
+                int px, int py,
+                int* rx, int* ry, float* rdx, float* rdy,
+                uint* packedImg,
+                int imgW, int N,
+                float thresh, float greedy,
+                int contrastInvariant);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvAcquirePoseBank(
+                MatcherHandle matcher, int modelKey,
+                float* modelX, float* modelY,
+                float* modelDx, float* modelDy, int modelCount,
+                double centerAngle, double angleRange, double angleStep,
+                double scaleCenter, double scaleRange, double scaleStep,
+                int* outPoseCount);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern double NvEvaluatePoseBankCompact(
+                MatcherHandle matcher, int bankIndex,
                 int baseCx, int baseCy, int refRadius,
-                int* allRx, int* allRy,
-                float* allRdx, float* allRdy,
-                int* margins,
-                int poseCount, int N,
-                float* dxImg, float* dyImg, float* magImg,
+                uint* packedImg,
                 int imgW, int imgH,
-                float thresh, float greedy,
-                int* outBestDx, int* outBestDy, int* outBestPoseIdx,
+                int* outBestDx, int* outBestDy, double* outBestAngle, double* outBestScale,
                 int contrastInvariant);
 
             [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
-            public static extern void HoughVotingNative(
+            public static extern int NvRefinePose(
+                float* modelX, float* modelY,
+                float* modelDx, float* modelDy, int modelCount,
+                float* dxImg, float* dyImg, float* magImg,
+                int imgW, int imgH, int contrastInvariant,
+                double angleLimit, double scaleLimit, int maxIterations,
+                double* ioX, double* ioY, double* ioAngle, double* ioScale);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvRefinePoseCompact(
+                float* modelX, float* modelY,
+                float* modelDx, float* modelDy, int modelCount,
+                uint* packedImg,
+                int imgW, int imgH, int contrastInvariant,
+                double angleLimit, double scaleLimit, int maxIterations,
+                double* ioX, double* ioY, double* ioAngle, double* ioScale);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern double NvTrackPose(
+                MatcherHandle matcher, int modelKey,
+                float* modelX, float* modelY,
+                float* modelDx, float* modelDy,
+                float* refineX, float* refineY, int modelCount,
+                byte* gray, int width, int height, int stride,
+                double prevX, double prevY, double prevAngle, double prevScale,
+                double maxShift, double maxRotation, double maxScaleChange,
+                double angleStep, double scaleStep, int contrastInvariant, int refineIterations,
+                double* outX, double* outY, double* outAngle, double* outScale);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvHoughVoting(
+                MatcherHandle matcher,
                 float* modelX, float* modelY, int modelCount,
                 int* binOffsets, int* binIndices, int numGradBins,
                 int* searchX, int* searchY, int* searchBin, int searchEdgeCount,
@@ -81,21 +148,512 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                 double invScale, int binShiftBits,
                 double* outBestCx, double* outBestCy, double* outBestAngle, int* outBestVotes);
 
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvHoughVotingScaled(
+                MatcherHandle matcher,
+                float* modelX, float* modelY, int modelCount,
+                int* binOffsets, int* binIndices, int numGradBins,
+                int* searchX, int* searchY, int* searchBin, int searchEdgeCount,
+                int voteWidth, int voteHeight,
+                double angleStart, double angleExtent,
+                double coarseAngleStep, double fineAngleStep, int topK,
+                double scaleCenter, double scaleRange, double scaleStep,
+                double invScale, int binShiftBits,
+                double* outBestCx, double* outBestCy, double* outBestAngle, double* outBestScale, int* outBestVotes,
+                double* outBandCenter, double* outBandRange);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvExtractSearchEdges(
+                MatcherHandle matcher,
+                byte* gray, int width, int height, int stride,
+                int levels,
+                uint* fullGrad,
+                double cannyLow, double cannyHigh, int numGradBins);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvCopySearchEdges(
+                MatcherHandle matcher, int* outX, int* outY, int* outBin);
+
+            [StructLayout(LayoutKind.Sequential)]
+            public struct MatchInstance
+            {
+                public double X, Y, Angle, Scale, Score;
+            }
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvMatchInstancesCompact(
+                MatcherHandle matcher,
+                float* modelX, float* modelY,
+                float* modelDx, float* modelDy, int modelCount,
+                int* binOffsets, int* binIndices, int numGradBins,
+                int* searchX, int* searchY, int* searchBin, int searchEdgeCount,
+                int voteWidth, int voteHeight,
+                double angleStart, double angleExtent,
+                double coarseAngleStep, double fineAngleStep,
+                double scaleCenter, double scaleRange, double scaleStep,
+                double invScale, int binShiftBits,
+                uint* packedImg,
+                int imgW, int imgH, int refRadius,
+                float thresh, float greedy, int contrastInvariant,
+                double minScore, double minDistRatio, int maxCount,
+                MatchInstance* outInstances);
+
+            [StructLayout(LayoutKind.Sequential)]
+            public struct ModelDesc
+            {
+                public float* ModelX, ModelY, ModelDx, ModelDy;
+                public int* BinOffsets, BinIndices;
+                public int ModelCount, ModelKey;
+                public int VoteMode, Reserved;
+            }
+
+            [StructLayout(LayoutKind.Sequential)]
+            public struct ModelResult
+            {
+                public double X, Y, Angle, Scale, Score;
+                public int Votes, Reserved;
+            }
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvMatchModelsCompact(
+                MatcherHandle matcher,
+                ModelDesc* models, int numModels, int numGradBins,
+                int* searchX, int* searchY, int* searchBin, int searchEdgeCount,
+                int voteWidth, int voteHeight,
+                double angleStart, double angleExtent,
+                double coarseAngleStep, double fineVoteAngleStep, int topK,
+                double invScale, int binShiftBits,
+                double fineAngleStep, double scaleCenter, double scaleRange, double scaleStep,
+                uint* packedImg,
+                int imgW, int imgH, int refRadius, int contrastInvariant,
+                ModelResult* outResults);
+
+            [StructLayout(LayoutKind.Sequential)]
+            public struct SearchParams
+            {
+                public int Levels, NumGradBins;
+                public double CannyLow, CannyHigh;
+                public double AngleStart, AngleExtent;
+                public double CoarseAngleStep, FineVoteAngleStep;
+                public int TopK, BinShiftBits;
+                public double FineAngleStep, ScaleCenter, ScaleRange, ScaleStep;
+                public int RefRadius, ContrastInvariant;
+                public double RefineMinScore, RefineScaleLimit;
+                public int RefineIterations, Reserved;
+            }
+
+            [StructLayout(LayoutKind.Sequential)]
+            public struct PipelineResult
+            {
+                public long Ticket;
+                public int Winner, Votes;
+                public double X, Y, Angle, Scale, Score;
+                public int Refined, Reserved;
+                public double PrepareMs, MatchMs;
+            }
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern PipelineHandle NvCreatePipeline(int queueDepth, int prepareThreads, int matchThreads);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvDestroyPipeline(IntPtr pipeline);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern ModelSetHandle NvCreateModelSet(
+                ModelDesc* models, int numModels, int numGradBins,
+                float** refineX, float** refineY);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvDestroyModelSet(IntPtr set);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern long NvPipelineSubmit(
+                PipelineHandle pipeline, ModelSetHandle models,
+                byte* gray, int width, int height, int stride,
+                SearchParams* searchParams);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvPipelineWait(
+                PipelineHandle pipeline, long ticket, int timeoutMs, PipelineResult* outResult);
+
+            [StructLayout(LayoutKind.Sequential)]
+            public struct ModelBankGrid
+            {
+                public double AngleStart, AngleExtent;
+                public double AngleRange, AngleStep;
+                public double ScaleCenter, ScaleRange, ScaleStep;
+            }
+
+            [StructLayout(LayoutKind.Sequential)]
+            public struct ModelFileInfo
+            {
+                public float* ModelX, ModelY, ModelDx, ModelDy;
+                public float* RefineX, RefineY, Magnitude;
+                public int* BinOffsets, BinIndices;
+                public int ModelCount, NumGradBins;
+                public int TemplateWidth, TemplateHeight;
+                public int ModelKey, PoseCount;
+            }
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvWriteModelFile(
+                [MarshalAs(UnmanagedType.LPUTF8Str)] string path,
+                ModelDesc* model, int numGradBins,
+                float* refineX, float* refineY, float* magnitude,
+                int templateWidth, int templateHeight, ModelBankGrid* grid);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern ModelFileHandle NvOpenModelFile([MarshalAs(UnmanagedType.LPUTF8Str)] string path);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvGetModelFileInfo(ModelFileHandle file, ModelFileInfo* outInfo);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvCloseModelFile(IntPtr file);
+
+            public const int StatsSlots = 16;
+
+            [StructLayout(LayoutKind.Sequential)]
+            public struct Stats
+            {
+                public fixed long StageCalls[StatsSlots];
+                public fixed long StageTicks[StatsSlots];
+                public fixed long Counters[StatsSlots];
+                public double TicksPerSecond;
+                public int Threads, Enabled;
+            }
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvSetStatsEnabled(int enabled);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvGetStats(Stats* outStats);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvResetStats();
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvConfigureWorkers(int cores, int pinThreads);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern int NvGetWorkerCores(int* outLeased);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvSetMatcherThreads(MatcherHandle matcher, int threads);
+
+            [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+            public static extern void NvSetEdgePruning(MatcherHandle matcher, double minScore);
+
+            // Entry points the matcher calls without a Has* check. A DLL missing any of
+            // them (e.g. a build that predates the matcher context) leaves the managed path.
+            private static readonly string[] CoreExports =
+            {
+                "ComputeGradientNative", "ComputeGradientCompactNative",
+                "NvCreateMatcher", "NvDestroyMatcher",
+                "NvExtractSearchEdges", "NvCopySearchEdges",
+                "NvHoughVoting", "NvMatchModelsCompact", "NvMatchInstancesCompact",
+                "NvAcquirePoseBank", "NvEvaluatePoseBankCompact", "NvEvaluateCompact",
+                "NvRefinePose", "NvRefinePoseCompact"
+            };
+
+            private static string _isaName = "";
+            private static bool _hasPipeline;
+            private static bool _hasTracking;
+            private static bool _hasLazyGradient;
+            private static bool _hasStats;
+            private static bool _hasWorkerLeases;
+            private static bool _hasModelFiles;
+            private static bool _hasScaleVoting;
+            private static bool _hasEdgePruning;
+            // Declared after CoreExports: static fields initialise in textual order
             private static readonly bool _isAvailable = ProbeNative();
 
             public static bool IsAvailable => _isAvailable;
 
+            /// <summary>DLL exports the asynchronous match pipeline.</summary>
+            public static bool HasPipeline => _isAvailable && _hasPipeline;
+
+            /// <summary>DLL exports the windowed tracking search (NvTrackPose).</summary>
+            public static bool HasTracking => _isAvailable && _hasTracking;
+
+            /// <summary>DLL computes the full-resolution gradient per tile on demand.</summary>
+            public static bool HasLazyGradient => _isAvailable && _hasLazyGradient;
+
+            /// <summary>DLL exports the stage timers and kernel counters (NvGetStats).</summary>
+            public static bool HasStats => _isAvailable && _hasStats;
+
+            /// <summary>DLL leases cores from a shared ledger (NvSetMatcherThreads).</summary>
+            public static bool HasWorkerLeases => _isAvailable && _hasWorkerLeases;
+
+            /// <summary>DLL writes and maps precompiled model files (NvOpenModelFile).</summary>
+            public static bool HasModelFiles => _isAvailable && _hasModelFiles;
+
+            /// <summary>DLL votes over the scale range in Phase 1 (NvHoughVotingScaled).</summary>
+            public static bool HasScaleVoting => _isAvailable && _hasScaleVoting;
+
+            /// <summary>DLL skips search windows too sparse in edges to reach the score (NvSetEdgePruning).</summary>
+            public static bool HasEdgePruning => _isAvailable && _hasEdgePruning;
+
+            /// <summary>SIMD kernel set chosen by the DLL at load time (e.g. "AVX2").</summary>
+            public static string IsaName => _isaName;
+
             private static bool ProbeNative()
             {
-                try
+                if (!NativeVisionLibrary.HasExports(CoreExports))
+                    return false;
+
+                // Older DLLs predate runtime dispatch and do not export the query
+                if (NativeVisionLibrary.TryGetExport("NvGetIsaName", out var fn))
+                {
+                    var getName = (delegate* unmanaged[Cdecl]<IntPtr>)fn;
+                    _isaName = Marshal.PtrToStringAnsi(getName()) ?? "";
+                }
+                _hasPipeline = NativeVisionLibrary.HasExport("NvCreatePipeline");
+                _hasTracking = NativeVisionLibrary.HasExport("NvTrackPose");
+                _hasLazyGradient = NativeVisionLibrary.HasExport("NvBeginLazyGradient");
+                _hasStats = NativeVisionLibrary.HasExport("NvGetStats");
+                _hasWorkerLeases = NativeVisionLibrary.HasExport("NvSetMatcherThreads");
+                _hasModelFiles = NativeVisionLibrary.HasExport("NvOpenModelFile");
+                _hasScaleVoting = NativeVisionLibrary.HasExport("NvHoughVotingScaled");
+                _hasEdgePruning = NativeVisionLibrary.HasExport("NvSetEdgePruning");
+                return true;
+            }
+        }
+
+        /// <summary>
+        /// Owns a native matcher context (per-thread scratch arenas). Released by the
+        /// finalizer when the tool is collected, so tools need no explicit disposal.
+        /// </summary>
+        private sealed class MatcherHandle : SafeHandle
+        {
+            public MatcherHandle() : base(IntPtr.Zero, true) { }
+
+            public override bool IsInvalid => handle == IntPtr.Zero;
+
+            protected override bool ReleaseHandle()
+            {
+                NativeVision.NvDestroyMatcher(handle);
+                return true;
+            }
+        }
+
+        /// <summary>
+        /// Owns a native match pipeline (two stage threads and their job slots).
+        /// </summary>
+        private sealed class PipelineHandle : SafeHandle
+        {
+            public PipelineHandle() : base(IntPtr.Zero, true) { }
+
+            public override bool IsInvalid => handle == IntPtr.Zero;
+
+            protected override bool ReleaseHandle()
+            {
+                NativeVision.NvDestroyPipeline(handle);
+                return true;
+            }
+        }
+
+        /// <summary>
+        /// Native copy of the models a pipeline searches. Queued jobs hold their own
+        /// reference, so the handle can be released while they are in flight.
+        /// </summary>
+        private sealed class ModelSetHandle : SafeHandle
+        {
+            public ModelSetHandle() : base(IntPtr.Zero, true) { }
+
+            public override bool IsInvalid => handle == IntPtr.Zero;
+
+            protected override bool ReleaseHandle()
+            {
+                NativeVision.NvDestroyModelSet(handle);
+                return true;
+            }
+        }
+
+        /// <summary>
+        /// Read-only mapping of a precompiled model file. Pose banks built from it keep
+        /// the mapping alive natively, so the handle may be released at any time.
+        /// </summary>
+        internal sealed class ModelFileHandle : SafeHandle
+        {
+            public ModelFileHandle() : base(IntPtr.Zero, true) { }
+
+            public override bool IsInvalid => handle == IntPtr.Zero;
+
+            protected override bool ReleaseHandle()
+            {
+                NativeVision.NvCloseModelFile(handle);
+                return true;
+            }
+        }
+
+        /// <summary>
+        /// Search-image gradients handed to the scorers: the packed int16 dx/dy plane
+        /// when the native matcher runs, float Sobel planes for the managed fallback.
+        /// </summary>
+        private readonly struct GradientPlanes
+        {
+            public readonly float* Dx, Dy, Mag;
+            public readonly uint* Packed;
+
+            public GradientPlanes(float* dx, float* dy, float* mag)
+            {
+                Dx = dx; Dy = dy; Mag = mag; Packed = null;
+            }
+
+            public GradientPlanes(uint* packed)
+            {
+                Dx = Dy = Mag = null;
+                Packed = packed;
+            }
+        }
+
+        private MatcherHandle? _matcher;
+
+        /// <summary>
+        /// Native matcher for this tool instance. Created on first use; the native side grows
+        /// its arenas on demand, so later calls with larger images or models stay valid.
+        /// </summary>
+        private MatcherHandle? GetMatcher(int voteW, int voteH, int maxModelPoints, int maxPoses)
+        {
+            if (_matcher == null || _matcher.IsInvalid)
+            {
+                _matcher?.Dispose();
+                _matcher = NativeVision.NvCreateMatcher(voteW, voteH, maxModelPoints, maxPoses);
+            }
+            if (_matcher.IsInvalid) return null;
+            if (NativeVision.HasWorkerLeases)
+                NativeVision.NvSetMatcherThreads(_matcher, MaxThreads);
+            // Windows whose edges cannot support ScoreThreshold are dropped before voting (opt-in)
+            if (NativeVision.HasEdgePruning)
+                NativeVision.NvSetEdgePruning(_matcher, UseEdgePruning ? ScoreThreshold : 0.0);
+            return _matcher;
+        }
+
+        #endregion
+
+        #region Native Statistics
+
+        /// <summary>Stage names in NvStats order (NvStage in NativeVision.cpp).</summary>
+        public static readonly string[] NativeStageNames =
+        {
+            "Gradient", "SearchEdges", "VoteCoarse", "VoteFine", "PoseBank",
+            "Score", "Instances", "Refine", "Track", "Alloc", "Prune"
+        };
+
+        /// <summary>Counter names in NvStats order (NvCounter in NativeVision.cpp).</summary>
+        public static readonly string[] NativeCounterNames =
+        {
+            "EdgesVoted", "AccumulatorCells", "AnglesVoted", "Poses", "Positions", "PosesPruned",
+            "Evaluations", "EarlyExits", "GradientTiles", "PoseBankHits", "PoseBankMisses",
+            "BusyTicks", "SpanTicks", "WindowsBounded", "WindowsRejected", "EdgesPruned"
+        };
+
+        /// <summary>
+        /// Process-wide totals of the native stage timers and kernel counters since the
+        /// last reset. Stage times are exclusive: a stage's nested stages are not included.
+        /// </summary>
+        public sealed class NativeStatsSnapshot
+        {
+            public long[] StageCalls { get; } = new long[NativeStageNames.Length];
+            public double[] StageMs { get; } = new double[NativeStageNames.Length];
+            public long[] Counters { get; } = new long[NativeCounterNames.Length];
+            public int Threads { get; init; }
+
+            public long Counter(string name) => Counters[Array.IndexOf(NativeCounterNames, name)];
+
+            /// <summary>Share of scored positions rejected by the greediness early exit.</summary>
+            public double EarlyExitRate
+            {
+                get
                 {
-                    return NativeLibrary.TryLoad(DllName, typeof(NativeVision).Assembly, null, out _);
+                    long evaluations = Counter("Evaluations");
+                    return evaluations > 0 ? (double)Counter("EarlyExits") / evaluations : 0;
                 }
-                catch
+            }
+
+            /// <summary>Share of bounded search windows rejected by edge-density pruning.</summary>
+            public double PruneRate
+            {
+                get
                 {
-                    return false;
+                    long bounded = Counter("WindowsBounded");
+                    return bounded > 0 ? (double)Counter("WindowsRejected") / bounded : 0;
                 }
             }
+
+            /// <summary>Busy share of thread time inside the parallel search loops.</summary>
+            public double ThreadUtilization
+            {
+                get
+                {
+                    long span = Counter("SpanTicks");
+                    return span > 0 ? Math.Min(1.0, (double)Counter("BusyTicks") / span) : 0;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Turns the native stats recording on or off at runtime. Off by default; when
+        /// off every hook reduces to one relaxed load.
+        /// </summary>
+        public static bool NativeStatsEnabled
+        {
+            get
+            {
+                if (!NativeVision.HasStats) return false;
+                NativeVision.Stats s;
+                NativeVision.NvGetStats(&s);
+                return s.Enabled != 0;
+            }
+            set
+            {
+                if (NativeVision.HasStats) NativeVision.NvSetStatsEnabled(value ? 1 : 0);
+            }
+        }
+
+        public static void ResetNativeStats()
+        {
+            if (NativeVision.HasStats) NativeVision.NvResetStats();
+        }
+
+        /// <summary>Current totals, or null when the DLL does not export stats.</summary>
+        public static NativeStatsSnapshot? GetNativeStats()
+        {
+            if (!NativeVision.HasStats) return null;
+
+            NativeVision.Stats s;
+            NativeVision.NvGetStats(&s);
+            var snapshot = new NativeStatsSnapshot { Threads = s.Threads };
+            double msPerTick = s.TicksPerSecond > 0 ? 1000.0 / s.TicksPerSecond : 0;
+            for (int i = 0; i < NativeStageNames.Length; i++)
+            {
+                snapshot.StageCalls[i] = s.StageCalls[i];
+                snapshot.StageMs[i] = s.StageTicks[i] * msPerTick;
+            }
+            for (int i = 0; i < NativeCounterNames.Length; i++)
+                snapshot.Counters[i] = s.Counters[i];
+            return snapshot;
+        }
+
+        /// <summary>
+        /// Limits the cores all native matchers share (0 = every processor). Concurrent
+        /// searches split them fairly; with pinThreads each team's worker threads stay on
+        /// their leased cores (the calling thread is never pinned). Set once at startup,
+        /// before inspections run; the VMS app applies SystemConfiguration.NativeWorkerCores.
+        /// </summary>
+        public static void ConfigureNativeWorkers(int cores, bool pinThreads)
+        {
+            if (NativeVision.HasWorkerLeases) NativeVision.NvConfigureWorkers(cores, pinThreads ? 1 : 0);
+        }
+
+        /// <summary>Cores in the shared ledger and how many are leased right now.</summary>
+        public static (int Cores, int Leased) GetNativeWorkerCores()
+        {
+            if (!NativeVision.HasWorkerLeases) return (Environment.ProcessorCount, 0);
+            int leased;
+            int cores = NativeVision.NvGetWorkerCores(&leased);
+            return (cores, leased);
         }
 
         #endregion
@@ -187,6 +745,77 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
         private bool _useContrastInvariant;
         public bool UseContrastInvariant { get => _useContrastInvariant; set => SetProperty(ref _useContrastInvariant, value); }
 
+        private int _maxInstances = 1;
+        /// <summary>
+        /// Maximum number of non-overlapping matches to report. Values above 1 use the
+        /// native multi-instance search (requires NativeVision.dll).
+        /// </summary>
+        public int MaxInstances
+        {
+            get => _maxInstances;
+            set => SetProperty(ref _maxInstances, Math.Max(1, value));
+        }
+
+        private bool _useTracking;
+        /// <summary>
+        /// Once a part is found, search the next frame only around its last pose
+        /// (TrackMaxShift / TrackMaxRotation / TrackMaxScaleChange) and skip voting.
+        /// Falls back to the full search whenever the tracked score is below
+        /// ScoreThreshold. Single-instance native search only.
+        /// </summary>
+        public bool UseTracking
+        {
+            get => _useTracking;
+            set
+            {
+                if (SetProperty(ref _useTracking, value))
+                    ResetTracking();
+            }
+        }
+
+        private double _trackMaxShift = 8.0;
+        /// <summary>Largest movement between frames while tracking, in pixels.</summary>
+        public double TrackMaxShift
+        {
+            get => _trackMaxShift;
+            set => SetProperty(ref _trackMaxShift, Math.Clamp(value, 1, 100));
+        }
+
+        private double _trackMaxRotation = 3.0;
+        /// <summary>Largest rotation between frames while tracking, in degrees.</summary>
+        public double TrackMaxRotation
+        {
+            get => _trackMaxRotation;
+            set => SetProperty(ref _trackMaxRotation, Math.Clamp(value, 0, 45));
+        }
+
+        private double _trackMaxScaleChange;
+        /// <summary>Largest scale change between frames while tracking (0 keeps the scale).</summary>
+        public double TrackMaxScaleChange
+        {
+            get => _trackMaxScaleChange;
+            set => SetProperty(ref _trackMaxScaleChange, Math.Clamp(value, 0, 0.5));
+        }
+
+        private int _maxThreads;
+        /// <summary>
+        /// Most threads one search of this tool may use (0 = fair share of all cores).
+        /// Lets several tools or cameras run side by side without oversubscribing.
+        /// </summary>
+        public int MaxThreads
+        {
+            get => _maxThreads;
+            set => SetProperty(ref _maxThreads, Math.Clamp(value, 0, 256));
+        }
+
+        private bool _useEdgePruning;
+        /// <summary>
+        /// Skip search windows with too few edges to reach ScoreThreshold before voting
+        /// and scoring. Faster on sparse scenes, but the edge-count bound is a heuristic
+        /// and can drop a faint or partly occluded match, so it is off by default.
+        /// </summary>
+        public bool UseEdgePruning { get => _useEdgePruning; set => SetProperty(ref _useEdgePruning, value); }
+
         private double _curvatureWeight = 0.4;
         public double CurvatureWeight
         {
@@ -305,16 +934,7 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                 model.TemplateWidth = patternImage.Width;
                 model.TemplateHeight = patternImage.Height;
 
-                if (UseROI && ROI.Width > 0 && ROI.Height > 0)
-                {
-                    model.TrainedCenterX = ROI.X + patternImage.Width / 2.0;
-                    model.TrainedCenterY = ROI.Y + patternImage.Height / 2.0;
-                }
-                else
-                {
-                    model.TrainedCenterX = patternImage.Width / 2.0;
-                    model.TrainedCenterY = patternImage.Height / 2.0;
-                }
+                SetTrainedCenter(model, patternImage);
 
                 using var gray = patternImage.Channels() > 1
                     ? patternImage.CvtColor(ColorConversionCodes.BGR2GRAY)
@@ -352,7 +972,8 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                             X = x - cx, Y = y - cy,
                             Dx = gx / mag, Dy = gy / mag,
                             Magnitude = mag,
-                            CurvatureScore = Math.Clamp(cv, 0f, 1f)
+                            CurvatureScore = Math.Clamp(cv, 0f, 1f),
+                            EdgeOffset = SubPixelEdgeOffset(sobelX, sobelY, x, y, gx / mag, gy / mag, mag)
                         });
                     }
 
@@ -391,14 +1012,27 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                         model.BinIndices[model.BinOffsets[b] + i] = list[i];
                 }
 
-                // Cache model X/Y as float arrays for native Hough voting
+                // Cache model X/Y (and gradient direction) as float arrays for native search
                 model.ModelXArray = new float[model.ModelEdges.Count];
                 model.ModelYArray = new float[model.ModelEdges.Count];
+                model.ModelDxArray = new float[model.ModelEdges.Count];
+                model.ModelDyArray = new float[model.ModelEdges.Count];
                 for (int i = 0; i < model.ModelEdges.Count; i++)
                 {
                     model.ModelXArray[i] = model.ModelEdges[i].X;
                     model.ModelYArray[i] = model.ModelEdges[i].Y;
+                    model.ModelDxArray[i] = model.ModelEdges[i].Dx;
+                    model.ModelDyArray[i] = model.ModelEdges[i].Dy;
                 }
+                model.RefineXArray = new float[model.ModelEdges.Count];
+                model.RefineYArray = new float[model.ModelEdges.Count];
+                for (int i = 0; i < model.ModelEdges.Count; i++)
+                {
+                    var e = model.ModelEdges[i];
+                    model.RefineXArray[i] = e.X + e.EdgeOffset * e.Dx;
+                    model.RefineYArray[i] = e.Y + e.EdgeOffset * e.Dy;
+                }
+                model.RenewPoseBankKey();
 
                 // Generate training feature visualization
                 BuildTrainedFeatureImage(model, patternImage);
@@ -443,6 +1077,37 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                 LastMatchedModel = null;
         }
 
+        /// <summary>
+        /// Sub-pixel position of the edge at (x, y) along its gradient direction: the
+        /// vertex of a parabola through the gradient magnitude one pixel either side,
+        /// sampled bilinearly. Canny puts the edge on whole pixels; pose refinement
+        /// needs where it really is.
+        /// </summary>
+        private static float SubPixelEdgeOffset(Mat sobelX, Mat sobelY, int x, int y, float dx, float dy, float mag)
+        {
+            float before = BilinearMagnitude(sobelX, sobelY, x - dx, y - dy);
+            float after = BilinearMagnitude(sobelX, sobelY, x + dx, y + dy);
+            float denom = before - 2f * mag + after;
+            if (denom >= 0f) return 0f;
+            return Math.Clamp(0.5f * (before - after) / denom, -0.5f, 0.5f);
+        }
+
+        private static float BilinearMagnitude(Mat sobelX, Mat sobelY, float x, float y)
+        {
+            int x0 = Math.Clamp((int)MathF.Floor(x), 0, sobelX.Cols - 2);
+            int y0 = Math.Clamp((int)MathF.Floor(y), 0, sobelX.Rows - 2);
+            float fx = Math.Clamp(x - x0, 0f, 1f), fy = Math.Clamp(y - y0, 0f, 1f);
+
+            float Mag(int xx, int yy)
+            {
+                float gx = sobelX.At<float>(yy, xx), gy = sobelY.At<float>(yy, xx);
+                return MathF.Sqrt(gx * gx + gy * gy);
+            }
+
+            return (1 - fx) * (1 - fy) * Mag(x0, y0) + fx * (1 - fy) * Mag(x0 + 1, y0)
+                + (1 - fx) * fy * Mag(x0, y0 + 1) + fx * fy * Mag(x0 + 1, y0 + 1);
+        }
+
         private static List<EdgePoint> SpatialSample(List<EdgePoint> allEdges, int maxPoints, int imgW, int imgH, double curvatureWeight = 0.0)
         {
             float cx = imgW / 2.0f;
@@ -555,6 +1220,20 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
             HasSuggestions = false;
         }
 
+        private void SetTrainedCenter(FeatureMatchModel model, Mat patternImage)
+        {
+            if (UseROI && ROI.Width > 0 && ROI.Height > 0)
+            {
+                model.TrainedCenterX = ROI.X + patternImage.Width / 2.0;
+                model.TrainedCenterY = ROI.Y + patternImage.Height / 2.0;
+            }
+            else
+            {
+                model.TrainedCenterX = patternImage.Width / 2.0;
+                model.TrainedCenterY = patternImage.Height / 2.0;
+            }
+        }
+
         private static void BuildTrainedFeatureImage(FeatureMatchModel model, Mat patternImage)
         {
             model.TrainedFeatureImage?.Dispose();
@@ -591,6 +1270,225 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
 
         #endregion
 
+        #region Precompiled Models
+
+        // Bumped whenever training or the file layout changes, so stale cache files are ignored
+        private const int MODEL_FILE_VERSION = 1;
+        // Largest pose bank written into one model file; wider search ranges skip it
+        private const long MODEL_FILE_BANK_LIMIT = 64L << 20;
+        // Total size of ModelCacheDirectory; least recently used files are evicted past it
+        private const long MODEL_CACHE_LIMIT = 512L << 20;
+
+        /// <summary>
+        /// Precompiled model files, named after a hash of the template and the
+        /// parameters that shape the trained model. A file's write time is its last
+        /// use; the directory is trimmed to MODEL_CACHE_LIMIT after every write.
+        /// </summary>
+        public static string ModelCacheDirectory { get; } = Path.Combine(
+            Environment.GetFolderPath(Environment.SpecialFolder.LocalApplicationData),
+            "BODA VISION AI", "ModelCache");
+
+        /// <summary>
+        /// Trains from a saved template, mapping the precompiled model from the cache
+        /// instead when one exists (recipe load / changeover). A model trained here is
+        /// written to the cache for the next load. encodedTemplate is the template as
+        /// stored in the recipe and only keys the cache.
+        /// </summary>
+        public bool TrainPatternCached(Mat patternImage, byte[] encodedTemplate)
+        {
+            if (!NativeVision.HasModelFiles)
+                return TrainPattern(patternImage);
+
+            string path = ModelCachePath(encodedTemplate);
+            if (File.Exists(path))
+            {
+                TouchModelCacheFile(path);
+                if (LoadModelFile(path, patternImage))
+                    return true;
+            }
+
+            if (!TrainPattern(patternImage))
+                return false;
+            var model = Models.LastOrDefault();
+            if (model != null && SaveModelFile(model, path))
+                TrimModelCache(path);
+            return true;
+        }
+
+        /// <summary>
+        /// Writes a trained model as a precompiled model file, with the pose bank for
+        /// the current angle/scale range when it fits MODEL_FILE_BANK_LIMIT.
+        /// </summary>
+        public bool SaveModelFile(FeatureMatchModel model, string path)
+        {
+            if (!NativeVision.HasModelFiles || !model.IsTrained
+                || model.ModelXArray == null || model.ModelYArray == null
+                || model.ModelDxArray == null || model.ModelDyArray == null
+                || model.BinOffsets == null || model.BinIndices == null)
+                return false;
+
+            try
+            {
+                Directory.CreateDirectory(Path.GetDirectoryName(Path.GetFullPath(path))!);
+
+                int n = model.ModelEdges.Count;
+                var magnitude = new float[n];
+                for (int i = 0; i < n; i++)
+                    magnitude[i] = model.ModelEdges[i].Magnitude;
+
+                // Same grid as MatchModelsBatched's pose banks
+                var grid = new NativeVision.ModelBankGrid
+                {
+                    AngleStart = AngleStart,
+                    AngleExtent = AngleExtent,
+                    AngleRange = Math.Max(AngleStep, 4.0),
+                    AngleStep = Math.Max(0.1, AngleStep / 2.0),
+                    ScaleCenter = (MinScale + MaxScale) / 2.0,
+                    ScaleRange = (MaxScale - MinScale) / 2.0,
+                    ScaleStep = Math.Max(0.001, ScaleStep)
+                };
+                long bankAngles = (long)((grid.AngleExtent + 2 * grid.AngleRange) / grid.AngleStep) + 1;
+                long bankScales = (long)(2 * grid.ScaleRange / grid.ScaleStep) + 1;
+                bool withBank = bankAngles * bankScales * n * 16 <= MODEL_FILE_BANK_LIMIT;
+
+                fixed (float* pX = model.ModelXArray, pY = model.ModelYArray)
+                fixed (float* pDx = model.ModelDxArray, pDy = model.ModelDyArray)
+                fixed (float* pRefineX = model.RefineXArray, pRefineY = model.RefineYArray, pMag = magnitude)
+                fixed (int* pBinOffsets = model.BinOffsets, pBinIndices = model.BinIndices)
+                {
+                    var desc = new NativeVision.ModelDesc
+                    {
+                        ModelX = pX, ModelY = pY, ModelDx = pDx, ModelDy = pDy,
+                        BinOffsets = pBinOffsets, BinIndices = pBinIndices,
+                        ModelCount = n, ModelKey = model.PoseBankKey
+                    };
+                    return NativeVision.NvWriteModelFile(path, &desc, NUM_GRAD_BINS,
+                        pRefineX, pRefineY, pMag, model.TemplateWidth, model.TemplateHeight,
+                        withBank ? &grid : null) != 0;
+                }
+            }
+            catch { return false; }
+        }
+
+        /// <summary>
+        /// Adds a model from a precompiled model file. The point arrays are copied out
+        /// of the mapping (a few KB); the pose bank stays mapped and is shared by every
+        /// tool and process that opens the same file. templateImage must be the image
+        /// the model was trained from.
+        /// </summary>
+        public bool LoadModelFile(string path, Mat templateImage)
+        {
+            if (!NativeVision.HasModelFiles) return false;
+
+            var file = NativeVision.NvOpenModelFile(path);
+            NativeVision.ModelFileInfo info;
+            if (file.IsInvalid || NativeVision.NvGetModelFileInfo(file, &info) == 0
+                || info.NumGradBins != NUM_GRAD_BINS
+                || info.TemplateWidth != templateImage.Width || info.TemplateHeight != templateImage.Height)
+            {
+                file.Dispose();
+                return false;
+            }
+
+            int n = info.ModelCount;
+            var model = new FeatureMatchModel { Name = $"Model {Models.Count + 1}" };
+            model.TemplateImage = templateImage.Clone();
+            model.TemplateWidth = info.TemplateWidth;
+            model.TemplateHeight = info.TemplateHeight;
+            SetTrainedCenter(model, templateImage);
+
+            model.ModelXArray = new ReadOnlySpan<float>(info.ModelX, n).ToArray();
+            model.ModelYArray = new ReadOnlySpan<float>(info.ModelY, n).ToArray();
+            model.ModelDxArray = new ReadOnlySpan<float>(info.ModelDx, n).ToArray();
+            model.ModelDyArray = new ReadOnlySpan<float>(info.ModelDy, n).ToArray();
+            model.RefineXArray = new ReadOnlySpan<float>(info.RefineX, n).ToArray();
+            model.RefineYArray = new ReadOnlySpan<float>(info.RefineY, n).ToArray();
+            model.BinOffsets = new ReadOnlySpan<int>(info.BinOffsets, NUM_GRAD_BINS + 1).ToArray();
+            model.BinIndices = new ReadOnlySpan<int>(info.BinIndices, model.BinOffsets[NUM_GRAD_BINS]).ToArray();
+
+            var edges = new List<EdgePoint>(n);
+            for (int i = 0; i < n; i++)
+            {
+                float dx = info.ModelDx[i], dy = info.ModelDy[i];
+                edges.Add(new EdgePoint
+                {
+                    X = info.ModelX[i], Y = info.ModelY[i],
+                    Dx = dx, Dy = dy,
+                    Magnitude = info.Magnitude[i],
+                    EdgeOffset = (info.RefineX[i] - info.ModelX[i]) * dx + (info.RefineY[i] - info.ModelY[i]) * dy
+                });
+            }
+            model.ModelEdges = edges;
+
+            model.GradBinTable = new List<int>[NUM_GRAD_BINS];
+            for (int b = 0; b < NUM_GRAD_BINS; b++)
+            {
+                model.GradBinTable[b] = new List<int>(model.BinOffsets[b + 1] - model.BinOffsets[b]);
+                for (int k = model.BinOffsets[b]; k < model.BinOffsets[b + 1]; k++)
+                    model.GradBinTable[b].Add(model.BinIndices[k]);
+            }
+
+            // Pose buffers are left to the first search that needs them
+            model.UseModelFile(file, info.ModelKey);
+            BuildTrainedFeatureImage(model, templateImage);
+
+            Models.Add(model);
+            SelectedModel = model;
+            OnPropertyChanged(nameof(TemplateImage));
+            OnPropertyChanged(nameof(TrainedFeatureImage));
+            OnPropertyChanged(nameof(SelectedModelTemplateImage));
+            OnPropertyChanged(nameof(SelectedModelFeatureImage));
+            return model.IsTrained;
+        }
+
+        private string ModelCachePath(byte[] encodedTemplate)
+        {
+            using var sha = IncrementalHash.CreateHash(HashAlgorithmName.SHA256);
+            sha.AppendData(encodedTemplate);
+            var key = FormattableString.Invariant(
+                $"{MODEL_FILE_VERSION}|{CannyLow}|{CannyHigh}|{MaxModelPoints}|{CurvatureWeight}|{AngleStart}|{AngleExtent}|{AngleStep}|{MinScale}|{MaxScale}|{ScaleStep}");
+            sha.AppendData(System.Text.Encoding.UTF8.GetBytes(key));
+            return Path.Combine(ModelCacheDirectory, Convert.ToHexString(sha.GetHashAndReset()) + ".nvm");
+        }
+
+        // Marks a cache file as just used (NTFS last-access times are often disabled)
+        private static void TouchModelCacheFile(string path)
+        {
+            try { File.SetLastWriteTimeUtc(path, DateTime.UtcNow); }
+            catch { }
+        }
+
+        /// <summary>
+        /// Deletes the least recently used cache files until the directory fits
+        /// MODEL_CACHE_LIMIT. keep (the file just written) is never evicted; files
+        /// still mapped by another tool or process fail to delete and are skipped.
+        /// </summary>
+        private static void TrimModelCache(string keep)
+        {
+            try
+            {
+                var files = new DirectoryInfo(ModelCacheDirectory).GetFiles("*.nvm");
+                long total = files.Sum(f => f.Length);
+                if (total <= MODEL_CACHE_LIMIT) return;
+
+                string keepPath = Path.GetFullPath(keep);
+                foreach (var file in files.OrderBy(f => f.LastWriteTimeUtc))
+                {
+                    if (total <= MODEL_CACHE_LIMIT) break;
+                    if (string.Equals(file.FullName, keepPath, StringComparison.OrdinalIgnoreCase)) continue;
+                    try
+                    {
+                        file.Delete();
+                        total -= file.Length;
+                    }
+                    catch { }
+                }
+            }
+            catch { }
+        }
+
+        #endregion
+
         #region Execute
 
         public override VisionResult Execute(Mat inputImage)
@@ -627,116 +1525,171 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                 int W = searchGray.Cols, H = searchGray.Rows;
 
                 // ── 2. Gradient computation (shared across all models) ──
-                using var sSobelX = new Mat(H, W, MatType.CV_32F);
-                using var sSobelY = new Mat(H, W, MatType.CV_32F);
-                using var sMag = new Mat(H, W, MatType.CV_32F);
+                // The native scorers read one packed int16 dx/dy plane (4 B/px);
+                // the managed fallback keeps the three float planes.
+                int actualLevels = Math.Max(1, Math.Min(NumLevels, 5));
+                double pyramidScale = Math.Pow(2, actualLevels - 1);
+                // Voting-level size: every PyrDown halves, rounding up
+                int vW = W, vH = H;
+                for (int lvl = 1; lvl < actualLevels; lvl++)
+                {
+                    vW = (vW + 1) / 2;
+                    vH = (vH + 1) / 2;
+                }
+
+                var matcher = NativeVision.IsAvailable
+                    ? GetMatcher(vW, vH,
+                        enabledModels.Max(m => m.ModelEdges.Count),
+                        enabledModels.Max(m => m.PoseBufferCapacity))
+                    : null;
+
+                // ── 1b. Tracking: score only the window around the last pose ──
+                if (matcher != null && UseTracking && MaxInstances == 1)
+                {
+                    var tracked = TrackLastPose(matcher, enabledModels, searchGray, offsetX, offsetY);
+                    if (tracked != null)
+                    {
+                        var (model, score, x, y, angle, scale) = tracked.Value;
+                        sw.Stop();
+                        ExecutionTime = sw.Elapsed.TotalMilliseconds;
+                        LastMatchedModel = model;
+                        SetMatchData(result, model, score, x, y, angle, scale);
+                        result.Message += ", Tracked";
+                        result.Data["Tracked"] = true;
+                        result.OverlayImage = DrawOverlay(inputImage, x, y, angle, scale,
+                            model.TemplateWidth, model.TemplateHeight, model.ModelEdges);
+                        return result;
+                    }
+                }
 
-                float* dxPtr = (float*)sSobelX.Data;
-                float* dyPtr = (float*)sSobelY.Data;
-                float* magPtr = (float*)sMag.Data;
+                // The matcher's lazy plane computes only the tiles Phase 2 and
+                // refinement read (searchGray outlives every call on it)
+                uint* lazyPlane = matcher != null && NativeVision.HasLazyGradient
+                    ? NativeVision.NvBeginLazyGradient(matcher,
+                        (byte*)searchGray.Data, W, H, (int)searchGray.Step())
+                    : null;
 
-                if (NativeVision.IsAvailable)
+                using var sPacked = matcher != null && lazyPlane == null ? new Mat(H, W, MatType.CV_32S) : null;
+                using var sSobelX = matcher == null ? new Mat(H, W, MatType.CV_32F) : null;
+                using var sSobelY = matcher == null ? new Mat(H, W, MatType.CV_32F) : null;
+                using var sMag = matcher == null ? new Mat(H, W, MatType.CV_32F) : null;
+
+                GradientPlanes grad;
+                if (lazyPlane != null)
+                {
+                    grad = new GradientPlanes(lazyPlane);
+                }
+                else if (sPacked != null)
                 {
-                    NativeVision.ComputeGradientNative(
+                    NativeVision.ComputeGradientCompactNative(
                         (byte*)searchGray.Data,
                         W, H, (int)searchGray.Step(),
-                        dxPtr, dyPtr, magPtr);
+                        (uint*)sPacked.Data, null);
+                    grad = new GradientPlanes((uint*)sPacked.Data);
                 }
                 else
                 {
-                    Cv2.Sobel(searchGray, sSobelX, MatType.CV_32F, 1, 0, 3);
-                    Cv2.Sobel(searchGray, sSobelY, MatType.CV_32F, 0, 1, 3);
-                    Cv2.Magnitude(sSobelX, sSobelY, sMag);
-                }
-
-                // ── 3. Shared pyramid voting image ──
-                int actualLevels = Math.Max(1, Math.Min(NumLevels, 5));
-                Mat? coarseImg = null;
-                double pyramidScale = 1.0;
-                if (actualLevels > 1)
-                {
-                    coarseImg = searchGray;
-                    for (int lvl = 0; lvl < actualLevels - 1; lvl++)
+                    if (NativeVision.IsAvailable)
+                    {
+                        NativeVision.ComputeGradientNative(
+                            (byte*)searchGray.Data,
+                            W, H, (int)searchGray.Step(),
+                            (float*)sSobelX!.Data, (float*)sSobelY!.Data, (float*)sMag!.Data);
+                    }
+                    else
                     {
-                        var temp = new Mat();
-                        Cv2.PyrDown(coarseImg, temp);
-                        if (coarseImg != searchGray) coarseImg.Dispose();
-                        coarseImg = temp;
+                        Cv2.Sobel(searchGray, sSobelX!, MatType.CV_32F, 1, 0, 3);
+                        Cv2.Sobel(searchGray, sSobelY!, MatType.CV_32F, 0, 1, 3);
+                        Cv2.Magnitude(sSobelX!, sSobelY!, sMag!);
                     }
-                    pyramidScale = Math.Pow(2, actualLevels - 1);
+                    grad = new GradientPlanes((float*)sSobelX!.Data, (float*)sSobelY!.Data, (float*)sMag!.Data);
                 }
 
-                var voteImg = coarseImg ?? searchGray;
-                int vW = voteImg.Cols, vH = voteImg.Rows;
-
-                using var voteEdges = voteImg.Canny(CannyLow, CannyHigh);
-                using var votePhase = new Mat();
+                // ── 3. Search edges on the voting pyramid level ──
+                var pool = ArrayPool<int>.Shared;
+                int[] seX, seY, seBin;
+                int searchEdgeCount;
+                if (matcher != null)
                 {
-                    using var vsx = new Mat();
-                    using var vsy = new Mat();
-                    Cv2.Sobel(voteImg, vsx, MatType.CV_32F, 1, 0, 3);
-                    Cv2.Sobel(voteImg, vsy, MatType.CV_32F, 0, 1, 3);
-                    Cv2.Phase(vsx, vsy, votePhase, true);
+                    // Pyramid, Canny and phase bins in one native pass; at full
+                    // resolution the packed gradient above is reused
+                    searchEdgeCount = NativeVision.NvExtractSearchEdges(
+                        matcher,
+                        (byte*)searchGray.Data, W, H, (int)searchGray.Step(),
+                        actualLevels, grad.Packed,
+                        CannyLow, CannyHigh, NUM_GRAD_BINS);
+                    seX = pool.Rent(searchEdgeCount);
+                    seY = pool.Rent(searchEdgeCount);
+                    seBin = pool.Rent(searchEdgeCount);
+                    fixed (int* pSeX = seX, pSeY = seY, pSeBin = seBin)
+                        NativeVision.NvCopySearchEdges(matcher, pSeX, pSeY, pSeBin);
                 }
-
-                byte* vEdgePtr = (byte*)voteEdges.Data;
-                float* vPhasePtr = (float*)votePhase.Data;
-
-                int vtotalPx = vW * vH;
-                int vEdgeCount = 0;
-                for (int i = 0; i < vtotalPx; i++)
-                    if (vEdgePtr[i] > 0) vEdgeCount++;
-
-                var pool = ArrayPool<int>.Shared;
-                int[] seX = pool.Rent(vEdgeCount);
-                int[] seY = pool.Rent(vEdgeCount);
-                int[] seBin = pool.Rent(vEdgeCount);
-                int sei = 0;
-                for (int idx = 0; idx < vtotalPx; idx++)
+                else
                 {
-                    if (vEdgePtr[idx] > 0)
-                    {
-                        seX[sei] = idx % vW;
-                        seY[sei] = idx / vW;
-                        int b = (int)(vPhasePtr[idx] / BIN_WIDTH_DEG);
-                        if (b < 0) b += NUM_GRAD_BINS;
-                        if (b >= NUM_GRAD_BINS) b = NUM_GRAD_BINS - 1;
-                        seBin[sei] = b;
-                        sei++;
-                    }
+                    searchEdgeCount = ExtractSearchEdges(searchGray, actualLevels, pool,
+                        out seX, out seY, out seBin);
                 }
-                int searchEdgeCount = sei;
 
                 // ── 4. Iterate all enabled models ──
                 double globalBestScore = 0;
                 double globalBestX = 0, globalBestY = 0, globalBestAngle = 0, globalBestScale = 1.0;
                 FeatureMatchModel? bestModel = null;
                 double globalBestVoteVal = 0;
+                List<MatchInstanceResult>? instances = null;
 
-                foreach (var model in enabledModels)
+                if (MaxInstances > 1 && matcher != null)
                 {
-                    var (modelScore, modelX, modelY, modelAngle, modelScale, modelVoteVal) =
-                        MatchSingleModel(model, searchGray, dxPtr, dyPtr, magPtr,
-                            W, H, offsetX, offsetY, pyramidScale, actualLevels,
-                            vW, vH, seX, seY, seBin, searchEdgeCount, pool);
+                    instances = MatchInstancesAllModels(matcher, enabledModels,
+                        grad, W, H, offsetX, offsetY,
+                        pyramidScale, actualLevels, vW, vH,
+                        seX, seY, seBin, searchEdgeCount);
 
-                    if (modelScore > globalBestScore)
+                    if (instances.Count > 0)
+                    {
+                        var first = instances[0];
+                        globalBestScore = first.Score;
+                        globalBestX = first.CenterX - offsetX;
+                        globalBestY = first.CenterY - offsetY;
+                        globalBestAngle = first.Angle;
+                        globalBestScale = first.Scale;
+                        bestModel = first.Model;
+                    }
+                }
+                else if (matcher != null && enabledModels.Count > 1)
+                {
+                    // One native call for all models: shared voting pass, and
+                    // scoring that drops models which can no longer win
+                    (bestModel, globalBestScore, globalBestX, globalBestY,
+                        globalBestAngle, globalBestScale, globalBestVoteVal) =
+                        MatchModelsBatched(matcher, enabledModels, grad,
+                            W, H, pyramidScale, actualLevels,
+                            vW, vH, seX, seY, seBin, searchEdgeCount);
+                }
+                else
+                {
+                    foreach (var model in enabledModels)
                     {
-                        globalBestScore = modelScore;
-                        globalBestX = modelX;
-                        globalBestY = modelY;
-                        globalBestAngle = modelAngle;
-                        globalBestScale = modelScale;
-                        bestModel = model;
-                        globalBestVoteVal = modelVoteVal;
+                        var (modelScore, modelX, modelY, modelAngle, modelScale, modelVoteVal) =
+                            MatchSingleModel(matcher, model, searchGray, grad,
+                                W, H, offsetX, offsetY, pyramidScale, actualLevels,
+                                vW, vH, seX, seY, seBin, searchEdgeCount, pool);
+
+                        if (modelScore > globalBestScore)
+                        {
+                            globalBestScore = modelScore;
+                            globalBestX = modelX;
+                            globalBestY = modelY;
+                            globalBestAngle = modelAngle;
+                            globalBestScale = modelScale;
+                            bestModel = model;
+                            globalBestVoteVal = modelVoteVal;
+                        }
                     }
                 }
 
                 pool.Return(seX);
                 pool.Return(seY);
                 pool.Return(seBin);
-                if (coarseImg != null && coarseImg != searchGray)
-                    coarseImg.Dispose();
 
                 // ── 5. Build result ──
                 sw.Stop();
@@ -748,22 +1701,38 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                     double finalX = globalBestX + offsetX;
                     double finalY = globalBestY + offsetY;
 
-                    result.Success = true;
-                    string modelInfo = Models.Count > 1 ? $", Model={bestModel.Name}" : "";
-                    result.Message = $"Score={globalBestScore:F3}, Pos=({finalX:F1},{finalY:F1}), Angle={globalBestAngle:F2}, Scale={globalBestScale:F3}{modelInfo}";
-                    result.Data["Score"] = globalBestScore;
-                    result.Data["CenterX"] = finalX;
-                    result.Data["CenterY"] = finalY;
-                    result.Data["Angle"] = globalBestAngle;
-                    result.Data["Scale"] = globalBestScale;
-                    result.Data["MatchedModel"] = bestModel.Name;
-                    result.Data["TrainedCenterX"] = bestModel.TrainedCenterX;
-                    result.Data["TrainedCenterY"] = bestModel.TrainedCenterY;
-                    result.OverlayImage = DrawOverlay(inputImage, finalX, finalY, globalBestAngle, globalBestScale,
-                        bestModel.TemplateWidth, bestModel.TemplateHeight, bestModel.ModelEdges);
+                    SetMatchData(result, bestModel, globalBestScore, finalX, finalY, globalBestAngle, globalBestScale);
+                    if (UseTracking)
+                    {
+                        result.Data["Tracked"] = false;
+                        RememberTrackPose(bestModel, finalX, finalY, globalBestAngle, globalBestScale);
+                    }
+
+                    if (instances != null)
+                    {
+                        result.Message += $", Count={instances.Count}";
+                        result.Data["InstanceCount"] = instances.Count;
+                        result.Data["Instances"] = instances;
+
+                        var overlay = DrawOverlay(inputImage, finalX, finalY, globalBestAngle, globalBestScale,
+                            bestModel.TemplateWidth, bestModel.TemplateHeight, bestModel.ModelEdges);
+                        for (int i = 1; i < instances.Count; i++)
+                        {
+                            var inst = instances[i];
+                            DrawMatch(overlay, inst.CenterX, inst.CenterY, inst.Angle, inst.Scale,
+                                inst.Model.TemplateWidth, inst.Model.TemplateHeight, inst.Model.ModelEdges);
+                        }
+                        result.OverlayImage = overlay;
+                    }
+                    else
+                    {
+                        result.OverlayImage = DrawOverlay(inputImage, finalX, finalY, globalBestAngle, globalBestScale,
+                            bestModel.TemplateWidth, bestModel.TemplateHeight, bestModel.ModelEdges);
+                    }
                 }
                 else
                 {
+                    ResetTracking();
                     result.Success = false;
                     result.Message = $"패턴을 찾지 못했습니다. (최대 Score={globalBestScore:F3}, Votes={globalBestVoteVal})";
                     if (UseSearchRegion && SearchRegion.Width > 0 && SearchRegion.Height > 0)
@@ -777,13 +1746,97 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                     }
                 }
             }
-            catch (Exception ex)
+            catch (Exception ex)
+            {
+                result.Success = false;
+                result.Message = $"실행 오류: {ex.Message}";
+            }
+
+            return result;
+        }
+
+        // Last pose found while UseTracking is on (image coordinates). The model's
+        // PoseBankKey at that time detects a retrain in between.
+        private FeatureMatchModel? _trackModel;
+        private int _trackModelKey;
+        private double _trackX, _trackY, _trackAngle, _trackScale;
+
+        private void ResetTracking() => _trackModel = null;
+
+        private void RememberTrackPose(FeatureMatchModel model, double x, double y, double angle, double scale)
+        {
+            _trackModel = model;
+            _trackModelKey = model.PoseBankKey;
+            _trackX = x;
+            _trackY = y;
+            _trackAngle = angle;
+            _trackScale = scale;
+        }
+
+        /// <summary>
+        /// Tracking step: searches only the window the last found part can reach
+        /// (TrackMaxShift, TrackMaxRotation, TrackMaxScaleChange), with no voting and
+        /// no full-image gradient. Returns null — and the caller runs the full
+        /// search — when nothing is tracked or the score is below ScoreThreshold.
+        /// </summary>
+        private (FeatureMatchModel model, double score, double x, double y, double angle, double scale)?
+            TrackLastPose(MatcherHandle matcher, List<FeatureMatchModel> enabledModels,
+                Mat searchGray, int offsetX, int offsetY)
+        {
+            const int REFINE_ITERATIONS = 8;
+
+            var model = _trackModel;
+            if (model == null || !NativeVision.HasTracking) return null;
+            if (!enabledModels.Contains(model) || model.PoseBankKey != _trackModelKey
+                || model.ModelXArray == null || model.ModelYArray == null
+                || model.ModelDxArray == null || model.ModelDyArray == null)
+            {
+                ResetTracking();
+                return null;
+            }
+
+            double fineAngleStep = Math.Max(0.1, AngleStep / 2.0);
+            double fineScaleStep = Math.Max(0.001, ScaleStep);
+            double maxScaleChange = MaxScale > MinScale ? TrackMaxScaleChange : 0.0;
+            double x, y, angle, scale, score;
+            fixed (float* pModelX = model.ModelXArray, pModelY = model.ModelYArray)
+            fixed (float* pModelDx = model.ModelDxArray, pModelDy = model.ModelDyArray)
+            fixed (float* pRefineX = model.RefineXArray, pRefineY = model.RefineYArray)
             {
-                result.Success = false;
-                result.Message = $"실행 오류: {ex.Message}";
+                score = NativeVision.NvTrackPose(
+                    matcher, model.PoseBankKey,
+                    pModelX, pModelY, pModelDx, pModelDy,
+                    pRefineX, pRefineY, model.ModelEdges.Count,
+                    (byte*)searchGray.Data, searchGray.Cols, searchGray.Rows, (int)searchGray.Step(),
+                    _trackX - offsetX, _trackY - offsetY, _trackAngle, _trackScale,
+                    TrackMaxShift, TrackMaxRotation, maxScaleChange,
+                    fineAngleStep, fineScaleStep, UseContrastInvariant ? 1 : 0, REFINE_ITERATIONS,
+                    &x, &y, &angle, &scale);
             }
+            if (score < ScoreThreshold) return null;
 
-            return result;
+            x += offsetX;
+            y += offsetY;
+            RememberTrackPose(model, x, y, angle, scale);
+            return (model, score, x, y, angle, scale);
+        }
+
+        private void SetMatchData(VisionResult result, FeatureMatchModel model, double score,
+            double x, double y, double angle, double scale)
+        {
+            result.Success = true;
+            string modelInfo = Models.Count > 1 ? $", Model={model.Name}" : "";
+            result.Message = $"Score={score:F3}, Pos=({x:F1},{y:F1}), Angle={angle:F2}, Scale={scale:F3}{modelInfo}";
+            result.Data["Score"] = score;
+            result.Data["CenterX"] = x;
+            result.Data["CenterY"] = y;
+            result.Data["Angle"] = angle;
+            result.Data["Scale"] = scale;
+            result.Data["MatchedModel"] = model.Name;
+            if (NativeVision.IsAvailable)
+                result.Data["NativeIsa"] = NativeVision.IsaName;
+            result.Data["TrainedCenterX"] = model.TrainedCenterX;
+            result.Data["TrainedCenterY"] = model.TrainedCenterY;
         }
 
         /// <summary>
@@ -791,8 +1844,9 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
         /// </summary>
         private (double score, double x, double y, double angle, double scale, double voteVal)
             MatchSingleModel(
+                MatcherHandle? matcher,
                 FeatureMatchModel model, Mat searchGray,
-                float* dxPtr, float* dyPtr, float* magPtr,
+                GradientPlanes grad,
                 int W, int H, int offsetX, int offsetY,
                 double pyramidScale, int actualLevels,
                 int vW, int vH,
@@ -803,6 +1857,11 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
             double coarseAngleStep = Math.Max(AngleStep, 4.0);
             double fineVoteAngleStep = Math.Max(AngleStep, 1.0);
             double bestVoteVal = 0, bestVoteCx = 0, bestVoteCy = 0, bestVoteAngle = 0;
+            double fineScaleStep = Math.Max(0.001, ScaleStep);
+            double scaleCenter = (MinScale + MaxScale) / 2.0;
+            double scaleRange = (MaxScale - MinScale) / 2.0;
+            // Phase 2 scale range; scale voting narrows it to a band around the voted scale
+            double bestVoteScale = 1.0, bandCenter = scaleCenter, bandRange = scaleRange;
 
             int[] binOffsets = model.BinOffsets!;
             int[] binIndices = model.BinIndices!;
@@ -810,7 +1869,7 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
             const int BIN_SHIFT = 1;
             double invScale = 1.0 / pyramidScale;
 
-            if (NativeVision.IsAvailable && model.ModelXArray != null && model.ModelYArray != null)
+            if (matcher != null && model.ModelXArray != null && model.ModelYArray != null)
             {
                 fixed (float* pModelX = model.ModelXArray, pModelY = model.ModelYArray)
                 fixed (int* pBinOffsets = binOffsets, pBinIndices = binIndices)
@@ -818,15 +1877,38 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                 {
                     double outCx, outCy, outAngle;
                     int outVotes;
-                    NativeVision.HoughVotingNative(
-                        pModelX, pModelY, N,
-                        pBinOffsets, pBinIndices, NUM_GRAD_BINS,
-                        pSeX, pSeY, pSeBin, searchEdgeCount,
-                        vW, vH,
-                        AngleStart, AngleExtent,
-                        coarseAngleStep, fineVoteAngleStep, 5,
-                        invScale, BIN_SHIFT,
-                        &outCx, &outCy, &outAngle, &outVotes);
+                    if (NativeVision.HasScaleVoting)
+                    {
+                        double outScale, outBandCenter, outBandRange;
+                        NativeVision.NvHoughVotingScaled(
+                            matcher,
+                            pModelX, pModelY, N,
+                            pBinOffsets, pBinIndices, NUM_GRAD_BINS,
+                            pSeX, pSeY, pSeBin, searchEdgeCount,
+                            vW, vH,
+                            AngleStart, AngleExtent,
+                            coarseAngleStep, fineVoteAngleStep, 5,
+                            scaleCenter, scaleRange, fineScaleStep,
+                            invScale, BIN_SHIFT,
+                            &outCx, &outCy, &outAngle, &outScale, &outVotes,
+                            &outBandCenter, &outBandRange);
+                        bestVoteScale = outScale;
+                        bandCenter = outBandCenter;
+                        bandRange = outBandRange;
+                    }
+                    else
+                    {
+                        NativeVision.NvHoughVoting(
+                            matcher,
+                            pModelX, pModelY, N,
+                            pBinOffsets, pBinIndices, NUM_GRAD_BINS,
+                            pSeX, pSeY, pSeBin, searchEdgeCount,
+                            vW, vH,
+                            AngleStart, AngleExtent,
+                            coarseAngleStep, fineVoteAngleStep, 5,
+                            invScale, BIN_SHIFT,
+                            &outCx, &outCy, &outAngle, &outVotes);
+                    }
                     bestVoteCx = outCx;
                     bestVoteCy = outCy;
                     bestVoteAngle = outAngle;
@@ -846,7 +1928,12 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                 object lockObj = new();
                 var modelEdges = model.ModelEdges;
 
-                Parallel.For(0, numCoarseAngles, ai =>
+                var parallelOptions = new ParallelOptions
+                {
+                    MaxDegreeOfParallelism = MaxThreads > 0 ? MaxThreads : -1
+                };
+
+                Parallel.For(0, numCoarseAngles, parallelOptions, ai =>
                 {
                     double angle = AngleStart + ai * coarseAngleStep;
                     double rad = angle * (Math.PI / 180.0);
@@ -918,7 +2005,7 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                     double fineEnd = cand.angle + coarseAngleStep;
                     int numFine = Math.Max(1, (int)((fineEnd - fineStart) / fineVoteAngleStep) + 1);
 
-                    Parallel.For(0, numFine, fi =>
+                    Parallel.For(0, numFine, parallelOptions, fi =>
                     {
                         double angle = fineStart + fi * fineVoteAngleStep;
                         if (angle < AngleStart || angle > AngleStart + AngleExtent) return;
@@ -993,19 +2080,9 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
 
             // ── Phase 2: SIMD gradient dot-product refinement ──
             double fineAngleStep = Math.Max(0.1, AngleStep / 2.0);
-            double fineScaleStep = Math.Max(0.001, ScaleStep);
-            double scaleCenter = (MinScale + MaxScale) / 2.0;
-            double scaleRange = (MaxScale - MinScale) / 2.0;
-
-            int poseCount;
-            PrecomputeFinePosesNative(
-                model,
-                bestVoteAngle, coarseAngleStep, fineAngleStep,
-                scaleCenter, scaleRange, fineScaleStep,
-                out poseCount);
 
             double bestScore = 0, bestX = bestVoteCx, bestY = bestVoteCy;
-            double bestAngle = bestVoteAngle, bestScale = 1.0;
+            double bestAngle = bestVoteAngle, bestScale = bestVoteScale;
             int refRadius = actualLevels > 1
                 ? Math.Max(4, (int)pyramidScale + 2)
                 : 4;
@@ -1013,30 +2090,54 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
             float greedy = (float)Greediness;
             bool ciFlag = UseContrastInvariant;
 
-            if (NativeVision.IsAvailable && poseCount > 0)
-            {
-                int bestDx, bestDy, bestPoseIdx;
-                double score = NativeVision.EvaluateAllPosesNative(
-                    (int)bestVoteCx, (int)bestVoteCy, refRadius,
-                    model.NativeRxBuf, model.NativeRyBuf,
-                    model.NativeRdxBuf, model.NativeRdyBuf,
-                    model.NativeMarginBuf,
-                    poseCount, N,
-                    dxPtr, dyPtr, magPtr,
-                    W, H, thresh, greedy,
-                    &bestDx, &bestDy, &bestPoseIdx,
-                    ciFlag ? 1 : 0);
+            if (matcher != null)
+            {
+                // Fine poses come from the matcher's pose-bank cache: a frame whose
+                // coarse angle repeats reuses the poses built for an earlier frame.
+                // Scoring is gather-free and exhaustive over the window (Greediness
+                // only applies to the managed fallback)
+                if (model.ModelXArray == null || model.ModelYArray == null
+                    || model.ModelDxArray == null || model.ModelDyArray == null)
+                    return (0, bestX, bestY, bestAngle, bestScale, bestVoteVal);
+
+                int bestDx = 0, bestDy = 0, poseCount = 0;
+                double poseAngle = bestAngle, poseScale = bestScale, score = 0;
+                fixed (float* pModelX = model.ModelXArray, pModelY = model.ModelYArray)
+                fixed (float* pModelDx = model.ModelDxArray, pModelDy = model.ModelDyArray)
+                {
+                    int bank = NativeVision.NvAcquirePoseBank(
+                        matcher, model.PoseBankKey,
+                        pModelX, pModelY, pModelDx, pModelDy, N,
+                        bestVoteAngle, coarseAngleStep, fineAngleStep,
+                        bandCenter, bandRange, fineScaleStep,
+                        &poseCount);
+                    if (bank >= 0 && poseCount > 0)
+                        score = NativeVision.NvEvaluatePoseBankCompact(
+                            matcher, bank,
+                            (int)bestVoteCx, (int)bestVoteCy, refRadius,
+                            grad.Packed,
+                            W, H,
+                            &bestDx, &bestDy, &poseAngle, &poseScale,
+                            ciFlag ? 1 : 0);
+                }
                 if (score > bestScore)
                 {
                     bestScore = score;
                     bestX = (int)bestVoteCx + bestDx;
                     bestY = (int)bestVoteCy + bestDy;
-                    bestAngle = model.NativeAngleBuf[bestPoseIdx];
-                    bestScale = model.NativeScaleBuf[bestPoseIdx];
+                    bestAngle = poseAngle;
+                    bestScale = poseScale;
                 }
             }
-            else if (poseCount > 0)
+            else
             {
+                int poseCount;
+                PrecomputeFinePosesNative(
+                    model,
+                    bestVoteAngle, coarseAngleStep, fineAngleStep,
+                    scaleCenter, scaleRange, fineScaleStep,
+                    out poseCount);
+
                 for (int pi = 0; pi < poseCount; pi++)
                 {
                     int fm = model.NativeMarginBuf[pi];
@@ -1055,7 +2156,7 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
 
                             double score = EvaluateSimd(
                                 px, py, pRx, pRy, pRdx, pRdy,
-                                dxPtr, dyPtr, magPtr, W, N, thresh, greedy, ciFlag);
+                                grad.Dx, grad.Dy, grad.Mag, W, N, thresh, greedy, ciFlag);
                             if (score > bestScore)
                             {
                                 bestScore = score;
@@ -1070,27 +2171,488 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
 
             // Sub-pixel parabolic refinement
             if (bestScore >= ScoreThreshold)
+                RefineSubPixel(matcher, model, grad, W, H, bestScore, fineAngleStep, fineScaleStep,
+                    ref bestX, ref bestY, ref bestAngle, ref bestScale);
+
+            return (bestScore, bestX, bestY, bestAngle, bestScale, bestVoteVal);
+        }
+
+        /// <summary>
+        /// Sub-pixel / sub-step refinement of a Phase 2 peak. Natively, x, y, angle
+        /// and scale are solved jointly (Gauss-Newton edge alignment) within one
+        /// pose step of the peak; otherwise, or if that fails, each is fitted with a
+        /// parabola through neighbouring scores: position first, then angle, then scale.
+        /// </summary>
+        private void RefineSubPixel(
+            MatcherHandle? matcher, FeatureMatchModel model,
+            GradientPlanes grad, int W, int H, double bestScore,
+            double fineAngleStep, double fineScaleStep,
+            ref double bestX, ref double bestY, ref double bestAngle, ref double bestScale)
+        {
+            const int REFINE_ITERATIONS = 8;
+
+            int N = model.ModelEdges.Count;
+            float thresh = (float)ScoreThreshold;
+            float greedy = (float)Greediness;
+            bool ciFlag = UseContrastInvariant;
+
+            if (NativeVision.IsAvailable && model.RefineXArray != null && model.RefineYArray != null
+                && model.ModelDxArray != null && model.ModelDyArray != null)
             {
-                int bxi = (int)bestX, byi = (int)bestY;
+                double x = bestX, y = bestY, angle = bestAngle, scale = bestScale;
+                double scaleLimit = MaxScale > MinScale ? fineScaleStep : 0.0;
+                int used;
+                fixed (float* pX = model.RefineXArray, pY = model.RefineYArray)
+                fixed (float* pDx = model.ModelDxArray, pDy = model.ModelDyArray)
+                {
+                    used = grad.Packed != null
+                        ? NativeVision.NvRefinePoseCompact(pX, pY, pDx, pDy, N,
+                            grad.Packed, W, H, ciFlag ? 1 : 0,
+                            fineAngleStep, scaleLimit, REFINE_ITERATIONS,
+                            &x, &y, &angle, &scale)
+                        : NativeVision.NvRefinePose(pX, pY, pDx, pDy, N,
+                            grad.Dx, grad.Dy, grad.Mag, W, H, ciFlag ? 1 : 0,
+                            fineAngleStep, scaleLimit, REFINE_ITERATIONS,
+                            &x, &y, &angle, &scale);
+                }
+                if (used > 0)
+                {
+                    bestX = x;
+                    bestY = y;
+                    bestAngle = angle;
+                    bestScale = scale;
+                    return;
+                }
+            }
+
+            int bxi = (int)bestX, byi = (int)bestY;
 
-                double sxm = EvaluateSinglePose(model.ModelEdges, bestAngle, bestScale, bxi - 1, byi, dxPtr, dyPtr, magPtr, W, N, thresh, greedy, ciFlag);
-                double sxp = EvaluateSinglePose(model.ModelEdges, bestAngle, bestScale, bxi + 1, byi, dxPtr, dyPtr, magPtr, W, N, thresh, greedy, ciFlag);
-                bestX = bxi + ParabolicPeak(sxm, bestScore, sxp);
+            double sxm = EvaluateSinglePose(matcher, model.ModelEdges, bestAngle, bestScale, bxi - 1, byi, grad, W, N, thresh, greedy, ciFlag);
+            double sxp = EvaluateSinglePose(matcher, model.ModelEdges, bestAngle, bestScale, bxi + 1, byi, grad, W, N, thresh, greedy, ciFlag);
+            bestX = bxi + ParabolicPeak(sxm, bestScore, sxp);
 
-                double sym = EvaluateSinglePose(model.ModelEdges, bestAngle, bestScale, bxi, byi - 1, dxPtr, dyPtr, magPtr, W, N, thresh, greedy, ciFlag);
-                double syp = EvaluateSinglePose(model.ModelEdges, bestAngle, bestScale, bxi, byi + 1, dxPtr, dyPtr, magPtr, W, N, thresh, greedy, ciFlag);
-                bestY = byi + ParabolicPeak(sym, bestScore, syp);
+            double sym = EvaluateSinglePose(matcher, model.ModelEdges, bestAngle, bestScale, bxi, byi - 1, grad, W, N, thresh, greedy, ciFlag);
+            double syp = EvaluateSinglePose(matcher, model.ModelEdges, bestAngle, bestScale, bxi, byi + 1, grad, W, N, thresh, greedy, ciFlag);
+            bestY = byi + ParabolicPeak(sym, bestScore, syp);
 
-                double sam = EvaluateSinglePose(model.ModelEdges, bestAngle - fineAngleStep, bestScale, bxi, byi, dxPtr, dyPtr, magPtr, W, N, thresh, greedy, ciFlag);
-                double sap = EvaluateSinglePose(model.ModelEdges, bestAngle + fineAngleStep, bestScale, bxi, byi, dxPtr, dyPtr, magPtr, W, N, thresh, greedy, ciFlag);
-                bestAngle += ParabolicPeak(sam, bestScore, sap) * fineAngleStep;
+            double sam = EvaluateSinglePose(matcher, model.ModelEdges, bestAngle - fineAngleStep, bestScale, bxi, byi, grad, W, N, thresh, greedy, ciFlag);
+            double sap = EvaluateSinglePose(matcher, model.ModelEdges, bestAngle + fineAngleStep, bestScale, bxi, byi, grad, W, N, thresh, greedy, ciFlag);
+            bestAngle += ParabolicPeak(sam, bestScore, sap) * fineAngleStep;
 
-                double ssm = EvaluateSinglePose(model.ModelEdges, bestAngle, bestScale - fineScaleStep, bxi, byi, dxPtr, dyPtr, magPtr, W, N, thresh, greedy, ciFlag);
-                double ssp = EvaluateSinglePose(model.ModelEdges, bestAngle, bestScale + fineScaleStep, bxi, byi, dxPtr, dyPtr, magPtr, W, N, thresh, greedy, ciFlag);
-                bestScale += ParabolicPeak(ssm, bestScore, ssp) * fineScaleStep;
+            double ssm = EvaluateSinglePose(matcher, model.ModelEdges, bestAngle, bestScale - fineScaleStep, bxi, byi, grad, W, N, thresh, greedy, ciFlag);
+            double ssp = EvaluateSinglePose(matcher, model.ModelEdges, bestAngle, bestScale + fineScaleStep, bxi, byi, grad, W, N, thresh, greedy, ciFlag);
+            bestScale += ParabolicPeak(ssm, bestScore, ssp) * fineScaleStep;
+        }
+
+        /// <summary>
+        /// Single-instance search over several models in one native call. Voting for
+        /// every model × angle shares one parallel pass; Phase 2 scores all models'
+        /// poses against a common best and abandons models that can no longer win.
+        /// Only the winning model is refined. Same result as calling MatchSingleModel
+        /// per model and keeping the first best score.
+        /// </summary>
+        private (FeatureMatchModel? model, double score, double x, double y, double angle, double scale, double voteVal)
+            MatchModelsBatched(
+                MatcherHandle matcher,
+                List<FeatureMatchModel> models,
+                GradientPlanes grad,
+                int W, int H,
+                double pyramidScale, int actualLevels,
+                int vW, int vH,
+                int[] seX, int[] seY, int[] seBin, int searchEdgeCount)
+        {
+            const int BIN_SHIFT = 1;
+            const int TOP_K = 5;
+
+            double coarseAngleStep = Math.Max(AngleStep, 4.0);
+            double fineVoteAngleStep = Math.Max(AngleStep, 1.0);
+            double fineAngleStep = Math.Max(0.1, AngleStep / 2.0);
+            double fineScaleStep = Math.Max(0.001, ScaleStep);
+            double scaleCenter = (MinScale + MaxScale) / 2.0;
+            double scaleRange = (MaxScale - MinScale) / 2.0;
+            int refRadius = actualLevels > 1
+                ? Math.Max(4, (int)pyramidScale + 2)
+                : 4;
+
+            var batch = models.Where(m => m.ModelXArray != null && m.ModelYArray != null
+                && m.ModelDxArray != null && m.ModelDyArray != null).ToList();
+            if (batch.Count == 0)
+                return (null, 0, 0, 0, 0, 1.0, 0);
+
+            // The descriptors hold raw pointers, so every array stays pinned
+            // for the duration of the call
+            var descs = new NativeVision.ModelDesc[batch.Count];
+            var results = new NativeVision.ModelResult[batch.Count];
+            var pins = new List<GCHandle>(batch.Count * 6);
+            int winner;
+            try
+            {
+                for (int i = 0; i < batch.Count; i++)
+                {
+                    var model = batch[i];
+                    descs[i] = new NativeVision.ModelDesc
+                    {
+                        ModelX = (float*)Pin(pins, model.ModelXArray!),
+                        ModelY = (float*)Pin(pins, model.ModelYArray!),
+                        ModelDx = (float*)Pin(pins, model.ModelDxArray!),
+                        ModelDy = (float*)Pin(pins, model.ModelDyArray!),
+                        BinOffsets = (int*)Pin(pins, model.BinOffsets!),
+                        BinIndices = (int*)Pin(pins, model.BinIndices!),
+                        ModelCount = model.ModelEdges.Count,
+                        ModelKey = model.PoseBankKey,
+                        VoteMode = (int)model.Phase1Engine
+                    };
+                }
+
+                fixed (NativeVision.ModelDesc* pDescs = descs)
+                fixed (NativeVision.ModelResult* pResults = results)
+                fixed (int* pSeX = seX, pSeY = seY, pSeBin = seBin)
+                {
+                    winner = NativeVision.NvMatchModelsCompact(
+                        matcher,
+                        pDescs, batch.Count, NUM_GRAD_BINS,
+                        pSeX, pSeY, pSeBin, searchEdgeCount,
+                        vW, vH,
+                        AngleStart, AngleExtent,
+                        coarseAngleStep, fineVoteAngleStep, TOP_K,
+                        1.0 / pyramidScale, BIN_SHIFT,
+                        fineAngleStep, scaleCenter, scaleRange, fineScaleStep,
+                        grad.Packed,
+                        W, H, refRadius, UseContrastInvariant ? 1 : 0,
+                        pResults);
+                }
+            }
+            finally
+            {
+                foreach (var h in pins)
+                    h.Free();
             }
 
-            return (bestScore, bestX, bestY, bestAngle, bestScale, bestVoteVal);
+            if (winner < 0)
+                return (null, 0, 0, 0, 0, 1.0, 0);
+
+            var best = results[winner];
+            double x = best.X, y = best.Y, angle = best.Angle, scale = best.Scale;
+            if (best.Score >= ScoreThreshold)
+                RefineSubPixel(matcher, batch[winner], grad, W, H, best.Score, fineAngleStep, fineScaleStep,
+                    ref x, ref y, ref angle, ref scale);
+
+            return (batch[winner], best.Score, x, y, angle, scale, best.Votes);
+        }
+
+        private static IntPtr Pin(List<GCHandle> pins, Array array)
+        {
+            var handle = GCHandle.Alloc(array, GCHandleType.Pinned);
+            pins.Add(handle);
+            return handle.AddrOfPinnedObject();
+        }
+
+        /// <summary>
+        /// Multi-instance search: every enabled model returns its non-overlapping matches
+        /// from one native call, then matches from different models are merged best-first.
+        /// </summary>
+        private List<MatchInstanceResult> MatchInstancesAllModels(
+            MatcherHandle matcher,
+            List<FeatureMatchModel> models,
+            GradientPlanes grad,
+            int W, int H, int offsetX, int offsetY,
+            double pyramidScale, int actualLevels,
+            int vW, int vH,
+            int[] seX, int[] seY, int[] seBin, int searchEdgeCount)
+        {
+            // Suppression box as a fraction of the model's bounding box (turned to each instance's pose)
+            const double INSTANCE_SEPARATION = 1.0;
+            const int BIN_SHIFT = 1;
+
+            double coarseAngleStep = Math.Max(AngleStep, 4.0);
+            double fineAngleStep = Math.Max(0.1, AngleStep / 2.0);
+            double fineScaleStep = Math.Max(0.001, ScaleStep);
+            double scaleCenter = (MinScale + MaxScale) / 2.0;
+            double scaleRange = (MaxScale - MinScale) / 2.0;
+            int refRadius = actualLevels > 1
+                ? Math.Max(4, (int)pyramidScale + 2)
+                : 4;
+
+            var all = new List<MatchInstanceResult>();
+            var buffer = new NativeVision.MatchInstance[MaxInstances];
+
+            foreach (var model in models)
+            {
+                if (model.ModelXArray == null || model.ModelYArray == null
+                    || model.ModelDxArray == null || model.ModelDyArray == null)
+                    continue;
+
+                int count;
+                fixed (float* pModelX = model.ModelXArray, pModelY = model.ModelYArray)
+                fixed (float* pModelDx = model.ModelDxArray, pModelDy = model.ModelDyArray)
+                fixed (int* pBinOffsets = model.BinOffsets, pBinIndices = model.BinIndices)
+                fixed (int* pSeX = seX, pSeY = seY, pSeBin = seBin)
+                fixed (NativeVision.MatchInstance* pOut = buffer)
+                {
+                    count = NativeVision.NvMatchInstancesCompact(
+                        matcher,
+                        pModelX, pModelY, pModelDx, pModelDy, model.ModelEdges.Count,
+                        pBinOffsets, pBinIndices, NUM_GRAD_BINS,
+                        pSeX, pSeY, pSeBin, searchEdgeCount,
+                        vW, vH,
+                        AngleStart, AngleExtent,
+                        coarseAngleStep, fineAngleStep,
+                        scaleCenter, scaleRange, fineScaleStep,
+                        1.0 / pyramidScale, BIN_SHIFT,
+                        grad.Packed,
+                        W, H, refRadius,
+                        (float)ScoreThreshold, (float)Greediness, UseContrastInvariant ? 1 : 0,
+                        ScoreThreshold, INSTANCE_SEPARATION, MaxInstances,
+                        pOut);
+                }
+
+                for (int i = 0; i < count; i++)
+                {
+                    all.Add(new MatchInstanceResult
+                    {
+                        Model = model,
+                        ModelName = model.Name,
+                        CenterX = buffer[i].X + offsetX,
+                        CenterY = buffer[i].Y + offsetY,
+                        Angle = buffer[i].Angle,
+                        Scale = buffer[i].Scale,
+                        Score = buffer[i].Score
+                    });
+                }
+            }
+
+            // Different models may land on the same part — keep the better one
+            all.Sort((a, b) => b.Score.CompareTo(a.Score));
+            var kept = new List<MatchInstanceResult>();
+            foreach (var inst in all)
+            {
+                double radius = 0.5 * Math.Min(inst.Model.TemplateWidth, inst.Model.TemplateHeight) * inst.Scale;
+                bool overlaps = kept.Any(k =>
+                    (k.CenterX - inst.CenterX) * (k.CenterX - inst.CenterX) +
+                    (k.CenterY - inst.CenterY) * (k.CenterY - inst.CenterY) < radius * radius);
+                if (overlaps) continue;
+                kept.Add(inst);
+                if (kept.Count >= MaxInstances) break;
+            }
+            return kept;
+        }
+
+        #endregion
+
+        #region Pipelined Execute
+
+        private const int PIPELINE_DEPTH = 3;
+
+        /// <summary>Per-ticket context needed to turn a native result into a VisionResult.</summary>
+        private sealed record PendingJob(List<FeatureMatchModel> Models, int OffsetX, int OffsetY, long SubmitTimestamp);
+
+        private readonly object _pipelineLock = new();
+        private PipelineHandle? _pipeline;
+        private ModelSetHandle? _pipelineModelSet;
+        private List<FeatureMatchModel>? _pipelineModels;
+        private (int Key, Phase1Engine Engine)[]? _pipelineModelKeys;
+        private readonly Dictionary<long, PendingJob> _pendingJobs = new();
+
+        /// <summary>
+        /// Queues a frame on the tool's native match pipeline and returns its ticket, or 0
+        /// when the frame needs the synchronous Execute (no pipeline export, colour input,
+        /// MaxInstances &gt; 1, no trained model). The pipeline prepares the next frame
+        /// (gradient, pyramid, Canny) while the previous one is voted, scored and refined,
+        /// and completes jobs in submission order. The frame is copied on submit; blocks
+        /// while PIPELINE_DEPTH results are still uncollected.
+        /// </summary>
+        public long SubmitFrame(Mat inputImage)
+        {
+            if (!NativeVision.HasPipeline || inputImage.Channels() != 1 || MaxInstances > 1)
+                return 0;
+
+            var enabledModels = Models.Where(m => m.IsEnabled && m.IsTrained
+                && m.BinOffsets != null && m.BinIndices != null
+                && m.ModelXArray != null && m.ModelYArray != null
+                && m.ModelDxArray != null && m.ModelDyArray != null).ToList();
+            if (enabledModels.Count == 0)
+                return 0;
+
+            using var searchGray = PrepareSearchImage(inputImage, out int offsetX, out int offsetY);
+            int actualLevels = Math.Max(1, Math.Min(NumLevels, 5));
+            double pyramidScale = Math.Pow(2, actualLevels - 1);
+            double fineScaleStep = Math.Max(0.001, ScaleStep);
+            var sp = new NativeVision.SearchParams
+            {
+                Levels = actualLevels,
+                NumGradBins = NUM_GRAD_BINS,
+                CannyLow = CannyLow,
+                CannyHigh = CannyHigh,
+                AngleStart = AngleStart,
+                AngleExtent = AngleExtent,
+                CoarseAngleStep = Math.Max(AngleStep, 4.0),
+                FineVoteAngleStep = Math.Max(AngleStep, 1.0),
+                TopK = 5,
+                BinShiftBits = 1,
+                FineAngleStep = Math.Max(0.1, AngleStep / 2.0),
+                ScaleCenter = (MinScale + MaxScale) / 2.0,
+                ScaleRange = (MaxScale - MinScale) / 2.0,
+                ScaleStep = fineScaleStep,
+                RefRadius = actualLevels > 1 ? Math.Max(4, (int)pyramidScale + 2) : 4,
+                ContrastInvariant = UseContrastInvariant ? 1 : 0,
+                RefineMinScore = ScoreThreshold,
+                RefineScaleLimit = MaxScale > MinScale ? fineScaleStep : 0.0,
+                RefineIterations = 8
+            };
+
+            PipelineHandle pipeline;
+            ModelSetHandle modelSet;
+            List<FeatureMatchModel> models;
+            lock (_pipelineLock)
+            {
+                if (_pipeline == null || _pipeline.IsInvalid)
+                {
+                    _pipeline?.Dispose();
+                    _pipeline = NativeVision.NvCreatePipeline(PIPELINE_DEPTH, 0, 0);
+                    if (_pipeline.IsInvalid)
+                        return 0;
+                }
+                if (!EnsurePipelineModelSet(enabledModels))
+                    return 0;
+                pipeline = _pipeline;
+                modelSet = _pipelineModelSet!;
+                models = _pipelineModels!;
+            }
+
+            // Outside the lock: submit blocks until a slot is collected
+            long submitted = Stopwatch.GetTimestamp();
+            long ticket = NativeVision.NvPipelineSubmit(
+                pipeline, modelSet,
+                (byte*)searchGray.Data, searchGray.Cols, searchGray.Rows, (int)searchGray.Step(),
+                &sp);
+            if (ticket <= 0)
+                return 0;
+
+            lock (_pipelineLock)
+                _pendingJobs[ticket] = new PendingJob(models, offsetX, offsetY, submitted);
+            return ticket;
+        }
+
+        /// <summary>
+        /// Collects the result of a SubmitFrame ticket, waiting up to timeoutMs (-1 = forever).
+        /// Returns false on timeout. The overlay is drawn only when overlayBase is given,
+        /// since the submitted frame may be gone by now. ExecutionTime is submit → result.
+        /// </summary>
+        public bool TryGetResult(long ticket, int timeoutMs, out VisionResult result, Mat? overlayBase = null)
+        {
+            result = new VisionResult();
+            PipelineHandle? pipeline;
+            PendingJob? job;
+            lock (_pipelineLock)
+            {
+                pipeline = _pipeline;
+                _pendingJobs.TryGetValue(ticket, out job);
+            }
+            if (pipeline == null || job == null)
+            {
+                result.Success = false;
+                result.Message = "알 수 없는 작업 번호입니다.";
+                return true;
+            }
+
+            NativeVision.PipelineResult r;
+            int status = NativeVision.NvPipelineWait(pipeline, ticket, timeoutMs, &r);
+            if (status == 0)
+                return false;
+
+            lock (_pipelineLock)
+                _pendingJobs.Remove(ticket);
+
+            ExecutionTime = Stopwatch.GetElapsedTime(job.SubmitTimestamp).TotalMilliseconds;
+            if (status < 0)
+            {
+                result.Success = false;
+                result.Message = "파이프라인 작업이 취소되었습니다.";
+                return true;
+            }
+
+            var model = r.Winner >= 0 && r.Winner < job.Models.Count ? job.Models[r.Winner] : null;
+            LastMatchedModel = model;
+            if (model != null && r.Score >= ScoreThreshold)
+            {
+                double finalX = r.X + job.OffsetX;
+                double finalY = r.Y + job.OffsetY;
+                SetMatchData(result, model, r.Score, finalX, finalY, r.Angle, r.Scale);
+                result.Data["PrepareMs"] = r.PrepareMs;
+                result.Data["MatchMs"] = r.MatchMs;
+                if (overlayBase != null)
+                    result.OverlayImage = DrawOverlay(overlayBase, finalX, finalY, r.Angle, r.Scale,
+                        model.TemplateWidth, model.TemplateHeight, model.ModelEdges);
+            }
+            else
+            {
+                result.Success = false;
+                result.Message = $"패턴을 찾지 못했습니다. (최대 Score={r.Score:F3}, Votes={r.Votes})";
+            }
+            return true;
+        }
+
+        /// <summary>
+        /// Rebuilds the native model set when the enabled models changed; retraining
+        /// renews PoseBankKey, so the keys and engines identify the set.
+        /// </summary>
+        private bool EnsurePipelineModelSet(List<FeatureMatchModel> models)
+        {
+            var keys = models.Select(m => (m.PoseBankKey, m.Phase1Engine)).ToArray();
+            if (_pipelineModelSet != null && !_pipelineModelSet.IsInvalid
+                && _pipelineModelKeys != null && keys.SequenceEqual(_pipelineModelKeys))
+                return true;
+
+            var descs = new NativeVision.ModelDesc[models.Count];
+            var refineX = new IntPtr[models.Count];
+            var refineY = new IntPtr[models.Count];
+            var pins = new List<GCHandle>(models.Count * 8);
+            try
+            {
+                for (int i = 0; i < models.Count; i++)
+                {
+                    var model = models[i];
+                    descs[i] = new NativeVision.ModelDesc
+                    {
+                        ModelX = (float*)Pin(pins, model.ModelXArray!),
+                        ModelY = (float*)Pin(pins, model.ModelYArray!),
+                        ModelDx = (float*)Pin(pins, model.ModelDxArray!),
+                        ModelDy = (float*)Pin(pins, model.ModelDyArray!),
+                        BinOffsets = (int*)Pin(pins, model.BinOffsets!),
+                        BinIndices = (int*)Pin(pins, model.BinIndices!),
+                        ModelCount = model.ModelEdges.Count,
+                        ModelKey = model.PoseBankKey,
+                        VoteMode = (int)model.Phase1Engine
+                    };
+                    if (model.RefineXArray != null && model.RefineYArray != null)
+                    {
+                        refineX[i] = Pin(pins, model.RefineXArray);
+                        refineY[i] = Pin(pins, model.RefineYArray);
+                    }
+                }
+
+                _pipelineModelSet?.Dispose();
+                fixed (NativeVision.ModelDesc* pDescs = descs)
+                fixed (IntPtr* pRx = refineX, pRy = refineY)
+                {
+                    _pipelineModelSet = NativeVision.NvCreateModelSet(pDescs, models.Count, NUM_GRAD_BINS,
+                        (float**)pRx, (float**)pRy);
+                }
+            }
+            finally
+            {
+                foreach (var h in pins)
+                    h.Free();
+            }
+
+            if (_pipelineModelSet.IsInvalid)
+            {
+                _pipelineModelKeys = null;
+                return false;
+            }
+            _pipelineModels = models;
+            _pipelineModelKeys = keys;
+            return true;
         }
 
         #endregion
@@ -1275,9 +2837,10 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
         }
 
         private static double EvaluateSinglePose(
+            MatcherHandle? matcher,
             List<EdgePoint> modelEdges,
             double angle, double scale, int px, int py,
-            float* dxPtr, float* dyPtr, float* magPtr,
+            GradientPlanes grad,
             int W, int N, float thresh, float greedy, bool ciFlag)
         {
             double rad = angle * (Math.PI / 180.0);
@@ -1306,14 +2869,80 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
 
             if (px < maxOff + 1 || px >= W - maxOff - 1) return 0;
 
+            if (matcher != null)
+                return NativeVision.NvEvaluateCompact(matcher, px, py, prx, pry, prdx, prdy,
+                    grad.Packed, W, N, thresh, greedy, ciFlag ? 1 : 0);
+
             return EvaluateSimd(px, py, prx, pry, prdx, prdy,
-                dxPtr, dyPtr, magPtr, W, N, thresh, greedy, ciFlag);
+                grad.Dx, grad.Dy, grad.Mag, W, N, thresh, greedy, ciFlag);
         }
 
         #endregion
 
         #region Helpers
 
+        /// <summary>
+        /// Managed search-edge extraction: PyrDown to the voting level, Canny, then
+        /// one orientation bin per edge pixel. Arrays are rented from <paramref name="pool"/>.
+        /// </summary>
+        private int ExtractSearchEdges(Mat searchGray, int actualLevels, ArrayPool<int> pool,
+            out int[] seX, out int[] seY, out int[] seBin)
+        {
+            Mat? coarseImg = null;
+            if (actualLevels > 1)
+            {
+                coarseImg = searchGray;
+                for (int lvl = 0; lvl < actualLevels - 1; lvl++)
+                {
+                    var temp = new Mat();
+                    Cv2.PyrDown(coarseImg, temp);
+                    if (coarseImg != searchGray) coarseImg.Dispose();
+                    coarseImg = temp;
+                }
+            }
+
+            var voteImg = coarseImg ?? searchGray;
+            int vW = voteImg.Cols, vH = voteImg.Rows;
+
+            using var voteEdges = voteImg.Canny(CannyLow, CannyHigh);
+            using var votePhase = new Mat();
+            {
+                using var vsx = new Mat();
+                using var vsy = new Mat();
+                Cv2.Sobel(voteImg, vsx, MatType.CV_32F, 1, 0, 3);
+                Cv2.Sobel(voteImg, vsy, MatType.CV_32F, 0, 1, 3);
+                Cv2.Phase(vsx, vsy, votePhase, true);
+            }
+            coarseImg?.Dispose();
+
+            byte* vEdgePtr = (byte*)voteEdges.Data;
+            float* vPhasePtr = (float*)votePhase.Data;
+
+            int vtotalPx = vW * vH;
+            int vEdgeCount = 0;
+            for (int i = 0; i < vtotalPx; i++)
+                if (vEdgePtr[i] > 0) vEdgeCount++;
+
+            seX = pool.Rent(vEdgeCount);
+            seY = pool.Rent(vEdgeCount);
+            seBin = pool.Rent(vEdgeCount);
+            int sei = 0;
+            for (int idx = 0; idx < vtotalPx; idx++)
+            {
+                if (vEdgePtr[idx] > 0)
+                {
+                    seX[sei] = idx % vW;
+                    seY[sei] = idx / vW;
+                    int b = (int)(vPhasePtr[idx] / BIN_WIDTH_DEG);
+                    if (b < 0) b += NUM_GRAD_BINS;
+                    if (b >= NUM_GRAD_BINS) b = NUM_GRAD_BINS - 1;
+                    seBin[sei] = b;
+                    sei++;
+                }
+            }
+            return sei;
+        }
+
         private Mat PrepareSearchImage(Mat input, out int ox, out int oy)
         {
             if (UseSearchRegion && SearchRegion.Width > 0 && SearchRegion.Height > 0)
@@ -1338,6 +2967,22 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
             int templateWidth, int templateHeight, List<EdgePoint> modelEdges)
         {
             var overlay = GetColorOverlayBase(inputImage);
+            DrawMatch(overlay, cx, cy, angle, scale, templateWidth, templateHeight, modelEdges);
+
+            if (UseSearchRegion && SearchRegion.Width > 0 && SearchRegion.Height > 0)
+            {
+                Cv2.Rectangle(overlay,
+                    new Point(SearchRegion.X, SearchRegion.Y),
+                    new Point(SearchRegion.X + SearchRegion.Width, SearchRegion.Y + SearchRegion.Height),
+                    new Scalar(255, 255, 0), 2);
+            }
+
+            return overlay;
+        }
+
+        private static void DrawMatch(Mat overlay, double cx, double cy, double angle, double scale,
+            int templateWidth, int templateHeight, List<EdgePoint> modelEdges)
+        {
             double cosA = Math.Cos(angle * Math.PI / 180.0);
             double sinA = Math.Sin(angle * Math.PI / 180.0);
             double hw = templateWidth / 2.0 * scale;
@@ -1366,16 +3011,6 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                 Cv2.Circle(overlay, new Point((int)Math.Round(rx), (int)Math.Round(ry)),
                     2, new Scalar(0, 255, 0), -1);
             }
-
-            if (UseSearchRegion && SearchRegion.Width > 0 && SearchRegion.Height > 0)
-            {
-                Cv2.Rectangle(overlay,
-                    new Point(SearchRegion.X, SearchRegion.Y),
-                    new Point(SearchRegion.X + SearchRegion.Width, SearchRegion.Y + SearchRegion.Height),
-                    new Scalar(255, 255, 0), 2);
-            }
-
-            return overlay;
         }
 
         #endregion
@@ -1384,7 +3019,7 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
 
         public override List<string> GetAvailableResultKeys()
         {
-            return new List<string> { "Success", "Score", "CenterX", "CenterY", "Angle", "Scale" };
+            return new List<string> { "Success", "Score", "CenterX", "CenterY", "Angle", "Scale", "InstanceCount", "Tracked" };
         }
 
         public override VisionToolBase Clone()
@@ -1400,6 +3035,13 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                 SearchRegion = this.SearchRegion, UseSearchRegion = this.UseSearchRegion,
                 UseContrastInvariant = this.UseContrastInvariant,
                 CurvatureWeight = this.CurvatureWeight,
+                MaxInstances = this.MaxInstances,
+                UseTracking = this.UseTracking,
+                TrackMaxShift = this.TrackMaxShift,
+                TrackMaxRotation = this.TrackMaxRotation,
+                TrackMaxScaleChange = this.TrackMaxScaleChange,
+                MaxThreads = this.MaxThreads,
+                UseEdgePruning = this.UseEdgePruning,
                 IsAutoTuneEnabled = this.IsAutoTuneEnabled
             };
 
@@ -1410,6 +3052,7 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                 {
                     Name = model.Name,
                     IsEnabled = model.IsEnabled,
+                    Phase1Engine = model.Phase1Engine,
                     TemplateImage = model.TemplateImage?.Clone(),
                     TrainedFeatureImage = model.TrainedFeatureImage?.Clone(),
                     TemplateWidth = model.TemplateWidth,
@@ -1417,6 +3060,10 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
                     ModelEdges = new List<EdgePoint>(model.ModelEdges),
                     ModelXArray = model.ModelXArray != null ? (float[])model.ModelXArray.Clone() : null,
                     ModelYArray = model.ModelYArray != null ? (float[])model.ModelYArray.Clone() : null,
+                    ModelDxArray = model.ModelDxArray != null ? (float[])model.ModelDxArray.Clone() : null,
+                    ModelDyArray = model.ModelDyArray != null ? (float[])model.ModelDyArray.Clone() : null,
+                    RefineXArray = model.RefineXArray != null ? (float[])model.RefineXArray.Clone() : null,
+                    RefineYArray = model.RefineYArray != null ? (float[])model.RefineYArray.Clone() : null,
                     BinOffsets = model.BinOffsets != null ? (int[])model.BinOffsets.Clone() : null,
                     BinIndices = model.BinIndices != null ? (int[])model.BinIndices.Clone() : null
                 };
@@ -1441,4 +3088,19 @@ namespace VMS.VisionSetup.VisionTools.PatternMatching
 
         #endregion
     }
+
+    /// <summary>
+    /// One match reported by the multi-instance search (image coordinates).
+    /// </summary>
+    public class MatchInstanceResult
+    {
+        public string ModelName { get; set; } = string.Empty;
+        public double CenterX { get; set; }
+        public double CenterY { get; set; }
+        public double Angle { get; set; }
+        public double Scale { get; set; }
+        public double Score { get; set; }
+
+        internal FeatureMatchModel Model { get; set; } = null!;
+    }
 }
@@ -13,6 +13,7 @@ using VMS.PLC.Services;
 using VMS.Services;
 using VMS.ViewModels;
 using VMS.Views;
+using VMS.VisionSetup.VisionTools.PatternMatching;
 
 namespace VMS
 {
@@ -53,8 +54,13 @@ namespace VMS
                 sharedFrameWriter = null;
             }
 
-            // ── PLC connection setup ──
             var systemConfig = configService.LoadSystemConfiguration();
+
+            // ── Native Vision worker cores (검사 시작 전 한 번 설정) ──
+            FeatureMatchTool.ConfigureNativeWorkers(systemConfig.NativeWorkerCores, systemConfig.PinNativeWorkers);
+            Debug.WriteLine($"[App] Native workers: {FeatureMatchTool.GetNativeWorkerCores().Cores} cores, pin={systemConfig.PinNativeWorkers}");
+
+            // ── PLC connection setup ──
             var plcConfig = new PlcConnectionConfig
             {
                 Vendor = systemConfig.PlcVendor,
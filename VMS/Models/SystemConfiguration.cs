@@ -39,6 +39,10 @@ namespace VMS.Models
         public PlcWriteMode WriteMode { get; set; } = PlcWriteMode.Handshake;
         public PlcEndianMode EndianMode { get; set; } = PlcEndianMode.LittleEndian;
 
+        // Native Vision workers
+        public int NativeWorkerCores { get; set; }          // 0 = all processors
+        public bool PinNativeWorkers { get; set; }
+
         public DateTime CreatedAt { get; set; } = DateTime.UtcNow;
         public string Version { get; set; } = "1.0.0";
     }